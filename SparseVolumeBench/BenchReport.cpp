@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include "SVXFile.h"
+#include "BenchReport.h"
+
+using namespace std;
+using namespace SVX;
+
+const uint32_t BenchReport::SCHEMA_VERSION;
+
+BenchReport::BenchReport() :
+	m_vResults(0)
+{
+}
+
+BenchReport::~BenchReport()
+{
+}
+
+void BenchReport::Add(const BenchResult &result)
+{
+	m_vResults.push_back(result);
+}
+
+bool BenchReport::WriteCSV(const char *pszFilename) const
+{
+	const auto pFile = OpenFile(pszFilename, "w");
+	if (!pFile) return false;
+
+	fprintf(pFile, "schema_version,suite,case,mesh,triangles,width,height,k,threads,lights,"
+		"depth_complexity,repeats,seconds,metric,value,unit,error\n");
+	for (const auto &r : m_vResults)
+		fprintf(pFile, "%u,%s,%s,%s,%u,%u,%u,%u,%u,%u,%.4f,%u,%.9f,%s,%.6g,%s,%.6g\n", SCHEMA_VERSION,
+			r.strSuite.c_str(), r.strCase.c_str(), r.strMesh.c_str(), r.uTriangles, r.uWidth, r.uHeight,
+			r.uNumLayers, r.uThreads, r.uLights, r.fDepthComplexity, r.uRepeats, r.fSeconds,
+			r.strMetric.c_str(), r.fValue, r.strUnit.c_str(), r.fError);
+	fclose(pFile);
+
+	return true;
+}
+
+bool BenchReport::WriteJSON(const char *pszFilename) const
+{
+	const auto pFile = OpenFile(pszFilename, "w");
+	if (!pFile) return false;
+
+	// Names and units are identifiers without quotes or backslashes, so no escaping
+	fprintf(pFile, "{\n\t\"schema\": \"sparsevolume-bench\",\n\t\"schema_version\": %u,\n\t\"results\": [", SCHEMA_VERSION);
+	for (size_t i = 0; i < m_vResults.size(); ++i)
+	{
+		const auto &r = m_vResults[i];
+		fprintf(pFile, "%s\n\t\t{\"suite\": \"%s\", \"case\": \"%s\", \"mesh\": \"%s\", \"triangles\": %u, "
+			"\"width\": %u, \"height\": %u, \"k\": %u, \"threads\": %u, \"lights\": %u, "
+			"\"depth_complexity\": %.4f, \"repeats\": %u, \"seconds\": %.9f, "
+			"\"metric\": \"%s\", \"value\": %.6g, \"unit\": \"%s\", \"error\": %.6g}",
+			i > 0 ? "," : "", r.strSuite.c_str(), r.strCase.c_str(), r.strMesh.c_str(), r.uTriangles,
+			r.uWidth, r.uHeight, r.uNumLayers, r.uThreads, r.uLights, r.fDepthComplexity, r.uRepeats,
+			r.fSeconds, r.strMetric.c_str(), r.fValue, r.strUnit.c_str(), r.fError);
+	}
+	fprintf(pFile, "\n\t]\n}\n");
+	fclose(pFile);
+
+	return true;
+}
+
+void BenchReport::Print(FILE *pFile, const BenchResult &r) const
+{
+	fprintf(pFile, "%-12s %-10s %-16s %8u tri %4ux%-4u k=%-2u t=%-2u l=%-2u dc=%5.2f  %10.3f %s",
+		r.strSuite.c_str(), r.strCase.c_str(), r.strMesh.c_str(), r.uTriangles, r.uWidth, r.uHeight,
+		r.uNumLayers, r.uThreads, r.uLights, r.fDepthComplexity, r.fValue, r.strUnit.c_str());
+
+	// The error where measured
+	if (r.fError > 0.0) fprintf(pFile, "  error=%.2e", r.fError);
+	fprintf(pFile, "\n");
+}
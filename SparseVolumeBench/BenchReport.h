@@ -0,0 +1,62 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+//--------------------------------------------------------------------------------------
+// Benchmark results with a stable schema. Columns are only ever appended, and
+// SCHEMA_VERSION is bumped whenever the meaning of an existing column changes.
+//
+//	suite				loader, peel, integrate, threads, lights, transmission, balance,
+//						framegraph, solid, packets, morton, lod, sdf, filter, arena
+//	case				Variant within the suite, e.g. the transmission evaluator
+//	mesh				Mesh name, empty when not applicable
+//	triangles			Triangle count of the mesh
+//	width, height		Render resolution
+//	k					k-buffer layers
+//	threads				Concurrent renderers, or scheduler threads for balance and framegraph
+//	lights				Light count
+//	depth_complexity	Mean number of surfaces per covered pixel, capped at k
+//	repeats				Timed repetitions; seconds is their median
+//	seconds				Median seconds per repetition
+//	metric, value, unit	The headline figure, e.g. "peel", 12.3, "Mtri/s"
+//	error				Max relative error against the reference, when measured
+//--------------------------------------------------------------------------------------
+struct BenchResult
+{
+	std::string	strSuite;
+	std::string	strCase;
+	std::string	strMesh;
+	uint32_t	uTriangles;
+	uint32_t	uWidth;
+	uint32_t	uHeight;
+	uint32_t	uNumLayers;
+	uint32_t	uThreads;
+	uint32_t	uLights;
+	double		fDepthComplexity;
+	uint32_t	uRepeats;
+	double		fSeconds;
+	std::string	strMetric;
+	double		fValue;
+	std::string	strUnit;
+	double		fError;
+};
+
+class BenchReport
+{
+public:
+	static const uint32_t SCHEMA_VERSION = 1;
+
+	BenchReport();
+	virtual ~BenchReport();
+
+	void Add(const BenchResult &result);
+
+	bool WriteCSV(const char *pszFilename) const;
+	bool WriteJSON(const char *pszFilename) const;
+	void Print(FILE *pFile, const BenchResult &result) const;
+
+protected:
+	std::vector<BenchResult> m_vResults;
+};
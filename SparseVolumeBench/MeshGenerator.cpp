@@ -0,0 +1,133 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <unordered_map>
+#include "SVXFile.h"
+#include "MeshGenerator.h"
+
+using namespace std;
+using namespace SVX;
+using namespace MeshGenerator;
+
+static const float g_fPI = 3.14159265f;
+
+// Appends a UV sphere with radius fn(theta, phi)
+template<typename Fn>
+static void appendSphere(const uint32_t uSegments, const float3 &vCenter, const Fn &radius,
+	vfloat3 &vPositions, vuint &vIndices)
+{
+	const auto uRings = uSegments / 2;
+	const auto uBase = static_cast<uint32_t>(vPositions.size());
+	for (auto j = 0u; j <= uRings; ++j)
+	{
+		const auto fTheta = g_fPI * j / uRings;
+		for (auto i = 0u; i <= uSegments; ++i)
+		{
+			const auto fPhi = 2.0f * g_fPI * (i % uSegments) / uSegments;
+			const auto vDir = float3(sin(fTheta) * cos(fPhi), cos(fTheta), sin(fTheta) * sin(fPhi));
+			vPositions.push_back(vCenter + vDir * radius(fTheta, fPhi));
+		}
+	}
+
+	for (auto j = 0u; j < uRings; ++j)
+		for (auto i = 0u; i < uSegments; ++i)
+		{
+			const auto v0 = uBase + j * (uSegments + 1) + i;
+			const auto v1 = v0 + uSegments + 1;
+			if (j > 0) vIndices.insert(vIndices.end(), { v0, v0 + 1, v1 });
+			if (j + 1 < uRings) vIndices.insert(vIndices.end(), { v0 + 1, v1 + 1, v1 });
+		}
+}
+
+void MeshGenerator::NestedSpheres(const uint32_t uNumShells, const uint32_t uSegments,
+	vfloat3 &vPositions, vuint &vIndices)
+{
+	vPositions.clear();
+	vIndices.clear();
+	for (auto i = 0u; i < uNumShells; ++i)
+	{
+		const auto fRadius = 4.0f * (uNumShells - i) / uNumShells;
+		appendSphere(uSegments, float3(0.0f, 4.0f, 0.0f), [fRadius](float, float) { return fRadius; },
+			vPositions, vIndices);
+	}
+}
+
+void MeshGenerator::NoisyShell(const uint32_t uSegments, const float fAmplitude, const uint32_t uSeed,
+	vfloat3 &vPositions, vuint &vIndices)
+{
+	// Random phases from a linear congruential sequence
+	float vPhases[8];
+	auto uState = uSeed * 747796405u + 2891336453u;
+	for (auto &fPhase : vPhases)
+	{
+		uState = uState * 1664525u + 1013904223u;
+		fPhase = 2.0f * g_fPI * (uState >> 8) / 16777216.0f;
+	}
+
+	vPositions.clear();
+	vIndices.clear();
+	appendSphere(uSegments, float3(0.0f, 4.0f, 0.0f), [&vPhases, fAmplitude](const float fTheta, const float fPhi)
+	{
+		auto fNoise = 0.0f;
+		for (auto i = 0u; i < 4; ++i)
+		{
+			const auto fFreq = static_cast<float>(3 << i);
+			fNoise += sin(fTheta * fFreq + vPhases[i * 2]) * sin(fPhi * fFreq + vPhases[i * 2 + 1]) / (i + 1);
+		}
+
+		return 4.0f * (1.0f + fAmplitude * fNoise);
+	}, vPositions, vIndices);
+}
+
+void MeshGenerator::Tessellate(const uint32_t uLevels, vfloat3 &vPositions, vuint &vIndices)
+{
+	for (auto l = 0u; l < uLevels; ++l)
+	{
+		unordered_map<uint64_t, uint32_t> midpoints;
+		const auto midpoint = [&](const uint32_t a, const uint32_t b)
+		{
+			const auto uKey = static_cast<uint64_t>((std::min)(a, b)) << 32 | (std::max)(a, b);
+			const auto iter = midpoints.find(uKey);
+			if (iter != midpoints.end()) return iter->second;
+
+			const auto v = static_cast<uint32_t>(vPositions.size());
+			vPositions.push_back((vPositions[a] + vPositions[b]) * 0.5f);
+			midpoints[uKey] = v;
+
+			return v;
+		};
+
+		vuint vSubdivided;
+		vSubdivided.reserve(vIndices.size() * 4);
+		for (size_t i = 0; i + 2 < vIndices.size(); i += 3)
+		{
+			const auto v0 = vIndices[i], v1 = vIndices[i + 1], v2 = vIndices[i + 2];
+			const auto m01 = midpoint(v0, v1), m12 = midpoint(v1, v2), m20 = midpoint(v2, v0);
+			vSubdivided.insert(vSubdivided.end(), { v0, m01, m20, m01, v1, m12, m20, m12, v2, m01, m12, m20 });
+		}
+		vIndices.swap(vSubdivided);
+	}
+}
+
+spMesh MeshGenerator::CreateMesh(const vfloat3 &vPositions, const vuint &vIndices)
+{
+	const auto pMesh = make_shared<Mesh>();
+	pMesh->Create(reinterpret_cast<const uint8_t*>(vPositions.data()), sizeof(float3),
+		static_cast<uint32_t>(vPositions.size()), vIndices.data(), static_cast<uint32_t>(vIndices.size()));
+
+	return pMesh;
+}
+
+bool MeshGenerator::WriteOBJ(const char *pszFilename, const vfloat3 &vPositions, const vuint &vIndices)
+{
+	const auto pFile = OpenFile(pszFilename, "w");
+	if (!pFile) return false;
+
+	for (const auto &v : vPositions) fprintf(pFile, "v %f %f %f\n", v.x, v.y, v.z);
+	for (size_t i = 0; i + 2 < vIndices.size(); i += 3)
+		fprintf(pFile, "f %u %u %u\n", vIndices[i] + 1, vIndices[i + 1] + 1, vIndices[i + 2] + 1);
+	fclose(pFile);
+
+	return true;
+}
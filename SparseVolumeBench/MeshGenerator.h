@@ -0,0 +1,30 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SVXMesh.h"
+
+//--------------------------------------------------------------------------------------
+// Procedural benchmark meshes. All are closed, so every camera ray crosses an even
+// number of surfaces and the depth complexity is controlled by the shell count.
+//--------------------------------------------------------------------------------------
+namespace MeshGenerator
+{
+	using vfloat3 = std::vector<SVX::float3>;
+	using vuint = std::vector<uint32_t>;
+
+	// uNumShells concentric UV spheres of radius 4 down to 4 / uNumShells around (0, 4, 0)
+	void NestedSpheres(const uint32_t uNumShells, const uint32_t uSegments, vfloat3 &vPositions, vuint &vIndices);
+
+	// A sphere displaced along its normal by a sum of randomly phased waves
+	void NoisyShell(const uint32_t uSegments, const float fAmplitude, const uint32_t uSeed,
+		vfloat3 &vPositions, vuint &vIndices);
+
+	// 1-to-4 midpoint subdivision, uLevels times; shared edges share their midpoints
+	void Tessellate(const uint32_t uLevels, vfloat3 &vPositions, vuint &vIndices);
+
+	SVX::spMesh CreateMesh(const vfloat3 &vPositions, const vuint &vIndices);
+	bool WriteOBJ(const char *pszFilename, const vfloat3 &vPositions, const vuint &vIndices);
+}
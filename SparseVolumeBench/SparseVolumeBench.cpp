@@ -0,0 +1,1472 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+// Benchmarks of the CPU core over procedural meshes: OBJ import, depth peeling and
+// interval integration, swept over mesh size, resolution, K, thread count, light count
+// and depth complexity. Results go to stdout and optionally to CSV and JSON files with
+// the schema of BenchReport.h.
+//
+// Usage: SparseVolumeBench [--quick] [--suite name]... [--repeat N] [--bunny file.obj]
+//		[--csv file.csv] [--json file.json]
+//
+// Suites: loader, peel, integrate, threads, lights, transmission, balance, framegraph, solid,
+// packets, morton, lod, sdf, filter, arena (default: all)
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <thread>
+#include "ObjLoader.h"
+#include "SVXBVH.h"
+#include "SVXDistanceField.h"
+#include "SVXFile.h"
+#include "SVXLayeredDepth.h"
+#include "SVXLRUCache.h"
+#include "SVXVoxelOctree.h"
+#include "SVXRenderer.h"
+#include "SVXScheduler.h"
+#include "SVXTransmission.h"
+#include "MeshGenerator.h"
+#include "BenchReport.h"
+
+using namespace std;
+using namespace SVX;
+using namespace MeshGenerator;
+
+struct Options
+{
+	const char		*pszBunny;
+	const char		*pszCSV;
+	const char		*pszJSON;
+	vector<string>	vSuites;
+	bool			bQuick;
+	uint32_t		uRepeats;
+};
+
+struct BenchMesh
+{
+	string		strName;
+	vfloat3		vPositions;
+	vuint		vIndices;
+	spMesh		pMesh;
+	uint32_t	uTriangles;
+};
+
+struct Resolution
+{
+	uint32_t	uWidth;
+	uint32_t	uHeight;
+};
+
+static void printUsage()
+{
+	fprintf(stderr, "Usage: SparseVolumeBench [--quick] [--suite name]... [--repeat N] [--bunny file.obj]\n"
+		"\t[--csv file.csv] [--json file.json]\n"
+		"Suites: loader, peel, integrate, threads, lights, transmission, balance, framegraph, solid,\n"
+		"        packets, morton, lod, sdf, filter, arena\n");
+}
+
+static bool parseOptions(const int argc, char *argv[], Options &options)
+{
+	options = { "Media/bunny.obj", nullptr, nullptr, vector<string>(0), false, 0 };
+
+	for (auto i = 1; i < argc; ++i)
+	{
+		const string strArg = argv[i];
+		const auto bHasValue = i + 1 < argc;
+		if (strArg == "--quick") options.bQuick = true;
+		else if (strArg == "--suite" && bHasValue) options.vSuites.push_back(argv[++i]);
+		else if (strArg == "--repeat" && bHasValue) options.uRepeats = strtoul(argv[++i], nullptr, 10);
+		else if (strArg == "--bunny" && bHasValue) options.pszBunny = argv[++i];
+		else if (strArg == "--csv" && bHasValue) options.pszCSV = argv[++i];
+		else if (strArg == "--json" && bHasValue) options.pszJSON = argv[++i];
+		else return false;
+	}
+
+	if (!options.uRepeats) options.uRepeats = options.bQuick ? 3 : 5;
+
+	return true;
+}
+
+static bool hasSuite(const Options &options, const char *pszSuite)
+{
+	return options.vSuites.empty() ||
+		find(options.vSuites.cbegin(), options.vSuites.cend(), pszSuite) != options.vSuites.cend();
+}
+
+// Median seconds of uRepeats runs
+template<typename Fn>
+static double timeMedian(const uint32_t uRepeats, const Fn &fn)
+{
+	vector<double> vSeconds(uRepeats);
+	for (auto &fSeconds : vSeconds)
+	{
+		const auto tStart = chrono::high_resolution_clock::now();
+		fn();
+		fSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - tStart).count();
+	}
+	sort(vSeconds.begin(), vSeconds.end());
+
+	return vSeconds[vSeconds.size() / 2];
+}
+
+// Frames the mesh from the direction of the default camera of the viewer
+static Camera frameMesh(const Mesh &mesh)
+{
+	const Camera cameraDefault;
+	Camera camera;
+	camera.vAt = mesh.GetCenter();
+	camera.vEye = camera.vAt + normalize(cameraDefault.vEye - cameraDefault.vAt) * mesh.GetRadius() * 3.5f;
+
+	return camera;
+}
+
+static float4x4 viewProj(const Camera &camera, const Resolution &resolution)
+{
+	const auto fAspect = static_cast<float>(resolution.uWidth) / resolution.uHeight;
+
+	return mul(MatrixLookAtLH(camera.vEye, camera.vAt, camera.vUp),
+		MatrixPerspectiveFovLH(camera.fFovY, fAspect, camera.fZNear, camera.fZFar));
+}
+
+// Mean number of peeled layers over the covered pixels
+static double depthComplexity(const KBuffer &kBuffer)
+{
+	uint64_t uCovered = 0, uLayers = 0;
+	for (auto y = 0u; y < kBuffer.GetHeight(); ++y)
+		for (auto x = 0u; x < kBuffer.GetWidth(); ++x)
+		{
+			const auto pLayers = kBuffer.GetLayers(x, y);
+			if (pLayers[0] >= 1.0f) continue;
+			++uCovered;
+			for (auto i = 0u; i < kBuffer.GetNumLayers() && pLayers[i] < 1.0f; ++i) ++uLayers;
+		}
+
+	return uCovered > 0 ? static_cast<double>(uLayers) / uCovered : 0.0;
+}
+
+// Lights on a cone around the default light of the viewer
+static vector<Light> createLights(const uint32_t uNumLights)
+{
+	const Light lightDefault = { float3(10.0f, 45.0f, 75.0f), float3(1.0f) };
+	const auto fRadius = length(lightDefault.vPosition);
+	vector<Light> vLights(uNumLights, lightDefault);
+	for (auto i = 1u; i < uNumLights; ++i)
+	{
+		const auto fAngle = 2.0f * 3.14159265f * i / uNumLights;
+		const auto vDir = float3(0.6f * cos(fAngle), 0.6f, 0.6f * sin(fAngle) + 0.5f);
+		vLights[i].vPosition = normalize(vDir) * fRadius;
+		vLights[i].vColor = float3(1.0f / uNumLights);
+	}
+	if (uNumLights > 1) vLights[0].vColor = float3(1.0f / uNumLights);
+
+	return vLights;
+}
+
+static void addMesh(vector<BenchMesh> &vMeshes, const string &strName, vfloat3 &vPositions, vuint &vIndices)
+{
+	BenchMesh mesh;
+	mesh.strName = strName;
+	mesh.vPositions.swap(vPositions);
+	mesh.vIndices.swap(vIndices);
+	mesh.pMesh = CreateMesh(mesh.vPositions, mesh.vIndices);
+	mesh.uTriangles = static_cast<uint32_t>(mesh.vIndices.size() / 3);
+	vMeshes.push_back(move(mesh));
+}
+
+static void createMeshes(const Options &options, vector<BenchMesh> &vMeshes)
+{
+	vfloat3 vPositions;
+	vuint vIndices;
+
+	// Depth complexity: 2, 4, 8 and 16 surfaces along a central ray
+	const auto uSegments = options.bQuick ? 64u : 128u;
+	for (auto uShells = 1u; uShells <= (options.bQuick ? 4u : 8u); uShells *= 2)
+	{
+		NestedSpheres(uShells, uSegments, vPositions, vIndices);
+		addMesh(vMeshes, "spheres" + to_string(uShells) + "_s" + to_string(uSegments), vPositions, vIndices);
+	}
+
+	// Mesh size at a fixed depth complexity
+	if (!options.bQuick)
+	{
+		NestedSpheres(1, 512, vPositions, vIndices);
+		addMesh(vMeshes, "spheres1_s512", vPositions, vIndices);
+	}
+
+	NoisyShell(options.bQuick ? 64 : 256, 0.15f, 1, vPositions, vIndices);
+	addMesh(vMeshes, "noisy_s" + to_string(options.bQuick ? 64 : 256), vPositions, vIndices);
+
+	// Tessellated bunny
+	ObjLoader objLoader;
+	if (!objLoader.Import(options.pszBunny, false, false))
+	{
+		fprintf(stderr, "Skipping the bunny meshes: failed to load %s\n", options.pszBunny);
+		return;
+	}
+
+	const auto pVertices = objLoader.GetVertices();
+	const auto uStride = objLoader.GetVertexStride();
+	vfloat3 vBunnyPositions(objLoader.GetNumVertices());
+	for (auto i = 0u; i < objLoader.GetNumVertices(); ++i)
+		memcpy(&vBunnyPositions[i], &pVertices[uStride * i], sizeof(float3));
+	const vuint vBunnyIndices(objLoader.GetIndices(), objLoader.GetIndices() + objLoader.GetNumIndices());
+
+	for (auto uLevels = 0u; uLevels <= (options.bQuick ? 1u : 2u); ++uLevels)
+	{
+		vPositions = vBunnyPositions;
+		vIndices = vBunnyIndices;
+		Tessellate(uLevels, vPositions, vIndices);
+		addMesh(vMeshes, "bunny_t" + to_string(uLevels), vPositions, vIndices);
+	}
+}
+
+static BenchResult makeResult(const char *pszSuite, const BenchMesh *pMesh)
+{
+	BenchResult result = {};
+	result.strSuite = pszSuite;
+	if (pMesh)
+	{
+		result.strMesh = pMesh->strName;
+		result.uTriangles = pMesh->uTriangles;
+	}
+	result.uThreads = 1;
+
+	return result;
+}
+
+static void report(BenchReport &benchReport, const BenchResult &result)
+{
+	benchReport.Print(stdout, result);
+	fflush(stdout);
+	benchReport.Add(result);
+}
+
+//--------------------------------------------------------------------------------------
+// ObjLoader::Import MB/s of the procedural meshes written as OBJ, against the binary
+// mesh cache of the CLI
+//--------------------------------------------------------------------------------------
+static void benchLoader(const Options &options, const vector<BenchMesh> &vMeshes, BenchReport &benchReport)
+{
+	for (const auto &mesh : vMeshes)
+	{
+		const auto strOBJ = "SparseVolumeBench." + mesh.strName + ".obj";
+		const auto strCache = strOBJ + ".svxmesh";
+		if (!WriteOBJ(strOBJ.c_str(), mesh.vPositions, mesh.vIndices))
+		{
+			fprintf(stderr, "Failed to write %s\n", strOBJ.c_str());
+			continue;
+		}
+		const auto uSourceSize = GetFileSize(strOBJ.c_str());
+
+		auto result = makeResult("loader", &mesh);
+		auto bLoaded = true;
+		result.strCase = "obj";
+		result.uRepeats = options.uRepeats;
+		result.fSeconds = timeMedian(options.uRepeats, [&]()
+		{
+			ObjLoader objLoader;
+			bLoaded = objLoader.Import(strOBJ.c_str()) && bLoaded;
+		});
+		result.strMetric = "import";
+		result.fValue = uSourceSize / result.fSeconds / 1e6;
+		result.strUnit = "MB/s";
+		if (bLoaded) report(benchReport, result);
+
+		const auto uSourceStamp = GetFileStamp(strOBJ.c_str());
+		mesh.pMesh->Save(strCache.c_str(), uSourceStamp);
+		const auto uCacheSize = GetFileSize(strCache.c_str());
+		result.strCase = "svxmesh";
+		result.fSeconds = timeMedian(options.uRepeats, [&]()
+		{
+			Mesh meshCached;
+			bLoaded = meshCached.Load(strCache.c_str(), uSourceStamp) && bLoaded;
+		});
+		result.fValue = uCacheSize / result.fSeconds / 1e6;
+		if (bLoaded) report(benchReport, result);
+
+		remove(strOBJ.c_str());
+		remove(strCache.c_str());
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Rasterizer::DepthPeel triangles/s over mesh x resolution x K, and of a view zoomed into
+// a corner of the mesh ("zoom"), with the share of meshlets left by the frustum culling
+//--------------------------------------------------------------------------------------
+static void benchPeel(const Options &options, const vector<BenchMesh> &vMeshes,
+	const vector<Resolution> &vResolutions, const vector<uint32_t> &vNumLayers, BenchReport &benchReport)
+{
+	Rasterizer rasterizer;
+	KBuffer kBuffer;
+	vector<float4> vClipPos;
+	for (const auto &mesh : vMeshes)
+	{
+		const auto camera = frameMesh(*mesh.pMesh);
+		auto cameraZoom = camera;
+		cameraZoom.vAt = lerp(mesh.pMesh->GetCenter(), mesh.pMesh->GetAABBMax(), 0.5f);
+		cameraZoom.fFovY *= 0.25f;
+		for (const auto &resolution : vResolutions)
+			for (const auto &uNumLayers : vNumLayers)
+				for (const auto bZoom : { false, true })
+				{
+					kBuffer.Create(resolution.uWidth, resolution.uHeight, uNumLayers);
+					const auto mViewProj = viewProj(bZoom ? cameraZoom : camera, resolution);
+
+					auto result = makeResult("peel", &mesh);
+					result.strCase = bZoom ? "zoom" : "";
+					result.uWidth = resolution.uWidth;
+					result.uHeight = resolution.uHeight;
+					result.uNumLayers = uNumLayers;
+					result.uRepeats = options.uRepeats;
+					result.fSeconds = timeMedian(options.uRepeats, [&]()
+					{
+						kBuffer.Clear();
+						rasterizer.DepthPeel(*mesh.pMesh, mViewProj, kBuffer);
+					});
+					result.fDepthComplexity = depthComplexity(kBuffer);
+					result.strMetric = "peel";
+					result.fValue = mesh.uTriangles / result.fSeconds / 1e6;
+					result.strUnit = "Mtri/s";
+					report(benchReport, result);
+
+					vClipPos.resize(Rasterizer::GetNumClipPos(*mesh.pMesh));
+					const auto uNumVisible = Rasterizer::TransformVertices(*mesh.pMesh, mViewProj, vClipPos.data());
+					result.strMetric = "meshlets";
+					result.fValue = 100.0 * uNumVisible / (std::max)(mesh.pMesh->GetNumMeshlets(), 1u);
+					result.strUnit = "%";
+					report(benchReport, result);
+				}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Renderer integration pixels/s over mesh x resolution x K, with warm light k-buffers
+//--------------------------------------------------------------------------------------
+static void benchIntegrate(const Options &options, const vector<BenchMesh> &vMeshes,
+	const vector<Resolution> &vResolutions, const vector<uint32_t> &vNumLayers, BenchReport &benchReport)
+{
+	vector<uint8_t> vRGB;
+	for (const auto &mesh : vMeshes)
+	{
+		const auto camera = frameMesh(*mesh.pMesh);
+		for (const auto &resolution : vResolutions)
+			for (const auto &uNumLayers : vNumLayers)
+			{
+				Renderer renderer;
+				renderer.Init(mesh.pMesh, resolution.uWidth, resolution.uHeight, uNumLayers);
+				renderer.Render(camera, vRGB);
+
+				vector<double> vSeconds(options.uRepeats);
+				for (auto &fSeconds : vSeconds)
+				{
+					renderer.Render(camera, vRGB);
+					fSeconds = renderer.GetTimings().fIntegrate / 1000.0;
+				}
+				sort(vSeconds.begin(), vSeconds.end());
+
+				auto result = makeResult("integrate", &mesh);
+				result.uWidth = resolution.uWidth;
+				result.uHeight = resolution.uHeight;
+				result.uNumLayers = uNumLayers;
+				result.uLights = 1;
+				result.fDepthComplexity = depthComplexity(renderer.GetKBuffer());
+				result.uRepeats = options.uRepeats;
+				result.fSeconds = vSeconds[vSeconds.size() / 2];
+				result.strMetric = "integrate";
+				result.fValue = resolution.uWidth * resolution.uHeight / result.fSeconds / 1e6;
+				result.strUnit = "Mpix/s";
+				report(benchReport, result);
+			}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Aggregate frames/s of concurrent renderers sharing the mesh and the light field
+//--------------------------------------------------------------------------------------
+static void benchThreads(const Options &options, const BenchMesh &mesh, const Resolution &resolution,
+	const uint32_t uNumLayers, BenchReport &benchReport)
+{
+	const auto camera = frameMesh(*mesh.pMesh);
+	vector<uint8_t> vRGB;
+	Renderer rendererWarm;
+	rendererWarm.Init(mesh.pMesh, resolution.uWidth, resolution.uHeight, uNumLayers);
+	rendererWarm.Render(camera, vRGB);
+	const auto pLightField = rendererWarm.GetLightField();
+	const vector<Light> vLights(createLights(1));
+
+	const auto uMaxThreads = (std::max)(thread::hardware_concurrency(), 1u);
+	vector<uint32_t> vThreads;
+	for (auto uThreads = 1u; uThreads < uMaxThreads; uThreads *= 2) vThreads.push_back(uThreads);
+	vThreads.push_back(uMaxThreads);
+	if (options.bQuick) vThreads.resize((std::min)(vThreads.size(), static_cast<size_t>(2)));
+
+	for (const auto &uThreads : vThreads)
+	{
+		vector<upRenderer> vRenderers(uThreads);
+		for (auto &pRenderer : vRenderers)
+		{
+			pRenderer = make_unique<Renderer>();
+			pRenderer->Init(mesh.pMesh, resolution.uWidth, resolution.uHeight, uNumLayers);
+			pRenderer->SetLights(vLights, pLightField);
+		}
+
+		auto result = makeResult("threads", &mesh);
+		result.uWidth = resolution.uWidth;
+		result.uHeight = resolution.uHeight;
+		result.uNumLayers = uNumLayers;
+		result.uThreads = uThreads;
+		result.uLights = 1;
+		result.fDepthComplexity = depthComplexity(rendererWarm.GetKBuffer());
+		result.uRepeats = options.uRepeats;
+		result.fSeconds = timeMedian(options.uRepeats, [&]()
+		{
+			vector<thread> vWorkers;
+			for (auto &pRenderer : vRenderers)
+				vWorkers.emplace_back([&pRenderer, &camera]()
+				{
+					vector<uint8_t> vFrame;
+					pRenderer->Render(camera, vFrame);
+				});
+			for (auto &worker : vWorkers) worker.join();
+		});
+		result.strMetric = "frame";
+		result.fValue = static_cast<double>(resolution.uWidth) * resolution.uHeight * uThreads / result.fSeconds / 1e6;
+		result.strUnit = "Mpix/s";
+		report(benchReport, result);
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Light peeling time and integration pixels/s against the light count
+//--------------------------------------------------------------------------------------
+static void benchLights(const Options &options, const BenchMesh &mesh, const Resolution &resolution,
+	const uint32_t uNumLayers, BenchReport &benchReport)
+{
+	const auto camera = frameMesh(*mesh.pMesh);
+	vector<uint8_t> vRGB;
+	for (auto uNumLights = 1u; uNumLights <= (options.bQuick ? 2u : 8u); uNumLights *= 2)
+	{
+		Renderer renderer;
+		renderer.Init(mesh.pMesh, resolution.uWidth, resolution.uHeight, uNumLayers);
+		renderer.SetLights(createLights(uNumLights));
+		renderer.Render(camera, vRGB);
+		const auto fLightPeel = renderer.GetTimings().fLightPeel / 1000.0;
+
+		vector<double> vSeconds(options.uRepeats);
+		for (auto &fSeconds : vSeconds)
+		{
+			renderer.Render(camera, vRGB);
+			fSeconds = renderer.GetTimings().fIntegrate / 1000.0;
+		}
+		sort(vSeconds.begin(), vSeconds.end());
+
+		auto result = makeResult("lights", &mesh);
+		result.uWidth = resolution.uWidth;
+		result.uHeight = resolution.uHeight;
+		result.uNumLayers = uNumLayers;
+		result.uLights = uNumLights;
+		result.fDepthComplexity = depthComplexity(renderer.GetKBuffer());
+		result.uRepeats = 1;
+		result.fSeconds = fLightPeel;
+		result.strCase = "light_peel";
+		result.strMetric = "light_peel";
+		result.fValue = fLightPeel * 1000.0;
+		result.strUnit = "ms";
+		report(benchReport, result);
+
+		result.uRepeats = options.uRepeats;
+		result.fSeconds = vSeconds[vSeconds.size() / 2];
+		result.strCase = "integrate";
+		result.strMetric = "integrate";
+		result.fValue = resolution.uWidth * resolution.uHeight / result.fSeconds / 1e6;
+		result.strUnit = "Mpix/s";
+		report(benchReport, result);
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Throughput and max relative error of the transmission evaluators of SVXTransmission.h
+//--------------------------------------------------------------------------------------
+static void benchTransmission(const Options &options, BenchReport &benchReport)
+{
+	const auto fSigma = 1.0f;
+	const auto fMaxOpticalDepth = 16.0f;
+	const auto uCount = options.bQuick ? 1u << 18 : 1u << 22;
+
+	vector<float> vThickness(uCount), vTransmission(uCount);
+	for (auto i = 0u; i < uCount; ++i) vThickness[i] = fMaxOpticalDepth / fSigma * i / uCount;
+
+	TransmissionLUT lut;
+	lut.Create(fSigma, fMaxOpticalDepth, 1024);
+
+	const auto maxError = [&]()
+	{
+		auto fError = 0.0;
+		for (auto i = 0u; i < uCount; ++i)
+		{
+			const auto fRef = exp(-static_cast<double>(fSigma) * vThickness[i]);
+			fError = (std::max)(fError, abs(vTransmission[i] - fRef) / fRef);
+		}
+
+		return fError;
+	};
+
+	const auto run = [&](const char *pszCase, const function<void()> &evaluate)
+	{
+		auto result = makeResult("transmission", nullptr);
+		result.strCase = pszCase;
+		result.uRepeats = options.uRepeats;
+		result.fSeconds = timeMedian(options.uRepeats, evaluate);
+		result.strMetric = "evaluate";
+		result.fValue = uCount / result.fSeconds / 1e6;
+		result.strUnit = "Meval/s";
+		result.fError = maxError();
+		report(benchReport, result);
+	};
+
+	run("exact", [&]()
+	{
+		for (auto i = 0u; i < uCount; ++i) vTransmission[i] = TransmissionExact(fSigma, vThickness[i]);
+	});
+	run("poly", [&]() { TransmissionPoly(fSigma, vThickness.data(), vTransmission.data(), uCount); });
+	run("lut", [&]()
+	{
+		for (auto i = 0u; i < uCount; ++i) vTransmission[i] = lut.Lookup(vThickness[i]);
+	});
+}
+
+//--------------------------------------------------------------------------------------
+// Load balance of a row-band peel on the scheduler, with up to 32 surfaces per pixel in
+// the top rows of the screen and none below: one contiguous range per thread as static
+// partitioning, against 4-row bands left to work stealing. The value is the busiest
+// thread's peel time over the mean.
+//--------------------------------------------------------------------------------------
+static void benchBalance(const Options &options, const Resolution &resolution,
+	const uint32_t uNumLayers, BenchReport &benchReport)
+{
+	vfloat3 vPositions;
+	vuint vIndices;
+	NestedSpheres(16, options.bQuick ? 64 : 128, vPositions, vIndices);
+	BenchMesh mesh;
+	mesh.strName = "spheres16_corner";
+	mesh.uTriangles = static_cast<uint32_t>(vIndices.size() / 3);
+	mesh.pMesh = CreateMesh(vPositions, vIndices);
+
+	// From afar and looking below the spheres, so that they cover the top rows only
+	auto camera = frameMesh(*mesh.pMesh);
+	const auto fRadius = mesh.pMesh->GetRadius();
+	const auto vDir = normalize(camera.vEye - camera.vAt);
+	camera.vEye = camera.vAt + vDir * fRadius * 8.0f;
+	camera.vAt = camera.vAt - camera.vUp * fRadius * 2.2f;
+	const auto mViewProj = viewProj(camera, resolution);
+
+	KBuffer kBuffer;
+	kBuffer.Create(resolution.uWidth, resolution.uHeight, uNumLayers);
+	const auto uBandHeight = 4u;
+	const auto uNumBands = (resolution.uHeight + uBandHeight - 1) / uBandHeight;
+
+	const auto uMaxThreads = (std::max)(thread::hardware_concurrency(), 4u);
+	vector<uint32_t> vThreads;
+	for (auto uThreads = 2u; uThreads < uMaxThreads; uThreads *= 2) vThreads.push_back(uThreads);
+	vThreads.push_back(uMaxThreads);
+	if (options.bQuick) vThreads.resize((std::min)(vThreads.size(), static_cast<size_t>(2)));
+
+	for (const auto &uThreads : vThreads)
+	{
+		Scheduler scheduler(uThreads);
+		vector<Rasterizer> vRasterizers(uThreads);
+		vector<double> vBusy(uThreads);
+
+		const auto run = [&](const char *pszCase, const uint32_t uGrain)
+		{
+			auto result = makeResult("balance", &mesh);
+			result.strCase = pszCase;
+			result.uWidth = resolution.uWidth;
+			result.uHeight = resolution.uHeight;
+			result.uNumLayers = uNumLayers;
+			result.uThreads = uThreads;
+			result.uRepeats = options.uRepeats;
+			result.fSeconds = timeMedian(options.uRepeats, [&]()
+			{
+				kBuffer.Clear();
+				fill(vBusy.begin(), vBusy.end(), 0.0);
+				scheduler.ParallelFor(0, uNumBands, uGrain, [&](const uint32_t uBegin, const uint32_t uEnd, const uint32_t uThread)
+				{
+					const auto tStart = chrono::high_resolution_clock::now();
+					vRasterizers[uThread].DepthPeel(*mesh.pMesh, mViewProj, kBuffer, uBegin * uBandHeight, uEnd * uBandHeight);
+					vBusy[uThread] += chrono::duration<double>(chrono::high_resolution_clock::now() - tStart).count();
+				});
+			});
+
+			double fMax = 0.0, fSum = 0.0;
+			for (const auto &fBusy : vBusy)
+			{
+				fMax = (std::max)(fMax, fBusy);
+				fSum += fBusy;
+			}
+
+			result.fDepthComplexity = depthComplexity(kBuffer);
+			result.strMetric = "imbalance";
+			result.fValue = fSum > 0.0 ? fMax * uThreads / fSum : 0.0;
+			result.strUnit = "x";
+			report(benchReport, result);
+		};
+
+		run("static", (uNumBands + uThreads - 1) / uThreads);
+		run("stealing", 1);
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Frame time, k-buffer and light field memory of the frame graph, with the view k-buffer
+// retained across frames and with transient bands streamed into the integration
+//--------------------------------------------------------------------------------------
+static void benchFrameGraph(const Options &options, const BenchMesh &mesh, const Resolution &resolution,
+	const uint32_t uNumLayers, BenchReport &benchReport)
+{
+	const auto camera = frameMesh(*mesh.pMesh);
+	vector<uint8_t> vRGB;
+	Renderer rendererWarm;
+	rendererWarm.Init(mesh.pMesh, resolution.uWidth, resolution.uHeight, uNumLayers);
+	rendererWarm.Render(camera, vRGB);
+	const auto pLightField = rendererWarm.GetLightField();
+	const vector<Light> vLights(createLights(1));
+	const auto fDepthComplexity = depthComplexity(rendererWarm.GetKBuffer());
+
+	const vector<uint32_t> vThreads = { 1, (std::max)(thread::hardware_concurrency(), 4u) };
+
+	for (const auto &uThreads : vThreads)
+	{
+		for (const auto bRetain : { true, false })
+		{
+			Renderer renderer;
+			renderer.SetRetainKBuffer(bRetain);
+			renderer.SetNumThreads(uThreads);
+			renderer.Init(mesh.pMesh, resolution.uWidth, resolution.uHeight, uNumLayers);
+			renderer.SetLights(vLights, pLightField);
+			renderer.Render(camera, vRGB);
+
+			auto result = makeResult("framegraph", &mesh);
+			result.strCase = bRetain ? "retained" : "streaming";
+			result.uWidth = resolution.uWidth;
+			result.uHeight = resolution.uHeight;
+			result.uNumLayers = uNumLayers;
+			result.uThreads = uThreads;
+			result.uLights = 1;
+			result.fDepthComplexity = fDepthComplexity;
+			result.uRepeats = options.uRepeats;
+			result.fSeconds = timeMedian(options.uRepeats, [&]() { renderer.Render(camera, vRGB); });
+			result.strMetric = "frame";
+			result.fValue = result.fSeconds * 1000.0;
+			result.strUnit = "ms";
+			report(benchReport, result);
+
+			MemoryTracker memoryTracker;
+			renderer.TrackMemory(memoryTracker, mesh.strName.c_str());
+			result.strMetric = "kBuffer";
+			result.fValue = memoryTracker.GetBytes(MemoryTracker::CATEGORY_K_BUFFER) / (1024.0 * 1024.0);
+			result.strUnit = "MB";
+			report(benchReport, result);
+
+			// Light-space columns, proportional to the surface crossings of the light texels
+			result.strMetric = "lightField";
+			result.fValue = memoryTracker.GetBytes(MemoryTracker::CATEGORY_LIGHT) / (1024.0 * 1024.0);
+			report(benchReport, result);
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// View k-buffer peeled from the mesh against resampled from its solid representations,
+// layered depth images ("ldi"), a sparse voxel octree ("svo") and a triangle BVH ("bvh"),
+// with their build time, memory and the pixels whose layer count differs from the peel;
+// for the BVH also the pixels with more hits than K, which the k-buffer drops
+//--------------------------------------------------------------------------------------
+static void benchSolid(const Options &options, const vector<BenchMesh> &vMeshes,
+	const Resolution &resolution, const uint32_t uNumLayers, BenchReport &benchReport)
+{
+	const auto uResolution = options.bQuick ? 256u : 512u;
+	Scheduler scheduler(1);
+	Rasterizer rasterizer;
+	KBuffer kBufferPeel, kBufferSolid;
+	kBufferPeel.Create(resolution.uWidth, resolution.uHeight, uNumLayers);
+	kBufferSolid.Create(resolution.uWidth, resolution.uHeight, uNumLayers);
+
+	for (const auto &mesh : vMeshes)
+	{
+		VolumeState state;
+		state.uWidth = resolution.uWidth;
+		state.uHeight = resolution.uHeight;
+		state.SetCamera(viewProj(frameMesh(*mesh.pMesh), resolution));
+
+		auto result = makeResult("solid", &mesh);
+		result.uWidth = resolution.uWidth;
+		result.uHeight = resolution.uHeight;
+		result.uNumLayers = uNumLayers;
+		result.uRepeats = options.uRepeats;
+
+		result.strCase = "peel";
+		result.fSeconds = timeMedian(options.uRepeats, [&]()
+		{
+			kBufferPeel.Clear();
+			rasterizer.DepthPeel(*mesh.pMesh, state.mViewProj, kBufferPeel);
+		});
+		result.fDepthComplexity = depthComplexity(kBufferPeel);
+		result.strMetric = "view";
+		result.fValue = result.fSeconds * 1000.0;
+		result.strUnit = "ms";
+		report(benchReport, result);
+
+		// The build and memory rows have no view, so no depth complexity
+		const auto benchRepresentation = [&](Solid &solid, const string &strCase, const function<void()> &create)
+		{
+			result.strCase = strCase;
+			result.fDepthComplexity = 0.0;
+			result.uRepeats = 1;
+			result.fSeconds = timeMedian(1, create);
+			result.strMetric = "build";
+			result.fValue = result.fSeconds * 1000.0;
+			result.strUnit = "ms";
+			report(benchReport, result);
+
+			result.strMetric = "memory";
+			result.fValue = solid.GetBytes() / (1024.0 * 1024.0);
+			result.strUnit = "MB";
+			report(benchReport, result);
+
+			result.uRepeats = options.uRepeats;
+			result.fSeconds = timeMedian(options.uRepeats, [&]()
+			{
+				solid.Resample(state.mViewProj, state.mScreenToWorld, kBufferSolid);
+			});
+			result.fDepthComplexity = depthComplexity(kBufferSolid);
+			result.strMetric = "view";
+			result.fValue = result.fSeconds * 1000.0;
+			result.strUnit = "ms";
+			report(benchReport, result);
+
+			auto uMismatches = 0u;
+			for (auto y = 0u; y < resolution.uHeight; ++y)
+				for (auto x = 0u; x < resolution.uWidth; ++x)
+				{
+					const auto pPeel = kBufferPeel.GetLayers(x, y), pSolid = kBufferSolid.GetLayers(x, y);
+					auto i = 0u;
+					while (i < uNumLayers && (pPeel[i] < 1.0f) == (pSolid[i] < 1.0f) && pPeel[i] < 1.0f) ++i;
+					if (i < uNumLayers && (pPeel[i] < 1.0f) != (pSolid[i] < 1.0f)) ++uMismatches;
+				}
+			result.strMetric = "mismatch";
+			result.fValue = 100.0 * uMismatches / (resolution.uWidth * resolution.uHeight);
+			result.strUnit = "%";
+			report(benchReport, result);
+		};
+
+		LayeredDepth layeredDepth;
+		benchRepresentation(layeredDepth, "ldi" + to_string(uResolution),
+			[&]() { layeredDepth.Create(*mesh.pMesh, uResolution, uNumLayers, scheduler); });
+		VoxelOctree voxelOctree;
+		benchRepresentation(voxelOctree, "svo" + to_string(uResolution),
+			[&]() { voxelOctree.Create(*mesh.pMesh, uResolution, uNumLayers, scheduler); });
+		BVH bvh;
+		benchRepresentation(bvh, "bvh", [&]() { bvh.Create(*mesh.pMesh, scheduler); });
+
+		auto uOverflows = 0u;
+		vector<float> vT;
+		for (auto y = 0u; y < resolution.uHeight; ++y)
+			for (auto x = 0u; x < resolution.uWidth; ++x)
+			{
+				const auto fX = x + 0.5f, fY = y + 0.5f;
+				const auto vNear = TransformCoord(float3(fX, fY, 0.0f), state.mScreenToWorld);
+				bvh.Intersect(vNear, TransformCoord(float3(fX, fY, 1.0f), state.mScreenToWorld) - vNear, 0.0f, 1.0f, vT);
+				if (vT.size() > uNumLayers) ++uOverflows;
+			}
+		result.fDepthComplexity = 0.0;
+		result.strMetric = "overflow";
+		result.fValue = 100.0 * uOverflows / (resolution.uWidth * resolution.uHeight);
+		report(benchReport, result);
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Rays per second on one core through the BVH, single rays against the packets of the
+// camera rays ("camera") and against the streams of rays toward the lights from random
+// points in the bound ("light"); the rays are the same for both
+//--------------------------------------------------------------------------------------
+static void benchPackets(const Options &options, const vector<BenchMesh> &vMeshes,
+	const Resolution &resolution, BenchReport &benchReport)
+{
+	static const uint32_t uTileSize = 32;
+	static const uint32_t uPacketWidth = 4;
+	const auto uPacketHeight = BVH::PACKET_SIZE / uPacketWidth;
+	const auto uNumLightRays = options.bQuick ? 16384u : 65536u;
+	const auto uStreamSize = 4096u;
+	Scheduler scheduler(1);
+
+	for (const auto &mesh : vMeshes)
+	{
+		BVH bvh;
+		bvh.Create(*mesh.pMesh, scheduler);
+
+		VolumeState state;
+		state.uWidth = resolution.uWidth;
+		state.uHeight = resolution.uHeight;
+		state.SetCamera(viewProj(frameMesh(*mesh.pMesh), resolution));
+
+		// Camera rays grouped as BVH::Resample(), 4 x 2 packets in 32 x 32 tiles
+		vector<float3> vOrigins, vDirs;
+		vector<uint32_t> vPackets;
+		for (auto uTileY = 0u; uTileY < resolution.uHeight; uTileY += uTileSize)
+			for (auto uTileX = 0u; uTileX < resolution.uWidth; uTileX += uTileSize)
+				for (auto uY = uTileY; uY < (std::min)(uTileY + uTileSize, resolution.uHeight); uY += uPacketHeight)
+					for (auto uX = uTileX; uX < (std::min)(uTileX + uTileSize, resolution.uWidth); uX += uPacketWidth)
+					{
+						vPackets.push_back(static_cast<uint32_t>(vOrigins.size()));
+						for (auto y = uY; y < (std::min)(uY + uPacketHeight, resolution.uHeight); ++y)
+							for (auto x = uX; x < (std::min)(uX + uPacketWidth, resolution.uWidth); ++x)
+							{
+								const auto fX = x + 0.5f, fY = y + 0.5f;
+								const auto vNear = TransformCoord(float3(fX, fY, 0.0f), state.mScreenToWorld);
+								vOrigins.push_back(vNear);
+								vDirs.push_back(TransformCoord(float3(fX, fY, 1.0f), state.mScreenToWorld) - vNear);
+							}
+					}
+		vPackets.push_back(static_cast<uint32_t>(vOrigins.size()));
+
+		// Light rays from points in the bound to points on a sphere around it
+		vector<float3> vLightOrigins(uNumLightRays), vLightDirs(uNumLightRays);
+		mt19937 rng(1);
+		uniform_real_distribution<float> distribution(0.0f, 1.0f);
+		const auto &vMin = mesh.pMesh->GetAABBMin();
+		const auto vExtent = mesh.pMesh->GetAABBMax() - vMin;
+		for (auto i = 0u; i < uNumLightRays; ++i)
+		{
+			vLightOrigins[i] = vMin + vExtent * float3(distribution(rng), distribution(rng), distribution(rng));
+			const auto fZ = distribution(rng) * 2.0f - 1.0f;
+			const auto fPhi = distribution(rng) * 6.2831853f;
+			const auto fR = sqrt(1.0f - fZ * fZ);
+			const float3 vLightDir(fR * cos(fPhi), fR * sin(fPhi), fZ);
+			vLightDirs[i] = mesh.pMesh->GetCenter() + vLightDir * mesh.pMesh->GetRadius() * 2.0f - vLightOrigins[i];
+		}
+
+		auto result = makeResult("packets", &mesh);
+		result.uWidth = resolution.uWidth;
+		result.uHeight = resolution.uHeight;
+		result.uThreads = 1;
+		result.uRepeats = options.uRepeats;
+		result.strMetric = "rays";
+		result.strUnit = "Mrays/s";
+
+		const auto run = [&](const string &strCase, const uint32_t uNumRays, const function<void()> &trace)
+		{
+			result.strCase = strCase;
+			result.fSeconds = timeMedian(options.uRepeats, trace);
+			result.fValue = uNumRays / result.fSeconds * 1e-6;
+			report(benchReport, result);
+		};
+
+		vector<float> vT;
+		BVH::RayHits hits;
+		const auto uNumCameraRays = static_cast<uint32_t>(vOrigins.size());
+		run("camera_single", uNumCameraRays, [&]()
+		{
+			for (auto i = 0u; i < uNumCameraRays; ++i) bvh.Intersect(vOrigins[i], vDirs[i], 0.0f, 1.0f, vT);
+		});
+		run("camera_packet", uNumCameraRays, [&]()
+		{
+			for (auto i = 0u; i + 1 < vPackets.size(); ++i)
+			{
+				hits.vT.clear();
+				hits.vOffsets.clear();
+				bvh.IntersectPacket(&vOrigins[vPackets[i]], &vDirs[vPackets[i]], vPackets[i + 1] - vPackets[i],
+					0.0f, 1.0f, hits);
+			}
+		});
+		run("light_single", uNumLightRays, [&]()
+		{
+			for (auto i = 0u; i < uNumLightRays; ++i) bvh.Intersect(vLightOrigins[i], vLightDirs[i], 0.0f, 1.0f, vT);
+		});
+		run("light_stream", uNumLightRays, [&]()
+		{
+			for (auto i = 0u; i < uNumLightRays; i += uStreamSize)
+			{
+				hits.vT.clear();
+				hits.vOffsets.clear();
+				bvh.IntersectStream(&vLightOrigins[i], &vLightDirs[i], (std::min)(uStreamSize, uNumLightRays - i),
+					0.0f, 1.0f, hits);
+			}
+		});
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Hit rate of an LRU cache of 16 x 16 screen tiles over the tiles under the bounds of
+// the triangles, taken in the order that a peel scans them
+//--------------------------------------------------------------------------------------
+static double tileHitRate(const Mesh &mesh, const float4 *pClipPos, const Resolution &resolution)
+{
+	static const uint32_t uTileSize = 16;
+	static const uint32_t uCachedTiles = 16;
+	const auto iTilesX = static_cast<int32_t>((resolution.uWidth + uTileSize - 1) / uTileSize);
+	const auto iTilesY = static_cast<int32_t>((resolution.uHeight + uTileSize - 1) / uTileSize);
+
+	LRUCache<int32_t, bool> tileCache(uCachedTiles);
+	const auto pMeshlets = mesh.GetMeshlets();
+	const auto pTriangles = mesh.GetMeshletTriangles();
+	const auto pRanges = pClipPos + mesh.GetNumMeshletVertices();
+	for (auto m = 0u; m < mesh.GetNumMeshlets(); ++m)
+	{
+		const auto &meshlet = pMeshlets[m];
+		if (pRanges[m].x > pRanges[m].y) continue;
+
+		for (auto i = 0u; i < meshlet.uNumTriangles * 3; i += 3)
+		{
+			auto vMin = float3(FLT_MAX), vMax = float3(-FLT_MAX);
+			auto bBehind = false;
+			for (auto j = 0u; j < 3; ++j)
+			{
+				const auto &v = pClipPos[meshlet.uVertexOffset + pTriangles[meshlet.uTriangleOffset + i + j]];
+				bBehind = bBehind || v.w <= 0.0f;
+				const auto vScreen = float3((v.x / v.w * 0.5f + 0.5f) * resolution.uWidth,
+					(0.5f - v.y / v.w * 0.5f) * resolution.uHeight, 0.0f);
+				vMin = (min)(vMin, vScreen);
+				vMax = (max)(vMax, vScreen);
+			}
+			if (bBehind) continue;
+
+			const auto iX0 = (std::max)(static_cast<int32_t>(floor(vMin.x / uTileSize)), 0);
+			const auto iY0 = (std::max)(static_cast<int32_t>(floor(vMin.y / uTileSize)), 0);
+			const auto iX1 = (std::min)(static_cast<int32_t>(floor(vMax.x / uTileSize)), iTilesX - 1);
+			const auto iY1 = (std::min)(static_cast<int32_t>(floor(vMax.y / uTileSize)), iTilesY - 1);
+			for (auto y = iY0; y <= iY1; ++y)
+				for (auto x = iX0; x <= iX1; ++x)
+					if (!tileCache.Find(y * iTilesX + x)) tileCache.Insert(y * iTilesX + x, true);
+		}
+	}
+
+	const auto uLookups = tileCache.GetHits() + tileCache.GetMisses();
+
+	return 100.0 * tileCache.GetHits() / (std::max)(uLookups, static_cast<size_t>(1));
+}
+
+//--------------------------------------------------------------------------------------
+// Peel speed and screen-tile locality of the triangle layout: the index order of the
+// mesh, a random order as from an unsorted OBJ, and that order sorted by Morton code
+//--------------------------------------------------------------------------------------
+static void benchMorton(const Options &options, const vector<BenchMesh> &vMeshes,
+	const Resolution &resolution, BenchReport &benchReport)
+{
+	static const uint32_t uNumLayers = 16;
+	Rasterizer rasterizer;
+	KBuffer kBuffer;
+	kBuffer.Create(resolution.uWidth, resolution.uHeight, uNumLayers);
+	vector<float4> vClipPos;
+	for (const auto &mesh : vMeshes)
+	{
+		// Random triangle and vertex order
+		mt19937 rng(1);
+		vuint vTriangles(mesh.uTriangles), vVertices(mesh.vPositions.size());
+		for (auto i = 0u; i < vTriangles.size(); ++i) vTriangles[i] = i;
+		for (auto i = 0u; i < vVertices.size(); ++i) vVertices[i] = i;
+		shuffle(vTriangles.begin(), vTriangles.end(), rng);
+		shuffle(vVertices.begin(), vVertices.end(), rng);
+
+		vfloat3 vPositions(mesh.vPositions.size());
+		vuint vIndices(mesh.vIndices.size());
+		for (auto i = 0u; i < vVertices.size(); ++i) vPositions[vVertices[i]] = mesh.vPositions[i];
+		for (auto i = 0u; i < vTriangles.size(); ++i)
+			for (auto j = 0u; j < 3; ++j) vIndices[i * 3 + j] = vVertices[mesh.vIndices[vTriangles[i] * 3 + j]];
+
+		const auto pShuffled = CreateMesh(vPositions, vIndices);
+		const auto pMorton = make_shared<Mesh>(*pShuffled);
+		pMorton->SortMorton();
+
+		const auto mViewProj = viewProj(frameMesh(*mesh.pMesh), resolution);
+		const pair<const char*, const Mesh*> layouts[] =
+		{
+			{ "index", mesh.pMesh.get() }, { "shuffled", pShuffled.get() }, { "morton", pMorton.get() }
+		};
+		for (const auto &layout : layouts)
+		{
+			auto result = makeResult("morton", &mesh);
+			result.strCase = layout.first;
+			result.uWidth = resolution.uWidth;
+			result.uHeight = resolution.uHeight;
+			result.uNumLayers = uNumLayers;
+			result.uRepeats = options.uRepeats;
+			result.fSeconds = timeMedian(options.uRepeats, [&]()
+			{
+				kBuffer.Clear();
+				rasterizer.DepthPeel(*layout.second, mViewProj, kBuffer);
+			});
+			result.fDepthComplexity = depthComplexity(kBuffer);
+			result.strMetric = "peel";
+			result.fValue = mesh.uTriangles / result.fSeconds / 1e6;
+			result.strUnit = "Mtri/s";
+			report(benchReport, result);
+
+			vClipPos.resize(Rasterizer::GetNumClipPos(*layout.second));
+			Rasterizer::TransformVertices(*layout.second, mViewProj, vClipPos.data());
+			result.strMetric = "tiles";
+			result.fValue = tileHitRate(*layout.second, vClipPos.data(), resolution);
+			result.strUnit = "%";
+			report(benchReport, result);
+		}
+	}
+}
+
+// Layers of a pixel of the k-buffer
+static uint32_t countLayers(const KBuffer &kBuffer, const uint32_t x, const uint32_t y)
+{
+	const auto pLayers = kBuffer.GetLayers(x, y);
+	auto uCount = 0u;
+	while (uCount < kBuffer.GetNumLayers() && pLayers[uCount] < 1.0f) ++uCount;
+
+	return uCount;
+}
+
+//--------------------------------------------------------------------------------------
+// Peel time of the full mesh against the level of detail selected for a tolerance of one
+// pixel, as the camera backs off; the error is the fraction of covered pixels whose
+// layer count differs from the full mesh
+//--------------------------------------------------------------------------------------
+static void benchLOD(const Options &options, const vector<BenchMesh> &vMeshes,
+	const Resolution &resolution, BenchReport &benchReport)
+{
+	static const uint32_t uNumLayers = 16;
+	static const float fTolerance = 1.0f;
+	Rasterizer rasterizer;
+	KBuffer kBuffer, kBufferLOD;
+	kBuffer.Create(resolution.uWidth, resolution.uHeight, uNumLayers);
+	kBufferLOD.Create(resolution.uWidth, resolution.uHeight, uNumLayers);
+	for (const auto &benchMesh : vMeshes)
+	{
+		if (benchMesh.strName.compare(0, 5, "bunny")) continue;
+
+		auto mesh = *benchMesh.pMesh;
+		auto result = makeResult("lod", &benchMesh);
+		result.uRepeats = 1;
+		result.fSeconds = timeMedian(1, [&]() { mesh.BuildLODs(); });
+		result.strCase = "build";
+		result.strMetric = "simplify";
+		result.fValue = benchMesh.uTriangles / result.fSeconds / 1e6;
+		result.strUnit = "Mtri/s";
+		report(benchReport, result);
+
+		const auto cameraNear = frameMesh(mesh);
+		for (const auto fDistance : { 1.0f, 4.0f, 16.0f })
+		{
+			auto camera = cameraNear;
+			camera.vEye = camera.vAt + (cameraNear.vEye - camera.vAt) * fDistance;
+			const auto mViewProj = viewProj(camera, resolution);
+			const auto uLevel = mesh.SelectLOD(mViewProj, resolution.uHeight, fTolerance);
+			const auto &meshLOD = mesh.GetLOD(uLevel);
+
+			result = makeResult("lod", &benchMesh);
+			result.uWidth = resolution.uWidth;
+			result.uHeight = resolution.uHeight;
+			result.uNumLayers = uNumLayers;
+			result.uRepeats = options.uRepeats;
+			result.strMetric = "peel";
+			result.strUnit = "ms";
+
+			const auto strDistance = "d" + to_string(static_cast<uint32_t>(fDistance));
+			result.strCase = strDistance + "_full";
+			result.fSeconds = timeMedian(options.uRepeats, [&]()
+			{
+				kBuffer.Clear();
+				rasterizer.DepthPeel(mesh, mViewProj, kBuffer);
+			});
+			result.fDepthComplexity = depthComplexity(kBuffer);
+			result.fValue = result.fSeconds * 1e3;
+			report(benchReport, result);
+
+			result.strCase = strDistance + "_lod" + to_string(uLevel);
+			result.fSeconds = timeMedian(options.uRepeats, [&]()
+			{
+				kBufferLOD.Clear();
+				rasterizer.DepthPeel(meshLOD, mViewProj, kBufferLOD);
+			});
+			result.fDepthComplexity = depthComplexity(kBufferLOD);
+			result.fValue = result.fSeconds * 1e3;
+
+			uint64_t uCovered = 0, uDiffers = 0;
+			for (auto y = 0u; y < resolution.uHeight; ++y)
+				for (auto x = 0u; x < resolution.uWidth; ++x)
+				{
+					const auto uLayers = countLayers(kBuffer, x, y);
+					uCovered += uLayers > 0 ? 1 : 0;
+					uDiffers += uLayers != countLayers(kBufferLOD, x, y) ? 1 : 0;
+				}
+			result.fError = static_cast<double>(uDiffers) / (std::max)(uCovered, static_cast<uint64_t>(1));
+			report(benchReport, result);
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Light-path thicknesses sphere-traced in signed distance fields of a few resolutions
+// against the peeled light field: bake time, cold frame and integration time, the mean
+// thickness error over random points of the bound relative to the mean thickness, and
+// the mean difference of the frame per channel relative to full scale
+//--------------------------------------------------------------------------------------
+static void benchDistanceField(const Options &options, const vector<BenchMesh> &vMeshes,
+	const Resolution &resolution, const uint32_t uNumLayers, BenchReport &benchReport)
+{
+	static const uint32_t uNumPoints = 4096;
+	const auto vLights = createLights(1);
+	const auto vLightDir = normalize(vLights[0].vPosition);
+	Scheduler scheduler(1);
+	for (const auto &benchMesh : vMeshes)
+	{
+		if (benchMesh.strName.compare(0, 5, "bunny")) continue;
+
+		const auto &mesh = *benchMesh.pMesh;
+		const auto camera = frameMesh(mesh);
+		Renderer renderer;
+		renderer.Init(benchMesh.pMesh, resolution.uWidth, resolution.uHeight, uNumLayers);
+
+		// Cold frames, the lights set again before each so that the light field is peeled
+		vector<uint8_t> vRGB;
+		double fIntegrate = 0.0;
+		const auto renderCold = [&]()
+		{
+			vector<double> vIntegrate;
+			const auto fSeconds = timeMedian(options.uRepeats, [&]()
+			{
+				renderer.SetLights(vLights);
+				renderer.Render(camera, vRGB);
+				vIntegrate.push_back(renderer.GetTimings().fIntegrate);
+			});
+			sort(vIntegrate.begin(), vIntegrate.end());
+			fIntegrate = vIntegrate[vIntegrate.size() / 2];
+
+			return fSeconds;
+		};
+
+		auto result = makeResult("sdf", &benchMesh);
+		result.uWidth = resolution.uWidth;
+		result.uHeight = resolution.uHeight;
+		result.uNumLayers = uNumLayers;
+		result.uLights = 1;
+		result.uRepeats = options.uRepeats;
+		result.fSeconds = renderCold();
+		result.fDepthComplexity = depthComplexity(renderer.GetKBuffer());
+		result.strCase = "light_field";
+		result.strMetric = "frame";
+		result.fValue = result.fSeconds * 1e3;
+		result.strUnit = "ms";
+		report(benchReport, result);
+
+		result.strMetric = "integrate";
+		result.fValue = fIntegrate;
+		report(benchReport, result);
+
+		const auto pLightField = renderer.GetLightField();
+		const auto vRGBRef = vRGB;
+
+		// Random points of the bound, with their thicknesses toward the light in the light field
+		mt19937 rng(1);
+		uniform_real_distribution<float> distribution(0.0f, 1.0f);
+		vector<float3> vPoints(uNumPoints);
+		vector<float> vThicknessRef(uNumPoints);
+		auto fMeanRef = 0.0;
+		for (auto i = 0u; i < uNumPoints; ++i)
+		{
+			const auto vRand = float3(distribution(rng), distribution(rng), distribution(rng));
+			vPoints[i] = mesh.GetAABBMin() + (mesh.GetAABBMax() - mesh.GetAABBMin()) * vRand;
+			vThicknessRef[i] = pLightField->GetThickness(vPoints[i], 0);
+			fMeanRef += vThicknessRef[i];
+		}
+
+		for (const auto uResolution : { 64u, 128u })
+		{
+			const auto strResolution = "r" + to_string(uResolution);
+			const auto pDistanceField = make_shared<DistanceField>();
+			result.uRepeats = 1;
+			result.fSeconds = timeMedian(1, [&]() { pDistanceField->Create(mesh, uResolution, scheduler); });
+			result.strCase = "bake_" + strResolution;
+			result.strMetric = "bake";
+			result.fValue = result.fSeconds * 1e3;
+			auto fError = 0.0;
+			for (auto i = 0u; i < uNumPoints; ++i)
+				fError += fabs(pDistanceField->TraceThickness(vPoints[i], vLightDir) - vThicknessRef[i]);
+			result.fError = fError / (std::max)(fMeanRef, 1e-6);
+			report(benchReport, result);
+
+			renderer.SetDistanceField(pDistanceField);
+			result.uRepeats = options.uRepeats;
+			result.fSeconds = renderCold();
+			result.strCase = "sdf_" + strResolution;
+			result.strMetric = "frame";
+			result.fValue = result.fSeconds * 1e3;
+			auto fDiff = 0.0;
+			for (auto i = 0u; i < vRGB.size(); ++i) fDiff += abs(vRGB[i] - vRGBRef[i]);
+			result.fError = fDiff / (255.0 * vRGB.size());
+			report(benchReport, result);
+
+			result.strMetric = "integrate";
+			result.fValue = fIntegrate;
+			report(benchReport, result);
+			renderer.SetDistanceField(nullptr);
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Light-space thickness filters of CSRender against SHADOW_MAP_SIZE, on the light field of
+// a sphere with the ortho light frustum spanning 3 radii: point sampling and the edge-aware
+// filter over the interval columns, as in CSRender, against LightField::GetThickness, which
+// is bilinear. The reference is the exact thickness along the light ray through the BVH
+// of the same mesh, so the error is that of the filter, averaged over random points of the
+// bound and relative to the diameter. The value is the time per lookup.
+//--------------------------------------------------------------------------------------
+static void benchFilter(const Options &options, BenchReport &benchReport)
+{
+	static const uint32_t uNumPoints = 1 << 16;
+	static const float fEdgeTol = 0.25f;	// g_fThicknessEdgeTol of SharedConst.h
+
+	vfloat3 vPositions;
+	vuint vIndices;
+	NestedSpheres(1, 256, vPositions, vIndices);
+	const auto pMesh = CreateMesh(vPositions, vIndices);
+	const auto uTriangles = static_cast<uint32_t>(vIndices.size() / 3);
+	const auto fDiameter = pMesh->GetRadius() * 2.0f;
+
+	Scheduler scheduler(1);
+	BVH bvh;
+	bvh.Create(*pMesh, scheduler);
+
+	// Random points of the bound, with the exact thickness in front of them along the light
+	// ray, a hit left unpaired being an entry before the point
+	const auto vLights = createLights(1);
+	const auto vLightDir = normalize(vLights[0].vPosition);
+	mt19937 rng(1);
+	uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	vector<float3> vPoints(uNumPoints);
+	vector<float> vThicknessRef(uNumPoints);
+	vector<float> vHits;
+	for (auto i = 0u; i < uNumPoints; ++i)
+	{
+		const auto vRand = float3(distribution(rng), distribution(rng), distribution(rng));
+		vPoints[i] = pMesh->GetAABBMin() + (pMesh->GetAABBMax() - pMesh->GetAABBMin()) * vRand;
+		bvh.Intersect(vPoints[i], vLightDir, 0.0f, fDiameter * 2.0f, vHits);
+		auto fThickness = 0.0f;
+		for (auto j = vHits.size() & 1; j < vHits.size(); j += 2) fThickness += vHits[j + 1] - vHits[j];
+		vThicknessRef[i] = fThickness + (vHits.size() & 1 ? vHits[0] : 0.0f);
+	}
+
+	// The texel of a point, and the weights of its 4 bilinear taps
+	struct Lookup
+	{
+		float3		vPosLS;
+		int32_t		vLoc[2];
+		float		vFrac[2];
+	};
+	const auto lookup = [](const LightField &lightField, const float3 &vPos)
+	{
+		Lookup texel;
+		const auto fSize = static_cast<float>(lightField.vColumns[0].GetWidth());
+		texel.vPosLS = TransformCoord(vPos, lightField.vViewProjs[0]);
+		const float vTexel[] = { (texel.vPosLS.x * 0.5f + 0.5f) * fSize, (0.5f - texel.vPosLS.y * 0.5f) * fSize };
+		for (auto i = 0u; i < 2; ++i)
+		{
+			texel.vLoc[i] = static_cast<int32_t>(floor(vTexel[i] - 0.5f));
+			texel.vFrac[i] = vTexel[i] - 0.5f - texel.vLoc[i];
+		}
+
+		return texel;
+	};
+	const auto tap = [](const LightField &lightField, const Lookup &texel, const int32_t x, const int32_t y)
+	{
+		const auto &columns = lightField.vColumns[0];
+		const auto iMax = static_cast<int32_t>(columns.GetWidth()) - 1;
+
+		return columns.GetThickness((std::min)((std::max)(x, 0), iMax), (std::min)((std::max)(y, 0), iMax),
+			texel.vPosLS.z);
+	};
+
+	const function<float(const LightField&, const float3&)> filters[] =
+	{
+		// Point: the texel under the point
+		[&](const LightField &lightField, const float3 &vPos)
+		{
+			const auto texel = lookup(lightField, vPos);
+			return tap(lightField, texel, texel.vLoc[0] + (texel.vFrac[0] < 0.5f ? 0 : 1),
+				texel.vLoc[1] + (texel.vFrac[1] < 0.5f ? 0 : 1));
+		},
+		[](const LightField &lightField, const float3 &vPos) { return lightField.GetThickness(vPos, 0); },
+		// Edge-aware: bilinear weights times a range weight against the nearest tap
+		[&](const LightField &lightField, const float3 &vPos)
+		{
+			const auto texel = lookup(lightField, vPos);
+			float vThickness[4], vWeight[4];
+			for (auto i = 0u; i < 4; ++i)
+			{
+				const auto u = i & 1, v = i >> 1;
+				vThickness[i] = tap(lightField, texel, texel.vLoc[0] + u, texel.vLoc[1] + v);
+				vWeight[i] = (u ? texel.vFrac[0] : 1.0f - texel.vFrac[0]) * (v ? texel.vFrac[1] : 1.0f - texel.vFrac[1]);
+			}
+			const auto uNearest = (texel.vFrac[0] < 0.5f ? 0 : 1) | (texel.vFrac[1] < 0.5f ? 0 : 2);
+			const auto fThicknessRef = vThickness[uNearest];
+			auto fSum = 0.0f, fWeights = 0.0f;
+			for (auto i = 0u; i < 4; ++i)
+			{
+				const auto fDev = (vThickness[i] - fThicknessRef) / (fEdgeTol * (std::max)(fThicknessRef, 1e-3f));
+				vWeight[i] *= exp(-0.5f * fDev * fDev);
+				fSum += vThickness[i] * vWeight[i];
+				fWeights += vWeight[i];
+			}
+
+			return fSum / fWeights;
+		}
+	};
+	const char *const pszFilters[] = { "point", "bilinear", "edge_aware" };
+
+	for (const auto uSize : { 128u, 256u, 512u, 1024u })
+	{
+		// The light field of a small frame
+		Renderer renderer;
+		renderer.Init(pMesh, 64, 48, 16, uSize);
+		renderer.SetLights(vLights);
+		vector<uint8_t> vRGB;
+		renderer.Render(frameMesh(*pMesh), vRGB);
+		const auto &lightField = *renderer.GetLightField();
+
+		for (auto f = 0u; f < 3; ++f)
+		{
+			auto result = makeResult("filter", nullptr);
+			result.strCase = pszFilters[f] + string("_r") + to_string(uSize);
+			result.strMesh = "spheres1_s256";
+			result.uTriangles = uTriangles;
+			result.uWidth = uSize;
+			result.uHeight = uSize;
+			result.uNumLayers = 16;
+			result.uLights = 1;
+			result.uRepeats = options.uRepeats;
+
+			auto fError = 0.0;
+			result.fSeconds = timeMedian(options.uRepeats, [&]()
+			{
+				fError = 0.0;
+				for (auto i = 0u; i < uNumPoints; ++i)
+					fError += fabs(filters[f](lightField, vPoints[i]) - vThicknessRef[i]);
+			});
+			result.strMetric = "lookup";
+			result.fValue = result.fSeconds / uNumPoints * 1e9;
+			result.strUnit = "ns";
+			result.fError = fError / uNumPoints / fDiameter;
+			report(benchReport, result);
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Heap allocations per frame of the frame arena and the task pool of the scheduler once
+// the renderer is warm, with the retained and streamed k-buffer, and the bytes held by
+// ObjLoader at the end of parsing the bunny
+//--------------------------------------------------------------------------------------
+static void benchArena(const Options &options, const BenchMesh &mesh, const Resolution &resolution,
+	const uint32_t uNumLayers, BenchReport &benchReport)
+{
+	const uint32_t uWarmFrames = 8;
+	const auto camera = frameMesh(*mesh.pMesh);
+	const vector<uint32_t> vThreads = { 1, (std::max)(thread::hardware_concurrency(), 4u) };
+	vector<uint8_t> vRGB;
+
+	for (const auto &uThreads : vThreads)
+	{
+		for (const auto bRetain : { true, false })
+		{
+			Renderer renderer;
+			renderer.SetRetainKBuffer(bRetain);
+			renderer.SetNumThreads(uThreads);
+			renderer.Init(mesh.pMesh, resolution.uWidth, resolution.uHeight, uNumLayers);
+			for (auto i = 0u; i < uWarmFrames; ++i) renderer.Render(camera, vRGB);
+
+			auto result = makeResult("arena", &mesh);
+			result.strCase = bRetain ? "retained" : "streaming";
+			result.uWidth = resolution.uWidth;
+			result.uHeight = resolution.uHeight;
+			result.uNumLayers = uNumLayers;
+			result.uThreads = uThreads;
+			result.uLights = 1;
+			result.uRepeats = options.uRepeats;
+			const auto uNumAllocations = renderer.GetNumFrameAllocations();
+			result.fSeconds = timeMedian(options.uRepeats, [&]() { renderer.Render(camera, vRGB); });
+			result.strMetric = "allocations";
+			result.fValue = static_cast<double>(renderer.GetNumFrameAllocations() - uNumAllocations) / options.uRepeats;
+			result.strUnit = "/frame";
+			report(benchReport, result);
+
+			result.strMetric = "frameArena";
+			result.fValue = renderer.GetFrameArenaBytes() / 1024.0;
+			result.strUnit = "KB";
+			report(benchReport, result);
+		}
+	}
+
+	auto result = makeResult("arena", nullptr);
+	result.strCase = "import";
+	result.uRepeats = 1;
+	ObjLoader objLoader;
+	result.fSeconds = timeMedian(1, [&]() { objLoader.Import(options.pszBunny, false, false); });
+	if (objLoader.GetNumIndices() == 0) return;
+	result.uTriangles = objLoader.GetNumIndices() / 3;
+	result.strMetric = "peak";
+	result.fValue = objLoader.GetPeakBytes() / (1024.0 * 1024.0);
+	result.strUnit = "MB";
+	report(benchReport, result);
+}
+
+int main(int argc, char *argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	vector<BenchMesh> vMeshes;
+	createMeshes(options, vMeshes);
+
+	vector<Resolution> vResolutions = { { 320, 240 } };
+	vector<uint32_t> vNumLayers = { 8, 16 };
+	if (!options.bQuick)
+	{
+		vResolutions.push_back({ 640, 480 });
+		vResolutions.push_back({ 1280, 960 });
+		vNumLayers = { 4, 8, 16, 32 };
+	}
+
+	// The 4-shell spheres: 8 surfaces along the central rays
+	const auto &meshThreads = vMeshes[2];
+	const Resolution resolutionThreads = options.bQuick ? Resolution{ 320, 240 } : Resolution{ 640, 480 };
+
+	BenchReport benchReport;
+	if (hasSuite(options, "loader")) benchLoader(options, vMeshes, benchReport);
+	if (hasSuite(options, "peel")) benchPeel(options, vMeshes, vResolutions, vNumLayers, benchReport);
+	if (hasSuite(options, "integrate")) benchIntegrate(options, vMeshes, vResolutions, vNumLayers, benchReport);
+	if (hasSuite(options, "threads")) benchThreads(options, meshThreads, resolutionThreads, 16, benchReport);
+	if (hasSuite(options, "lights")) benchLights(options, meshThreads, resolutionThreads, 16, benchReport);
+	if (hasSuite(options, "transmission")) benchTransmission(options, benchReport);
+	if (hasSuite(options, "balance")) benchBalance(options, resolutionThreads, 16, benchReport);
+	if (hasSuite(options, "framegraph")) benchFrameGraph(options, meshThreads, resolutionThreads, 16, benchReport);
+	if (hasSuite(options, "solid")) benchSolid(options, vMeshes, resolutionThreads, 16, benchReport);
+	if (hasSuite(options, "packets")) benchPackets(options, vMeshes, resolutionThreads, benchReport);
+	if (hasSuite(options, "morton")) benchMorton(options, vMeshes, resolutionThreads, benchReport);
+	if (hasSuite(options, "lod")) benchLOD(options, vMeshes, resolutionThreads, benchReport);
+	if (hasSuite(options, "sdf")) benchDistanceField(options, vMeshes, resolutionThreads, 16, benchReport);
+	if (hasSuite(options, "filter")) benchFilter(options, benchReport);
+	if (hasSuite(options, "arena")) benchArena(options, meshThreads, resolutionThreads, 16, benchReport);
+
+	if (options.pszCSV && !benchReport.WriteCSV(options.pszCSV))
+		fprintf(stderr, "Failed to write %s\n", options.pszCSV);
+	if (options.pszJSON && !benchReport.WriteJSON(options.pszJSON))
+		fprintf(stderr, "Failed to write %s\n", options.pszJSON);
+
+	return 0;
+}
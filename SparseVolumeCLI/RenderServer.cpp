@@ -0,0 +1,445 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <thread>
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include "ObjLoader.h"
+#include "SVXImageIO.h"
+#include "RenderServer.h"
+
+using namespace std;
+using namespace SVX;
+
+// Depths a job may allocate over its view and light k-buffers, 1 GB
+static const uint64_t g_uMaxLayerValues = 1ull << 28;
+
+#ifndef _WIN32
+// Milliseconds to wait before accepting again when out of descriptors or buffers
+static const uint32_t g_uAcceptBackOff = 100;
+#endif
+
+// Comma separated floats; returns the count, or 0 on trailing garbage
+static uint32_t parseFloats(const char *pszValue, float *pValues, const uint32_t uMax)
+{
+	auto i = 0u;
+	for (char *pszEnd; i < uMax; ++i, pszValue = pszEnd + (*pszEnd == ',' ? 1 : 0))
+	{
+		pValues[i] = strtof(pszValue, &pszEnd);
+		if (pszEnd == pszValue) break;
+	}
+
+	return *pszValue == '\0' ? i : 0;
+}
+
+// Path of the binary cache of a file
+static string getCachePath(const char *pszFilename, const char *pszExtension, const char *pszCacheDir)
+{
+	if (!pszCacheDir || *pszCacheDir == '\0') return string(pszFilename) + pszExtension;
+
+	string strCache = pszCacheDir;
+	if (strCache.back() != '/' && strCache.back() != '\\') strCache += '/';
+	for (auto pszChar = pszFilename; *pszChar; ++pszChar)
+		strCache += strchr("/\\:", *pszChar) ? '_' : *pszChar;
+
+	return strCache + pszExtension;
+}
+
+spMesh ImportMesh(const char *pszFilename, bool *pbParsed, MemoryTracker *pMemoryTracker,
+	const char *pszCacheDir)
+{
+	const auto uSourceStamp = GetFileStamp(pszFilename);
+	if (!uSourceStamp) return nullptr;
+
+	const auto strCache = getCachePath(pszFilename, ".svxmesh", pszCacheDir);
+	const auto pMesh = make_shared<Mesh>();
+	if (pbParsed) *pbParsed = false;
+	if (pMesh->Load(strCache.c_str(), uSourceStamp)) return pMesh;
+
+	// Cache miss: parse the OBJ, keeping only the positions
+	ObjLoader objLoader;
+	if (!objLoader.Import(pszFilename, false, false)) return nullptr;
+	if (pMemoryTracker) pMemoryTracker->Allocate(pszFilename, "ObjLoader",
+		MemoryTracker::CATEGORY_IMPORT, objLoader.GetPeakBytes());
+	pMesh->Create(objLoader.GetVertices(), objLoader.GetVertexStride(), objLoader.GetNumVertices(),
+		objLoader.GetIndices(), objLoader.GetNumIndices());
+	pMesh->BuildLODs();
+	if (pMemoryTracker)
+	{
+		pMemoryTracker->Allocate(pszFilename, "mesh", MemoryTracker::CATEGORY_GEOMETRY, pMesh->GetBytes());
+		pMemoryTracker->Release(pszFilename, "ObjLoader");
+	}
+	pMesh->Save(strCache.c_str(), uSourceStamp);
+	if (pbParsed) *pbParsed = true;
+
+	return pMesh;
+}
+
+// Solid of a mesh through its binary cache, created on a miss
+template<typename T>
+static shared_ptr<T> importSolid(const char *pszFilename, const char *pszExtension, const Mesh &mesh,
+	const uint32_t uResolution, const uint32_t uNumLayers, Scheduler &scheduler, const char *pszCacheDir)
+{
+	const auto uSourceStamp = GetFileStamp(pszFilename);
+	const auto strCache = getCachePath(pszFilename, pszExtension, pszCacheDir);
+	const auto pSolid = make_shared<T>();
+	if (pSolid->Load(strCache.c_str(), uSourceStamp, uResolution, uNumLayers)) return pSolid;
+
+	pSolid->Create(mesh, uResolution, uNumLayers, scheduler);
+	pSolid->Save(strCache.c_str(), uSourceStamp);
+
+	return pSolid;
+}
+
+spLayeredDepth ImportLayeredDepth(const char *pszFilename, const Mesh &mesh,
+	const uint32_t uResolution, const uint32_t uNumLayers, Scheduler &scheduler, const char *pszCacheDir)
+{
+	return importSolid<LayeredDepth>(pszFilename, ".svxldi", mesh, uResolution, uNumLayers, scheduler, pszCacheDir);
+}
+
+spVoxelOctree ImportVoxelOctree(const char *pszFilename, const Mesh &mesh,
+	const uint32_t uResolution, const uint32_t uNumLayers, Scheduler &scheduler, const char *pszCacheDir)
+{
+	return importSolid<VoxelOctree>(pszFilename, ".svxsvo", mesh, uResolution, uNumLayers, scheduler, pszCacheDir);
+}
+
+RenderServer::RenderServer(const size_t uMeshCapacity, const size_t uLightFieldCapacity,
+	const size_t uKBufferCapacity) :
+	m_meshCache(uMeshCapacity),
+	m_lightFieldCache(uLightFieldCapacity),
+	m_kBufferCache(uKBufferCapacity),
+	m_vRGB(0),
+	m_memoryTracker(),
+	m_strCacheDir(),
+	m_vLatencies(0),
+	m_uNumFailed(0),
+	m_tStart(chrono::steady_clock::now())
+{
+	// Jobs are served one at a time, each on all the hardware threads
+	m_renderer.SetNumThreads(0);
+}
+
+RenderServer::~RenderServer()
+{
+}
+
+void RenderServer::SetCacheDirectory(const char *pszCacheDir)
+{
+	m_strCacheDir = pszCacheDir ? pszCacheDir : "";
+}
+
+bool RenderServer::Run(FILE *pIn, FILE *pOut)
+{
+	char szLine[4096];
+	while (fgets(szLine, sizeof(szLine), pIn))
+	{
+		// Trim the line
+		auto pszLine = szLine;
+		while (*pszLine == ' ' || *pszLine == '\t') ++pszLine;
+		auto pszEnd = pszLine + strlen(pszLine);
+		while (pszEnd > pszLine && (pszEnd[-1] == '\n' || pszEnd[-1] == '\r' || pszEnd[-1] == ' ')) *--pszEnd = '\0';
+
+		if (*pszLine == '\0' || *pszLine == '#') continue;
+		if (!strcmp(pszLine, "quit")) return false;
+		if (!strcmp(pszLine, "stats")) printStats(pOut);
+		else if (!strcmp(pszLine, "memory")) m_memoryTracker.PrintReport(pOut);
+		else
+		{
+			string strReply;
+			runJob(pszLine, strReply);
+			fprintf(pOut, "%s\n", strReply.c_str());
+		}
+		fflush(pOut);
+	}
+
+	return true;
+}
+
+#ifndef _WIN32
+bool RenderServer::Listen(const char *pszSocket)
+{
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	if (strlen(pszSocket) >= sizeof(address.sun_path)) return false;
+	strcpy(address.sun_path, pszSocket);
+
+	const auto iSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (iSocket < 0) return false;
+	unlink(pszSocket);
+	if (bind(iSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(iSocket, 4) < 0)
+	{
+		close(iSocket);
+		return false;
+	}
+
+	auto bSuccess = true;
+	for (auto bServing = true; bServing;)
+	{
+		const auto iConnection = accept(iSocket, nullptr, nullptr);
+		if (iConnection < 0)
+		{
+			// Retried at once after a signal or a client gone before being accepted, and after
+			// a back-off when out of descriptors or buffers, which closing connections frees
+			const auto iError = errno;
+			if (iError == EINTR || iError == ECONNABORTED) continue;
+			fprintf(stderr, "Failed to accept a connection on %s: %s\n", pszSocket, strerror(iError));
+			if (iError != EMFILE && iError != ENFILE && iError != ENOBUFS && iError != ENOMEM)
+			{
+				bSuccess = false;
+				break;
+			}
+			this_thread::sleep_for(chrono::milliseconds(g_uAcceptBackOff));
+			continue;
+		}
+
+		// Each stream owns its descriptor, the reply one a duplicate
+		const auto pIn = fdopen(iConnection, "r");
+		const auto iReply = dup(iConnection);
+		const auto pOut = iReply < 0 ? nullptr : fdopen(iReply, "w");
+		if (pIn && pOut) bServing = Run(pIn, pOut);
+		if (pOut) fclose(pOut);
+		else if (iReply >= 0) close(iReply);
+		if (pIn) fclose(pIn);
+		else close(iConnection);
+	}
+
+	close(iSocket);
+	unlink(pszSocket);
+
+	return bSuccess;
+}
+#endif
+
+bool RenderServer::runJob(char *pszJob, string &strReply)
+{
+	const auto tStart = chrono::steady_clock::now();
+
+	// Parse the job
+	string strId = "-", strMesh, strOutput;
+	uint32_t uWidth = 1280, uHeight = 960, uNumLayers = 16, uLightMapSize = 512;
+	Camera camera;
+	vector<Light> vLights;
+	string strError;
+	for (auto pszToken = pszJob; *pszToken && strError.empty();)
+	{
+		// Split the next key=value token in place
+		auto pszNext = pszToken + strcspn(pszToken, " \t");
+		if (*pszNext) *pszNext++ = '\0';
+		pszNext += strspn(pszNext, " \t");
+
+		const auto pszValue = strchr(pszToken, '=');
+		if (!pszValue)
+		{
+			strError = string("malformed ") + pszToken;
+			break;
+		}
+		*pszValue = '\0';
+
+		const string strKey = pszToken;
+		const auto pszArg = pszValue + 1;
+		pszToken = pszNext;
+
+		float vValues[6];
+		if (strKey == "id") strId = pszArg;
+		else if (strKey == "mesh") strMesh = pszArg;
+		else if (strKey == "out") strOutput = pszArg;
+		else if (strKey == "size")
+		{
+			char *pszEnd;
+			uWidth = strtoul(pszArg, &pszEnd, 10);
+			uHeight = *pszEnd == 'x' ? strtoul(pszEnd + 1, nullptr, 10) : 0;
+		}
+		else if (strKey == "k") uNumLayers = strtoul(pszArg, nullptr, 10);
+		else if (strKey == "light-res") uLightMapSize = strtoul(pszArg, nullptr, 10);
+		else if (strKey == "eye" && parseFloats(pszArg, vValues, 3) == 3)
+			camera.vEye = float3(vValues[0], vValues[1], vValues[2]);
+		else if (strKey == "at" && parseFloats(pszArg, vValues, 3) == 3)
+			camera.vAt = float3(vValues[0], vValues[1], vValues[2]);
+		else if (strKey == "fov" && parseFloats(pszArg, vValues, 1) == 1)
+			camera.fFovY = vValues[0] * 3.14159265f / 180.0f;
+		else if (strKey == "light")
+		{
+			const auto uNumValues = parseFloats(pszArg, vValues, 6);
+			if (uNumValues == 3 || uNumValues == 6)
+				vLights.push_back({ float3(vValues[0], vValues[1], vValues[2]),
+					uNumValues == 6 ? float3(vValues[3], vValues[4], vValues[5]) : float3(1.0f) });
+			else strError = "bad light";
+		}
+		else strError = "bad " + strKey;
+	}
+
+	if (vLights.empty()) vLights.push_back({ float3(10.0f, 45.0f, 75.0f), float3(1.0f) });
+
+	if (strError.empty())
+	{
+		const auto uLayerValues = (static_cast<uint64_t>(uWidth) * uHeight +
+			static_cast<uint64_t>(uLightMapSize) * uLightMapSize * vLights.size()) * uNumLayers;
+		if (strMesh.empty() || strOutput.empty()) strError = "mesh and out are required";
+		else if (!uWidth || !uHeight || uNumLayers < 2 || uNumLayers & 1 || !uLightMapSize) strError = "bad dimensions";
+		else if (uLayerValues > g_uMaxLayerValues) strError = "dimensions too large";
+	}
+
+	if (!strError.empty())
+	{
+		++m_uNumFailed;
+		strReply = "error id=" + strId + " " + strError;
+
+		return false;
+	}
+
+	// A job failing to import, render or write is answered, the server serving on
+	try
+	{
+		return renderJob(strId, strMesh, strOutput, uWidth, uHeight, uNumLayers, uLightMapSize,
+			camera, vLights, tStart, strReply);
+	}
+	catch (const exception &e)
+	{
+		++m_uNumFailed;
+		strReply = "error id=" + strId + " " + e.what();
+
+		return false;
+	}
+}
+
+bool RenderServer::renderJob(const string &strId, const string &strMesh, const string &strOutput,
+	const uint32_t uWidth, const uint32_t uHeight, const uint32_t uNumLayers, const uint32_t uLightMapSize,
+	const Camera &camera, const vector<Light> &vLights, const chrono::steady_clock::time_point &tStart,
+	string &strReply)
+{
+	// Mesh, keyed by its path and the stamp of its source, so that an edited OBJ misses
+	// and the assets of its earlier versions are dropped
+	char szKey[256];
+	snprintf(szKey, sizeof(szKey), "|%016llx", static_cast<unsigned long long>(GetFileStamp(strMesh.c_str())));
+	const auto strPrefix = strMesh + "|";
+	const auto strMeshKey = strMesh + szKey;
+	auto bParsed = false;
+	const auto ppMesh = m_meshCache.Find(strMeshKey);
+	const auto bMeshHit = ppMesh != nullptr;
+	auto pMesh = bMeshHit ? *ppMesh : ImportMesh(strMesh.c_str(), &bParsed, &m_memoryTracker,
+		m_strCacheDir.c_str());
+	if (!pMesh)
+	{
+		++m_uNumFailed;
+		strReply = "error id=" + strId + " failed to load " + strMesh;
+
+		return false;
+	}
+	if (!bMeshHit)
+	{
+		const auto isStale = [&strPrefix, &strMeshKey](const string &strKey)
+		{
+			return strKey.compare(0, strPrefix.size(), strPrefix) == 0 &&
+				strKey.compare(0, strMeshKey.size(), strMeshKey) != 0;
+		};
+		m_meshCache.EraseIf([&isStale](const string &strKey, const spMesh &) { return isStale(strKey); });
+		m_lightFieldCache.EraseIf([&isStale](const string &strKey, const spLightField &) { return isStale(strKey); });
+		m_meshCache.Insert(strMeshKey, pMesh);
+	}
+
+	// Scratch k-buffer of the resolution
+	snprintf(szKey, sizeof(szKey), "%ux%ux%u", uWidth, uHeight, uNumLayers);
+	const auto ppKBuffer = m_kBufferCache.Find(szKey);
+	const auto bKBufferHit = ppKBuffer != nullptr;
+	const auto pKBuffer = bKBufferHit ? *ppKBuffer : m_kBufferCache.Insert(szKey, make_shared<KBuffer>());
+
+	// Light field of the mesh version and the lights
+	auto strLightKey = strMeshKey;
+	snprintf(szKey, sizeof(szKey), "|%u|%u", uNumLayers, uLightMapSize);
+	strLightKey += szKey;
+	for (const auto &light : vLights)
+	{
+		snprintf(szKey, sizeof(szKey), "|%g,%g,%g,%g,%g,%g", light.vPosition.x, light.vPosition.y,
+			light.vPosition.z, light.vColor.x, light.vColor.y, light.vColor.z);
+		strLightKey += szKey;
+	}
+	const auto ppLightField = m_lightFieldCache.Find(strLightKey);
+	const auto bLightHit = ppLightField != nullptr;
+
+	m_renderer.Init(pMesh, uWidth, uHeight, uNumLayers, uLightMapSize, pKBuffer);
+	m_renderer.SetLights(vLights, bLightHit ? *ppLightField : nullptr);
+	m_renderer.Render(camera, m_vRGB);
+	if (!bLightHit) m_lightFieldCache.Insert(strLightKey, m_renderer.GetLightField());
+	trackCaches();
+
+	// Output
+	const auto bPNG = strOutput.size() >= 4 && strOutput.compare(strOutput.size() - 4, 4, ".png") == 0;
+	const auto bWritten = bPNG ? WritePNG(strOutput.c_str(), m_vRGB.data(), uWidth, uHeight) :
+		WritePPM(strOutput.c_str(), m_vRGB.data(), uWidth, uHeight);
+	if (!bWritten)
+	{
+		++m_uNumFailed;
+		strReply = "error id=" + strId + " failed to write " + strOutput;
+
+		return false;
+	}
+
+	const auto fLatency = chrono::duration<double, milli>(chrono::steady_clock::now() - tStart).count();
+	m_vLatencies.push_back(fLatency);
+
+	const auto &timings = m_renderer.GetTimings();
+	char szReply[512];
+	snprintf(szReply, sizeof(szReply), "ok id=%s ms=%.2f mesh=%s light=%s kbuffer=%s light-peel=%.2f peel=%.2f integrate=%.2f",
+		strId.c_str(), fLatency, bMeshHit ? "hit" : bParsed ? "parsed" : "binary", bLightHit ? "hit" : "miss",
+		bKBufferHit ? "hit" : "miss", timings.fLightPeel, timings.fPeel, timings.fIntegrate);
+	strReply = szReply;
+
+	return true;
+}
+
+void RenderServer::printStats(FILE *pOut) const
+{
+	const auto fUptime = chrono::duration<double>(chrono::steady_clock::now() - m_tStart).count();
+	const auto uNumJobs = m_vLatencies.size();
+
+	auto vSorted = m_vLatencies;
+	sort(vSorted.begin(), vSorted.end());
+	const auto percentile = [&vSorted](const double fP)
+	{
+		return vSorted.empty() ? 0.0 : vSorted[static_cast<size_t>(fP * (vSorted.size() - 1) + 0.5)];
+	};
+
+	auto fSum = 0.0;
+	for (const auto &fLatency : vSorted) fSum += fLatency;
+
+	fprintf(pOut, "stats jobs=%zu failed=%u uptime=%.1fs throughput=%.2f/s mean=%.2fms p50=%.2fms p95=%.2fms max=%.2fms "
+		"mesh-hits=%zu/%zu light-hits=%zu/%zu kbuffer-hits=%zu/%zu memory=%.1fMB peak=%.1fMB\n", uNumJobs, m_uNumFailed, fUptime,
+		uNumJobs / fUptime, uNumJobs ? fSum / uNumJobs : 0.0, percentile(0.5), percentile(0.95), percentile(1.0),
+		m_meshCache.GetHits(), m_meshCache.GetHits() + m_meshCache.GetMisses(),
+		m_lightFieldCache.GetHits(), m_lightFieldCache.GetHits() + m_lightFieldCache.GetMisses(),
+		m_kBufferCache.GetHits(), m_kBufferCache.GetHits() + m_kBufferCache.GetMisses(),
+		m_memoryTracker.GetBytes() / (1024.0 * 1024.0), m_memoryTracker.GetPeakBytes() / (1024.0 * 1024.0));
+}
+
+// Re-accounts the cached assets, so that evictions are released
+void RenderServer::trackCaches()
+{
+	m_memoryTracker.ReleaseAll();
+	// Mesh keys are the path followed by the stamp of the source
+	m_meshCache.ForEach([this](const string &strKey, const spMesh &pMesh)
+	{
+		m_memoryTracker.Allocate(strKey.substr(0, strKey.find('|')).c_str(), "mesh",
+			MemoryTracker::CATEGORY_GEOMETRY, pMesh->GetBytes());
+	});
+
+	// Light keys are the mesh key followed by the light parameters
+	m_lightFieldCache.ForEach([this](const string &strKey, const spLightField &pLightField)
+	{
+		const auto uSplit = strKey.find('|');
+		const auto uParams = strKey.find('|', uSplit + 1);
+		m_memoryTracker.Allocate(strKey.substr(0, uSplit).c_str(), ("lightField" + strKey.substr(uParams)).c_str(),
+			MemoryTracker::CATEGORY_LIGHT, pLightField->GetBytes());
+	});
+
+	m_kBufferCache.ForEach([this](const string &strKey, const spKBuffer &pKBuffer)
+	{
+		m_memoryTracker.Allocate("scratch", ("kBuffer " + strKey).c_str(), MemoryTracker::CATEGORY_K_BUFFER,
+			pKBuffer->GetBytes());
+	});
+}
@@ -0,0 +1,88 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include "SVXBVH.h"
+#include "SVXLayeredDepth.h"
+#include "SVXLRUCache.h"
+#include "SVXRenderer.h"
+#include "SVXVoxelOctree.h"
+
+// The binary caches derived from a file are written next to it as <file><extension>, or,
+// given an existing cache directory, into it as <file><extension> with the separators and
+// drive colons of the path replaced by '_'
+
+// Imports an OBJ through its binary cache (.svxmesh), creating the cache on a miss; the
+// parser temporaries count towards the peak of the memory tracker
+SVX::spMesh ImportMesh(const char *pszFilename, bool *pbParsed = nullptr,
+	SVX::MemoryTracker *pMemoryTracker = nullptr, const char *pszCacheDir = nullptr);
+
+// Layered depth images of a mesh through their binary cache (.svxldi), peeled on a miss or
+// when the cache has another resolution or layer count
+SVX::spLayeredDepth ImportLayeredDepth(const char *pszFilename, const SVX::Mesh &mesh,
+	const uint32_t uResolution, const uint32_t uNumLayers, SVX::Scheduler &scheduler,
+	const char *pszCacheDir = nullptr);
+
+// Sparse voxel octree of a mesh through its binary cache (.svxsvo), voxelized on a miss or
+// when the cache has another resolution or layer count
+SVX::spVoxelOctree ImportVoxelOctree(const char *pszFilename, const SVX::Mesh &mesh,
+	const uint32_t uResolution, const uint32_t uNumLayers, SVX::Scheduler &scheduler,
+	const char *pszCacheDir = nullptr);
+
+//--------------------------------------------------------------------------------------
+// Long-lived render process. Jobs arrive one per line, as whitespace separated
+// key=value pairs:
+//
+//	mesh=<obj> out=<ppm|png> [id=<tag>] [size=WxH] [k=K] [light-res=N]
+//	[eye=x,y,z] [at=x,y,z] [fov=degrees] [light=x,y,z[,r,g,b]]...
+//
+// plus the commands "stats", "memory" and "quit". Each job is answered with one line, "ok" or
+// "error", carrying its latency and cache hits; a job whose view and light k-buffers
+// would exceed 1 GB is refused. Meshes, light fields and scratch k-buffers are kept in
+// LRU caches, so a repeated job on the same asset skips the parser and the light
+// peeling; the meshes and light fields are keyed by the stamp of the OBJ as well, so
+// an edited OBJ is imported again.
+//--------------------------------------------------------------------------------------
+class RenderServer
+{
+public:
+	RenderServer(const size_t uMeshCapacity = 4, const size_t uLightFieldCapacity = 8,
+		const size_t uKBufferCapacity = 2);
+	virtual ~RenderServer();
+
+	// Directory of the binary mesh caches, nullptr to write them next to the OBJs
+	void SetCacheDirectory(const char *pszCacheDir);
+
+	// Serves the jobs of a stream, returns false once "quit" is received
+	bool Run(FILE *pIn, FILE *pOut);
+#ifndef _WIN32
+	// Serves the connections of a local Unix socket one at a time; false if the socket
+	// cannot be opened or fails
+	bool Listen(const char *pszSocket);
+#endif
+
+protected:
+	bool runJob(char *pszJob, std::string &strReply);
+	bool renderJob(const std::string &strId, const std::string &strMesh, const std::string &strOutput,
+		const uint32_t uWidth, const uint32_t uHeight, const uint32_t uNumLayers, const uint32_t uLightMapSize,
+		const SVX::Camera &camera, const std::vector<SVX::Light> &vLights,
+		const std::chrono::steady_clock::time_point &tStart, std::string &strReply);
+	void printStats(FILE *pOut) const;
+	void trackCaches();
+
+	SVX::LRUCache<std::string, SVX::spMesh>			m_meshCache;
+	SVX::LRUCache<std::string, SVX::spLightField>	m_lightFieldCache;
+	SVX::LRUCache<std::string, SVX::spKBuffer>		m_kBufferCache;
+
+	SVX::Renderer							m_renderer;
+	std::vector<uint8_t>					m_vRGB;
+	SVX::MemoryTracker						m_memoryTracker;
+	std::string								m_strCacheDir;	// Empty next to the OBJs
+
+	std::vector<double>						m_vLatencies;	// Milliseconds per completed job
+	uint32_t								m_uNumFailed;
+	std::chrono::steady_clock::time_point	m_tStart;
+};
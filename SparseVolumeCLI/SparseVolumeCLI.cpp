@@ -0,0 +1,346 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+// Headless batch renderer: renders a camera path over a mesh with the CPU port of the
+// SparseVolumeX pipeline and writes PPM/PNG frames or a raw Y4M stream.
+//
+// Usage: SparseVolumeCLI mesh.obj [--path file | --turntable N] [--size WxH] [--k K]
+//		[--light-res N] [--format ppm|png|y4m] [--out pattern] [--fps N] [--trace file.json]
+//		[--threads N] [--ldi N | --voxels N | --bvh] [--morton] [--lod pixels] [--sdf N]
+//		[--cache dir]
+//	   SparseVolumeCLI --server [--socket path] [--cache dir]
+//
+// The camera path has one frame per line, "eyeX eyeY eyeZ atX atY atZ [fovYDegrees]",
+// '#' starting a comment. Frame patterns take a printf integer, e.g. frame_%04d.png.
+// The passes run on --threads worker threads, by default one per hardware thread.
+// --ldi N resamples every frame from N x N layered depth images of the mesh along the
+// three axes, cached next to it as <mesh>.svxldi, instead of peeling the mesh; --voxels N
+// does so from a sparse voxel octree of N^3 voxels, cached as <mesh>.svxsvo, and --bvh
+// traces the triangles through a bounding volume hierarchy. --morton sorts the triangles
+// along a Morton curve of their centroids before rendering, for coherent rasterization.
+// --lod P peels the coarsest level of detail of the mesh whose error stays within P pixels.
+// --sdf N sphere-traces the light-path thicknesses in a signed distance field of N^3 cells
+// baked from the mesh instead of peeling the light views, a faster approximate preview.
+// The mesh is cached next to it as <mesh>.svxmesh; --cache writes the binary caches into
+// an existing directory instead, see RenderServer.h.
+// The server mode takes render jobs from stdin (or a Unix socket), see RenderServer.h.
+
+#include "SVXImageIO.h"
+#include "RenderServer.h"
+
+using namespace std;
+using namespace SVX;
+
+struct Options
+{
+	const char	*pszMesh;
+	const char	*pszPath;
+	const char	*pszOutput;
+	const char	*pszSocket;
+	const char	*pszTrace;
+	const char	*pszCacheDir;	// nullptr to cache next to the mesh
+	string		strFormat;
+	bool		bServer;
+	uint32_t	uTurntable;
+	uint32_t	uWidth;
+	uint32_t	uHeight;
+	uint32_t	uNumLayers;
+	uint32_t	uLightMapSize;
+	uint32_t	uFPS;
+	uint32_t	uNumThreads;
+	uint32_t	uLayeredDepth;	// Resolution, 0 to peel the mesh
+	uint32_t	uVoxels;		// Resolution, 0 to peel the mesh
+	bool		bBVH;
+	bool		bMorton;
+	float		fLODTolerance;	// Pixels, 0 for the full mesh
+	uint32_t	uDistanceField;	// Resolution, 0 to peel the light views
+	CPUBackend::Evaluator eTransmission;
+};
+
+static void printUsage()
+{
+	fprintf(stderr, "Usage: SparseVolumeCLI mesh.obj [--path file | --turntable N] [--size WxH] [--k K]\n"
+		"\t[--light-res N] [--format ppm|png|y4m] [--out pattern] [--fps N] [--trace file.json]\n"
+		"\t[--threads N] [--ldi N | --voxels N | --bvh] [--morton] [--lod pixels] [--sdf N]\n"
+		"\t[--transmission exact|poly|lut] [--cache dir]\n"
+		"       SparseVolumeCLI --server [--socket path] [--cache dir]\n");
+}
+
+// Whether an output pattern has exactly one integer conversion, for the frame number, and
+// no other than %%, so that it is safe as the format of snprintf
+static bool isFramePattern(const char *pszPattern)
+{
+	auto uNumConversions = 0u;
+	for (auto pszPercent = strchr(pszPattern, '%'); pszPercent; pszPercent = strchr(pszPercent + 1, '%'))
+	{
+		if (pszPercent[1] == '%')
+		{
+			++pszPercent;
+			continue;
+		}
+
+		// Flags and width, as in frame_%04d.ppm
+		pszPercent += strspn(pszPercent + 1, "-+ #0") + 1;
+		pszPercent += strspn(pszPercent, "0123456789");
+		if (*pszPercent == '\0' || !strchr("diu", *pszPercent)) return false;
+		++uNumConversions;
+	}
+
+	return uNumConversions == 1;
+}
+
+static bool parseOptions(const int argc, char *argv[], Options &options)
+{
+	options = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "ppm", false, 0, 1280, 960, 16, 512, 30, 0, 0, 0, false, false, 0.0f, 0,
+		CPUBackend::EVALUATOR_EXACT };
+
+	for (auto i = 1; i < argc; ++i)
+	{
+		const string strArg = argv[i];
+		const auto bHasValue = i + 1 < argc;
+		if (strArg == "--path" && bHasValue) options.pszPath = argv[++i];
+		else if (strArg == "--turntable" && bHasValue) options.uTurntable = strtoul(argv[++i], nullptr, 10);
+		else if (strArg == "--size" && bHasValue)
+		{
+			const auto pszSize = argv[++i];
+			char *pszEnd;
+			options.uWidth = strtoul(pszSize, &pszEnd, 10);
+			options.uHeight = *pszEnd == 'x' ? strtoul(pszEnd + 1, nullptr, 10) : 0;
+		}
+		else if (strArg == "--k" && bHasValue) options.uNumLayers = strtoul(argv[++i], nullptr, 10);
+		else if (strArg == "--light-res" && bHasValue) options.uLightMapSize = strtoul(argv[++i], nullptr, 10);
+		else if (strArg == "--format" && bHasValue) options.strFormat = argv[++i];
+		else if (strArg == "--out" && bHasValue) options.pszOutput = argv[++i];
+		else if (strArg == "--fps" && bHasValue) options.uFPS = strtoul(argv[++i], nullptr, 10);
+		else if (strArg == "--trace" && bHasValue) options.pszTrace = argv[++i];
+		else if (strArg == "--threads" && bHasValue) options.uNumThreads = strtoul(argv[++i], nullptr, 10);
+		else if (strArg == "--ldi" && bHasValue) options.uLayeredDepth = strtoul(argv[++i], nullptr, 10);
+		else if (strArg == "--voxels" && bHasValue) options.uVoxels = strtoul(argv[++i], nullptr, 10);
+		else if (strArg == "--bvh") options.bBVH = true;
+		else if (strArg == "--morton") options.bMorton = true;
+		else if (strArg == "--lod" && bHasValue) options.fLODTolerance = strtof(argv[++i], nullptr);
+		else if (strArg == "--sdf" && bHasValue) options.uDistanceField = strtoul(argv[++i], nullptr, 10);
+		else if (strArg == "--transmission" && bHasValue)
+		{
+			const string strEvaluator = argv[++i];
+			if (strEvaluator == "exact") options.eTransmission = CPUBackend::EVALUATOR_EXACT;
+			else if (strEvaluator == "poly") options.eTransmission = CPUBackend::EVALUATOR_POLY;
+			else if (strEvaluator == "lut") options.eTransmission = CPUBackend::EVALUATOR_LUT;
+			else return false;
+		}
+		else if (strArg == "--server") options.bServer = true;
+		else if (strArg == "--socket" && bHasValue) options.pszSocket = argv[++i];
+		else if (strArg == "--cache" && bHasValue) options.pszCacheDir = argv[++i];
+		else if (strArg[0] != '-' && !options.pszMesh) options.pszMesh = argv[i];
+		else return false;
+	}
+
+	if (options.bServer) return true;
+	if (!options.pszMesh || !options.uWidth || !options.uHeight) return false;
+	if (options.uNumLayers < 2 || options.uNumLayers & 1 || !options.uLightMapSize) return false;
+	if (options.strFormat != "ppm" && options.strFormat != "png" && options.strFormat != "y4m") return false;
+	if (!options.pszOutput) options.pszOutput = options.strFormat == "y4m" ? "-" :
+		options.strFormat == "png" ? "frame_%04d.png" : "frame_%04d.ppm";
+	if (options.strFormat != "y4m" && !isFramePattern(options.pszOutput)) return false;
+
+	return true;
+}
+
+// Fails on a malformed line, and on a path without any frame
+static bool loadPath(const char *pszFilename, vector<Camera> &vCameras)
+{
+	const auto pFile = OpenFile(pszFilename, "r");
+	if (!pFile) return false;
+
+	char szLine[256];
+	while (fgets(szLine, sizeof(szLine), pFile))
+	{
+		const auto pszComment = strchr(szLine, '#');
+		if (pszComment) *pszComment = '\0';
+
+		Camera camera;
+		auto fFovY = 45.0f;
+		auto pszToken = szLine;
+		float vValues[7];
+		auto uNumValues = 0u;
+		for (char *pszEnd; uNumValues < 7; pszToken = pszEnd, ++uNumValues)
+		{
+			vValues[uNumValues] = strtof(pszToken, &pszEnd);
+			if (pszEnd == pszToken) break;
+		}
+
+		if (uNumValues == 0) continue;
+		if (uNumValues < 6)
+		{
+			fclose(pFile);
+			return false;
+		}
+		if (uNumValues > 6) fFovY = vValues[6];
+
+		camera.vEye = float3(vValues[0], vValues[1], vValues[2]);
+		camera.vAt = float3(vValues[3], vValues[4], vValues[5]);
+		camera.fFovY = fFovY * 3.14159265f / 180.0f;
+		vCameras.push_back(camera);
+	}
+	fclose(pFile);
+
+	return !vCameras.empty();
+}
+
+// Orbits the default camera of the viewer around the look-at point
+static void createTurntable(const uint32_t uNumFrames, vector<Camera> &vCameras)
+{
+	const Camera cameraDefault;
+	const auto vOffset = cameraDefault.vEye - cameraDefault.vAt;
+	const auto fRadius = sqrt(vOffset.x * vOffset.x + vOffset.z * vOffset.z);
+	const auto fAngleStart = atan2(vOffset.z, vOffset.x);
+
+	for (auto i = 0u; i < uNumFrames; ++i)
+	{
+		auto camera = cameraDefault;
+		const auto fAngle = fAngleStart + 2.0f * 3.14159265f * i / uNumFrames;
+		camera.vEye = cameraDefault.vAt + float3(fRadius * cos(fAngle), vOffset.y, fRadius * sin(fAngle));
+		vCameras.push_back(camera);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	if (options.bServer)
+	{
+		RenderServer server;
+		server.SetCacheDirectory(options.pszCacheDir);
+#ifndef _WIN32
+		if (options.pszSocket)
+		{
+			if (server.Listen(options.pszSocket)) return 0;
+			fprintf(stderr, "Failed to listen on %s\n", options.pszSocket);
+			return 1;
+		}
+#endif
+		server.Run(stdin, stdout);
+		return 0;
+	}
+
+	// Camera path
+	vector<Camera> vCameras;
+	if (options.pszPath)
+	{
+		if (!loadPath(options.pszPath, vCameras))
+		{
+			fprintf(stderr, "Failed to load the camera path %s\n", options.pszPath);
+			return 1;
+		}
+	}
+	else createTurntable(options.uTurntable > 0 ? options.uTurntable : 1, vCameras);
+
+	// Load the mesh once; only the positions are kept
+	MemoryTracker memoryTracker;
+	const auto pMesh = ImportMesh(options.pszMesh, nullptr, &memoryTracker, options.pszCacheDir);
+	if (!pMesh)
+	{
+		fprintf(stderr, "Failed to load the mesh %s\n", options.pszMesh);
+		return 1;
+	}
+	if (options.bMorton) pMesh->SortMorton();
+
+	Profiler profiler(static_cast<uint32_t>((std::max)(vCameras.size(), static_cast<size_t>(1))));
+	// Frames are written out, so the view k-buffer need not outlive them
+	Renderer renderer;
+	renderer.SetRetainKBuffer(false);
+	renderer.Init(pMesh, options.uWidth, options.uHeight, options.uNumLayers, options.uLightMapSize);
+	renderer.SetProfiler(&profiler);
+	renderer.SetNumThreads(options.uNumThreads);
+	renderer.SetLODTolerance(options.fLODTolerance);
+	renderer.SetTransmission(options.eTransmission);
+	if (options.uLayeredDepth > 0 || options.uVoxels > 0 || options.bBVH)
+	{
+		Scheduler scheduler(options.uNumThreads);
+		if (options.uLayeredDepth > 0) renderer.SetSolid(ImportLayeredDepth(options.pszMesh, *pMesh,
+			options.uLayeredDepth, options.uNumLayers, scheduler, options.pszCacheDir));
+		else if (options.uVoxels > 0) renderer.SetSolid(ImportVoxelOctree(options.pszMesh, *pMesh,
+			options.uVoxels, options.uNumLayers, scheduler, options.pszCacheDir));
+		else
+		{
+			const auto pBVH = make_shared<BVH>();
+			pBVH->Create(*pMesh, scheduler);
+			renderer.SetSolid(pBVH);
+		}
+	}
+	if (options.uDistanceField > 0)
+	{
+		Scheduler scheduler(options.uNumThreads);
+		const auto pDistanceField = make_shared<DistanceField>();
+		pDistanceField->Create(*pMesh, options.uDistanceField, scheduler);
+		renderer.SetDistanceField(pDistanceField);
+	}
+
+	Y4MWriter y4mWriter;
+	const auto bY4M = options.strFormat == "y4m";
+	if (bY4M && !y4mWriter.Open(options.pszOutput, options.uWidth, options.uHeight, options.uFPS))
+	{
+		fprintf(stderr, "Failed to open %s\n", options.pszOutput);
+		return 1;
+	}
+
+	// Timings go to stderr so that the Y4M stream can be piped from stdout
+	fprintf(stderr, "%u frames at %ux%u, K = %u, light maps %u^2\n", static_cast<uint32_t>(vCameras.size()),
+		options.uWidth, options.uHeight, options.uNumLayers, options.uLightMapSize);
+	fprintf(stderr, "frame\tlight peel\tpeel\tintegrate\ttotal (ms)\n");
+
+	vector<uint8_t> vRGB;
+	double fTotal = 0.0;
+	for (auto i = 0u; i < vCameras.size(); ++i)
+	{
+		profiler.BeginFrame();
+		renderer.Render(vCameras[i], vRGB);
+
+		auto bWritten = true;
+		{
+			const Profiler::Scope scope(&profiler, "write");
+			if (bY4M) bWritten = y4mWriter.Write(vRGB.data());
+			else
+			{
+				char szFilename[1024];
+				snprintf(szFilename, sizeof(szFilename), options.pszOutput, i);
+				bWritten = options.strFormat == "png" ?
+					WritePNG(szFilename, vRGB.data(), options.uWidth, options.uHeight) :
+					WritePPM(szFilename, vRGB.data(), options.uWidth, options.uHeight);
+			}
+		}
+
+		if (!bWritten)
+		{
+			fprintf(stderr, "Failed to write frame %u\n", i);
+			return 1;
+		}
+
+		const auto &timings = renderer.GetTimings();
+		const auto fFrame = timings.fFrame;
+		fTotal += fFrame;
+		char szLightPeel[32];
+		snprintf(szLightPeel, sizeof(szLightPeel), "%s", options.uDistanceField > 0 ? "sdf" : "cached");
+		if (timings.fLightPeel > 0.0) snprintf(szLightPeel, sizeof(szLightPeel), "%.2f", timings.fLightPeel);
+		fprintf(stderr, "%u\t%s\t%.2f\t%.2f\t%.2f\n", i, szLightPeel, timings.fPeel, timings.fIntegrate, fFrame);
+		profiler.EndFrame();
+	}
+
+	fprintf(stderr, "Average %.2f ms per frame, light cache %.1f MB\n", fTotal / vCameras.size(),
+		renderer.GetLightCacheBytes() / (1024.0 * 1024.0));
+	profiler.PrintSummary(stderr);
+	renderer.TrackMemory(memoryTracker, options.pszMesh);
+	fprintf(stderr, "\n");
+	memoryTracker.PrintReport(stderr);
+	if (options.pszTrace && !profiler.WriteChromeTrace(options.pszTrace))
+		fprintf(stderr, "Failed to write the trace %s\n", options.pszTrace);
+
+	return 0;
+}
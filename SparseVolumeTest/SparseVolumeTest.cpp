@@ -0,0 +1,495 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+// Unit tests of the CPU core: OBJ import, k-buffer insertion, interval columns against
+// the dense prefix sums of CSThicknessPrefix, the scheduler, the error bounds of the
+// transmission evaluators, and the solid representations resampled against the peel.
+//
+// Usage: SparseVolumeTest [test]... (default: all); exits with 1 if any test fails
+//
+// Tests: objLoader, kBuffer, intervalColumns, scheduler, transmission, solid
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include "ObjLoader.h"
+#include "SVXBVH.h"
+#include "SVXFile.h"
+#include "SVXIntervalColumns.h"
+#include "SVXLayeredDepth.h"
+#include "SVXRasterizer.h"
+#include "SVXRenderer.h"
+#include "SVXScheduler.h"
+#include "SVXTransmission.h"
+#include "SVXVoxelOctree.h"
+#include "MeshGenerator.h"
+
+using namespace std;
+using namespace SVX;
+using namespace MeshGenerator;
+
+struct Test
+{
+	const char	*pszName;
+	bool		(*pfnRun)();
+};
+
+// Reports a failed check of the running test; returns the condition
+static bool expect(const bool bCondition, const char *pszCheck)
+{
+	if (!bCondition) printf("\tfailed: %s\n", pszCheck);
+
+	return bCondition;
+}
+
+static bool writeFile(const char *pszFilename, const char *pszText)
+{
+	const auto pFile = OpenFile(pszFilename, "w");
+	if (!pFile) return false;
+
+	const auto bWritten = fputs(pszText, pFile) >= 0;
+	fclose(pFile);
+
+	return bWritten;
+}
+
+// Number of layers in front of the far plane
+static uint32_t countLayers(const float *pLayers, const uint32_t uNumLayers)
+{
+	auto i = 0u;
+	while (i < uNumLayers && pLayers[i] < 1.0f) ++i;
+
+	return i;
+}
+
+//--------------------------------------------------------------------------------------
+// Every face form of the OBJ reader: polygons fanned into triangles, the texcoord and
+// normal indices skipped, comments and the other statements ignored
+//--------------------------------------------------------------------------------------
+static bool testObjLoader()
+{
+	static const char *const ppszFaces[] =
+	{
+		"f 1 2 3 4\nf 4 3 5\n",
+		"f 1/1 2/2 3/3 4/4\nf 4/4 3/3 5/5\n",
+		"f 1//1 2//2 3//3 4//4\nf 4//4 3//3 5//5\n",
+		"f 1/1/1 2/2/2 3/3/3 4/4/4\nf 4/4/4 3/3/3 5/5/5\n"
+	};
+	static const float vPositions[] = { 0.0f, 0.0f, 0.0f, 2.0f, 0.0f, 0.0f, 2.0f, 1.0f, 0.0f, 0.0f, 1.0f, -3.0f, 1.0f, 4.0f, 0.5f };
+	static const uint32_t vIndices[] = { 0, 1, 2, 0, 2, 3, 3, 2, 4 };
+
+	const char *pszFilename = "SparseVolumeTest.obj";
+	auto bPass = true;
+	for (const auto &pszFaces : ppszFaces)
+	{
+		string strOBJ = "# Test mesh\nmtllib test.mtl\no test\n";
+		for (auto i = 0u; i < 5; ++i)
+		{
+			char szLine[128];
+			snprintf(szLine, sizeof(szLine), "v %g %g %g\nvt 0.5 0.5\nvn 0 0 1\n",
+				vPositions[i * 3], vPositions[i * 3 + 1], vPositions[i * 3 + 2]);
+			strOBJ += szLine;
+		}
+		strOBJ += "usemtl default\ns off\n";
+		strOBJ += pszFaces;
+
+		ObjLoader objLoader;
+		bPass = expect(writeFile(pszFilename, strOBJ.c_str()), "write the OBJ") && bPass;
+		bPass = expect(objLoader.Import(pszFilename), "import") && bPass;
+		bPass = expect(objLoader.GetNumVertices() == 5, "vertex count") && bPass;
+		bPass = expect(objLoader.GetNumIndices() == 9, "index count") && bPass;
+		if (!bPass) break;
+
+		for (auto i = 0u; i < 9; ++i) bPass = expect(objLoader.GetIndices()[i] == vIndices[i], "fanned indices") && bPass;
+		for (auto i = 0u; i < 5; ++i)
+		{
+			const auto pVertex = objLoader.GetVertices() + static_cast<size_t>(objLoader.GetVertexStride()) * i;
+			bPass = expect(!memcmp(pVertex, &vPositions[i * 3], sizeof(float) * 3), "positions") && bPass;
+		}
+
+		const auto &vMin = objLoader.GetAABBMin(), &vMax = objLoader.GetAABBMax();
+		bPass = expect(vMin.x == 0.0f && vMin.y == 0.0f && vMin.z == -3.0f, "bound minimum") && bPass;
+		bPass = expect(vMax.x == 2.0f && vMax.y == 4.0f && vMax.z == 0.5f, "bound maximum") && bPass;
+	}
+	remove(pszFilename);
+
+	ObjLoader objLoader;
+	bPass = expect(!objLoader.Import("SparseVolumeTest.missing.obj"), "missing file") && bPass;
+
+	return bPass;
+}
+
+//--------------------------------------------------------------------------------------
+// The insertion keeps the K nearest depths of any order ascending, also in a band
+//--------------------------------------------------------------------------------------
+static bool testKBuffer()
+{
+	const auto uWidth = 7u, uHeight = 5u, uNumLayers = 8u;
+	mt19937 rng(1);
+	uniform_real_distribution<float> depth(0.0f, 1.0f);
+	uniform_int_distribution<uint32_t> count(0, uNumLayers * 2);
+
+	KBuffer kBuffer;
+	kBuffer.Create(uWidth, uHeight, uNumLayers);
+	vector<vector<float>> vDepths(uWidth * uHeight);
+	for (auto y = 0u; y < uHeight; ++y)
+	{
+		for (auto x = 0u; x < uWidth; ++x)
+		{
+			auto &vPixel = vDepths[y * uWidth + x];
+			vPixel.resize(count(rng));
+			for (auto &fDepth : vPixel)
+			{
+				fDepth = depth(rng);
+				kBuffer.Insert(x, y, fDepth);
+			}
+		}
+	}
+
+	auto bPass = true;
+	for (auto y = 0u; y < uHeight; ++y)
+	{
+		for (auto x = 0u; x < uWidth; ++x)
+		{
+			auto vPixel = vDepths[y * uWidth + x];
+			sort(vPixel.begin(), vPixel.end());
+			vPixel.resize(uNumLayers, 1.0f);
+			bPass = expect(equal(vPixel.cbegin(), vPixel.cend(), kBuffer.GetLayers(x, y)),
+				"the K nearest depths ascending") && bPass;
+		}
+	}
+
+	// Rows [2, 4) of a band, cleared only within it
+	vector<float> vBand(uWidth * 2 * uNumLayers, 0.5f);
+	KBuffer band;
+	band.CreateBand(vBand.data(), uWidth, uHeight, 2, 4, uNumLayers);
+	band.Clear(0, 3);
+	bPass = expect(all_of(vBand.cbegin(), vBand.cbegin() + uWidth * uNumLayers, [](const float f) { return f == 1.0f; }),
+		"band rows cleared") && bPass;
+	bPass = expect(all_of(vBand.cbegin() + uWidth * uNumLayers, vBand.cend(), [](const float f) { return f == 0.5f; }),
+		"band rows past the range kept") && bPass;
+	band.Clear();
+	band.Insert(3, 3, 0.25f);
+	band.Insert(3, 3, 0.125f);
+	bPass = expect(band.GetLayers(3, 3)[0] == 0.125f && band.GetLayers(3, 3)[1] == 0.25f &&
+		&band.GetLayers(3, 3)[0] == &vBand[(uWidth + 3) * uNumLayers], "band insertion") && bPass;
+
+	return bPass;
+}
+
+//--------------------------------------------------------------------------------------
+// Thickness of the run-length columns against the dense prefix sums of
+// CSThicknessPrefix, read as in TexelThickness of CSRender, for columns of any layer
+// count including a trailing unpaired entry
+//--------------------------------------------------------------------------------------
+static bool testIntervalColumns()
+{
+	const auto uWidth = 33u, uHeight = 17u, uNumLayers = 8u;
+	const auto fDepthScale = 12.5f;
+	mt19937 rng(2);
+	uniform_real_distribution<float> depth(0.0f, 1.0f);
+	uniform_int_distribution<uint32_t> count(0, uNumLayers + 2);
+
+	KBuffer kBuffer;
+	kBuffer.Create(uWidth, uHeight, uNumLayers);
+	for (auto y = 0u; y < uHeight; ++y)
+		for (auto x = 0u; x < uWidth; ++x)
+			for (auto i = count(rng); i > 0; --i) kBuffer.Insert(x, y, depth(rng));
+
+	Scheduler scheduler(3);
+	IntervalColumns columns;
+	columns.Create(kBuffer, fDepthScale, scheduler);
+
+	auto bPass = true;
+	vector<float> vPrefix(uNumLayers / 2);
+	for (auto y = 0u; y < uHeight; ++y)
+	{
+		for (auto x = 0u; x < uWidth; ++x)
+		{
+			// Prefix sums of the complete intervals
+			const auto pLayers = kBuffer.GetLayers(x, y);
+			auto fThickness = 0.0f;
+			for (auto i = 0u; i < uNumLayers / 2; ++i)
+			{
+				vPrefix[i] = fThickness;
+				if (pLayers[i * 2] < 1.0f && pLayers[i * 2 + 1] < 1.0f)
+					fThickness += (pLayers[i * 2 + 1] - pLayers[i * 2]) * fDepthScale;
+			}
+			bPass = expect(columns.GetNumCrossings(x, y) == (countLayers(pLayers, uNumLayers) & ~1u),
+				"crossings of the complete intervals") && bPass;
+
+			for (auto j = 0u; j <= 64; ++j)
+			{
+				const auto fDepth = j / 64.0f;
+				auto i = 0u;
+				while (i < uNumLayers / 2 && pLayers[i * 2] <= fDepth) ++i;
+
+				auto fExpected = 0.0f;
+				if (i > 0)
+				{
+					const auto fFront = pLayers[(i - 1) * 2], fBack = pLayers[(i - 1) * 2 + 1];
+					fExpected = vPrefix[i - 1] + (fBack < 1.0f ? ((std::min)(fBack, fDepth) - fFront) * fDepthScale : 0.0f);
+				}
+				const auto fThicknessColumns = columns.GetThickness(x, y, fDepth);
+				bPass = expect(abs(fThicknessColumns - fExpected) <= 1e-5f * (std::max)(fExpected, 1.0f),
+					"thickness as the prefix sums") && bPass;
+				if (!bPass) return false;
+			}
+		}
+	}
+
+	return bPass;
+}
+
+//--------------------------------------------------------------------------------------
+// Loops cover their range once, nested and from outside; dependencies order the tasks
+// and pass exceptions on; waiters outside the workers are not starved of them
+//--------------------------------------------------------------------------------------
+static bool testScheduler()
+{
+	auto bPass = true;
+	for (const auto uNumThreads : { 1u, 2u, 4u })
+	{
+		Scheduler scheduler(uNumThreads);
+
+		// Every index once, with a unique thread per running body
+		const auto uBegin = 3u, uEnd = 10003u;
+		vector<atomic<uint32_t>> vHits(uEnd);
+		vector<atomic<uint32_t>> vBusy(uNumThreads);
+		for (auto &uHits : vHits) uHits = 0;
+		for (auto &uBusy : vBusy) uBusy = 0;
+		atomic<bool> bThreadsValid(true);
+		scheduler.ParallelFor(uBegin, uEnd, 7, [&](const uint32_t uRangeBegin, const uint32_t uRangeEnd, const uint32_t uThread)
+		{
+			if (uThread >= uNumThreads || vBusy[uThread]++ != 0) bThreadsValid = false;
+			for (auto i = uRangeBegin; i < uRangeEnd; ++i) ++vHits[i];
+			if (uThread < uNumThreads) --vBusy[uThread];
+		});
+		auto bCovered = true;
+		for (auto i = 0u; i < uEnd; ++i) bCovered = bCovered && vHits[i] == (i >= uBegin ? 1u : 0u);
+		bPass = expect(bCovered, "each index of a loop once") && bPass;
+		bPass = expect(bThreadsValid, "a unique thread per running body") && bPass;
+
+		// Loops nested in tasks, waited on from outside
+		atomic<uint32_t> uSum(0);
+		vector<spTask> vTasks;
+		for (auto t = 0u; t < 8; ++t)
+			vTasks.push_back(scheduler.Run([&scheduler, &uSum]()
+			{
+				scheduler.ParallelFor(0, 100, 1, [&uSum](const uint32_t uRangeBegin, const uint32_t uRangeEnd, uint32_t)
+				{
+					uSum += uRangeEnd - uRangeBegin;
+				});
+			}));
+		scheduler.Wait(scheduler.WhenAll(vTasks));
+		bPass = expect(uSum == 800, "nested loops") && bPass;
+
+		// A chain runs in order, and a throw skips the successors and reaches Wait()
+		vector<uint32_t> vOrder;
+		auto pTask = scheduler.Run([&vOrder]() { vOrder.push_back(0); });
+		for (auto i = 1u; i < 16; ++i) pTask = scheduler.Then(pTask, [&vOrder, i]() { vOrder.push_back(i); });
+		scheduler.Wait(pTask);
+		auto bOrdered = vOrder.size() == 16;
+		for (auto i = 0u; bOrdered && i < 16; ++i) bOrdered = vOrder[i] == i;
+		bPass = expect(bOrdered, "dependencies in order") && bPass;
+
+		auto bSkipped = true, bThrown = false;
+		const auto pThrow = scheduler.Run([]() { throw runtime_error("test"); });
+		const auto pSkipped = scheduler.Then(pThrow, [&bSkipped]() { bSkipped = false; });
+		try { scheduler.Wait(pSkipped); }
+		catch (const runtime_error &) { bThrown = true; }
+		bPass = expect(bSkipped && bThrown, "exceptions passed on to the successors and Wait()") && bPass;
+
+		// Tasks submitted from a second outside thread while this one waits: the workers
+		// must be woken for each, however the waiters take the notifications
+		atomic<uint32_t> uRun(0);
+		thread submitter([&]()
+		{
+			vector<spTask> vSubmitted;
+			for (auto i = 0u; i < 2000; ++i) vSubmitted.push_back(scheduler.Run([&uRun]() { ++uRun; }));
+			scheduler.Wait(scheduler.WhenAll(vSubmitted));
+		});
+		submitter.join();
+		bPass = expect(uRun == 2000, "tasks submitted from outside") && bPass;
+	}
+
+	return bPass;
+}
+
+//--------------------------------------------------------------------------------------
+// Relative errors of the evaluators within the bounds of SVXTransmission.h
+//--------------------------------------------------------------------------------------
+static bool testTransmission()
+{
+	const auto fSigma = 1.0f;
+	const auto uCount = 1u << 16;
+
+	// The polynomial down to the smallest normal, the LUT over its table
+	auto fErrorExact = 0.0, fErrorPoly = 0.0, fErrorLUT = 0.0;
+	TransmissionLUT lut;
+	lut.Create(fSigma, 16.0f, 1024);
+	for (auto i = 0u; i <= uCount; ++i)
+	{
+		const auto fThickness = 87.0f * i / uCount;
+		const auto fRef = exp(-static_cast<double>(fSigma) * fThickness);
+		fErrorExact = (std::max)(fErrorExact, abs(TransmissionExact(fSigma, fThickness) - fRef) / fRef);
+		fErrorPoly = (std::max)(fErrorPoly, abs(TransmissionPoly(fSigma, fThickness) - fRef) / fRef);
+		if (fThickness <= 16.0f) fErrorLUT = (std::max)(fErrorLUT, abs(lut.Lookup(fThickness) - fRef) / fRef);
+	}
+
+	// The batched polynomial as the scalar one
+	vector<float> vThickness(uCount), vTransmission(uCount);
+	for (auto i = 0u; i < uCount; ++i) vThickness[i] = 16.0f * i / uCount;
+	TransmissionPoly(fSigma, vThickness.data(), vTransmission.data(), uCount);
+	auto bBatched = true;
+	for (auto i = 0u; i < uCount; ++i) bBatched = bBatched && vTransmission[i] == TransmissionPoly(fSigma, vThickness[i]);
+
+	auto bPass = expect(fErrorExact < 1e-6, "exact within 1e-6");
+	bPass = expect(fErrorPoly < 6e-6, "polynomial within 6e-6") && bPass;
+	bPass = expect(fErrorLUT < 3.2e-5, "LUT within 3.2e-5") && bPass;
+	bPass = expect(bBatched, "batched polynomial") && bPass;
+	bPass = expect(lut.Lookup(1e6f) == lut.Lookup(16.0f), "LUT clamped past its table") && bPass;
+
+	return bPass;
+}
+
+//--------------------------------------------------------------------------------------
+// The BVH, LDI and voxel octree resampled against the peel of nested spheres: the layer
+// counts of the pixels, and the depths where they agree
+//--------------------------------------------------------------------------------------
+static bool testSolid()
+{
+	const auto uWidth = 160u, uHeight = 120u, uNumLayers = 16u;
+	vfloat3 vPositions;
+	vuint vIndices;
+	NestedSpheres(3, 64, vPositions, vIndices);
+	const auto pMesh = CreateMesh(vPositions, vIndices);
+
+	// Framed as the benchmarks from the direction of the default camera
+	const Camera cameraDefault;
+	Camera camera;
+	camera.vAt = pMesh->GetCenter();
+	camera.vEye = camera.vAt + normalize(cameraDefault.vEye - cameraDefault.vAt) * pMesh->GetRadius() * 3.5f;
+	VolumeState state;
+	state.uWidth = uWidth;
+	state.uHeight = uHeight;
+	state.SetCamera(mul(MatrixLookAtLH(camera.vEye, camera.vAt, camera.vUp),
+		MatrixPerspectiveFovLH(camera.fFovY, static_cast<float>(uWidth) / uHeight, camera.fZNear, camera.fZFar)));
+
+	KBuffer kBufferPeel;
+	kBufferPeel.Create(uWidth, uHeight, uNumLayers);
+	Rasterizer rasterizer;
+	rasterizer.DepthPeel(*pMesh, state.mViewProj, kBufferPeel);
+
+	Scheduler scheduler(2);
+	BVH bvh;
+	LayeredDepth layeredDepth;
+	VoxelOctree voxelOctree;
+	bvh.Create(*pMesh, scheduler);
+	layeredDepth.Create(*pMesh, 256, uNumLayers, scheduler);
+	voxelOctree.Create(*pMesh, 256, uNumLayers, scheduler);
+
+	// Fraction of the covered pixels with another layer count, and mean depth error in view
+	// units of the others. The BVH intersects the triangles. The others are within a cell
+	// of 1/256 of the bound, but for the rays at a grazing angle to a surface, which cross
+	// the staircase of its cells more than once; the band of such rays has an angular
+	// width, so the mismatches do not vanish with the resolution.
+	struct Case
+	{
+		const char	*pszName;
+		const Solid	*pSolid;
+		double		fMaxMismatch;
+		double		fMaxDepthError;
+	};
+	const Case vCases[] =
+	{
+		{ "bvh", &bvh, 0.001, 1e-4 },
+		{ "ldi", &layeredDepth, 0.04, 0.02 },
+		{ "svo", &voxelOctree, 0.05, 0.02 }
+	};
+
+	const auto toViewZ = [&camera](const float fz)
+	{
+		return camera.fZNear * camera.fZFar / (camera.fZFar - fz * (camera.fZFar - camera.fZNear));
+	};
+
+	auto bPass = true;
+	for (const auto &solidCase : vCases)
+	{
+		KBuffer kBuffer;
+		kBuffer.Create(uWidth, uHeight, uNumLayers);
+		solidCase.pSolid->Resample(state.mViewProj, state.mScreenToWorld, kBuffer);
+
+		auto uCovered = 0u, uMismatches = 0u, uDepths = 0u;
+		auto fDepthError = 0.0;
+		for (auto y = 0u; y < uHeight; ++y)
+		{
+			for (auto x = 0u; x < uWidth; ++x)
+			{
+				const auto pPeel = kBufferPeel.GetLayers(x, y), pSolid = kBuffer.GetLayers(x, y);
+				const auto uCount = countLayers(pPeel, uNumLayers);
+				uCovered += uCount > 0 ? 1 : 0;
+				if (uCount != countLayers(pSolid, uNumLayers))
+				{
+					++uMismatches;
+					continue;
+				}
+				for (auto i = 0u; i < uCount; ++i) fDepthError += abs(toViewZ(pSolid[i]) - toViewZ(pPeel[i]));
+				uDepths += uCount;
+			}
+		}
+
+		const auto fMismatch = static_cast<double>(uMismatches) / (std::max)(uCovered, 1u);
+		fDepthError /= (std::max)(uDepths, 1u);
+		printf("\t%s: %.3f%% layer count mismatch, mean depth error %.5f\n", solidCase.pszName,
+			fMismatch * 100.0, fDepthError);
+		bPass = expect(uCovered > uWidth * uHeight / 4, "the mesh in view") && bPass;
+		bPass = expect(fMismatch <= solidCase.fMaxMismatch, "layer counts as the peel") && bPass;
+		bPass = expect(fDepthError <= solidCase.fMaxDepthError, "depths as the peel") && bPass;
+	}
+
+	return bPass;
+}
+
+static const Test g_vTests[] =
+{
+	{ "objLoader", testObjLoader },
+	{ "kBuffer", testKBuffer },
+	{ "intervalColumns", testIntervalColumns },
+	{ "scheduler", testScheduler },
+	{ "transmission", testTransmission },
+	{ "solid", testSolid }
+};
+
+int main(int argc, char *argv[])
+{
+	vector<const Test*> vTests;
+	for (auto i = 1; i < argc; ++i)
+	{
+		const auto pTest = find_if(begin(g_vTests), end(g_vTests), [&](const Test &test) { return !strcmp(test.pszName, argv[i]); });
+		if (pTest == end(g_vTests))
+		{
+			fprintf(stderr, "Usage: SparseVolumeTest [test]...\nTests:");
+			for (const auto &test : g_vTests) fprintf(stderr, " %s", test.pszName);
+			fprintf(stderr, "\n");
+			return 1;
+		}
+		vTests.push_back(pTest);
+	}
+	if (vTests.empty()) for (const auto &test : g_vTests) vTests.push_back(&test);
+
+	auto uNumFailed = 0u;
+	for (const auto pTest : vTests)
+	{
+		printf("%s\n", pTest->pszName);
+		const auto bPass = pTest->pfnRun();
+		printf("%s %s\n", pTest->pszName, bPass ? "passed" : "FAILED");
+		uNumFailed += bPass ? 0 : 1;
+	}
+	printf("%u of %u tests passed\n", static_cast<uint32_t>(vTests.size()) - uNumFailed, static_cast<uint32_t>(vTests.size()));
+
+	return uNumFailed > 0 ? 1 : 0;
+}
@@ -1,7 +1,5 @@
 ﻿#pragma once
 
-#include <ppltasks.h>	// For create_task
-
 namespace DX
 {
 	inline void ThrowIfFailed(HRESULT hr)
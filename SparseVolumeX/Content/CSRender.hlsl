@@ -10,13 +10,16 @@
 //--------------------------------------------------------------------------------------
 cbuffer cbMatrices
 {
-	matrix	g_mViewProjLS;		// Light space
+	matrix	g_mViewProjLS[NUM_LIGHT_VIEWS];	// Light space, NUM_CASCADE per light
 	matrix	g_mScreenToWorld;	// View-screen space
+	matrix	g_mWorldToScreenPrev;	// View-screen space of the previous frame
+	float4	g_vVolume;			// Density volume origin (xyz) and bricks per unit length (w)
+	float4	g_vLightColors[NUM_LIGHTS];
+	float4	g_vCascadeSplits;	// Far view depths of the cascades
+	uint	g_uFrame;
+	uint	g_uHistoryValid;
 };
 
-static const min16float g_fDensity = 1.0;
-static const float g_fAbsorption = 1.0;
-
 static const min16float3 g_vCornflowerBlue = { 0.392156899, 0.584313750, 0.929411829 };
 static const min16float3 g_vClear = g_vCornflowerBlue * g_vCornflowerBlue;
 
@@ -24,12 +27,31 @@ static const min16float3 g_vClear = g_vCornflowerBlue * g_vCornflowerBlue;
 // Textures
 //--------------------------------------------------------------------------------------
 Texture2DArray<uint>		g_txKBufDepth;		// View-screen space
-Texture2DArray<uint>		g_txKBufDepthLS;	// Light space
+Texture2DArray<uint>		g_txKBufDepthLS;	// Light space, NUM_K_LAYERS slices per light cascade
+Texture2DArray<float>		g_txThicknessPrefix;	// Light space, NUM_K_LAYERS / 2 slices per light cascade
+#if	TEMPORAL
+Texture2D<float4>			g_txHistory;		// Previous linear color (xyz) and view depth (w)
+#endif
+#if	TRANSMISSION == TRANSMISSION_LUT
+Texture2D<float>			g_txTransmission;	// exp(-g_fAbsorption * g_fDensity * thickness)
+#endif
+#if	HETEROGENEOUS
+Texture3D<float>			g_txDensity;		// Brick atlas
+Texture3D<uint>				g_txBrickTable;		// Brick grid to 10:10:10 atlas brick coordinates
+#endif
 
 //--------------------------------------------------------------------------------------
 // Unordered access textures
 //--------------------------------------------------------------------------------------
 RWTexture2D<min16float4>	g_rwPresent;
+#if	TEMPORAL
+RWTexture2D<float4>			g_rwHistory;
+#endif
+
+//--------------------------------------------------------------------------------------
+// Sampler
+//--------------------------------------------------------------------------------------
+SamplerState				g_smpLinear;
 
 //--------------------------------------------------------------------------------------
 // Screen space to loacal space
@@ -57,36 +79,142 @@ float OrthoToViewZ(const float fz)
 	return fz * (g_fZFarLS - g_fZNearLS) + g_fZNearLS;
 }
 
+//--------------------------------------------------------------------------------------
+// Light-path thickness at a light texel
+//--------------------------------------------------------------------------------------
+float TexelThickness(const uint2 vLoc, const float fDepth, const uint uView)
+{
+	const uint uBase = uView * NUM_K_LAYERS;
+
+	// Binary search for the number of intervals starting in front of the point
+	uint uFirst = 0;
+	uint uCount = NUM_K_LAYERS >> 1;
+	while (uCount > 0)
+	{
+		const uint uStep = uCount >> 1;
+		const uint i = uFirst + uStep;
+		if (asfloat(g_txKBufDepthLS[uint3(vLoc, uBase + i * 2)]) <= fDepth)
+		{
+			uFirst = i + 1;
+			uCount -= uStep + 1;
+		}
+		else uCount = uStep;
+	}
+
+	if (uFirst == 0) return 0.0;
+
+	// Thickness in front of the last interval, plus the interval clipped to the point
+	const uint i = uFirst - 1;
+	const float fPrefix = g_txThicknessPrefix[uint3(vLoc, uView * (NUM_K_LAYERS >> 1) + i)];
+	const float fDepthFront = asfloat(g_txKBufDepthLS[uint3(vLoc, uBase + i * 2)]);
+	const float fDepthBack = asfloat(g_txKBufDepthLS[uint3(vLoc, uBase + i * 2 + 1)]);
+	if (fDepthBack >= 1.0) return fPrefix;
+
+	return fPrefix + OrthoToViewZ(min(fDepthBack, fDepth)) - OrthoToViewZ(fDepthFront);
+}
+
 //--------------------------------------------------------------------------------------
 // Compute light-path thickness
 //--------------------------------------------------------------------------------------
-float LightPathThickness(float3 vPos)
+float LightPathThickness(float3 vPos, const float fViewZ, const uint uLight)
 {
-	vPos = mul(float4(vPos, 1.0), g_mViewProjLS).xyz;
+	// Select the cascade by the camera view depth
+	uint uView = uLight * NUM_CASCADE;
+	[unroll]
+	for (uint i = 0; i + 1 < NUM_CASCADE; ++i) uView += fViewZ > g_vCascadeSplits[i] ? 1 : 0;
+
+	vPos = mul(float4(vPos, 1.0), g_mViewProjLS[uView]).xyz;
 	vPos.xy = vPos.xy * float2(0.5, -0.5) + 0.5;
 
-	const uint2 vLoc = vPos.xy * SHADOW_MAP_SIZE;
-	
-	float fThickness = 0.0;
-	for (uint i = 0; i < NUM_K_LAYERS >> 1; ++i)
-	{
-		// Get light-space depths
-		const float fDepthFront = asfloat(g_txKBufDepthLS[uint3(vLoc, i * 2)]);
-		float fDepthBack = asfloat(g_txKBufDepthLS[uint3(vLoc, i * 2 + 1)]);
+#if	THICKNESS_FILTER == THICKNESS_FILTER_POINT
+	return TexelThickness(vPos.xy * SHADOW_MAP_SIZE, vPos.z, uView);
+#else
+	// 4 taps around the point
+	const float2 vTexel = vPos.xy * SHADOW_MAP_SIZE - 0.5;
+	const float2 vFrac = frac(vTexel);
+	const int2 vLoc = floor(vTexel);
 
-		// Clip to the current point
-		if (fDepthFront > vPos.z || fDepthBack >= 1.0) break;
-		fDepthBack = min(fDepthBack, vPos.z);
+	float4 vThickness;
+	vThickness.x = TexelThickness(clamp(vLoc, 0, SHADOW_MAP_SIZE - 1), vPos.z, uView);
+	vThickness.y = TexelThickness(clamp(vLoc + int2(1, 0), 0, SHADOW_MAP_SIZE - 1), vPos.z, uView);
+	vThickness.z = TexelThickness(clamp(vLoc + int2(0, 1), 0, SHADOW_MAP_SIZE - 1), vPos.z, uView);
+	vThickness.w = TexelThickness(clamp(vLoc + 1, 0, SHADOW_MAP_SIZE - 1), vPos.z, uView);
 
-		// Transform to view space
-		const float fZFront = OrthoToViewZ(fDepthFront);
-		const float fZBack = OrthoToViewZ(fDepthBack);
+	float4 vWeight = float4(1.0 - vFrac.x, vFrac.x, 1.0 - vFrac.x, vFrac.x) *
+		float4(1.0 - vFrac.yy, vFrac.yy);
 
-		fThickness += fZBack - fZFront;
-	}
+#if	THICKNESS_FILTER == THICKNESS_FILTER_EDGE_AWARE
+	// Range weights against the nearest tap suppress blending across silhouettes
+	const uint uNearest = (vFrac.x < 0.5 ? 0 : 1) | (vFrac.y < 0.5 ? 0 : 2);
+	const float fThicknessRef = vThickness[uNearest];
+	const float4 vDev = (vThickness - fThicknessRef) / (g_fThicknessEdgeTol * max(fThicknessRef, 1e-3));
+	vWeight *= exp(-0.5 * vDev * vDev);
+#endif
+
+	return dot(vThickness, vWeight) / dot(vWeight, 1.0);
+#endif
+}
+
+//--------------------------------------------------------------------------------------
+// Transmission from thicknesses
+//--------------------------------------------------------------------------------------
+float4 Transmission(const float4 vThickness)
+{
+	const float fSigma = g_fAbsorption * g_fDensity;
+
+#if	TRANSMISSION == TRANSMISSION_POLY
+	// 2^n * p(f) with f in [-0.5, 0.5]
+	const float4 x = max(-fSigma * vThickness * 1.44269504, -126.0);
+	const float4 n = round(x);
+	const float4 f = x - n;
+
+	float4 p = 1.33335581e-3;
+	p = p * f + 9.61812911e-3;
+	p = p * f + 5.55041087e-2;
+	p = p * f + 2.40226507e-1;
+	p = p * f + 6.93147181e-1;
+	p = p * f + 1.0;
+
+	return p * asfloat(asuint(int4(n) + 127) << 23);
+#elif	TRANSMISSION == TRANSMISSION_LUT
+	const float fScale = fSigma / g_fTransmissionLUTMax * (TRANSMISSION_LUT_SIZE - 1.0) / TRANSMISSION_LUT_SIZE;
+	const float4 vTex = vThickness * fScale + 0.5 / TRANSMISSION_LUT_SIZE;
+
+	return float4(
+		g_txTransmission.SampleLevel(g_smpLinear, float2(vTex.x, 0.5), 0.0),
+		g_txTransmission.SampleLevel(g_smpLinear, float2(vTex.y, 0.5), 0.0),
+		g_txTransmission.SampleLevel(g_smpLinear, float2(vTex.z, 0.5), 0.0),
+		g_txTransmission.SampleLevel(g_smpLinear, float2(vTex.w, 0.5), 0.0));
+#else
+	return exp(-vThickness * fSigma);
+#endif
+}
+
+#if	HETEROGENEOUS
+//--------------------------------------------------------------------------------------
+// Relative density from the sparse brick volume, 0 in unallocated bricks
+//--------------------------------------------------------------------------------------
+float Density(const float3 vPos)
+{
+	uint3 vGridSize;
+	g_txBrickTable.GetDimensions(vGridSize.x, vGridSize.y, vGridSize.z);
+
+	const float3 vGrid = (vPos - g_vVolume.xyz) * g_vVolume.w;
+	if (any(vGrid < 0.0) || any(vGrid >= vGridSize)) return 0.0;
 
-	return fThickness;
+	const uint3 vBrick = vGrid;
+	const uint uEntry = g_txBrickTable[vBrick];
+	if (uEntry == 0xffffffff) return 0.0;
+
+	// Bricks store (DENSITY_BRICK_SIZE + 1)^3 vertex samples
+	float3 vAtlasSize;
+	g_txDensity.GetDimensions(vAtlasSize.x, vAtlasSize.y, vAtlasSize.z);
+	const uint3 vAtlasBrick = uint3(uEntry, uEntry >> 10, uEntry >> 20) & 0x3ff;
+	const float3 vTex = vAtlasBrick * (DENSITY_BRICK_SIZE + 1.0) + 0.5 + (vGrid - vBrick) * DENSITY_BRICK_SIZE;
+
+	return g_txDensity.SampleLevel(g_smpLinear, vTex / vAtlasSize, 0.0);
 }
+#endif
 
 //--------------------------------------------------------------------------------------
 // Simpson rule for integral approximation
@@ -96,17 +224,30 @@ min16float Simpson(const min16float4 vf, const float a, const float b)
 	return min16float(b - a) / 8.0 * (vf.x + 3.0 * (vf.y + vf.z) + vf.w);
 }
 
+#if	HETEROGENEOUS
 //--------------------------------------------------------------------------------------
-// Rendering from sparse volume representation
+// Light arriving at a point through the camera-path thickness, summed over the lights
 //--------------------------------------------------------------------------------------
-[numthreads(32, 32, 1)]
-void main(uint3 DTid : SV_DispatchThreadID)
+float3 InScatter(const float3 vPos, const float fViewZ, const float fThickness)
+{
+	float3 vLight = 0.0;
+	[unroll]
+	for (uint i = 0; i < NUM_LIGHTS; ++i)
+		vLight += g_vLightColors[i].xyz * Transmission(LightPathThickness(vPos, fViewZ, i) + fThickness).x;
+
+	return vLight;
+}
+#endif
+
+//--------------------------------------------------------------------------------------
+// Integrate the scattering along all the k-buffer intervals of a pixel
+//--------------------------------------------------------------------------------------
+min16float3 Integrate(const uint2 vLoc)
 {
-	const uint2 vLoc = DTid.xy;
 	const float2 vPos = vLoc;
 
 	float fThickness = 0.0;
-	min16float fScatter = 0.0;
+	min16float3 vScatter = 0.0;
 	for (uint i = 0; i < NUM_K_LAYERS >> 1; ++i)
 	{
 		// Get screen-space depths
@@ -129,26 +270,118 @@ void main(uint3 DTid : SV_DispatchThreadID)
 		const float fThicknessSeg = fZBack - fZFront;
 		//const float fThicknessSeg = distance(vPosFront, vPosBack);
 
-		float4 vThickness;	// Front, 1/3, 2/3, and back thicknesses
-		vThickness.x = LightPathThickness(vPosFront) + fThickness;
-		vThickness.y = LightPathThickness(vPosFMid) + fThicknessSeg / 3.0 + fThickness;
-		vThickness.z = LightPathThickness(vPosBMid) + fThicknessSeg * (2.0 / 3.0) + fThickness;
+#if	HETEROGENEOUS
+		// Trapezoidal march at the voxel size, so the cost follows the interval length.
+		// Thicknesses are weighted by the relative density; the light path assumes the
+		// base density since only its geometric thickness is known.
+		const float fStepSize = 1.0 / (g_vVolume.w * DENSITY_BRICK_SIZE);
+		const uint uSteps = clamp(ceil(fThicknessSeg / fStepSize), 1, MAX_DENSITY_STEPS);
+		const float fStep = fThicknessSeg / uSteps;
+
+		float fDensity = Density(vPosFront);
+		float3 vScatterPrev = fDensity * InScatter(vPosFront, fZFront, fThickness);
+		for (uint j = 1; j <= uSteps; ++j)
+		{
+			const float t = j / float(uSteps);
+			const float3 vPosStep = lerp(vPosFront, vPosBack, t);
+			const float fDensityStep = Density(vPosStep);
+			fThickness += (fDensity + fDensityStep) * 0.5 * fStep;
+			fDensity = fDensityStep;
+
+			const float3 vScatterStep = fDensityStep * InScatter(vPosStep, lerp(fZFront, fZBack, t), fThickness);
+			vScatter += min16float3(g_fDensity * (vScatterPrev + vScatterStep) * 0.5 * fStep);
+			vScatterPrev = vScatterStep;
+		}
+#else
+		// Camera-path thicknesses at the front, 1/3, 2/3, and back, shared by all the lights
+		const float4 vThicknessView = fThicknessSeg * float4(0.0, 1.0 / 3.0, 2.0 / 3.0, 1.0) + fThickness;
+		const float4 vZView = fThicknessSeg * float4(0.0, 1.0 / 3.0, 2.0 / 3.0, 1.0) + fZFront;
 
 		// Update the total thickness
 		fThickness += fThicknessSeg;
-		vThickness.w = LightPathThickness(vPosBack) + fThickness;
 
-		// Compute transmission
-		const min16float4 vTransmission = min16float4(exp(-vThickness * g_fAbsorption * g_fDensity));
-		
-		// Integral
-		fScatter += g_fDensity * Simpson(vTransmission, 0.0, fThicknessSeg);
+		[unroll]
+		for (uint j = 0; j < NUM_LIGHTS; ++j)
+		{
+			float4 vThickness;	// Front, 1/3, 2/3, and back thicknesses
+			vThickness.x = LightPathThickness(vPosFront, vZView.x, j);
+			vThickness.y = LightPathThickness(vPosFMid, vZView.y, j);
+			vThickness.z = LightPathThickness(vPosBMid, vZView.z, j);
+			vThickness.w = LightPathThickness(vPosBack, vZView.w, j);
+
+			// Compute transmission
+			const min16float4 vTransmission = min16float4(Transmission(vThickness + vThicknessView));
+
+			// Integral
+			vScatter += min16float3(g_vLightColors[j].xyz) * min16float(g_fDensity) *
+				Simpson(vTransmission, 0.0, fThicknessSeg);
+		}
+#endif
 	}
 
-	const min16float fTransmission = min16float(exp(-fThickness * g_fAbsorption * g_fDensity));
+	const min16float fTransmission = min16float(Transmission(fThickness).x);
+
+	min16float3 vResult = vScatter * 1.0 + 0.3;
+
+	return lerp(vResult, g_vClear, fTransmission);
+}
+
+#if	TEMPORAL
+//--------------------------------------------------------------------------------------
+// Reproject the history of the front-most surface, return false on rejection
+//--------------------------------------------------------------------------------------
+bool Reproject(const uint2 vLoc, const float fDepth, out float3 vHistory)
+{
+	vHistory = 0.0;
+	if (!g_uHistoryValid) return false;
+
+	// Front-most surface in the previous view-screen space
+	const float3 vPosWorld = ScreenToWorld(float3(vLoc, fDepth));
+	float4 vPosPrev = mul(float4(vPosWorld, 1.0), g_mWorldToScreenPrev);
+	vPosPrev.xyz /= vPosPrev.w;
+
+	float2 vSize;
+	g_txHistory.GetDimensions(vSize.x, vSize.y);
+	if (any(vPosPrev.xy < 0.0) || any(vPosPrev.xy >= vSize)) return false;
+
+	// Reject on depth mismatch against the previous layer 0
+	const float fZPrev = PrespectiveToViewZ(vPosPrev.z);
+	const float fZHistory = g_txHistory[uint2(vPosPrev.xy)].w;
+	if (abs(fZHistory - fZPrev) > g_fHistoryDepthTol * fZPrev) return false;
+
+	vHistory = g_txHistory.SampleLevel(g_smpLinear, (vPosPrev.xy + 0.5) / vSize, 0.0).xyz;
+
+	return true;
+}
+#endif
+
+//--------------------------------------------------------------------------------------
+// Rendering from sparse volume representation
+//--------------------------------------------------------------------------------------
+[numthreads(32, 32, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+#if	TEMPORAL
+	const float fDepth = asfloat(g_txKBufDepth[uint3(DTid.xy, 0)]);
+	const bool bSurface = fDepth < 1.0;
+
+	// Only one pixel of each tile is integrated in each frame
+	const uint uSubset = DTid.y % TEMPORAL_TILE * TEMPORAL_TILE + DTid.x % TEMPORAL_TILE;
+	const bool bScheduled = uSubset == g_uFrame % TEMPORAL_SUBSET;
+
+	float3 vHistory;
+	const bool bHistory = bSurface && Reproject(DTid.xy, fDepth, vHistory);
+
+	float3 vResult;
+	if (!bSurface) vResult = g_vClear;
+	else if (!bHistory) vResult = Integrate(DTid.xy);
+	else if (bScheduled) vResult = lerp(vHistory, Integrate(DTid.xy), g_fHistoryBlend);
+	else vResult = vHistory;
 
-	min16float3 vResult = fScatter * 1.0 + 0.3;
-	vResult = lerp(vResult, g_vClear, fTransmission);
+	g_rwHistory[DTid.xy] = float4(vResult, bSurface ? PrespectiveToViewZ(fDepth) : g_fZFar);
+#else
+	const min16float3 vResult = Integrate(DTid.xy);
+#endif
 
 	g_rwPresent[DTid.xy] = min16float4(sqrt(vResult), 1.0);
 }
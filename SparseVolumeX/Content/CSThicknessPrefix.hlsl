@@ -0,0 +1,41 @@
+//--------------------------------------------------------------------------------------
+// By XU, Tianchen
+//--------------------------------------------------------------------------------------
+
+#include "SharedConst.h"
+
+//--------------------------------------------------------------------------------------
+// Textures
+//--------------------------------------------------------------------------------------
+Texture2DArray<uint>		g_txKBufDepthLS;	// Light space, NUM_K_LAYERS slices per light cascade
+
+//--------------------------------------------------------------------------------------
+// Unordered access textures
+//--------------------------------------------------------------------------------------
+RWTexture2DArray<float>		g_rwThicknessPrefix;	// NUM_K_LAYERS / 2 slices per light cascade
+
+//--------------------------------------------------------------------------------------
+// Prefix-sum the light-space interval thicknesses, so that a lookup only needs the
+// interval containing the point
+//--------------------------------------------------------------------------------------
+[numthreads(32, 32, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+	const uint uBase = DTid.z * NUM_K_LAYERS;
+	const uint uBasePrefix = DTid.z * (NUM_K_LAYERS >> 1);
+
+	float fThickness = 0.0;
+	for (uint i = 0; i < NUM_K_LAYERS >> 1; ++i)
+	{
+		// Thickness in front of the current interval
+		g_rwThicknessPrefix[uint3(DTid.xy, uBasePrefix + i)] = fThickness;
+
+		// Get light-space depths
+		const float fDepthFront = asfloat(g_txKBufDepthLS[uint3(DTid.xy, uBase + i * 2)]);
+		const float fDepthBack = asfloat(g_txKBufDepthLS[uint3(DTid.xy, uBase + i * 2 + 1)]);
+
+		// Orthographic depths are linear in view space
+		if (fDepthFront < 1.0 && fDepthBack < 1.0)
+			fThickness += (fDepthBack - fDepthFront) * (g_fZFarLS - g_fZNearLS);
+	}
+}
@@ -0,0 +1,458 @@
+//--------------------------------------------------------------------------------------
+// By XU, Tianchen
+//--------------------------------------------------------------------------------------
+
+#include "SVXTransmission.h"
+#include "SVXBrickVolume.h"
+#include "D3D11Backend.h"
+
+using namespace DirectX;
+using namespace DX;
+using namespace std;
+using namespace XSDX;
+
+const auto g_pNullSRV = static_cast<LPDXShaderResourceView>(nullptr);	// Helper to Clear SRVs
+const auto g_pNullUAV = static_cast<LPDXUnorderedAccessView>(nullptr);	// Helper to Clear UAVs
+const auto g_uNullUint = 0u;											// Helper to Clear Buffers
+
+CPDXInputLayout	D3D11Backend::m_pVertexLayout;
+
+static_assert(NUM_CASCADE <= 4, "Cascade splits are passed in a float4");
+static_assert(sizeof(SVX::float4x4) == sizeof(XMFLOAT4X4), "SVX matrices share the DirectXMath layout");
+
+//--------------------------------------------------------------------------------------
+// Both are row-major for row vectors
+//--------------------------------------------------------------------------------------
+static XMMATRIX loadMatrix(const SVX::float4x4 &m)
+{
+	return XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(&m));
+}
+
+D3D11Backend::D3D11Backend(const CPDXDevice &pDXDevice, const spShader &pShader, const spState &pState) :
+	m_pDXDevice(pDXDevice),
+	m_pShader(pShader),
+	m_pState(pState),
+	m_uVertexStride(0),
+	m_uNumIndices(0),
+	m_vVolume(0.0f, 0.0f, 0.0f, 0.0f),
+	m_pProfiler(nullptr)
+{
+	m_pDXDevice->GetImmediateContext(&m_pDXContext);
+}
+
+D3D11Backend::~D3D11Backend()
+{
+}
+
+void D3D11Backend::UploadMesh(const uint8_t *pVertices, const uint32_t uStride, const uint32_t uNumVertices,
+	const uint32_t *pIndices, const uint32_t uNumIndices)
+{
+	m_uVertexStride = uStride;
+	m_pVB = make_unique<RawBuffer>(m_pDXDevice);
+	m_pVB->Create(uStride * uNumVertices, D3D11_BIND_VERTEX_BUFFER, pVertices);
+
+	m_uNumIndices = uNumIndices;
+	m_pIB = make_unique<RawBuffer>(m_pDXDevice);
+	m_pIB->Create(sizeof(uint32_t) * uNumIndices, D3D11_BIND_INDEX_BUFFER, pIndices);
+}
+
+void D3D11Backend::UploadDensity(const SVX::BrickVolume &brickVolume)
+{
+	// Upload as a brick atlas and an indirection table
+	auto vAtlas = vfloat(0);
+	auto vTable = vuint(0);
+	auto uAtlasBricks = 0u;
+	brickVolume.BuildAtlas(vAtlas, vTable, uAtlasBricks);
+
+	const auto uAtlasSize = uAtlasBricks * (brickVolume.GetBrickSize() + 1);
+	m_pTxDensity = make_unique<Texture3D>(m_pDXDevice);
+	m_pTxDensity->Create(uAtlasSize, uAtlasSize, uAtlasSize, DXGI_FORMAT_R32_FLOAT, D3D11_BIND_SHADER_RESOURCE,
+		1, vAtlas.data(), sizeof(float), D3D11_USAGE_IMMUTABLE);
+
+	m_pTxBrickTable = make_unique<Texture3D>(m_pDXDevice);
+	m_pTxBrickTable->Create(brickVolume.GetGridSize(0), brickVolume.GetGridSize(1), brickVolume.GetGridSize(2),
+		DXGI_FORMAT_R32_UINT, D3D11_BIND_SHADER_RESOURCE, 1, vTable.data(), sizeof(uint32_t), D3D11_USAGE_IMMUTABLE);
+
+	const auto &vOrigin = brickVolume.GetOrigin();
+	m_vVolume = XMFLOAT4(vOrigin.x, vOrigin.y, vOrigin.z, 1.0f / brickVolume.GetBrickExtent());
+}
+
+void D3D11Backend::CreateKBuffers(const SVX::VolumeState &state)
+{
+	assert(state.uNumLayers == NUM_K_LAYERS && state.uLightMapSize == SHADOW_MAP_SIZE);
+	createCBs();
+
+	m_pTxKBufferDepth = make_unique<Texture2D>(m_pDXDevice);
+	m_pTxKBufferDepth->Create(state.uWidth, state.uHeight, NUM_K_LAYERS, DXGI_FORMAT_R32_UINT);
+
+	m_pTxKBufferDepthLS = make_unique<Texture2D>(m_pDXDevice);
+	m_pTxKBufferDepthLS->Create(SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, NUM_K_LAYERS * NUM_LIGHT_VIEWS, DXGI_FORMAT_R32_UINT);
+
+	// Per-light-cascade slice ranges for peeling
+	for (auto i = 0u; i < NUM_LIGHT_VIEWS; ++i)
+	{
+		const auto pTexture = m_pTxKBufferDepthLS->GetTexture().Get();
+		const auto uavDesc = CD3D11_UNORDERED_ACCESS_VIEW_DESC(pTexture, D3D11_UAV_DIMENSION_TEXTURE2DARRAY,
+			DXGI_FORMAT_UNKNOWN, 0, NUM_K_LAYERS * i, NUM_K_LAYERS);
+		ThrowIfFailed(m_pDXDevice->CreateUnorderedAccessView(pTexture, &uavDesc, &m_pUAVKBufferDepthLS[i]));
+	}
+
+	m_pTxThicknessPrefix = make_unique<Texture2D>(m_pDXDevice);
+	m_pTxThicknessPrefix->Create(SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, (NUM_K_LAYERS >> 1) * NUM_LIGHT_VIEWS,
+		DXGI_FORMAT_R32_FLOAT);
+
+#if	TEMPORAL
+	// History of linear colors and front-most view depths
+	for (auto &pTxHistory : m_pTxHistories)
+	{
+		pTxHistory = make_unique<Texture2D>(m_pDXDevice);
+		pTxHistory->Create(state.uWidth, state.uHeight, DXGI_FORMAT_R32G32B32A32_FLOAT);
+	}
+#endif
+
+#if	TRANSMISSION == TRANSMISSION_LUT
+	// Transmission LUT for the fixed absorption and density
+	SVX::TransmissionLUT transmissionLUT;
+	transmissionLUT.Create(g_fAbsorption * g_fDensity, g_fTransmissionLUTMax, TRANSMISSION_LUT_SIZE);
+	m_pTxTransmission = make_unique<Texture2D>(m_pDXDevice);
+	m_pTxTransmission->Create(transmissionLUT.GetSize(), 1, DXGI_FORMAT_R32_FLOAT, D3D11_BIND_SHADER_RESOURCE,
+		1, transmissionLUT.GetData(), sizeof(float), D3D11_USAGE_IMMUTABLE);
+#endif
+}
+
+void D3D11Backend::ClearKBuffers(const bool bLightSpace)
+{
+	const auto fClearDepth = 1.0f;
+	const auto uClearDepth = reinterpret_cast<const uint32_t&>(fClearDepth);
+	m_pDXContext->ClearUnorderedAccessViewUint(m_pTxKBufferDepth->GetUAV().Get(), XMVECTORU32{ { uClearDepth } }.u);
+
+	// Depth k-buffers of all the lights
+	if (bLightSpace) m_pDXContext->ClearUnorderedAccessViewUint(m_pTxKBufferDepthLS->GetUAV().Get(),
+		XMVECTORU32{ { uClearDepth } }.u);
+}
+
+void D3D11Backend::UpdateFrame(const SVX::VolumeState &state)
+{
+	assert(state.GetNumLightViews() == NUM_LIGHT_VIEWS);
+
+	// General matrices
+	const auto mWorld = XMMatrixIdentity();
+	const auto mWorldI = XMMatrixInverse(nullptr, mWorld);
+	CBMatrices cbMatrices =
+	{
+		XMMatrixTranspose(mWorld * loadMatrix(state.mViewProj)),
+		XMMatrixTranspose(mWorld),
+		mWorldI
+	};
+
+	if (m_pCBMatrices) m_pDXContext->UpdateSubresource(m_pCBMatrices.Get(), 0, nullptr, &cbMatrices, 0, 0);
+
+	// Light-space matrices
+	CBPerObject cbPerObject;
+	for (auto i = 0u; i < NUM_LIGHT_VIEWS; ++i)
+	{
+		const auto mViewProjLS = loadMatrix(state.vLightViewProjs[i]);
+		cbMatrices.mWorldViewProj = XMMatrixTranspose(mWorld * mViewProjLS);
+		if (m_pCBMatricesLS[i]) m_pDXContext->UpdateSubresource(m_pCBMatricesLS[i].Get(), 0, nullptr, &cbMatrices, 0, 0);
+		cbPerObject.mViewProjLS[i] = XMMatrixTranspose(mViewProjLS);
+	}
+
+	for (auto i = 0u; i < NUM_LIGHTS; ++i)
+	{
+		const auto &vColor = state.vLights[i].vColor;
+		cbPerObject.vLightColors[i] = XMFLOAT4(vColor.x, vColor.y, vColor.z, 0.0f);
+	}
+
+	// Screen space matrices and temporal reprojection
+	for (auto i = 0u; i < 4; ++i) cbPerObject.fCascadeSplits[i] = state.fCascadeSplits[i];
+	cbPerObject.mScreenToWorld = XMMatrixTranspose(loadMatrix(state.mScreenToWorld));
+	cbPerObject.mWorldToScreenPrev = XMMatrixTranspose(loadMatrix(state.mWorldToScreenPrev));
+	cbPerObject.vVolume = m_vVolume;
+	cbPerObject.uFrame = state.uFrame;
+	cbPerObject.uHistoryValid = state.bHistoryValid ? 1 : 0;
+
+	if (m_pCBPerObject) m_pDXContext->UpdateSubresource(m_pCBPerObject.Get(), 0, nullptr, &cbPerObject, 0, 0);
+}
+
+void D3D11Backend::DepthPeelLightSpace(const SVX::VolumeState &)
+{
+	const GPUProfiler::Scope scope(gpuProfiler(), "depthPeelLightSpace");
+
+	// Record current RTV and DSV
+	auto pRTV = CPDXRenderTargetView();
+	auto pDSV = CPDXDepthStencilView();
+	m_pDXContext->OMGetRenderTargets(1, &pRTV, &pDSV);
+
+	// Record current viewport
+	auto uNumViewports = 1u;
+	auto vpBack = D3D11_VIEWPORT();
+	m_pDXContext->RSGetViewports(&uNumViewports, &vpBack);
+
+	// Change viewport
+	const auto uOffset = 0u;
+	const auto vpLightSpace = CD3D11_VIEWPORT(0.0f, 0.0f, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+	m_pDXContext->RSSetViewports(uNumViewports, &vpLightSpace);
+	m_pDXContext->RSSetState(m_pState->CullNone().Get());
+
+	// Set IA
+	m_pDXContext->IASetInputLayout(m_pVertexLayout.Get());
+	m_pDXContext->IASetVertexBuffers(0, 1, m_pVB->GetBuffer().GetAddressOf(), &m_uVertexStride, &uOffset);
+	m_pDXContext->IASetIndexBuffer(m_pIB->GetBuffer().Get(), DXGI_FORMAT_R32_UINT, 0);
+	m_pDXContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	// Set shaders
+	m_pDXContext->VSSetShader(m_pShader->GetVertexShader(VS_BASEPASS).Get(), nullptr, 0);
+	m_pDXContext->PSSetShader(m_pShader->GetPixelShader(PS_DEPTH_PEEL).Get(), nullptr, 0);
+
+	for (auto i = 0u; i < NUM_LIGHT_VIEWS; ++i)
+	{
+		// Change RT to the slices of the current light cascade
+		m_pDXContext->OMSetRenderTargetsAndUnorderedAccessViews(0, nullptr, nullptr,
+			0, 1, m_pUAVKBufferDepthLS[i].GetAddressOf(), &g_uNullUint);
+
+		// Set light-space matrices
+		m_pDXContext->VSSetConstantBuffers(0, 1, m_pCBMatricesLS[i].GetAddressOf());
+
+		m_pDXContext->DrawIndexed(m_uNumIndices, 0, 0);
+	}
+
+	// Reset states
+	m_pDXContext->IASetInputLayout(nullptr);
+	m_pDXContext->RSSetState(nullptr);
+	m_pDXContext->RSSetViewports(uNumViewports, &vpBack);
+	m_pDXContext->OMSetRenderTargets(1, pRTV.GetAddressOf(), pDSV.Get());
+}
+
+void D3D11Backend::ThicknessPrefix(const SVX::VolumeState &)
+{
+	const GPUProfiler::Scope scope(gpuProfiler(), "thicknessPrefix");
+
+	// Setup
+	m_pDXContext->CSSetUnorderedAccessViews(0, 1, m_pTxThicknessPrefix->GetUAV().GetAddressOf(), &g_uNullUint);
+	m_pDXContext->CSSetShaderResources(0, 1, m_pTxKBufferDepthLS->GetSRV().GetAddressOf());
+
+	// Dispatch
+	m_pDXContext->CSSetShader(m_pShader->GetComputeShader(CS_THICKNESS_PREFIX).Get(), nullptr, 0);
+	m_pDXContext->Dispatch(SHADOW_MAP_SIZE >> 5, SHADOW_MAP_SIZE >> 5, NUM_LIGHT_VIEWS);
+
+	// Unset
+	m_pDXContext->CSSetUnorderedAccessViews(0, 1, &g_pNullUAV, &g_uNullUint);
+	m_pDXContext->CSSetShaderResources(0, 1, &g_pNullSRV);
+}
+
+void D3D11Backend::DepthPeel(const SVX::VolumeState &)
+{
+	const GPUProfiler::Scope scope(gpuProfiler(), "depthPeel");
+
+	// Record current RTV and DSV
+	auto pRTV = CPDXRenderTargetView();
+	auto pDSV = CPDXDepthStencilView();
+	m_pDXContext->OMGetRenderTargets(1, &pRTV, &pDSV);
+
+	// Change RT
+	const auto uOffset = 0u;
+	m_pDXContext->OMSetRenderTargetsAndUnorderedAccessViews(0, nullptr, nullptr,
+		0, 1, m_pTxKBufferDepth->GetUAV().GetAddressOf(), &g_uNullUint);
+
+	m_pDXContext->RSSetState(m_pState->CullNone().Get());
+
+	// Set matrices
+	m_pDXContext->VSSetConstantBuffers(0, 1, m_pCBMatrices.GetAddressOf());
+
+	// Set IA
+	m_pDXContext->IASetInputLayout(m_pVertexLayout.Get());
+	m_pDXContext->IASetVertexBuffers(0, 1, m_pVB->GetBuffer().GetAddressOf(), &m_uVertexStride, &uOffset);
+	m_pDXContext->IASetIndexBuffer(m_pIB->GetBuffer().Get(), DXGI_FORMAT_R32_UINT, 0);
+	m_pDXContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	// Set shaders
+	m_pDXContext->VSSetShader(m_pShader->GetVertexShader(VS_BASEPASS).Get(), nullptr, 0);
+	m_pDXContext->PSSetShader(m_pShader->GetPixelShader(PS_DEPTH_PEEL).Get(), nullptr, 0);
+
+	m_pDXContext->DrawIndexed(m_uNumIndices, 0, 0);
+
+	// Reset states
+	m_pDXContext->IASetInputLayout(nullptr);
+	m_pDXContext->RSSetState(nullptr);
+	m_pDXContext->OMSetRenderTargets(1, pRTV.GetAddressOf(), pDSV.Get());
+}
+
+void D3D11Backend::Integrate(const SVX::VolumeState &state)
+{
+	const GPUProfiler::Scope scope(gpuProfiler(), "render");
+
+	auto pSrc = CPDXResource();
+	auto desc = D3D11_TEXTURE2D_DESC();
+	m_pUAVTarget->GetResource(&pSrc);
+	static_cast<LPDXTexture2D>(pSrc.Get())->GetDesc(&desc);
+
+	// Setup
+	const auto uHistory = state.uFrame & 1;
+	const auto pSRVs =
+	{
+		m_pTxKBufferDepth->GetSRV().Get(),
+		m_pTxKBufferDepthLS->GetSRV().Get(),
+		m_pTxThicknessPrefix->GetSRV().Get(),
+#if	TEMPORAL
+		m_pTxHistories[uHistory ^ 1]->GetSRV().Get(),
+#endif
+#if	TRANSMISSION == TRANSMISSION_LUT
+		m_pTxTransmission->GetSRV().Get(),
+#endif
+#if	HETEROGENEOUS
+		m_pTxDensity->GetSRV().Get(),
+		m_pTxBrickTable->GetSRV().Get()
+#endif
+	};
+	const auto pUAVs =
+	{
+		m_pUAVTarget.Get(),
+#if	TEMPORAL
+		m_pTxHistories[uHistory]->GetUAV().Get()
+#endif
+	};
+	m_pDXContext->CSSetUnorderedAccessViews(0, static_cast<uint32_t>(pUAVs.size()), pUAVs.begin(), nullptr);
+	m_pDXContext->CSSetShaderResources(0, static_cast<uint32_t>(pSRVs.size()), pSRVs.begin());
+	m_pDXContext->CSSetConstantBuffers(0, 1, m_pCBPerObject.GetAddressOf());
+	m_pDXContext->CSSetSamplers(0, 1, m_pState->LinearClamp().GetAddressOf());
+
+	// Dispatch
+	m_pDXContext->CSSetShader(m_pShader->GetComputeShader(CS_RENDER).Get(), nullptr, 0);
+	m_pDXContext->Dispatch(desc.Width >> 5, desc.Height >> 5, 1);
+
+	// Unset
+	const auto vpNullSRVs = vLPDXSRV(pSRVs.size(), nullptr);
+	const auto vpNullUAVs = vLPDXUAV(pUAVs.size(), nullptr);
+	m_pDXContext->CSSetShaderResources(0, static_cast<uint32_t>(vpNullSRVs.size()), vpNullSRVs.data());
+	m_pDXContext->CSSetUnorderedAccessViews(0, static_cast<uint32_t>(vpNullUAVs.size()), vpNullUAVs.data(), nullptr);
+}
+
+bool D3D11Backend::IsTemporal() const
+{
+	return TEMPORAL != 0;
+}
+
+void D3D11Backend::SetProfiler(SVX::Profiler *pProfiler)
+{
+	m_pProfiler = pProfiler;
+	if (m_pProfiler && !m_pGPUProfiler) m_pGPUProfiler = make_unique<GPUProfiler>(m_pDXDevice);
+}
+
+void D3D11Backend::BeginFrame()
+{
+	if (m_pProfiler) m_pGPUProfiler->BeginFrame(*m_pProfiler);
+}
+
+void D3D11Backend::EndFrame()
+{
+	if (m_pProfiler) m_pGPUProfiler->EndFrame();
+}
+
+void D3D11Backend::TrackMemory(SVX::MemoryTracker &memoryTracker, const char *pszAsset) const
+{
+	using MemoryTracker = SVX::MemoryTracker;
+	const auto track = [&memoryTracker, pszAsset](const char *pszResource,
+		const MemoryTracker::Category eCategory, const size_t uBytes)
+	{
+		memoryTracker.Allocate(pszAsset, pszResource, eCategory, uBytes);
+	};
+
+	track("VB", MemoryTracker::CATEGORY_GEOMETRY, m_pVB->GetBytes());
+	track("IB", MemoryTracker::CATEGORY_GEOMETRY, m_pIB->GetBytes());
+
+	auto uCBMatricesLS = size_t(0);
+	for (const auto &pCBMatricesLS : m_pCBMatricesLS) uCBMatricesLS += Resource::GetBytes(pCBMatricesLS);
+	track("CBMatrices", MemoryTracker::CATEGORY_CONSTANT, Resource::GetBytes(m_pCBMatrices));
+	track("CBMatricesLS", MemoryTracker::CATEGORY_CONSTANT, uCBMatricesLS);
+	track("CBPerObject", MemoryTracker::CATEGORY_CONSTANT, Resource::GetBytes(m_pCBPerObject));
+
+	track("KBufferDepth", MemoryTracker::CATEGORY_K_BUFFER, m_pTxKBufferDepth->GetBytes());
+	track("KBufferDepthLS", MemoryTracker::CATEGORY_LIGHT, m_pTxKBufferDepthLS->GetBytes());
+	track("ThicknessPrefix", MemoryTracker::CATEGORY_LIGHT, m_pTxThicknessPrefix->GetBytes());
+
+	if (m_pTxHistories[0]) track("Histories", MemoryTracker::CATEGORY_HISTORY,
+		m_pTxHistories[0]->GetBytes() + m_pTxHistories[1]->GetBytes());
+	if (m_pTxTransmission) track("TransmissionLUT", MemoryTracker::CATEGORY_LOOKUP, m_pTxTransmission->GetBytes());
+	if (m_pTxDensity) track("Density", MemoryTracker::CATEGORY_LOOKUP, m_pTxDensity->GetBytes());
+	if (m_pTxBrickTable) track("BrickTable", MemoryTracker::CATEGORY_LOOKUP, m_pTxBrickTable->GetBytes());
+}
+
+void D3D11Backend::SetTarget(const CPDXUnorderedAccessView &pUAVTarget)
+{
+	m_pUAVTarget = pUAVTarget;
+}
+
+void D3D11Backend::RenderTest()
+{
+#if 0
+	// Record current viewport
+	auto uNumViewports = 1u;
+	auto vpBack = D3D11_VIEWPORT();
+	m_pDXContext->RSGetViewports(&uNumViewports, &vpBack);
+
+	// Change viewport
+
+	const auto vpLightSpace = CD3D11_VIEWPORT(0.0f, 0.0f, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+	m_pDXContext->RSSetViewports(uNumViewports, &vpLightSpace);
+#endif
+
+	const auto uOffset = 0u;
+	m_pDXContext->RSSetState(m_pState->CullNone().Get());
+
+	// Set matrices
+	m_pDXContext->VSSetConstantBuffers(0, 1, m_pCBMatrices.GetAddressOf());
+
+	// Set IA
+	m_pDXContext->IASetInputLayout(m_pVertexLayout.Get());
+	m_pDXContext->IASetVertexBuffers(0, 1, m_pVB->GetBuffer().GetAddressOf(), &m_uVertexStride, &uOffset);
+	m_pDXContext->IASetIndexBuffer(m_pIB->GetBuffer().Get(), DXGI_FORMAT_R32_UINT, 0);
+	m_pDXContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	// Set shaders
+	m_pDXContext->VSSetShader(m_pShader->GetVertexShader(VS_BASEPASS).Get(), nullptr, 0);
+	m_pDXContext->PSSetShader(m_pShader->GetPixelShader(PS_TEST).Get(), nullptr, 0);
+
+	m_pDXContext->DrawIndexed(m_uNumIndices, 0, 0);
+
+	// Reset states
+	m_pDXContext->IASetInputLayout(nullptr);
+	m_pDXContext->RSSetState(nullptr);
+	//m_pDXContext->RSSetViewports(uNumViewports, &vpBack);
+}
+
+void D3D11Backend::CreateVertexLayout(const CPDXDevice &pDXDevice, CPDXInputLayout &pVertexLayout, const spShader &pShader, const uint8_t uVS)
+{
+	// Define our vertex data layout for skinned objects
+	const auto offset = D3D11_APPEND_ALIGNED_ELEMENT;
+	const auto vLayout = vector<D3D11_INPUT_ELEMENT_DESC>
+	{
+		{ "POSITION",	0, DXGI_FORMAT_R32G32B32_FLOAT,	0, 0,		D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL",		0, DXGI_FORMAT_R32G32B32_FLOAT,	0, offset,	D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	ThrowIfFailed(pDXDevice->CreateInputLayout(vLayout.data(), static_cast<uint32_t>(vLayout.size()),
+		pShader->GetVertexShaderBuffer(uVS)->GetBufferPointer(),
+		pShader->GetVertexShaderBuffer(uVS)->GetBufferSize(),
+		&pVertexLayout));
+}
+
+CPDXInputLayout &D3D11Backend::GetVertexLayout()
+{
+	return m_pVertexLayout;
+}
+
+void D3D11Backend::createCBs()
+{
+	auto desc = CD3D11_BUFFER_DESC(sizeof(CBMatrices), D3D11_BIND_CONSTANT_BUFFER);
+	ThrowIfFailed(m_pDXDevice->CreateBuffer(&desc, nullptr, &m_pCBMatrices));
+	for (auto &pCBMatricesLS : m_pCBMatricesLS)
+		ThrowIfFailed(m_pDXDevice->CreateBuffer(&desc, nullptr, &pCBMatricesLS));
+
+	desc.ByteWidth = sizeof(CBPerObject);
+	ThrowIfFailed(m_pDXDevice->CreateBuffer(&desc, nullptr, &m_pCBPerObject));
+}
+
+GPUProfiler *D3D11Backend::gpuProfiler() const
+{
+	return m_pProfiler ? m_pGPUProfiler.get() : nullptr;
+}
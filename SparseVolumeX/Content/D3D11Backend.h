@@ -0,0 +1,127 @@
+//--------------------------------------------------------------------------------------
+// By XU, Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XSDXShader.h"
+#include "XSDXState.h"
+#include "XSDXResource.h"
+#include "XSDXProfiler.h"
+#include "SharedConst.h"
+#include "SVXBackend.h"
+
+//--------------------------------------------------------------------------------------
+// Direct3D 11 passes of the sparse volume: the depth peels in pixel shaders, the
+// thickness prefix and the integration in compute shaders, with the temporal history
+//--------------------------------------------------------------------------------------
+class D3D11Backend : public SVX::Backend
+{
+public:
+	enum VertexShaderID : uint32_t
+	{
+		VS_BASEPASS
+	};
+
+	enum PixelShaderID : uint32_t
+	{
+		PS_DEPTH_PEEL,
+		PS_TEST
+	};
+
+	enum ComputeShaderID : uint32_t
+	{
+		CS_RENDER,
+		CS_THICKNESS_PREFIX
+	};
+
+	D3D11Backend(const XSDX::CPDXDevice &pDXDevice, const XSDX::spShader &pShader, const XSDX::spState &pState);
+	virtual ~D3D11Backend();
+
+	void UploadMesh(const uint8_t *pVertices, const uint32_t uStride, const uint32_t uNumVertices,
+		const uint32_t *pIndices, const uint32_t uNumIndices) override;
+	void UploadDensity(const SVX::BrickVolume &brickVolume) override;
+	void CreateKBuffers(const SVX::VolumeState &state) override;
+	void ClearKBuffers(const bool bLightSpace) override;
+	void UpdateFrame(const SVX::VolumeState &state) override;
+
+	void DepthPeelLightSpace(const SVX::VolumeState &state) override;
+	void ThicknessPrefix(const SVX::VolumeState &state) override;
+	void DepthPeel(const SVX::VolumeState &state) override;
+	void Integrate(const SVX::VolumeState &state) override;
+	bool IsTemporal() const override;
+
+	// Times the passes through timestamp queries; null to disable
+	void SetProfiler(SVX::Profiler *pProfiler) override;
+	void BeginFrame() override;
+	void EndFrame() override;
+
+	void TrackMemory(SVX::MemoryTracker &memoryTracker, const char *pszAsset) const override;
+
+	// Swap-chain UAV the integration writes to
+	void SetTarget(const XSDX::CPDXUnorderedAccessView &pUAVTarget);
+	void RenderTest();
+
+	static void CreateVertexLayout(const XSDX::CPDXDevice &pDXDevice, XSDX::CPDXInputLayout &pVertexLayout,
+		const XSDX::spShader &pShader, const uint8_t uVS);
+
+	static XSDX::CPDXInputLayout &GetVertexLayout();
+
+protected:
+	struct CBMatrices
+	{
+		DirectX::XMMATRIX mWorldViewProj;
+		DirectX::XMMATRIX mWorld;
+		DirectX::XMMATRIX mWorldIT;
+	};
+
+	struct CBPerObject
+	{
+		DirectX::XMMATRIX mViewProjLS[NUM_LIGHT_VIEWS];
+		DirectX::XMMATRIX mScreenToWorld;
+		DirectX::XMMATRIX mWorldToScreenPrev;
+		DirectX::XMFLOAT4 vVolume;
+		DirectX::XMFLOAT4 vLightColors[NUM_LIGHTS];
+		float fCascadeSplits[4];
+		uint32_t uFrame;
+		uint32_t uHistoryValid;
+		uint32_t uPadding[2];
+	};
+
+	void createCBs();
+	XSDX::GPUProfiler *gpuProfiler() const;
+
+	uint32_t						m_uVertexStride;
+	uint32_t						m_uNumIndices;
+	DirectX::XMFLOAT4				m_vVolume;				// Density volume origin and bricks per unit length
+
+	XSDX::upRawBuffer				m_pVB;
+	XSDX::upRawBuffer				m_pIB;
+	XSDX::CPDXBuffer				m_pCBMatrices;
+	XSDX::CPDXBuffer				m_pCBMatricesLS[NUM_LIGHT_VIEWS];
+	XSDX::CPDXBuffer				m_pCBPerObject;
+
+	XSDX::upTexture2D				m_pTxKBufferDepth;		// View-screen space
+	XSDX::upTexture2D				m_pTxKBufferDepthLS;	// Light space, NUM_K_LAYERS slices per light cascade
+	XSDX::CPDXUnorderedAccessView	m_pUAVKBufferDepthLS[NUM_LIGHT_VIEWS];
+	XSDX::upTexture2D				m_pTxThicknessPrefix;	// Light space, prefix-summed thicknesses
+	XSDX::upTexture2D				m_pTxHistories[2];		// Temporal ping-pong
+	XSDX::upTexture2D				m_pTxTransmission;		// Transmission LUT
+	XSDX::upTexture3D				m_pTxDensity;			// Density brick atlas
+	XSDX::upTexture3D				m_pTxBrickTable;		// Density brick indirection
+	XSDX::CPDXUnorderedAccessView	m_pUAVTarget;
+
+	XSDX::spShader					m_pShader;
+	XSDX::spState					m_pState;
+
+	SVX::Profiler					*m_pProfiler;
+	XSDX::upGPUProfiler				m_pGPUProfiler;
+
+	XSDX::CPDXDevice				m_pDXDevice;
+	XSDX::CPDXContext				m_pDXContext;
+
+	static XSDX::CPDXInputLayout	m_pVertexLayout;
+};
+
+using upD3D11Backend = std::unique_ptr<D3D11Backend>;
+using spD3D11Backend = std::shared_ptr<D3D11Backend>;
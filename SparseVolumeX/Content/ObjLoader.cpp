@@ -2,13 +2,37 @@
 // By Stars XU Tianchen
 //--------------------------------------------------------------------------------------
 
+#include <cmath>
+#include <cstring>
+#include "SVXFile.h"
 #include "ObjLoader.h"
 
 #define VEC_ALLOC(v, i)			{ v.resize(i); v.shrink_to_fit(); }
 
+#ifndef _MSC_VER
+// The bounds-checked scanf family is MSVC-only; numeric conversions behave the same
+#define fscanf_s	fscanf
+#define sscanf_s	sscanf
+#endif
+
 using namespace std;
 
-ObjLoader::ObjLoader()
+//--------------------------------------------------------------------------------------
+// Reads a whitespace-delimited token into the line buffer
+//--------------------------------------------------------------------------------------
+static int readToken(FILE *pFile, char (&buffer)[256])
+{
+#ifdef _MSC_VER
+	return fscanf_s(pFile, "%255s", buffer, static_cast<uint32_t>(sizeof(buffer)));
+#else
+	return fscanf(pFile, "%255s", buffer);
+#endif
+}
+
+ObjLoader::ObjLoader() :
+	m_bHasTexcoord(false),
+	m_bHasNormal(false),
+	m_uPeakBytes(0)
 {
 }
 
@@ -18,9 +42,7 @@ ObjLoader::~ObjLoader()
 
 bool ObjLoader::Import(const char *pszFilename, const bool bRecomputeNorm, const bool bNeedBound)
 {
-	FILE *pFile;
-	fopen_s(&pFile, pszFilename, "r");
-
+	const auto pFile = SVX::OpenFile(pszFilename, "r");
 	if (!pFile) return false;
 
 	// Import the OBJ file.
@@ -29,6 +51,8 @@ bool ObjLoader::Import(const char *pszFilename, const bool bRecomputeNorm, const
 	importGeometrySecondPass(pFile);
 	fclose(pFile);
 
+	m_uPeakBytes = sizeof(Vertex) * m_vVertices.capacity() + sizeof(uint32_t) * m_vIndices.capacity();
+
 	// Perform post import tasks.
 	if (bRecomputeNorm) computeNormal();
 	if (bNeedBound) computeBound();
@@ -71,6 +95,21 @@ const float ObjLoader::GetRadius() const
 	return m_fRadius;
 }
 
+const ObjLoader::float3 &ObjLoader::GetAABBMin() const
+{
+	return m_vAABBMin;
+}
+
+const ObjLoader::float3 &ObjLoader::GetAABBMax() const
+{
+	return m_vAABBMax;
+}
+
+const size_t ObjLoader::GetPeakBytes() const
+{
+	return m_uPeakBytes;
+}
+
 void ObjLoader::importGeometryFirstPass(FILE *pFile)
 {
 	auto v = 0u;
@@ -83,12 +122,12 @@ void ObjLoader::importGeometryFirstPass(FILE *pFile)
 	auto bHasTexcoord = false;
 	auto bHasNormal = false;
 
-	while (fscanf_s(pFile, "%s", buffer, static_cast<uint32_t>(sizeof(buffer))) != EOF)
+	while (readToken(pFile, buffer) != EOF)
 	{
 		switch (buffer[0])
 		{
 		case 'f':   // v, v//vn, v/vt, v/vt/vn.
-			fscanf_s(pFile, "%s", buffer, static_cast<uint32_t>(sizeof(buffer)));
+			readToken(pFile, buffer);
 
 			if (strstr(buffer, "//")) // v//vn
 			{
@@ -155,8 +194,8 @@ void ObjLoader::importGeometryFirstPass(FILE *pFile)
 	const auto uNumIdx = uNumTri * 3;
 	VEC_ALLOC(m_vVertices, uNumVert);
 	VEC_ALLOC(m_vIndices, uNumIdx);
-	if (bHasTexcoord) VEC_ALLOC(m_vTIndices, uNumIdx);
-	if (bHasNormal) VEC_ALLOC(m_vNIndices, uNumIdx);
+	m_bHasTexcoord = bHasTexcoord;
+	m_bHasNormal = bHasNormal;
 }
 
 void ObjLoader::importGeometrySecondPass(FILE *pFile)
@@ -165,7 +204,7 @@ void ObjLoader::importGeometrySecondPass(FILE *pFile)
 	auto uNumTri = 0u;
 	char buffer[256] = { 0 };
 
-	while (fscanf_s(pFile, "%s", buffer, static_cast<uint32_t>(sizeof(buffer))) != EOF)
+	while (readToken(pFile, buffer) != EOF)
 	{
 		switch (buffer[0])
 		{
@@ -197,37 +236,22 @@ void ObjLoader::importGeometrySecondPass(FILE *pFile)
 void ObjLoader::loadIndex(FILE *pFile, uint32_t &uNumTri)
 {
 	uint32_t v[3] = { 0 };
-	uint32_t vt[3] = { 0 };
-	uint32_t vn[3] = { 0 };
 
 	const auto uNumVert = static_cast<uint32_t>(m_vVertices.size());
 
-	for (auto i = 0ui8; i < 3u; ++i)
+	for (auto i = 0u; i < 3u; ++i)
 	{
 		fscanf_s(pFile, "%u", &v[i]);
 		v[i] = (v[i] < 0) ? v[i] + uNumVert - 1 : v[i] - 1;
 		m_vIndices[uNumTri * 3 + i] = v[i];
 
-		if (m_vTIndices.size() > 0)
-		{
-			fscanf_s(pFile, "/%u", &vt[i]);
-			vt[i] = (vt[i] < 0) ? vt[i] + uNumVert - 1 : vt[i] - 1;
-			m_vTIndices[uNumTri * 3 + i] = vt[i];
-		}
-		else if (m_vNIndices.size() > 0) fscanf_s(pFile, "/");
-
-		if (m_vNIndices.size() > 0)
-		{
-			fscanf_s(pFile, "/%u", &vn[i]);
-			vn[i] = (vn[i] < 0) ? vn[i] + uNumVert - 1 : vn[i] - 1;
-			m_vNIndices[uNumTri * 3 + i] = vn[i];
-		}
+		if (m_bHasTexcoord) fscanf_s(pFile, "/%*u");
+		else if (m_bHasNormal) fscanf_s(pFile, "/");
+		if (m_bHasNormal) fscanf_s(pFile, "/%*u");
 	}
 	++uNumTri;
 
 	v[1] = v[2];
-	vt[1] = vt[2];
-	vn[1] = vn[2];
 
 	while (fscanf_s(pFile, "%u", &v[2]) > 0)
 	{
@@ -237,26 +261,9 @@ void ObjLoader::loadIndex(FILE *pFile, uint32_t &uNumTri)
 		m_vIndices[uNumTri * 3 + 2] = v[2];
 		v[1] = v[2];
 
-		if (m_vTIndices.size() > 0)
-		{
-			fscanf_s(pFile, "/%u", &vt[2]);
-			vt[2] = (vt[2] < 0) ? vt[2] + uNumVert - 1 : vt[2] - 1;
-			m_vTIndices[uNumTri * 3] = vt[0];
-			m_vTIndices[uNumTri * 3 + 1] = vt[1];
-			m_vTIndices[uNumTri * 3 + 2] = vt[2];
-			vt[1] = vt[2];
-		}
-		else if (m_vNIndices.size() > 0) fscanf_s(pFile, "/");
-
-		if (m_vNIndices.size() > 0)
-		{
-			fscanf_s(pFile, "/%u", &vn[2]);
-			vn[2] = (vn[2] < 0) ? vn[2] + uNumVert - 1 : vn[2] - 1;
-			m_vNIndices[uNumTri * 3] = vn[0];
-			m_vNIndices[uNumTri * 3 + 1] = vn[1];
-			m_vNIndices[uNumTri * 3 + 2] = vn[2];
-			vn[1] = vn[2];
-		}
+		if (m_bHasTexcoord) fscanf_s(pFile, "/%*u");
+		else if (m_bHasNormal) fscanf_s(pFile, "/");
+		if (m_bHasNormal) fscanf_s(pFile, "/%*u");
 
 		++uNumTri;
 	}
@@ -342,6 +349,9 @@ void ObjLoader::computeBound()
 		else if (z > zMax) zMax = z;
 	}
 
+	m_vAABBMin = float3(xMin, yMin, zMin);
+	m_vAABBMax = float3(xMax, yMax, zMax);
+
 	m_vCenter.x = (xMin + xMax) / 2.0f;
 	m_vCenter.y = (yMin + yMax) / 2.0f;
 	m_vCenter.z = (zMin + zMax) / 2.0f;
@@ -4,6 +4,10 @@
 
 #pragma once
 
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
 class ObjLoader
 {
 public:
@@ -42,6 +46,11 @@ public:
 
 	const float3& GetCenter() const;
 	const float GetRadius() const;
+	const float3& GetAABBMin() const;
+	const float3& GetAABBMax() const;
+
+	// Bytes held at the end of parsing
+	const size_t GetPeakBytes() const;
 
 protected:
 	void importGeometryFirstPass(FILE *pFile);
@@ -52,9 +61,16 @@ protected:
 
 	vVertex		m_vVertices;
 	vuint		m_vIndices;
-	vuint		m_vTIndices;
-	vuint		m_vNIndices;
+
+	// The face texcoord and normal indices are skipped, as no vertex keeps a texcoord and
+	// the normals are recomputed or read per vertex
+	bool		m_bHasTexcoord;
+	bool		m_bHasNormal;
 
 	float3		m_vCenter;
 	float		m_fRadius;
+	float3		m_vAABBMin;
+	float3		m_vAABBMax;
+
+	size_t		m_uPeakBytes;
 };
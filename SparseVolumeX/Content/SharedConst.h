@@ -3,7 +3,80 @@
 //--------------------------------------------------------------------------------------
 
 #define	NUM_K_LAYERS		16
-#define	SHADOW_MAP_SIZE		1024
+
+#ifndef	SHADOW_MAP_SIZE
+#define	SHADOW_MAP_SIZE		256		// Per cascade
+#endif
+
+// Light-space thickness filters over the prefix-summed light k-buffer.
+// Mean absolute error of the thickness in front of random points of the
+// bound of a sphere, relative to its diameter, with the ortho light frustum
+// spanning 3 radii (the coarsest cascade; nearer cascades are denser), as
+// measured on the CPU light field by SparseVolumeBench --suite filter:
+//
+//	SHADOW_MAP_SIZE		point		bilinear	edge-aware
+//	128					3.0e-3		5.6e-4		9.9e-4
+//	256					1.5e-3		1.8e-4		3.4e-4
+//	512					7.3e-4		6.3e-5		1.2e-4
+//	1024				3.7e-4		2.0e-5		3.6e-5
+//
+// Point sampling converges as O(h) in the texel size h, bilinear as about
+// O(h^1.6), short of O(h^2) because of the silhouette, where the thickness
+// has an infinite gradient. Bilinear at 256 beats point at 1024.
+// Edge-aware filtering gives up some accuracy on a single convex shape, but
+// keeps separate occluders from bleeding into each other across silhouettes.
+#define	THICKNESS_FILTER_POINT		0
+#define	THICKNESS_FILTER_BILINEAR	1
+#define	THICKNESS_FILTER_EDGE_AWARE	2
+
+#ifndef	THICKNESS_FILTER
+#define	THICKNESS_FILTER	THICKNESS_FILTER_BILINEAR
+#endif
+
+// Lights evaluated in one pass over the camera intervals; each light peels
+// its own NUM_K_LAYERS slices of the light-space k-buffer array
+#ifndef	NUM_LIGHTS
+#define	NUM_LIGHTS			1
+#endif
+
+// Each light has NUM_CASCADE (XSDXSharedConst.h, at most 4) orthographic
+// cascades split by camera view depth over the depth range of the object
+#define	NUM_LIGHT_VIEWS		(NUM_LIGHTS * NUM_CASCADE)
+
+// Temporal accumulation: each pixel of a TEMPORAL_TILE x TEMPORAL_TILE tile is integrated
+// once every TEMPORAL_SUBSET frames and reprojected from the history in between
+#define	TEMPORAL_TILE		2
+#define	TEMPORAL_SUBSET		(TEMPORAL_TILE * TEMPORAL_TILE)
+#define	TEMPORAL_JITTERS	8
+
+// Transmission evaluators, see Core/SVXTransmission.h for the error bounds
+#define	TRANSMISSION_EXACT	0
+#define	TRANSMISSION_POLY	1
+#define	TRANSMISSION_LUT	2
+
+#ifndef	TRANSMISSION
+#define	TRANSMISSION		TRANSMISSION_EXACT
+#endif
+
+#define	TRANSMISSION_LUT_SIZE	1024
+
+// Heterogeneous density from a sparse brick volume over the mesh bound
+#ifndef	HETEROGENEOUS
+#define	HETEROGENEOUS		0
+#endif
+
+#define	DENSITY_BRICK_SIZE	8
+#define	DENSITY_VOLUME_RES	128		// Voxels across the bounding cube
+#define	MAX_DENSITY_STEPS	64		// Max samples per k-buffer interval
 
 static const float g_fZNearLS = 1.0f;
 static const float g_fZFarLS = 128.0f;
+
+static const float g_fDensity = 1.0f;
+static const float g_fAbsorption = 1.0f;
+static const float g_fTransmissionLUTMax = 16.0f;	// Max optical depth covered by the LUT
+static const float g_fThicknessEdgeTol = 0.25f;		// Relative thickness deviation of the edge-aware filter
+static const float g_fCascadeSplitLog = 0.5f;		// Weight of the logarithmic split against the uniform one
+
+static const float g_fHistoryBlend = 0.1f;		// Weight of the newly integrated sample
+static const float g_fHistoryDepthTol = 0.02f;	// Relative view-depth tolerance for history reuse
@@ -4,86 +4,46 @@
 
 #pragma once
 
-#include "XSDXShader.h"
-#include "XSDXState.h"
-#include "XSDXResource.h"
+#include <string>
+#include "SVXBackend.h"
 
+class ObjLoader;
+
+//--------------------------------------------------------------------------------------
+// Sparse volume of a mesh: owns the algorithmic state (bound, matrices, K) and drives
+// the passes of a backend, Direct3D 11 in the viewer or the CPU one headless
+//--------------------------------------------------------------------------------------
 class SparseVolume
 {
 public:
-	enum VertexShaderID : uint32_t
-	{
-		VS_BASEPASS
-	};
-
-	enum PixelShaderID : uint32_t
-	{
-		PS_DEPTH_PEEL,
-		PS_TEST
-	};
-
-	enum ComputeShaderID : uint32_t
-	{
-		CS_RENDER
-	};
-
-	SparseVolume(const XSDX::CPDXDevice &pDXDevice, const XSDX::spShader &pShader, const XSDX::spState &pState);
+	SparseVolume(const SVX::spBackend &pBackend);
 	virtual ~SparseVolume();
 
-	void Init(const uint32_t uWidth, const uint32_t uHeight, const char *szFileName = "Media\\bunny.obj");
-	void UpdateFrame(DirectX::CXMVECTOR vEyePt, DirectX::CXMMATRIX mViewProj);
-	void Render(const XSDX::CPDXUnorderedAccessView &pUAVSwapChain);
-	void RenderTest();
-
-	static void CreateVertexLayout(const XSDX::CPDXDevice &pDXDevice, XSDX::CPDXInputLayout &pVertexLayout,
-		const XSDX::spShader &pShader, const uint8_t uVS);
+	bool Init(const uint32_t uWidth, const uint32_t uHeight, const char *szFileName = "Media\\bunny.obj");
+	void UpdateFrame(const SVX::float3 &vEyePt, const SVX::float4x4 &mViewProj);
+	void SetLight(const uint8_t i, const SVX::float3 &vPosition, const SVX::float3 &vColor);
+	void Render();
 
-	static XSDX::CPDXInputLayout &GetVertexLayout();
+	// Times the passes on the CPU and through the backend, e.g. GPU timestamps; null to disable
+	void SetProfiler(SVX::Profiler *pProfiler);
 
-protected:
-	struct CBMatrices
-	{
-		DirectX::XMMATRIX mWorldViewProj;
-		DirectX::XMMATRIX mWorld;
-		DirectX::XMMATRIX mWorldIT;
-	};
-
-	struct CBPerObject
-	{
-		DirectX::XMMATRIX mViewProjLS;
-		DirectX::XMMATRIX mScreenToWorld;
-	};
-
-	void createVB(const uint32_t uNumVert, const uint32_t uStride, const uint8_t *pData);
-	void createIB(const uint32_t uNumIndices, const uint32_t *pData);
-	void createCBs();
-
-	void depthPeel();
-	void depthPeelLightSpace();
-	void render(const XSDX::CPDXUnorderedAccessView &pUAVSwapChain);
+	// Accounts the resources of the volume under its mesh file name; set before Init()
+	void SetMemoryTracker(SVX::MemoryTracker *pMemoryTracker);
 
-	uint32_t						m_uVertexStride;
-	uint32_t						m_uNumIndices;
+	const SVX::VolumeState &GetState() const;
+	const SVX::spBackend &GetBackend() const;
 
-	DirectX::XMFLOAT4				m_vBound;
-	DirectX::XMFLOAT2				m_vViewport;
-
-	XSDX::upRawBuffer				m_pVB;
-	XSDX::upRawBuffer				m_pIB;
-	XSDX::CPDXBuffer				m_pCBMatrices;
-	XSDX::CPDXBuffer				m_pCBMatricesLS;
-	XSDX::CPDXBuffer				m_pCBPerObject;
-	
-	XSDX::upTexture2D				m_pTxKBufferDepth;		// View-screen space
-	XSDX::upTexture2D				m_pTxKBufferDepthLS;	// Light space
-
-	XSDX::spShader					m_pShader;
-	XSDX::spState					m_pState;
+protected:
+	void createDensityVolume(const ObjLoader &objLoader);
+	void track(const char *pszResource, const SVX::MemoryTracker::Category eCategory, const size_t uBytes);
 
-	XSDX::CPDXDevice				m_pDXDevice;
-	XSDX::CPDXContext				m_pDXContext;
+	SVX::VolumeState				m_state;
+	SVX::spBackend					m_pBackend;
+	SVX::FrameGraph					m_frameGraph;
 
-	static XSDX::CPDXInputLayout	m_pVertexLayout;
+	SVX::Profiler					*m_pProfiler;
+	SVX::MemoryTracker				*m_pMemoryTracker;
+	std::string						m_strAsset;
 };
 
 using upSparseVolume = std::unique_ptr<SparseVolume>;
@@ -0,0 +1,103 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "SVXArena.h"
+
+using namespace std;
+using namespace SVX;
+
+Arena::Arena(const size_t uBlockBytes) :
+	m_vBlocks(0),
+	m_uBlockBytes(uBlockBytes),
+	m_uOffset(0),
+	m_uUsedBytes(0),
+	m_uPeakBytes(0),
+	m_uNumBlockAllocations(0)
+{
+}
+
+Arena::~Arena()
+{
+}
+
+void *Arena::Allocate(const size_t uBytes, const size_t uAlignment)
+{
+	if (!m_vBlocks.empty())
+	{
+		auto &block = m_vBlocks.back();
+		const auto uAddress = reinterpret_cast<uintptr_t>(block.pData.get()) + m_uOffset;
+		const auto uPadding = (uAlignment - uAddress % uAlignment) % uAlignment;
+		if (m_uOffset + uPadding + uBytes <= block.uBytes)
+		{
+			m_uOffset += uPadding + uBytes;
+			m_uUsedBytes += uPadding + uBytes;
+			m_uPeakBytes = (std::max)(m_uPeakBytes, m_uUsedBytes);
+
+			return block.pData.get() + m_uOffset - uBytes;
+		}
+
+		// The rest of the last block is left unused
+		m_uUsedBytes += block.uBytes - m_uOffset;
+	}
+
+	addBlock(uBytes + uAlignment);
+
+	return Allocate(uBytes, uAlignment);
+}
+
+void Arena::Reset()
+{
+	// One block for all that was allocated since the last reset, with room for the
+	// alignments to fall differently
+	if (m_vBlocks.size() > 1)
+	{
+		const auto uBytes = m_uUsedBytes + m_uUsedBytes / 4;
+		m_vBlocks.clear();
+		addBlock(uBytes);
+	}
+
+	m_uOffset = 0;
+	m_uUsedBytes = 0;
+}
+
+void Arena::Release()
+{
+	m_vBlocks.clear();
+	m_vBlocks.shrink_to_fit();
+	m_uOffset = 0;
+	m_uUsedBytes = 0;
+}
+
+size_t Arena::GetBytes() const
+{
+	size_t uBytes = 0;
+	for (const auto &block : m_vBlocks) uBytes += block.uBytes;
+
+	return uBytes;
+}
+
+size_t Arena::GetUsedBytes() const
+{
+	return m_uUsedBytes;
+}
+
+size_t Arena::GetPeakBytes() const
+{
+	return m_uPeakBytes;
+}
+
+uint64_t Arena::GetNumBlockAllocations() const
+{
+	return m_uNumBlockAllocations;
+}
+
+void Arena::addBlock(const size_t uMinBytes)
+{
+	// Blocks at least double the arena, so that a growing workload takes few of them
+	const auto uBytes = (std::max)((std::max)(uMinBytes, m_uBlockBytes), GetBytes());
+	m_vBlocks.push_back({ unique_ptr<uint8_t[]>(new uint8_t[uBytes]), uBytes });
+	m_uOffset = 0;
+	++m_uNumBlockAllocations;
+}
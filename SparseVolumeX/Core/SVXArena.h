@@ -0,0 +1,97 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Linear allocator over blocks from the heap. Allocations are freed all at once by
+	// Reset(), which also merges the blocks into one of the high-water size, so that a
+	// workload repeated between resets, e.g. the scratch of a frame, stops touching the
+	// heap after its first round. Not thread-safe; a frame graph owns one for the passes
+	// it declares, which are built on a single thread.
+	//--------------------------------------------------------------------------------------
+	class Arena
+	{
+	public:
+		Arena(const size_t uBlockBytes = 64 * 1024);
+		virtual ~Arena();
+
+		Arena(const Arena &) = delete;
+		Arena &operator=(const Arena &) = delete;
+
+		void *Allocate(const size_t uBytes, const size_t uAlignment = alignof(std::max_align_t));
+
+		// Uninitialized storage of uCount objects
+		template<typename T>
+		T *Allocate(const size_t uCount) { return static_cast<T*>(Allocate(sizeof(T) * uCount, alignof(T))); }
+
+		// Frees every allocation, keeping one block of the high-water size
+		void Reset();
+
+		// Returns the blocks to the heap
+		void Release();
+
+		size_t GetBytes() const;		// Of the blocks
+		size_t GetUsedBytes() const;	// Allocated since the last reset
+		size_t GetPeakBytes() const;	// High water of the used bytes across resets
+		uint64_t GetNumBlockAllocations() const;
+
+	protected:
+		struct Block
+		{
+			std::unique_ptr<uint8_t[]>	pData;
+			size_t						uBytes;
+		};
+
+		void addBlock(const size_t uMinBytes);
+
+		std::vector<Block>	m_vBlocks;
+		size_t				m_uBlockBytes;
+		size_t				m_uOffset;		// In the last block
+		size_t				m_uUsedBytes;	// In the blocks before the last, plus the offset
+		size_t				m_uPeakBytes;
+		uint64_t			m_uNumBlockAllocations;
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Allocator of standard containers in an arena; deallocation is left to its reset, so
+	// a container must not outlive the reset of its arena
+	//--------------------------------------------------------------------------------------
+	template<typename T>
+	class ArenaAllocator
+	{
+	public:
+		using value_type = T;
+
+		ArenaAllocator(Arena &arena) : m_pArena(&arena) {}
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U> &allocator) : m_pArena(allocator.GetArena()) {}
+
+		T *allocate(const size_t n) { return m_pArena->Allocate<T>(n); }
+		void deallocate(T *, const size_t) {}
+
+		Arena *GetArena() const { return m_pArena; }
+
+		template<typename U>
+		bool operator==(const ArenaAllocator<U> &allocator) const { return m_pArena == allocator.GetArena(); }
+		template<typename U>
+		bool operator!=(const ArenaAllocator<U> &allocator) const { return m_pArena != allocator.GetArena(); }
+
+	protected:
+		Arena *m_pArena;
+	};
+
+	template<typename T>
+	using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+	using upArena = std::unique_ptr<Arena>;
+	using spArena = std::shared_ptr<Arena>;
+}
@@ -0,0 +1,563 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <atomic>
+#include <cassert>
+#include <limits>
+#include "SVXBVH.h"
+
+using namespace std;
+using namespace SVX;
+
+// Centroid bins per axis of a split
+static const uint32_t g_uNumBins = 16;
+
+// Cost of visiting a node against intersecting a triangle
+static const float g_fTraversalCost = 1.0f;
+
+// Largest leaf kept when a split does not pay, and the depth past which every node is a
+// leaf, which bounds the traversal stack
+static const uint32_t g_uMaxLeafSize = 8;
+static const uint32_t g_uMaxDepth = 48;
+
+// Triangles of a node whose children are built as separate tasks
+static const uint32_t g_uTaskThreshold = 4096;
+
+// Pixels per side of the resampling tiles, and per row of a packet
+static const uint32_t g_uTileSize = 32;
+static const uint32_t g_uPacketWidth = 4;
+
+const uint32_t BVH::PACKET_SIZE;
+
+struct BVH::Build
+{
+	Scheduler				&scheduler;
+	std::vector<uint32_t>	vIndices;		// Triangles, partitioned in place
+	std::vector<float3>		vBoundMin;
+	std::vector<float3>		vBoundMax;
+	std::vector<float3>		vCentroids;
+	std::atomic<uint32_t>	uNumNodes;
+};
+
+struct Bin
+{
+	float3		vMin;
+	float3		vMax;
+	uint32_t	uCount;
+};
+
+static float halfArea(const float3 &vMin, const float3 &vMax)
+{
+	const auto vExtent = vMax - vMin;
+
+	return vExtent.x * vExtent.y + vExtent.y * vExtent.z + vExtent.z * vExtent.x;
+}
+
+static bool hitBox(const float3 &vMin, const float3 &vMax, const float3 &vOrigin, const float3 &vDirInv,
+	const float fTMin, const float fTMax)
+{
+	auto t0 = fTMin, t1 = fTMax;
+	for (auto i = 0u; i < 3; ++i)
+	{
+		auto ta = (vMin[i] - vOrigin[i]) * vDirInv[i];
+		auto tb = (vMax[i] - vOrigin[i]) * vDirInv[i];
+		if (ta > tb) swap(ta, tb);
+		t0 = (std::max)(t0, ta);
+		t1 = (std::min)(t1, tb);
+	}
+
+	return t0 <= t1;
+}
+
+// Moller-Trumbore, both faces
+static bool hitTriangle(const float3 &v0, const float3 &vEdge1, const float3 &vEdge2, const float3 &vOrigin,
+	const float3 &vDir, float &t)
+{
+	const auto vP = cross(vDir, vEdge2);
+	const auto fDet = dot(vEdge1, vP);
+	if (fDet == 0.0f) return false;
+
+	const auto fDetInv = 1.0f / fDet;
+	const auto vS = vOrigin - v0;
+	const auto u = dot(vS, vP) * fDetInv;
+	if (u < 0.0f || u > 1.0f) return false;
+
+	const auto vQ = cross(vS, vEdge1);
+	const auto v = dot(vDir, vQ) * fDetInv;
+	if (v < 0.0f || u + v > 1.0f) return false;
+	t = dot(vEdge2, vQ) * fDetInv;
+
+	return true;
+}
+
+// Appends the (ray, t) hits of uNumRays rays to the batch, sorted by ray and then by t
+static void appendHits(vector<pair<uint32_t, float>> &vRayHits, const uint32_t uNumRays, BVH::RayHits &hits)
+{
+	sort(vRayHits.begin(), vRayHits.end());
+	if (hits.vOffsets.empty()) hits.vOffsets.push_back(0);
+
+	auto uHit = 0u;
+	for (auto i = 0u; i < uNumRays; ++i)
+	{
+		for (; uHit < vRayHits.size() && vRayHits[uHit].first == i; ++uHit) hits.vT.push_back(vRayHits[uHit].second);
+		hits.vOffsets.push_back(static_cast<uint32_t>(hits.vT.size()));
+	}
+}
+
+BVH::BVH() :
+	m_vNodes(0),
+	m_vTriangles(0)
+{
+}
+
+BVH::~BVH()
+{
+}
+
+void BVH::Create(const Mesh &mesh, Scheduler &scheduler)
+{
+	setBound(mesh);
+
+	const auto pPositions = mesh.GetPositions();
+	const auto pIndices = mesh.GetIndices();
+	const auto uNumTriangles = mesh.GetNumIndices() / 3;
+	Build build = { scheduler, vector<uint32_t>(uNumTriangles), vector<float3>(uNumTriangles),
+		vector<float3>(uNumTriangles), vector<float3>(uNumTriangles), { 1 } };
+	scheduler.ParallelFor(0, uNumTriangles, 1024, [&](const uint32_t uBegin, const uint32_t uEnd, uint32_t)
+	{
+		for (auto i = uBegin; i < uEnd; ++i)
+		{
+			const auto &v0 = pPositions[pIndices[i * 3]];
+			const auto &v1 = pPositions[pIndices[i * 3 + 1]];
+			const auto &v2 = pPositions[pIndices[i * 3 + 2]];
+			build.vIndices[i] = i;
+			build.vBoundMin[i] = (min)((min)(v0, v1), v2);
+			build.vBoundMax[i] = (max)((max)(v0, v1), v2);
+			build.vCentroids[i] = (build.vBoundMin[i] + build.vBoundMax[i]) * 0.5f;
+		}
+	});
+
+	// A binary tree has fewer than twice as many nodes as leaves
+	m_vNodes.resize((std::max)(uNumTriangles * 2, 1u));
+	m_vNodes[0] = { float3(0.0f), 0, float3(0.0f), 0 };
+	if (uNumTriangles > 0) buildNode(build, 0, 0, uNumTriangles, 0);
+	m_vNodes.resize(build.uNumNodes);
+	m_vNodes.shrink_to_fit();
+
+	m_vTriangles.resize(uNumTriangles);
+	for (auto i = 0u; i < uNumTriangles; ++i)
+	{
+		const auto uTriangle = build.vIndices[i];
+		const auto &v0 = pPositions[pIndices[uTriangle * 3]];
+		m_vTriangles[i] = { v0, pPositions[pIndices[uTriangle * 3 + 1]] - v0, pPositions[pIndices[uTriangle * 3 + 2]] - v0 };
+	}
+}
+
+void BVH::Intersect(const float3 &vOrigin, const float3 &vDir, const float fTMin, const float fTMax,
+	vector<float> &vT) const
+{
+	vT.clear();
+	if (m_vTriangles.empty()) return;
+
+	const float3 vDirInv(1.0f / vDir.x, 1.0f / vDir.y, 1.0f / vDir.z);
+
+	// Every node the ray meets is visited, as no hit may be missed, so the order is free
+	uint32_t vStack[g_uMaxDepth + 2];
+	auto uStackSize = 0u;
+	vStack[uStackSize++] = 0;
+	while (uStackSize > 0)
+	{
+		const auto &node = m_vNodes[vStack[--uStackSize]];
+		if (!hitBox(node.vMin, node.vMax, vOrigin, vDirInv, fTMin, fTMax)) continue;
+
+		if (node.uCount == 0)
+		{
+			vStack[uStackSize++] = node.uIndex;
+			vStack[uStackSize++] = node.uIndex + 1;
+			continue;
+		}
+
+		for (auto i = node.uIndex; i < node.uIndex + node.uCount; ++i)
+		{
+			const auto &triangle = m_vTriangles[i];
+			float t;
+			if (hitTriangle(triangle.v0, triangle.vEdge1, triangle.vEdge2, vOrigin, vDir, t) &&
+				t >= fTMin && t <= fTMax) vT.push_back(t);
+		}
+	}
+
+	sort(vT.begin(), vT.end());
+}
+
+void BVH::IntersectPacket(const float3 *pOrigins, const float3 *pDirs, const uint32_t uNumRays,
+	const float fTMin, const float fTMax, RayHits &hits) const
+{
+	assert(uNumRays <= PACKET_SIZE);
+	static thread_local vector<pair<uint32_t, float>> vRayHits;
+	vRayHits.clear();
+
+	// Lanes as structures of arrays; the unused ones repeat the last ray with an empty range
+	float vOx[PACKET_SIZE], vOy[PACKET_SIZE], vOz[PACKET_SIZE];
+	float vDx[PACKET_SIZE], vDy[PACKET_SIZE], vDz[PACKET_SIZE];
+	float vIx[PACKET_SIZE], vIy[PACKET_SIZE], vIz[PACKET_SIZE], vTMax[PACKET_SIZE];
+	for (auto i = 0u; i < PACKET_SIZE; ++i)
+	{
+		const auto uRay = (std::min)(i, uNumRays - 1);
+		vOx[i] = pOrigins[uRay].x;
+		vOy[i] = pOrigins[uRay].y;
+		vOz[i] = pOrigins[uRay].z;
+		vDx[i] = pDirs[uRay].x;
+		vDy[i] = pDirs[uRay].y;
+		vDz[i] = pDirs[uRay].z;
+		vIx[i] = 1.0f / vDx[i];
+		vIy[i] = 1.0f / vDy[i];
+		vIz[i] = 1.0f / vDz[i];
+		vTMax[i] = i < uNumRays ? fTMax : -numeric_limits<float>::infinity();
+	}
+
+	uint32_t vStack[g_uMaxDepth + 2];
+	auto uStackSize = 0u;
+	if (uNumRays > 0 && !m_vTriangles.empty()) vStack[uStackSize++] = 0;
+	while (uStackSize > 0)
+	{
+		const auto &node = m_vNodes[vStack[--uStackSize]];
+
+		// Slabs of all lanes, branch-free so that the lanes map to vector registers
+		int32_t vHits[PACKET_SIZE];
+		for (auto i = 0u; i < PACKET_SIZE; ++i)
+		{
+			const auto tx0 = (node.vMin.x - vOx[i]) * vIx[i], tx1 = (node.vMax.x - vOx[i]) * vIx[i];
+			const auto ty0 = (node.vMin.y - vOy[i]) * vIy[i], ty1 = (node.vMax.y - vOy[i]) * vIy[i];
+			const auto tz0 = (node.vMin.z - vOz[i]) * vIz[i], tz1 = (node.vMax.z - vOz[i]) * vIz[i];
+			const auto t0 = (std::max)((std::max)(fTMin, (std::min)(tx0, tx1)),
+				(std::max)((std::min)(ty0, ty1), (std::min)(tz0, tz1)));
+			const auto t1 = (std::min)((std::min)(vTMax[i], (std::max)(tx0, tx1)),
+				(std::min)((std::max)(ty0, ty1), (std::max)(tz0, tz1)));
+			vHits[i] = -(t0 <= t1);
+		}
+
+		auto iAny = 0;
+		for (auto i = 0u; i < PACKET_SIZE; ++i) iAny |= vHits[i];
+		if (!iAny) continue;
+
+		if (node.uCount == 0)
+		{
+			vStack[uStackSize++] = node.uIndex;
+			vStack[uStackSize++] = node.uIndex + 1;
+			continue;
+		}
+
+		// Each triangle on all lanes, the hits kept for the lanes in the node
+		for (auto k = node.uIndex; k < node.uIndex + node.uCount; ++k)
+		{
+			const auto &triangle = m_vTriangles[k];
+			const auto &v0 = triangle.v0, &vE1 = triangle.vEdge1, &vE2 = triangle.vEdge2;
+			float vT[PACKET_SIZE];
+			int32_t vValid[PACKET_SIZE];
+			for (auto i = 0u; i < PACKET_SIZE; ++i)
+			{
+				const auto px = vDy[i] * vE2.z - vDz[i] * vE2.y;
+				const auto py = vDz[i] * vE2.x - vDx[i] * vE2.z;
+				const auto pz = vDx[i] * vE2.y - vDy[i] * vE2.x;
+				const auto fDet = vE1.x * px + vE1.y * py + vE1.z * pz;
+				const auto fDetInv = 1.0f / fDet;
+				const auto sx = vOx[i] - v0.x, sy = vOy[i] - v0.y, sz = vOz[i] - v0.z;
+				const auto u = (sx * px + sy * py + sz * pz) * fDetInv;
+				const auto qx = sy * vE1.z - sz * vE1.y;
+				const auto qy = sz * vE1.x - sx * vE1.z;
+				const auto qz = sx * vE1.y - sy * vE1.x;
+				const auto v = (vDx[i] * qx + vDy[i] * qy + vDz[i] * qz) * fDetInv;
+				const auto t = (vE2.x * qx + vE2.y * qy + vE2.z * qz) * fDetInv;
+				vT[i] = t;
+				vValid[i] = vHits[i] & -((fDet != 0.0f) & (u >= 0.0f) & (u <= 1.0f) & (v >= 0.0f) &
+					(u + v <= 1.0f) & (t >= fTMin) & (t <= vTMax[i]));
+			}
+			for (auto i = 0u; i < PACKET_SIZE; ++i) if (vValid[i]) vRayHits.emplace_back(i, vT[i]);
+		}
+	}
+
+	appendHits(vRayHits, uNumRays, hits);
+}
+
+void BVH::IntersectStream(const float3 *pOrigins, const float3 *pDirs, const uint32_t uNumRays,
+	const float fTMin, const float fTMax, RayHits &hits) const
+{
+	struct Entry
+	{
+		uint32_t uNode;
+		uint32_t uBegin;	// Rays reaching the node, in the active lists
+		uint32_t uEnd;
+	};
+
+	// The active rays as structures of arrays, so that the slab tests of a node run over
+	// contiguous lanes. The rays passed on by a node follow those it was given, which no
+	// later entry of the stack reads, so the lists are cut back to an entry when it is
+	// popped.
+	static thread_local vector<float> vOx, vOy, vOz, vIx, vIy, vIz;
+	static thread_local vector<uint32_t> vRays;
+	static thread_local vector<int32_t> vHits;
+	const auto reserve = [](const uint32_t uSize)
+	{
+		if (vRays.size() >= uSize) return;
+		for (auto pList : { &vOx, &vOy, &vOz, &vIx, &vIy, &vIz }) pList->resize(uSize);
+		vRays.resize(uSize);
+		vHits.resize(uSize);
+	};
+
+	reserve(uNumRays);
+	for (auto i = 0u; i < uNumRays; ++i)
+	{
+		vOx[i] = pOrigins[i].x;
+		vOy[i] = pOrigins[i].y;
+		vOz[i] = pOrigins[i].z;
+		vIx[i] = 1.0f / pDirs[i].x;
+		vIy[i] = 1.0f / pDirs[i].y;
+		vIz[i] = 1.0f / pDirs[i].z;
+		vRays[i] = i;
+	}
+	vector<pair<uint32_t, float>> vRayHits;
+
+	Entry vStack[g_uMaxDepth + 2];
+	auto uStackSize = 0u;
+	if (uNumRays > 0 && !m_vTriangles.empty()) vStack[uStackSize++] = { 0, 0, uNumRays };
+	while (uStackSize > 0)
+	{
+		const auto entry = vStack[--uStackSize];
+		const auto &node = m_vNodes[entry.uNode];
+		reserve(entry.uEnd + (entry.uEnd - entry.uBegin));
+
+		// Slabs of all the rays, branch-free, then the hits compacted after them
+		const auto pOx = vOx.data(), pOy = vOy.data(), pOz = vOz.data();
+		const auto pIx = vIx.data(), pIy = vIy.data(), pIz = vIz.data();
+		const auto pHits = vHits.data();
+		for (auto i = entry.uBegin; i < entry.uEnd; ++i)
+		{
+			const auto tx0 = (node.vMin.x - pOx[i]) * pIx[i], tx1 = (node.vMax.x - pOx[i]) * pIx[i];
+			const auto ty0 = (node.vMin.y - pOy[i]) * pIy[i], ty1 = (node.vMax.y - pOy[i]) * pIy[i];
+			const auto tz0 = (node.vMin.z - pOz[i]) * pIz[i], tz1 = (node.vMax.z - pOz[i]) * pIz[i];
+			const auto t0 = (std::max)((std::max)(fTMin, (std::min)(tx0, tx1)),
+				(std::max)((std::min)(ty0, ty1), (std::min)(tz0, tz1)));
+			const auto t1 = (std::min)((std::min)(fTMax, (std::max)(tx0, tx1)),
+				(std::min)((std::max)(ty0, ty1), (std::max)(tz0, tz1)));
+			pHits[i] = t0 <= t1;
+		}
+
+		const auto uBegin = entry.uEnd;
+		auto uEnd = uBegin;
+		for (auto i = entry.uBegin; i < entry.uEnd; ++i)
+		{
+			vOx[uEnd] = vOx[i];
+			vOy[uEnd] = vOy[i];
+			vOz[uEnd] = vOz[i];
+			vIx[uEnd] = vIx[i];
+			vIy[uEnd] = vIy[i];
+			vIz[uEnd] = vIz[i];
+			vRays[uEnd] = vRays[i];
+			uEnd += vHits[i];
+		}
+		if (uBegin == uEnd) continue;
+
+		if (node.uCount == 0)
+		{
+			vStack[uStackSize++] = { node.uIndex, uBegin, uEnd };
+			vStack[uStackSize++] = { node.uIndex + 1, uBegin, uEnd };
+			continue;
+		}
+
+		for (auto k = node.uIndex; k < node.uIndex + node.uCount; ++k)
+		{
+			const auto &triangle = m_vTriangles[k];
+			for (auto i = uBegin; i < uEnd; ++i)
+			{
+				const auto uRay = vRays[i];
+				float t;
+				if (hitTriangle(triangle.v0, triangle.vEdge1, triangle.vEdge2, pOrigins[uRay], pDirs[uRay], t) &&
+					t >= fTMin && t <= fTMax) vRayHits.emplace_back(uRay, t);
+			}
+		}
+	}
+
+	appendHits(vRayHits, uNumRays, hits);
+}
+
+uint32_t BVH::CastRay(const float3 &vOrigin, const float3 &vDir, const float fTMin, const float fTMax,
+	float *pT, const uint32_t uMaxValues) const
+{
+	// Reused by the rays of a thread; a hit left unpaired is dropped, as by the peel
+	static thread_local vector<float> vHits;
+	Intersect(vOrigin, vDir, fTMin, fTMax, vHits);
+	const auto uCount = (std::min)(static_cast<uint32_t>(vHits.size()), uMaxValues) & ~1u;
+	copy(vHits.cbegin(), vHits.cbegin() + uCount, pT);
+
+	return uCount;
+}
+
+void BVH::Resample(const float4x4 &mViewProj, const float4x4 &mScreenToWorld, KBuffer &kBuffer,
+	const uint32_t uRowBegin, const uint32_t uRowEnd) const
+{
+	const auto uWidth = kBuffer.GetWidth();
+	const auto uNumLayers = kBuffer.GetNumLayers();
+	const auto yBegin = (std::max)(uRowBegin, kBuffer.GetRowBegin());
+	const auto yEnd = (std::min)(uRowEnd, kBuffer.GetRowEnd());
+	const auto uPacketHeight = PACKET_SIZE / g_uPacketWidth;
+
+	RayHits hits;
+	float3 vOrigins[PACKET_SIZE], vDirs[PACKET_SIZE];
+	uint32_t vX[PACKET_SIZE], vY[PACKET_SIZE];
+	for (auto uTileY = yBegin; uTileY < yEnd; uTileY += g_uTileSize)
+	{
+		const auto uTileYEnd = (std::min)(uTileY + g_uTileSize, yEnd);
+		for (auto uTileX = 0u; uTileX < uWidth; uTileX += g_uTileSize)
+		{
+			const auto uTileXEnd = (std::min)(uTileX + g_uTileSize, uWidth);
+			for (auto uPacketY = uTileY; uPacketY < uTileYEnd; uPacketY += uPacketHeight)
+			{
+				for (auto uPacketX = uTileX; uPacketX < uTileXEnd; uPacketX += g_uPacketWidth)
+				{
+					auto uNumRays = 0u;
+					for (auto y = uPacketY; y < (std::min)(uPacketY + uPacketHeight, uTileYEnd); ++y)
+					{
+						for (auto x = uPacketX; x < (std::min)(uPacketX + g_uPacketWidth, uTileXEnd); ++x, ++uNumRays)
+						{
+							getPixelRay(mScreenToWorld, x, y, vOrigins[uNumRays], vDirs[uNumRays]);
+							vX[uNumRays] = x;
+							vY[uNumRays] = y;
+						}
+					}
+
+					hits.vT.clear();
+					hits.vOffsets.clear();
+					IntersectPacket(vOrigins, vDirs, uNumRays, 0.0f, 1.0f, hits);
+
+					// The nearest pairs, a hit left unpaired dropped as by CastRay()
+					for (auto i = 0u; i < uNumRays; ++i)
+					{
+						const auto uCount = (std::min)(hits.vOffsets[i + 1] - hits.vOffsets[i], uNumLayers) & ~1u;
+						writeLayers(mViewProj, vOrigins[i], vDirs[i], hits.vT.data() + hits.vOffsets[i], uCount,
+							kBuffer.GetLayers(vX[i], vY[i]), uNumLayers);
+					}
+				}
+			}
+		}
+	}
+}
+
+uint32_t BVH::GetNumNodes() const
+{
+	return static_cast<uint32_t>(m_vNodes.size());
+}
+
+uint32_t BVH::GetNumTriangles() const
+{
+	return static_cast<uint32_t>(m_vTriangles.size());
+}
+
+size_t BVH::GetBytes() const
+{
+	return sizeof(Node) * m_vNodes.size() + sizeof(Triangle) * m_vTriangles.size();
+}
+
+void BVH::buildNode(Build &build, const uint32_t uNode, const uint32_t uBegin, const uint32_t uEnd,
+	const uint32_t uDepth)
+{
+	auto &node = m_vNodes[uNode];
+	auto vCentroidMin = float3(numeric_limits<float>::max()), vCentroidMax = float3(-numeric_limits<float>::max());
+	node.vMin = vCentroidMin;
+	node.vMax = vCentroidMax;
+	for (auto i = uBegin; i < uEnd; ++i)
+	{
+		const auto uTriangle = build.vIndices[i];
+		node.vMin = (min)(node.vMin, build.vBoundMin[uTriangle]);
+		node.vMax = (max)(node.vMax, build.vBoundMax[uTriangle]);
+		vCentroidMin = (min)(vCentroidMin, build.vCentroids[uTriangle]);
+		vCentroidMax = (max)(vCentroidMax, build.vCentroids[uTriangle]);
+	}
+
+	const auto uCount = uEnd - uBegin;
+	node.uIndex = uBegin;
+	node.uCount = uCount;
+	if (uCount == 1 || uDepth >= g_uMaxDepth) return;
+
+	// Binned SAH over the three axes; the costs are relative to the area of the node
+	auto fBestCost = numeric_limits<float>::max();
+	auto uBestAxis = 0u, uBestBin = 0u;
+	const auto vCentroidExtent = vCentroidMax - vCentroidMin;
+	for (auto uAxis = 0u; uAxis < 3; ++uAxis)
+	{
+		if (vCentroidExtent[uAxis] <= 0.0f) continue;
+
+		Bin vBins[g_uNumBins];
+		for (auto &bin : vBins) bin = { float3(numeric_limits<float>::max()), float3(-numeric_limits<float>::max()), 0 };
+		const auto fScale = g_uNumBins / vCentroidExtent[uAxis];
+		for (auto i = uBegin; i < uEnd; ++i)
+		{
+			const auto uTriangle = build.vIndices[i];
+			const auto uBin = (std::min)(static_cast<uint32_t>((build.vCentroids[uTriangle][uAxis] -
+				vCentroidMin[uAxis]) * fScale), g_uNumBins - 1);
+			auto &bin = vBins[uBin];
+			bin.vMin = (min)(bin.vMin, build.vBoundMin[uTriangle]);
+			bin.vMax = (max)(bin.vMax, build.vBoundMax[uTriangle]);
+			++bin.uCount;
+		}
+
+		// Right sides swept from the last bin, then every split from the first
+		float vRightCosts[g_uNumBins];
+		auto vMin = vBins[g_uNumBins - 1].vMin, vMax = vBins[g_uNumBins - 1].vMax;
+		auto uRightCount = vBins[g_uNumBins - 1].uCount;
+		for (auto i = g_uNumBins - 1; i > 0; --i)
+		{
+			vRightCosts[i] = uRightCount > 0 ? halfArea(vMin, vMax) * uRightCount : 0.0f;
+			vMin = (min)(vMin, vBins[i - 1].vMin);
+			vMax = (max)(vMax, vBins[i - 1].vMax);
+			uRightCount += vBins[i - 1].uCount;
+		}
+
+		vMin = vBins[0].vMin;
+		vMax = vBins[0].vMax;
+		auto uLeftCount = vBins[0].uCount;
+		for (auto i = 1u; i < g_uNumBins; ++i)
+		{
+			const auto fCost = (uLeftCount > 0 ? halfArea(vMin, vMax) * uLeftCount : 0.0f) + vRightCosts[i];
+			if (uLeftCount > 0 && uLeftCount < uCount && fCost < fBestCost)
+			{
+				fBestCost = fCost;
+				uBestAxis = uAxis;
+				uBestBin = i;
+			}
+			vMin = (min)(vMin, vBins[i].vMin);
+			vMax = (max)(vMax, vBins[i].vMax);
+			uLeftCount += vBins[i].uCount;
+		}
+	}
+
+	// A leaf if no split separates the centroids, or if none beats it while it is small
+	if (fBestCost == numeric_limits<float>::max()) return;
+	const auto fSplitCost = g_fTraversalCost + fBestCost / halfArea(node.vMin, node.vMax);
+	if (uCount <= g_uMaxLeafSize && fSplitCost >= uCount) return;
+
+	const auto fScale = g_uNumBins / vCentroidExtent[uBestAxis];
+	const auto pMid = partition(build.vIndices.begin() + uBegin, build.vIndices.begin() + uEnd,
+		[&](const uint32_t uTriangle)
+	{
+		return (std::min)(static_cast<uint32_t>((build.vCentroids[uTriangle][uBestAxis] -
+			vCentroidMin[uBestAxis]) * fScale), g_uNumBins - 1) < uBestBin;
+	});
+	const auto uMid = static_cast<uint32_t>(pMid - build.vIndices.begin());
+
+	const auto uLeft = build.uNumNodes.fetch_add(2);
+	node.uIndex = uLeft;
+	node.uCount = 0;
+
+	// The children own disjoint ranges of the triangles and nodes of their own
+	if (uCount < g_uTaskThreshold)
+	{
+		buildNode(build, uLeft, uBegin, uMid, uDepth + 1);
+		buildNode(build, uLeft + 1, uMid, uEnd, uDepth + 1);
+	}
+	else build.scheduler.ParallelFor(0, 2, 1, [&](const uint32_t uChildBegin, const uint32_t uChildEnd, uint32_t)
+	{
+		for (auto i = uChildBegin; i < uChildEnd; ++i)
+			buildNode(build, uLeft + i, i ? uMid : uBegin, i ? uEnd : uMid, uDepth + 1);
+	});
+}
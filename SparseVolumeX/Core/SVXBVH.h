@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SVXSolid.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Bounding volume hierarchy over the triangles of a mesh, split by the surface area
+	// heuristic over binned centroids; subtrees of large nodes are built on the threads of
+	// the scheduler. A ray collects every triangle it hits, so its sorted hit depths are
+	// exact at any depth complexity. Pairs of them are the intervals the peel would store,
+	// and only resampling into a k-buffer keeps the K nearest.
+	// Coherent rays are traversed as packets, the lanes of a node test in one loop that the
+	// compiler vectorizes, and incoherent ones as a stream that each node filters.
+	//--------------------------------------------------------------------------------------
+	class BVH : public Solid
+	{
+	public:
+		// Hits of a batch of rays in one array, ascending per ray: those of ray i are
+		// vT[vOffsets[i]] to vT[vOffsets[i + 1]]
+		struct RayHits
+		{
+			std::vector<float>		vT;
+			std::vector<uint32_t>	vOffsets;
+		};
+
+		static const uint32_t PACKET_SIZE = 8;
+
+		BVH();
+		virtual ~BVH();
+
+		void Create(const Mesh &mesh, Scheduler &scheduler);
+
+		// Every hit along vOrigin + t * vDir for t in [fTMin, fTMax], ascending, without a
+		// bound on their count
+		void Intersect(const float3 &vOrigin, const float3 &vDir, const float fTMin, const float fTMax,
+			std::vector<float> &vT) const;
+
+		// Up to PACKET_SIZE coherent rays, e.g. of neighboring pixels: a node is tested on all
+		// lanes at once and visited if any hits it. The hits are appended to those of the
+		// rays already in the batch.
+		void IntersectPacket(const float3 *pOrigins, const float3 *pDirs, const uint32_t uNumRays,
+			const float fTMin, const float fTMax, RayHits &hits) const;
+
+		// Any number of incoherent rays, e.g. to the lights from scattered sample points:
+		// each node passes on the rays that hit it, so it is loaded once for all of them
+		void IntersectStream(const float3 *pOrigins, const float3 *pDirs, const uint32_t uNumRays,
+			const float fTMin, const float fTMax, RayHits &hits) const;
+
+		uint32_t CastRay(const float3 &vOrigin, const float3 &vDir, const float fTMin, const float fTMax,
+			float *pT, const uint32_t uMaxValues) const override;
+
+		// The camera rays in 32 x 32 tiles, as CSRender, and packets of 4 x 2 pixels
+		void Resample(const float4x4 &mViewProj, const float4x4 &mScreenToWorld, KBuffer &kBuffer,
+			const uint32_t uRowBegin = 0, const uint32_t uRowEnd = UINT32_MAX) const override;
+
+		uint32_t GetNumNodes() const;
+		uint32_t GetNumTriangles() const;
+		size_t GetBytes() const override;
+
+	protected:
+		struct Node
+		{
+			float3		vMin;
+			uint32_t	uIndex;		// First triangle of a leaf, or the left child, the right following
+			float3		vMax;
+			uint32_t	uCount;		// Triangles of a leaf, 0 for an inner node
+		};
+
+		struct Triangle
+		{
+			float3		v0;
+			float3		vEdge1;
+			float3		vEdge2;
+		};
+
+		struct Build;
+
+		void buildNode(Build &build, const uint32_t uNode, const uint32_t uBegin, const uint32_t uEnd,
+			const uint32_t uDepth);
+
+		std::vector<Node>		m_vNodes;
+		std::vector<Triangle>	m_vTriangles;	// In leaf order
+	};
+
+	using upBVH = std::unique_ptr<BVH>;
+	using spBVH = std::shared_ptr<BVH>;
+}
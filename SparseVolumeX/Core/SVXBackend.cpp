@@ -0,0 +1,35 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include "SVXBackend.h"
+
+using namespace std;
+using namespace SVX;
+
+void Backend::BuildFrame(FrameGraph &frameGraph, const VolumeState &state, const bool bLightSpace)
+{
+	const auto uLightKBuffers = frameGraph.ImportResource("lightKBuffers");
+	const auto uThicknessPrefix = frameGraph.ImportResource("thicknessPrefix");
+	const auto uKBuffer = frameGraph.ImportResource("kBuffer");
+	const auto uTarget = frameGraph.ImportResource("target");
+
+	if (bLightSpace)
+	{
+		frameGraph.AddPass("depthPeelLightSpace", {}, { uLightKBuffers, uKBuffer }, [this, &state]()
+		{
+			ClearKBuffers(true);
+			DepthPeelLightSpace(state);
+		});
+		frameGraph.AddPass("thicknessPrefix", { uLightKBuffers }, { uThicknessPrefix },
+			[this, &state]() { ThicknessPrefix(state); });
+	}
+
+	frameGraph.AddPass("depthPeel", {}, { uKBuffer }, [this, &state, bLightSpace]()
+	{
+		if (!bLightSpace) ClearKBuffers(false);
+		DepthPeel(state);
+	});
+	frameGraph.AddPass("render", { uKBuffer, uLightKBuffers, uThicknessPrefix }, { uTarget },
+		[this, &state]() { Integrate(state); });
+}
@@ -0,0 +1,67 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+#include "SVXFrameGraph.h"
+#include "SVXMemoryTracker.h"
+#include "SVXVolumeState.h"
+
+namespace SVX
+{
+	class BrickVolume;
+
+	//--------------------------------------------------------------------------------------
+	// Resources and passes of the sparse volume over the shared VolumeState. The D3D11
+	// path (Content/D3D11Backend) and the multi-threaded CPU port (CPUBackend) implement it,
+	// so the same scene runs in the viewer and headless.
+	//--------------------------------------------------------------------------------------
+	class Backend
+	{
+	public:
+		virtual ~Backend() {}
+
+		// The position is the first float3 of each vertex
+		virtual void UploadMesh(const uint8_t *pVertices, const uint32_t uStride, const uint32_t uNumVertices,
+			const uint32_t *pIndices, const uint32_t uNumIndices) = 0;
+
+		// Heterogeneous density; backends integrating a homogeneous medium ignore it
+		virtual void UploadDensity(const BrickVolume &) {}
+
+		// View and light-space k-buffers for the sizes of the state
+		virtual void CreateKBuffers(const VolumeState &state) = 0;
+		virtual void ClearKBuffers(const bool bLightSpace) = 0;
+
+		// Per-frame constants of the passes, before any of them
+		virtual void UpdateFrame(const VolumeState &state) = 0;
+
+		virtual void DepthPeelLightSpace(const VolumeState &state) = 0;
+		virtual void ThicknessPrefix(const VolumeState &state) = 0;
+		virtual void DepthPeel(const VolumeState &state) = 0;
+		virtual void Integrate(const VolumeState &state) = 0;
+
+		// Adds the passes of a frame: the light-space peel and thickness prefix if
+		// bLightSpace, the view peel and the integration. By default they are the passes
+		// above in sequence; a backend may split them finer.
+		virtual void BuildFrame(FrameGraph &frameGraph, const VolumeState &state, const bool bLightSpace);
+
+		// Scheduler of the frame graph, null to run the passes in order on the calling
+		// thread, as an immediate context requires
+		virtual Scheduler *GetScheduler() { return nullptr; }
+
+		// Whether the integration blends into a temporal history, so the camera is jittered
+		virtual bool IsTemporal() const { return false; }
+
+		// Backend timers of the passes, e.g. GPU timestamps, next to the CPU ones
+		virtual void SetProfiler(Profiler *) {}
+		virtual void BeginFrame() {}
+		virtual void EndFrame() {}
+
+		virtual void TrackMemory(MemoryTracker &memoryTracker, const char *pszAsset) const = 0;
+	};
+
+	using upBackend = std::unique_ptr<Backend>;
+	using spBackend = std::shared_ptr<Backend>;
+}
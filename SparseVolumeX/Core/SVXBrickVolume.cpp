@@ -0,0 +1,259 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include "SVXBrickVolume.h"
+
+using namespace std;
+using namespace SVX;
+
+//--------------------------------------------------------------------------------------
+// Lattice value noise
+//--------------------------------------------------------------------------------------
+static float latticeValue(const int32_t x, const int32_t y, const int32_t z, const uint32_t uSeed)
+{
+	auto h = static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u ^
+		static_cast<uint32_t>(z) * 83492791u ^ uSeed * 2654435761u;
+	h ^= h >> 13;
+	h *= 0x5bd1e995u;
+	h ^= h >> 15;
+
+	return static_cast<float>(h & 0xffffff) / static_cast<float>(0xffffff);
+}
+
+static float valueNoise(const float3 &vPos, const uint32_t uSeed)
+{
+	const auto x = static_cast<int32_t>(floor(vPos.x));
+	const auto y = static_cast<int32_t>(floor(vPos.y));
+	const auto z = static_cast<int32_t>(floor(vPos.z));
+	auto tx = vPos.x - x, ty = vPos.y - y, tz = vPos.z - z;
+
+	// Smoothstep weights
+	tx = tx * tx * (3.0f - 2.0f * tx);
+	ty = ty * ty * (3.0f - 2.0f * ty);
+	tz = tz * tz * (3.0f - 2.0f * tz);
+
+	float v[2][2];
+	for (auto k = 0; k < 2; ++k)
+		for (auto j = 0; j < 2; ++j)
+		{
+			const auto v0 = latticeValue(x, y + j, z + k, uSeed);
+			const auto v1 = latticeValue(x + 1, y + j, z + k, uSeed);
+			v[k][j] = v0 + (v1 - v0) * tx;
+		}
+
+	const auto v0 = v[0][0] + (v[0][1] - v[0][0]) * ty;
+	const auto v1 = v[1][0] + (v[1][1] - v[1][0]) * ty;
+
+	return v0 + (v1 - v0) * tz;
+}
+
+const uint32_t BrickVolume::EMPTY_BRICK;
+
+BrickVolume::BrickVolume() :
+	m_vOrigin(0.0f),
+	m_fBrickExtent(0.0f),
+	m_uBrickSize(0),
+	m_vGridSize(),
+	m_vTable(0),
+	m_vBricks(0),
+	m_vPool(0)
+{
+}
+
+BrickVolume::~BrickVolume()
+{
+}
+
+void BrickVolume::Create(const float3 &vCenter, const float fRadius, const float3 &vAABBMin,
+	const float3 &vAABBMax, const uint32_t uResolution, const uint32_t uBrickSize)
+{
+	// Cubic voxels over the bounding cube
+	const auto uGridSize = (uResolution + uBrickSize - 1) / uBrickSize;
+	m_uBrickSize = uBrickSize;
+	m_fBrickExtent = fRadius * 2.0f / uResolution * uBrickSize;
+	m_vOrigin = vCenter - float3(fRadius);
+	for (auto &uSize : m_vGridSize) uSize = uGridSize;
+
+	// Allocate only the bricks overlapping the AABB
+	uint32_t vBegin[3], vEnd[3];
+	for (auto i = 0u; i < 3; ++i)
+	{
+		const auto fBegin = floor((vAABBMin[i] - m_vOrigin[i]) / m_fBrickExtent);
+		const auto fEnd = floor((vAABBMax[i] - m_vOrigin[i]) / m_fBrickExtent) + 1.0f;
+		vBegin[i] = static_cast<uint32_t>((std::max)(fBegin, 0.0f));
+		vEnd[i] = static_cast<uint32_t>((std::min)(fEnd, static_cast<float>(uGridSize)));
+	}
+
+	m_vTable.assign(uGridSize * uGridSize * uGridSize, EMPTY_BRICK);
+	m_vBricks.clear();
+	for (auto k = vBegin[2]; k < vEnd[2]; ++k)
+		for (auto j = vBegin[1]; j < vEnd[1]; ++j)
+			for (auto i = vBegin[0]; i < vEnd[0]; ++i)
+			{
+				const auto uCell = (k * uGridSize + j) * uGridSize + i;
+				m_vTable[uCell] = static_cast<uint32_t>(m_vBricks.size());
+				m_vBricks.push_back(uCell);
+			}
+
+	m_vPool.resize(m_vBricks.size() * brickSamples());
+	m_vPool.shrink_to_fit();
+}
+
+void BrickVolume::Fill(const function<float(const float3&)> &density)
+{
+	const auto uSamples = m_uBrickSize + 1;
+	const auto fVoxelSize = m_fBrickExtent / m_uBrickSize;
+
+	auto pSample = m_vPool.data();
+	for (const auto &uCell : m_vBricks)
+	{
+		const auto i = uCell % m_vGridSize[0];
+		const auto j = uCell / m_vGridSize[0] % m_vGridSize[1];
+		const auto k = uCell / (m_vGridSize[0] * m_vGridSize[1]);
+		const auto vBrickOrigin = m_vOrigin + float3(static_cast<float>(i),
+			static_cast<float>(j), static_cast<float>(k)) * m_fBrickExtent;
+
+		for (auto z = 0u; z < uSamples; ++z)
+			for (auto y = 0u; y < uSamples; ++y)
+				for (auto x = 0u; x < uSamples; ++x)
+				{
+					const auto vOffset = float3(static_cast<float>(x),
+						static_cast<float>(y), static_cast<float>(z)) * fVoxelSize;
+					*pSample++ = density(vBrickOrigin + vOffset);
+				}
+	}
+}
+
+void BrickVolume::FillNoise(const float fFrequency, const uint32_t uOctaves, const uint32_t uSeed)
+{
+	// Fractal value noise remapped to [0, 2], i.e. around the uniform density
+	Fill([fFrequency, uOctaves, uSeed](const float3 &vPos)
+	{
+		auto fNoise = 0.0f, fAmplitude = 0.5f, fNorm = 0.0f;
+		auto vP = vPos * fFrequency;
+		for (auto i = 0u; i < uOctaves; ++i)
+		{
+			fNoise += valueNoise(vP, uSeed + i) * fAmplitude;
+			fNorm += fAmplitude;
+			fAmplitude *= 0.5f;
+			vP *= 2.0f;
+		}
+
+		return fNoise / fNorm * 2.0f;
+	});
+}
+
+float BrickVolume::Sample(const float3 &vPos) const
+{
+	const auto vGrid = (vPos - m_vOrigin) / m_fBrickExtent;
+	uint32_t vBrick[3];
+	for (auto i = 0u; i < 3; ++i)
+	{
+		if (vGrid[i] < 0.0f || vGrid[i] >= m_vGridSize[i]) return 0.0f;
+		vBrick[i] = static_cast<uint32_t>(vGrid[i]);
+	}
+
+	const auto uBrick = m_vTable[(vBrick[2] * m_vGridSize[1] + vBrick[1]) * m_vGridSize[0] + vBrick[0]];
+	if (uBrick == EMPTY_BRICK) return 0.0f;
+
+	// Trilinear filtering inside the brick
+	const auto uSamples = m_uBrickSize + 1;
+	uint32_t vIdx[3];
+	float vT[3];
+	for (auto i = 0u; i < 3; ++i)
+	{
+		const auto fLocal = (vGrid[i] - vBrick[i]) * m_uBrickSize;
+		vIdx[i] = (std::min)(static_cast<uint32_t>(fLocal), m_uBrickSize - 1);
+		vT[i] = fLocal - vIdx[i];
+	}
+
+	const auto pBrick = &m_vPool[uBrick * brickSamples()];
+	const auto sample = [&](const uint32_t x, const uint32_t y, const uint32_t z)
+	{
+		return pBrick[((vIdx[2] + z) * uSamples + vIdx[1] + y) * uSamples + vIdx[0] + x];
+	};
+
+	const auto v00 = sample(0, 0, 0) + (sample(1, 0, 0) - sample(0, 0, 0)) * vT[0];
+	const auto v10 = sample(0, 1, 0) + (sample(1, 1, 0) - sample(0, 1, 0)) * vT[0];
+	const auto v01 = sample(0, 0, 1) + (sample(1, 0, 1) - sample(0, 0, 1)) * vT[0];
+	const auto v11 = sample(0, 1, 1) + (sample(1, 1, 1) - sample(0, 1, 1)) * vT[0];
+	const auto v0 = v00 + (v10 - v00) * vT[1];
+	const auto v1 = v01 + (v11 - v01) * vT[1];
+
+	return v0 + (v1 - v0) * vT[2];
+}
+
+void BrickVolume::BuildAtlas(vector<float> &vAtlas, vector<uint32_t> &vTable, uint32_t &uAtlasBricks) const
+{
+	const auto uNumBricks = GetNumBricks();
+	uAtlasBricks = 1;
+	while (uAtlasBricks * uAtlasBricks * uAtlasBricks < uNumBricks) ++uAtlasBricks;
+
+	const auto uSamples = m_uBrickSize + 1;
+	const auto uAtlasSize = uAtlasBricks * uSamples;
+	vAtlas.assign(static_cast<size_t>(uAtlasSize) * uAtlasSize * uAtlasSize, 0.0f);
+
+	// Copy the bricks into their atlas slots
+	for (auto b = 0u; b < uNumBricks; ++b)
+	{
+		const auto uX = b % uAtlasBricks * uSamples;
+		const auto uY = b / uAtlasBricks % uAtlasBricks * uSamples;
+		const auto uZ = b / (uAtlasBricks * uAtlasBricks) * uSamples;
+		const auto pBrick = &m_vPool[b * brickSamples()];
+
+		for (auto z = 0u; z < uSamples; ++z)
+			for (auto y = 0u; y < uSamples; ++y)
+				copy_n(&pBrick[(z * uSamples + y) * uSamples], uSamples,
+					&vAtlas[((static_cast<size_t>(uZ) + z) * uAtlasSize + uY + y) * uAtlasSize + uX]);
+	}
+
+	// Indirection table
+	vTable.resize(m_vTable.size());
+	transform(m_vTable.cbegin(), m_vTable.cend(), vTable.begin(), [uAtlasBricks](const uint32_t b)
+	{
+		if (b == EMPTY_BRICK) return EMPTY_BRICK;
+		const auto uX = b % uAtlasBricks;
+		const auto uY = b / uAtlasBricks % uAtlasBricks;
+		const auto uZ = b / (uAtlasBricks * uAtlasBricks);
+
+		return uX | (uY << 10) | (uZ << 20);
+	});
+}
+
+const float3 &BrickVolume::GetOrigin() const
+{
+	return m_vOrigin;
+}
+
+float BrickVolume::GetBrickExtent() const
+{
+	return m_fBrickExtent;
+}
+
+uint32_t BrickVolume::GetBrickSize() const
+{
+	return m_uBrickSize;
+}
+
+uint32_t BrickVolume::GetGridSize(const uint8_t i) const
+{
+	return m_vGridSize[i];
+}
+
+uint32_t BrickVolume::GetNumBricks() const
+{
+	return static_cast<uint32_t>(m_vBricks.size());
+}
+
+size_t BrickVolume::GetPoolBytes() const
+{
+	return sizeof(float) * m_vPool.size();
+}
+
+uint32_t BrickVolume::brickSamples() const
+{
+	const auto uSamples = m_uBrickSize + 1;
+
+	return uSamples * uSamples * uSamples;
+}
@@ -0,0 +1,61 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "SVXMath.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Sparse brick map of a scalar density field. The grid covers the bounding cube of
+	// the mesh, but only the bricks overlapping its AABB own storage in the brick pool.
+	// A brick of N^3 cells stores (N + 1)^3 vertex samples so that trilinear filtering
+	// never crosses a brick boundary.
+	//--------------------------------------------------------------------------------------
+	class BrickVolume
+	{
+	public:
+		static const uint32_t EMPTY_BRICK = 0xffffffff;
+
+		BrickVolume();
+		virtual ~BrickVolume();
+
+		void Create(const float3 &vCenter, const float fRadius, const float3 &vAABBMin,
+			const float3 &vAABBMax, const uint32_t uResolution, const uint32_t uBrickSize = 8);
+		void Fill(const std::function<float(const float3&)> &density);
+		void FillNoise(const float fFrequency, const uint32_t uOctaves, const uint32_t uSeed = 0);
+
+		float Sample(const float3 &vPos) const;
+
+		// Packs the pool into a 3D atlas of uAtlasBricks^3 bricks; the table holds
+		// 10:10:10 atlas brick coordinates or EMPTY_BRICK
+		void BuildAtlas(std::vector<float> &vAtlas, std::vector<uint32_t> &vTable, uint32_t &uAtlasBricks) const;
+
+		const float3 &GetOrigin() const;
+		float GetBrickExtent() const;
+		uint32_t GetBrickSize() const;
+		uint32_t GetGridSize(const uint8_t i) const;
+		uint32_t GetNumBricks() const;
+		size_t GetPoolBytes() const;
+
+	protected:
+		uint32_t brickSamples() const;
+
+		float3					m_vOrigin;
+		float					m_fBrickExtent;
+		uint32_t				m_uBrickSize;
+		uint32_t				m_vGridSize[3];
+
+		std::vector<uint32_t>	m_vTable;	// Brick grid to pool index
+		std::vector<uint32_t>	m_vBricks;	// Pool index to brick grid
+		std::vector<float>		m_vPool;
+	};
+
+	using upBrickVolume = std::unique_ptr<BrickVolume>;
+	using spBrickVolume = std::shared_ptr<BrickVolume>;
+}
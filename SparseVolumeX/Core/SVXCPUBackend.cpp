@@ -0,0 +1,629 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <thread>
+#include "SVXCPUBackend.h"
+
+using namespace std;
+using namespace SVX;
+
+// Same medium and background as Content/SharedConst.h and CSRender.hlsl
+static const float g_fDensity = 1.0f;
+static const float g_fAbsorption = 1.0f;
+static const float3 g_vClear(0.392156899f * 0.392156899f, 0.584313750f * 0.584313750f, 0.929411829f * 0.929411829f);
+
+// Max optical depth and entries of the transmission LUT, as in Content/SharedConst.h
+static const float g_fTransmissionLUTMax = 16.0f;
+static const uint32_t g_uTransmissionLUTSize = 1024;
+
+// Row bands per thread of a peel, the units stolen between threads so that the ones
+// peeling empty regions take over from those in dense regions
+static const uint32_t g_uBandsPerThread = 4;
+
+// Least bands of a frame without a retained k-buffer, and the bands peeled ahead of the
+// integration per thread; the transient bands in flight bound its memory
+static const uint32_t g_uMinStreamBands = 16;
+static const uint32_t g_uStreamAheadPerThread = 2;
+
+// Bands of the rows, at most uNumBands, as many as their rounded up height leaves nonempty
+static uint32_t fitBands(const uint32_t uNumBands, const uint32_t uHeight)
+{
+	const auto uBandHeight = (uHeight + uNumBands - 1) / uNumBands;
+
+	return (uHeight + uBandHeight - 1) / uBandHeight;
+}
+
+float LightField::GetThickness(const float3 &vPos, const uint32_t uView) const
+{
+	const auto vPosLS = TransformCoord(vPos, vViewProjs[uView]);
+	const auto &columns = vColumns[uView];
+	const auto uSize = columns.GetWidth();
+	const auto fSize = static_cast<float>(uSize);
+
+	// 4 taps around the point
+	const auto fU = (vPosLS.x * 0.5f + 0.5f) * fSize - 0.5f;
+	const auto fV = (0.5f - vPosLS.y * 0.5f) * fSize - 0.5f;
+	const auto fFloorU = floor(fU), fFloorV = floor(fV);
+	const auto fFracU = fU - fFloorU, fFracV = fV - fFloorV;
+
+	const auto iMax = static_cast<int32_t>(uSize) - 1;
+	const auto clampLoc = [iMax](const float f)
+	{
+		return static_cast<uint32_t>((std::min)((std::max)(static_cast<int32_t>(f), 0), iMax));
+	};
+	const auto x0 = clampLoc(fFloorU), x1 = clampLoc(fFloorU + 1.0f);
+	const auto y0 = clampLoc(fFloorV), y1 = clampLoc(fFloorV + 1.0f);
+
+	const auto fTop = columns.GetThickness(x0, y0, vPosLS.z) * (1.0f - fFracU) +
+		columns.GetThickness(x1, y0, vPosLS.z) * fFracU;
+	const auto fBottom = columns.GetThickness(x0, y1, vPosLS.z) * (1.0f - fFracU) +
+		columns.GetThickness(x1, y1, vPosLS.z) * fFracU;
+
+	return fTop + (fBottom - fTop) * fFracV;
+}
+
+CPUBackend::CPUBackend(const uint32_t uNumThreads) :
+	m_pMesh(nullptr),
+	m_pKBuffer(nullptr),
+	m_pLightField(nullptr),
+	m_pSolid(nullptr),
+	m_pvTarget(&m_vTarget),
+	m_vTarget(0),
+	m_bRetainKBuffer(true),
+	m_fLODTolerance(0.0f),
+	m_pDistanceField(nullptr),
+	m_eTransmission(EVALUATOR_EXACT),
+	m_transmissionLUT(),
+	m_vClipPos(0),
+	m_vKBufferBands(0),
+	m_vLightDirs(0),
+	m_pScheduler(nullptr),
+	m_vRasterizers(0)
+{
+	SetNumThreads(uNumThreads);
+}
+
+CPUBackend::~CPUBackend()
+{
+}
+
+void CPUBackend::UploadMesh(const uint8_t *pVertices, const uint32_t uStride, const uint32_t uNumVertices,
+	const uint32_t *pIndices, const uint32_t uNumIndices)
+{
+	m_pMesh = make_shared<Mesh>();
+	m_pMesh->Create(pVertices, uStride, uNumVertices, pIndices, uNumIndices);
+}
+
+void CPUBackend::CreateKBuffers(const VolumeState &state)
+{
+	if (m_bRetainKBuffer) createKBuffer(state);
+
+	// Light fields are allocated by the light-space peel
+	m_pLightField = nullptr;
+}
+
+void CPUBackend::ClearKBuffers(const bool bLightSpace)
+{
+	if (m_pKBuffer) m_pKBuffer->Clear();
+
+	// A light field may be shared, so it is replaced rather than cleared in place
+	if (bLightSpace) m_pLightField = nullptr;
+}
+
+void CPUBackend::UpdateFrame(const VolumeState &state)
+{
+	// The passes read the matrices from the state directly; the directions toward the
+	// lights to trace the distance field along are kept, not to allocate them per row
+	m_vLightDirs.resize(state.vLights.size());
+	for (auto j = 0u; j < m_vLightDirs.size(); ++j) m_vLightDirs[j] = normalize(state.vLights[j].vPosition);
+}
+
+void CPUBackend::DepthPeelLightSpace(const VolumeState &state)
+{
+	if (m_pDistanceField) return;
+
+	createLightField(state);
+
+	auto &lightField = *m_pLightField;
+	peel(*m_pMesh, lightField.vViewProjs.data(), lightField.vKBuffers.data(), state.GetNumLightViews());
+}
+
+void CPUBackend::ThicknessPrefix(const VolumeState &)
+{
+	if (m_pDistanceField) return;
+
+	// The rows of each view are spread over the threads
+	for (auto v = 0u; v < m_pLightField->vKBuffers.size(); ++v) buildColumns(v);
+}
+
+void CPUBackend::DepthPeel(const VolumeState &state)
+{
+	createKBuffer(state);
+	if (!m_pSolid)
+	{
+		peel(getViewMesh(state), &state.mViewProj, m_pKBuffer.get(), 1);
+		return;
+	}
+
+	parallelFor(state.uHeight, [this, &state](const uint32_t y, uint32_t)
+	{
+		m_pSolid->Resample(state.mViewProj, state.mScreenToWorld, *m_pKBuffer, y, y + 1);
+	});
+}
+
+void CPUBackend::Integrate(const VolumeState &state)
+{
+	m_pvTarget->resize(static_cast<size_t>(state.uWidth) * state.uHeight * 3);
+	parallelFor(state.uHeight, [this, &state](const uint32_t y, uint32_t)
+	{
+		integrateRows(state, *m_pKBuffer, y, y + 1);
+	});
+}
+
+void CPUBackend::BuildFrame(FrameGraph &frameGraph, const VolumeState &state, const bool bLightSpace)
+{
+	const auto bLightPeel = bLightSpace && !m_pDistanceField;
+	const auto uLightClipPosBytes = sizeof(float4) * Rasterizer::GetNumClipPos(*m_pMesh);
+	const auto clipPos = [&frameGraph](const uint32_t uResource)
+	{
+		return reinterpret_cast<float4*>(frameGraph.GetTransient(uResource));
+	};
+
+	// Resource lists in the scratch of the frame
+	const ArenaAllocator<uint32_t> allocator(frameGraph.GetArena());
+
+	// Vertex transforms of every view first, so that their clip positions do not alias
+	// and the peels of different views do not wait for each other
+	ArenaVector<uint32_t> vLightClipPos(allocator);
+	if (bLightPeel)
+	{
+		createLightField(state);
+		for (auto v = 0u; v < state.GetNumLightViews(); ++v)
+		{
+			const auto uClipPos = frameGraph.CreateTransient("lightClipPos", uLightClipPosBytes);
+			frameGraph.AddPass("vertexTransformLightSpace", {}, { uClipPos }, [this, clipPos, uClipPos, v]()
+			{
+				Rasterizer::TransformVertices(*m_pMesh, m_pLightField->vViewProjs[v], clipPos(uClipPos));
+			});
+			vLightClipPos.push_back(uClipPos);
+		}
+	}
+
+	// A solid is resampled without the mesh
+	const auto pViewMesh = &getViewMesh(state);
+	const auto uClipPos = frameGraph.CreateTransient("clipPos", m_pSolid ? 0 :
+		sizeof(float4) * Rasterizer::GetNumClipPos(*pViewMesh));
+	const auto vPeelReads = m_pSolid ? ArenaVector<uint32_t>(allocator) : ArenaVector<uint32_t>(1, uClipPos, allocator);
+	if (!m_pSolid)
+		frameGraph.AddPass("vertexTransform", {}, { uClipPos }, [clipPos, uClipPos, pViewMesh, &state]()
+		{
+			Rasterizer::TransformVertices(*pViewMesh, state.mViewProj, clipPos(uClipPos));
+		});
+
+	// View bands, in the retained k-buffer or as transients
+	const auto uWidth = state.uWidth, uHeight = state.uHeight;
+	const auto uNumLayers = state.uNumLayers;
+	const auto uNumThreads = GetNumThreads();
+	const auto uNumBands = m_bRetainKBuffer ? getNumBands(uHeight) :
+		fitBands((std::max)(getNumBands(uHeight), g_uMinStreamBands), uHeight);
+	const auto uBandHeight = (uHeight + uNumBands - 1) / uNumBands;
+	ArenaVector<uint32_t> vBands(uNumBands, allocator), vTargets(uNumBands, allocator);
+	if (m_bRetainKBuffer)
+	{
+		createKBuffer(state);
+		m_vKBufferBands.clear();
+		for (auto &uBand : vBands) uBand = frameGraph.ImportResource("kBuffer");
+	}
+	else
+	{
+		m_vKBufferBands.resize(uNumBands);
+		for (auto b = 0u; b < uNumBands; ++b)
+		{
+			const auto uRowBegin = b * uBandHeight;
+			vBands[b] = frameGraph.CreateTransient("kBufferBand", KBuffer::GetBytes(uWidth, uRowBegin,
+				(std::min)(uRowBegin + uBandHeight, uHeight), uNumLayers));
+		}
+	}
+	for (auto &uTarget : vTargets) uTarget = frameGraph.ImportResource("target");
+	m_pvTarget->resize(static_cast<size_t>(uWidth) * uHeight * 3);
+
+	const auto addPeel = [&](const uint32_t b)
+	{
+		const auto uRowBegin = b * uBandHeight;
+		const auto uRowEnd = (std::min)(uRowBegin + uBandHeight, uHeight);
+		const auto uBand = vBands[b];
+		frameGraph.AddPass(m_pSolid ? "resampleSolid" : "depthPeel", vPeelReads, { uBand },
+			[=, &frameGraph, &state]()
+		{
+			auto pKBuffer = m_pKBuffer.get();
+			if (!m_bRetainKBuffer)
+			{
+				pKBuffer = &m_vKBufferBands[b];
+				pKBuffer->CreateBand(reinterpret_cast<float*>(frameGraph.GetTransient(uBand)),
+					uWidth, uHeight, uRowBegin, uRowEnd, uNumLayers);
+			}
+
+			// Every layer of the resampled rows is written, so only a peel clears them
+			if (m_pSolid)
+			{
+				m_pSolid->Resample(state.mViewProj, state.mScreenToWorld, *pKBuffer, uRowBegin, uRowEnd);
+				return;
+			}
+			pKBuffer->Clear(uRowBegin, uRowEnd);
+			m_vRasterizers[m_pScheduler->GetCurrentThread()].DepthPeel(*pViewMesh, clipPos(uClipPos),
+				*pKBuffer, uRowBegin, uRowEnd);
+		});
+	};
+
+	// Peels ahead of the integration: all of them into a retained k-buffer, otherwise a
+	// window of bands, each next one declared after the integration of the band it aliases
+	const auto uNumAhead = m_bRetainKBuffer ? uNumBands :
+		(std::min)(uNumThreads * g_uStreamAheadPerThread, uNumBands);
+	for (auto b = 0u; b < uNumAhead; ++b) addPeel(b);
+
+	// Light bands, each view compressed into columns as soon as all its bands are peeled
+	ArenaVector<uint32_t> vLightColumns(allocator);
+	if (bLightPeel)
+	{
+		const auto uSize = state.uLightMapSize;
+		const auto uNumLightBands = getNumBands(uSize);
+		const auto uLightBandHeight = (uSize + uNumLightBands - 1) / uNumLightBands;
+		for (auto v = 0u; v < state.GetNumLightViews(); ++v)
+		{
+			ArenaVector<uint32_t> vLightBands(allocator);
+			for (auto uRowBegin = 0u; uRowBegin < uSize; uRowBegin += uLightBandHeight)
+			{
+				const auto uRowEnd = (std::min)(uRowBegin + uLightBandHeight, uSize);
+				const auto uLightBand = frameGraph.ImportResource("lightKBuffer");
+				const auto uLightClipPos = vLightClipPos[v];
+				frameGraph.AddPass("depthPeelLightSpace", { uLightClipPos }, { uLightBand }, [=]()
+				{
+					m_vRasterizers[m_pScheduler->GetCurrentThread()].DepthPeel(*m_pMesh, clipPos(uLightClipPos),
+						m_pLightField->vKBuffers[v], uRowBegin, uRowEnd);
+				});
+				vLightBands.push_back(uLightBand);
+			}
+
+			const auto uColumns = frameGraph.ImportResource("thicknessPrefix");
+			frameGraph.AddPass("thicknessPrefix", vLightBands, { uColumns }, [this, v]() { buildColumns(v); });
+			vLightColumns.push_back(uColumns);
+		}
+	}
+
+	// Integration of each band once it and the whole light field are ready, its rows
+	// spread over the threads
+	for (auto b = 0u; b < uNumBands; ++b)
+	{
+		auto vReads = vLightColumns;
+		vReads.push_back(vBands[b]);
+		const auto uRowBegin = b * uBandHeight;
+		const auto uRowEnd = (std::min)(uRowBegin + uBandHeight, uHeight);
+		frameGraph.AddPass("integrate", vReads, { vTargets[b] }, [this, b, uRowBegin, uRowEnd, &state]()
+		{
+			// Captured by one reference, small enough for the function not to allocate
+			const struct { const VolumeState *pState; const KBuffer *pKBuffer; } band =
+				{ &state, m_bRetainKBuffer ? m_pKBuffer.get() : &m_vKBufferBands[b] };
+			m_pScheduler->ParallelFor(uRowBegin, uRowEnd, 1, [this, &band](const uint32_t uBegin,
+				const uint32_t uEnd, uint32_t) { integrateRows(*band.pState, *band.pKBuffer, uBegin, uEnd); });
+		});
+
+		if (b + uNumAhead < uNumBands) addPeel(b + uNumAhead);
+	}
+}
+
+Scheduler *CPUBackend::GetScheduler()
+{
+	return m_pScheduler.get();
+}
+
+const Scheduler *CPUBackend::GetScheduler() const
+{
+	return m_pScheduler.get();
+}
+
+void CPUBackend::TrackMemory(MemoryTracker &memoryTracker, const char *pszAsset) const
+{
+	if (m_pMesh) memoryTracker.Allocate(pszAsset, "mesh", MemoryTracker::CATEGORY_GEOMETRY, m_pMesh->GetBytes());
+	if (m_pKBuffer) memoryTracker.Allocate(pszAsset, "kBuffer", MemoryTracker::CATEGORY_K_BUFFER, m_pKBuffer->GetBytes());
+	if (m_pSolid) memoryTracker.Allocate(pszAsset, "solid", MemoryTracker::CATEGORY_GEOMETRY,
+		m_pSolid->GetBytes());
+	if (m_pDistanceField) memoryTracker.Allocate(pszAsset, "distanceField", MemoryTracker::CATEGORY_GEOMETRY,
+		m_pDistanceField->GetBytes());
+	if (m_transmissionLUT.GetData()) memoryTracker.Allocate(pszAsset, "transmissionLUT", MemoryTracker::CATEGORY_LOOKUP,
+		sizeof(float) * (m_transmissionLUT.GetSize() + 1));
+	memoryTracker.Allocate(pszAsset, "lightField", MemoryTracker::CATEGORY_LIGHT, m_pLightField ? m_pLightField->GetBytes() : 0);
+}
+
+void CPUBackend::SetMesh(const spMesh &pMesh)
+{
+	m_pMesh = pMesh;
+}
+
+void CPUBackend::SetKBuffer(const spKBuffer &pKBuffer)
+{
+	m_pKBuffer = pKBuffer;
+}
+
+void CPUBackend::SetLightField(const spLightField &pLightField)
+{
+	m_pLightField = pLightField;
+}
+
+void CPUBackend::SetSolid(const spSolid &pSolid)
+{
+	m_pSolid = pSolid;
+}
+
+void CPUBackend::SetTarget(vector<uint8_t> *pvRGB)
+{
+	m_pvTarget = pvRGB ? pvRGB : &m_vTarget;
+}
+
+void CPUBackend::SetRetainKBuffer(const bool bRetainKBuffer)
+{
+	m_bRetainKBuffer = bRetainKBuffer;
+	if (!m_bRetainKBuffer) m_pKBuffer = nullptr;
+}
+
+void CPUBackend::SetLODTolerance(const float fTolerance)
+{
+	m_fLODTolerance = fTolerance;
+}
+
+void CPUBackend::SetDistanceField(const spDistanceField &pDistanceField)
+{
+	m_pDistanceField = pDistanceField;
+}
+
+void CPUBackend::SetTransmission(const Evaluator eEvaluator)
+{
+	m_eTransmission = eEvaluator;
+	if (m_eTransmission == EVALUATOR_LUT && !m_transmissionLUT.GetData())
+		m_transmissionLUT.Create(g_fAbsorption * g_fDensity, g_fTransmissionLUTMax, g_uTransmissionLUTSize);
+}
+
+void CPUBackend::SetNumThreads(const uint32_t uNumThreads)
+{
+	const auto uThreads = uNumThreads > 0 ? uNumThreads : (std::max)(thread::hardware_concurrency(), 1u);
+	if (m_pScheduler && m_pScheduler->GetNumThreads() == uThreads) return;
+
+	m_pScheduler = make_unique<Scheduler>(uThreads);
+	m_vRasterizers.resize(m_pScheduler->GetNumThreads());
+}
+
+const spMesh &CPUBackend::GetMesh() const
+{
+	return m_pMesh;
+}
+
+const spKBuffer &CPUBackend::GetKBuffer() const
+{
+	return m_pKBuffer;
+}
+
+const spLightField &CPUBackend::GetLightField() const
+{
+	return m_pLightField;
+}
+
+const spSolid &CPUBackend::GetSolid() const
+{
+	return m_pSolid;
+}
+
+uint32_t CPUBackend::GetNumThreads() const
+{
+	return m_pScheduler->GetNumThreads();
+}
+
+float CPUBackend::GetLODTolerance() const
+{
+	return m_fLODTolerance;
+}
+
+const spDistanceField &CPUBackend::GetDistanceField() const
+{
+	return m_pDistanceField;
+}
+
+CPUBackend::Evaluator CPUBackend::GetTransmission() const
+{
+	return m_eTransmission;
+}
+
+const vector<uint8_t> &CPUBackend::GetTarget() const
+{
+	return *m_pvTarget;
+}
+
+void CPUBackend::createKBuffer(const VolumeState &state)
+{
+	// The k-buffer may be a pooled one from an earlier job
+	if (!m_pKBuffer) m_pKBuffer = make_shared<KBuffer>();
+	if (m_pKBuffer->GetWidth() != state.uWidth || m_pKBuffer->GetHeight() != state.uHeight ||
+		m_pKBuffer->GetNumLayers() != state.uNumLayers)
+		m_pKBuffer->Create(state.uWidth, state.uHeight, state.uNumLayers);
+}
+
+void CPUBackend::createLightField(const VolumeState &state)
+{
+	const auto uNumViews = state.GetNumLightViews();
+	const auto uSize = state.uLightMapSize;
+
+	m_pLightField = make_shared<LightField>();
+	auto &lightField = *m_pLightField;
+	lightField.vViewProjs = state.vLightViewProjs;
+	lightField.vKBuffers.resize(uNumViews);
+	lightField.vColumns.resize(uNumViews);
+	lightField.uNumCascades = state.uNumCascades;
+	lightField.fDepthScale = state.fLightDepthScale;
+	for (auto &kBuffer : lightField.vKBuffers) kBuffer.Create(uSize, uSize, state.uNumLayers);
+}
+
+void CPUBackend::peel(const Mesh &mesh, const float4x4 *pViewProjs, KBuffer *pKBuffers, const uint32_t uNumViews)
+{
+	if (uNumViews == 0) return;
+
+	// Every view transformed once
+	const auto uNumClipPos = Rasterizer::GetNumClipPos(mesh);
+	m_vClipPos.resize(static_cast<size_t>(uNumClipPos) * uNumViews);
+	parallelFor(uNumViews, [&](const uint32_t uView, uint32_t)
+	{
+		Rasterizer::TransformVertices(mesh, pViewProjs[uView], &m_vClipPos[static_cast<size_t>(uView) * uNumClipPos]);
+	});
+
+	// Disjoint row bands of every view, each peeled by the rasterizer of its thread
+	const auto uHeight = pKBuffers[0].GetHeight();
+	const auto uNumBands = getNumBands(uHeight);
+	const auto uBandHeight = (uHeight + uNumBands - 1) / uNumBands;
+	parallelFor(uNumViews * uNumBands, [&](const uint32_t i, const uint32_t uThread)
+	{
+		const auto uView = i / uNumBands;
+		const auto uRowBegin = i % uNumBands * uBandHeight;
+		m_vRasterizers[uThread].DepthPeel(mesh, &m_vClipPos[static_cast<size_t>(uView) * uNumClipPos],
+			pKBuffers[uView], uRowBegin, uRowBegin + uBandHeight);
+	});
+}
+
+const Mesh &CPUBackend::getViewMesh(const VolumeState &state) const
+{
+	return m_pMesh->GetLOD(m_pMesh->SelectLOD(state.mViewProj, state.uHeight, m_fLODTolerance));
+}
+
+void CPUBackend::buildColumns(const uint32_t uView)
+{
+	// The columns replace the k-buffer, so a shared light field keeps only them
+	auto &lightField = *m_pLightField;
+	lightField.vColumns[uView].Create(lightField.vKBuffers[uView], lightField.fDepthScale, *m_pScheduler);
+	lightField.vKBuffers[uView] = KBuffer();
+}
+
+template<CPUBackend::Evaluator eEvaluator>
+float CPUBackend::getTransmission(const float fSigma, const float fThickness) const
+{
+	// Folded per instance of integrateRows, so the samples do not branch on the evaluator
+	switch (eEvaluator)
+	{
+	case EVALUATOR_POLY:
+		return TransmissionPoly(fSigma, fThickness);
+	case EVALUATOR_LUT:
+		return m_transmissionLUT.Lookup(fThickness);
+	default:
+		return TransmissionExact(fSigma, fThickness);
+	}
+}
+
+template<CPUBackend::Evaluator eEvaluator>
+void CPUBackend::integrateRows(const VolumeState &state, const KBuffer &kBuffer, const uint32_t uRowBegin,
+	const uint32_t uRowEnd)
+{
+	const auto fSigma = g_fAbsorption * g_fDensity;
+	const auto uWidth = state.uWidth;
+	const auto uNumLights = static_cast<uint32_t>(state.vLights.size());
+	const auto uNumCascades = m_pDistanceField ? 1u : m_pLightField->uNumCascades;
+	const auto uNumIntervals = state.uNumLayers >> 1;
+	const auto &mScreenToWorld = state.mScreenToWorld;
+
+	// Perspective clip space to view space
+	const auto fZNear = state.fZNear, fZFar = state.fZFar;
+	const auto toViewZ = [fZNear, fZFar](const float fz) { return fZNear * fZFar / (fZFar - fz * (fZFar - fZNear)); };
+
+	auto &vRGB = *m_pvTarget;
+	for (auto y = uRowBegin; y < uRowEnd; ++y)
+	{
+		for (auto x = 0u; x < uWidth; ++x)
+		{
+			const auto pLayers = kBuffer.GetLayers(x, y);
+			const auto fX = x + 0.5f, fY = y + 0.5f;
+
+			auto fThickness = 0.0f;
+			auto vScatter = float3(0.0f);
+			for (auto i = 0u; i < uNumIntervals; ++i)
+			{
+				const auto fDepthFront = pLayers[i * 2];
+				const auto fDepthBack = pLayers[i * 2 + 1];
+				if (fDepthFront >= 1.0f || fDepthBack >= 1.0f) break;
+
+				// Transform to world space
+				const auto vPosFront = TransformCoord(float3(fX, fY, fDepthFront), mScreenToWorld);
+				const auto vPosBack = TransformCoord(float3(fX, fY, fDepthBack), mScreenToWorld);
+				const float3 vPos[] = { vPosFront, lerp(vPosFront, vPosBack, 1.0f / 3.0f),
+					lerp(vPosFront, vPosBack, 2.0f / 3.0f), vPosBack };
+
+				// Thickness of the current interval, and the camera-path thicknesses
+				const auto fViewZFront = toViewZ(fDepthFront);
+				const auto fThicknessSeg = toViewZ(fDepthBack) - fViewZFront;
+				const float fThicknessView[] = { fThickness, fThickness + fThicknessSeg / 3.0f,
+					fThickness + fThicknessSeg * (2.0f / 3.0f), fThickness + fThicknessSeg };
+				fThickness += fThicknessSeg;
+
+				// Cascades by the camera view depths of the samples
+				uint32_t uCascades[4];
+				for (auto k = 0u; k < 4; ++k)
+				{
+					const auto fViewZ = fViewZFront + (fThicknessView[k] - fThicknessView[0]);
+					uCascades[k] = 0;
+					for (auto c = 0u; c + 1 < uNumCascades; ++c) uCascades[k] += fViewZ > state.fCascadeSplits[c] ? 1 : 0;
+				}
+
+				for (auto j = 0u; j < uNumLights; ++j)
+				{
+					float fThicknessLight[4], fTransmission[4];
+					if (m_pDistanceField) m_pDistanceField->TraceThickness(vPos, 4, m_vLightDirs[j], fThicknessLight);
+					else for (auto k = 0u; k < 4; ++k)
+						fThicknessLight[k] = m_pLightField->GetThickness(vPos[k], j * uNumCascades + uCascades[k]);
+					for (auto k = 0u; k < 4; ++k)
+						fTransmission[k] = getTransmission<eEvaluator>(fSigma, fThicknessLight[k] + fThicknessView[k]);
+
+					// Simpson 3/8 rule
+					const auto fIntegral = fThicknessSeg / 8.0f * (fTransmission[0] +
+						3.0f * (fTransmission[1] + fTransmission[2]) + fTransmission[3]);
+					vScatter += state.vLights[j].vColor * (g_fDensity * fIntegral);
+				}
+			}
+
+			const auto fTransmission = getTransmission<eEvaluator>(fSigma, fThickness);
+			const auto vResult = lerp(vScatter + float3(0.3f), g_vClear, fTransmission);
+
+			auto pRGB = &vRGB[(static_cast<size_t>(y) * uWidth + x) * 3];
+			for (auto k = 0u; k < 3; ++k)
+			{
+				const auto fColor = sqrt((std::min)((std::max)(vResult[k], 0.0f), 1.0f));
+				pRGB[k] = static_cast<uint8_t>(fColor * 255.0f + 0.5f);
+			}
+		}
+	}
+}
+
+void CPUBackend::integrateRows(const VolumeState &state, const KBuffer &kBuffer, const uint32_t uRowBegin,
+	const uint32_t uRowEnd)
+{
+	switch (m_eTransmission)
+	{
+	case EVALUATOR_POLY:
+		integrateRows<EVALUATOR_POLY>(state, kBuffer, uRowBegin, uRowEnd);
+		break;
+	case EVALUATOR_LUT:
+		integrateRows<EVALUATOR_LUT>(state, kBuffer, uRowBegin, uRowEnd);
+		break;
+	default:
+		integrateRows<EVALUATOR_EXACT>(state, kBuffer, uRowBegin, uRowEnd);
+	}
+}
+
+uint32_t CPUBackend::getNumBands(const uint32_t uHeight) const
+{
+	const auto uNumThreads = GetNumThreads();
+
+	return uNumThreads > 1 ? fitBands(uNumThreads * g_uBandsPerThread, uHeight) : 1;
+}
+
+void CPUBackend::parallelFor(const uint32_t uCount, const function<void(uint32_t, uint32_t)> &task)
+{
+	// Single tasks, so the last ones are spread over the threads
+	m_pScheduler->ParallelFor(0, uCount, 1, [&task](const uint32_t uBegin, const uint32_t uEnd, const uint32_t uThread)
+	{
+		for (auto i = uBegin; i < uEnd; ++i) task(i, uThread);
+	});
+}
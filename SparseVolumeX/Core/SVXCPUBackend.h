@@ -0,0 +1,168 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <functional>
+#include "SVXBackend.h"
+#include "SVXDistanceField.h"
+#include "SVXIntervalColumns.h"
+#include "SVXSolid.h"
+#include "SVXRasterizer.h"
+#include "SVXScheduler.h"
+#include "SVXTransmission.h"
+
+namespace SVX
+{
+	// Light-space k-buffers compressed into columns of prefix-summed thicknesses. Immutable
+	// once peeled, so renderers of the same mesh and lights can share one.
+	struct LightField
+	{
+		std::vector<float4x4>			vViewProjs;
+		std::vector<KBuffer>			vKBuffers;		// Released once the columns are built
+		std::vector<IntervalColumns>	vColumns;
+		uint32_t						uNumCascades;
+		float							fDepthScale;	// Light-space depth range
+
+		size_t GetBytes() const
+		{
+			auto uBytes = size_t(0);
+			for (const auto &kBuffer : vKBuffers) uBytes += kBuffer.GetBytes();
+			for (const auto &columns : vColumns) uBytes += columns.GetBytes();
+
+			return uBytes;
+		}
+
+		// Light-path thickness of a world-space point in a view, bilinear over the columns
+		float GetThickness(const float3 &vPos, const uint32_t uView) const;
+	};
+
+	using spLightField = std::shared_ptr<LightField>;
+
+	//--------------------------------------------------------------------------------------
+	// CPU port of the D3D11 path: light-space peeling with prefix-summed thicknesses, kept
+	// as run-length interval columns, view-space peeling, and the interval integrator of
+	// CSRender with bilinear light thickness lookups and per-light cascades. The peels
+	// split the k-buffers into row bands and the integrator splits the image into rows,
+	// balanced over the worker threads by work stealing.
+	// In a frame graph every view is transformed once, and each band is a pass of its
+	// own, so the peels of all views run concurrently and a band is integrated as soon
+	// as it is peeled and the light columns are built. Without a retained k-buffer the view bands
+	// are transients, peeled a few bands ahead of the integration, so they alias.
+	// With a solid representation the view bands are resampled from it instead of peeled.
+	// Given an error tolerance, a view peels the coarsest level of detail of the mesh that
+	// stays within it; the light views always peel the full mesh, as the light field is shared.
+	// Integrates the homogeneous medium without a temporal history.
+	//--------------------------------------------------------------------------------------
+	class CPUBackend : public Backend
+	{
+	public:
+		// Transmission evaluators of the integration, the counterparts of TRANSMISSION in
+		// Content/SharedConst.h; see SVXTransmission.h for their error bounds
+		enum Evaluator : uint8_t
+		{
+			EVALUATOR_EXACT,
+			EVALUATOR_POLY,
+			EVALUATOR_LUT
+		};
+
+		// 0 threads for one per hardware thread
+		CPUBackend(const uint32_t uNumThreads = 0);
+		virtual ~CPUBackend();
+
+		void UploadMesh(const uint8_t *pVertices, const uint32_t uStride, const uint32_t uNumVertices,
+			const uint32_t *pIndices, const uint32_t uNumIndices) override;
+		void CreateKBuffers(const VolumeState &state) override;
+		void ClearKBuffers(const bool bLightSpace) override;
+		void UpdateFrame(const VolumeState &state) override;
+
+		void DepthPeelLightSpace(const VolumeState &state) override;
+		void ThicknessPrefix(const VolumeState &state) override;
+		void DepthPeel(const VolumeState &state) override;
+		void Integrate(const VolumeState &state) override;
+
+		void BuildFrame(FrameGraph &frameGraph, const VolumeState &state, const bool bLightSpace) override;
+		Scheduler *GetScheduler() override;
+		const Scheduler *GetScheduler() const;
+
+		void TrackMemory(MemoryTracker &memoryTracker, const char *pszAsset) const override;
+
+		// Shares a mesh, a pooled k-buffer or a light field peeled earlier for the same
+		// mesh and lights instead of creating them
+		void SetMesh(const spMesh &pMesh);
+		void SetKBuffer(const spKBuffer &pKBuffer);
+		void SetLightField(const spLightField &pLightField);
+
+		// Solid of the mesh to resample the view k-buffer from, null to peel
+		void SetSolid(const spSolid &pSolid);
+
+		// 8-bit RGB output of the integration, with the sqrt encoding of the swap chain;
+		// null (the default) for a buffer of the backend
+		void SetTarget(std::vector<uint8_t> *pvRGB);
+		void SetNumThreads(const uint32_t uNumThreads);
+
+		// Whether frame graphs peel into the k-buffer kept across frames (the default), or
+		// into transient bands, which cuts the memory to a few bands but leaves no k-buffer
+		void SetRetainKBuffer(const bool bRetainKBuffer);
+
+		// Error in pixels of the level of detail peeled for a view, 0 (the default) for the
+		// full mesh
+		void SetLODTolerance(const float fTolerance);
+
+		// Distance field of the mesh to sphere-trace the light-path thicknesses in, instead
+		// of peeling the light views; null (the default) to peel them
+		void SetDistanceField(const spDistanceField &pDistanceField);
+
+		// Evaluator of the transmission in the integration, EVALUATOR_EXACT by default
+		void SetTransmission(const Evaluator eEvaluator);
+
+		const spMesh &GetMesh() const;
+		const spKBuffer &GetKBuffer() const;
+		const spLightField &GetLightField() const;
+		const spSolid &GetSolid() const;
+		uint32_t GetNumThreads() const;
+		float GetLODTolerance() const;
+		const spDistanceField &GetDistanceField() const;
+		Evaluator GetTransmission() const;
+		const std::vector<uint8_t> &GetTarget() const;
+
+	protected:
+		void createKBuffer(const VolumeState &state);
+		void createLightField(const VolumeState &state);
+		void peel(const Mesh &mesh, const float4x4 *pViewProjs, KBuffer *pKBuffers, const uint32_t uNumViews);
+		const Mesh &getViewMesh(const VolumeState &state) const;
+		void buildColumns(const uint32_t uView);
+		template<Evaluator eEvaluator>
+		void integrateRows(const VolumeState &state, const KBuffer &kBuffer, const uint32_t uRowBegin,
+			const uint32_t uRowEnd);
+		void integrateRows(const VolumeState &state, const KBuffer &kBuffer, const uint32_t uRowBegin,
+			const uint32_t uRowEnd);
+		template<Evaluator eEvaluator>
+		float getTransmission(const float fSigma, const float fThickness) const;
+		uint32_t getNumBands(const uint32_t uHeight) const;
+		void parallelFor(const uint32_t uCount, const std::function<void(uint32_t, uint32_t)> &task);
+
+		spMesh						m_pMesh;
+		spKBuffer					m_pKBuffer;
+		spLightField				m_pLightField;
+		spSolid						m_pSolid;
+		std::vector<uint8_t>		*m_pvTarget;
+		std::vector<uint8_t>		m_vTarget;			// Without a target set
+		bool						m_bRetainKBuffer;
+		float						m_fLODTolerance;
+		spDistanceField				m_pDistanceField;
+		Evaluator					m_eTransmission;
+		TransmissionLUT				m_transmissionLUT;	// Of EVALUATOR_LUT
+
+		std::vector<float4>			m_vClipPos;			// Of all views of a peel outside a frame graph
+		std::vector<KBuffer>		m_vKBufferBands;	// Transient view bands of a frame graph
+		std::vector<float3>			m_vLightDirs;		// Toward the lights, of the frame
+
+		upScheduler					m_pScheduler;
+		std::vector<Rasterizer>		m_vRasterizers;		// One per thread
+	};
+
+	using upCPUBackend = std::unique_ptr<CPUBackend>;
+	using spCPUBackend = std::shared_ptr<CPUBackend>;
+}
@@ -0,0 +1,434 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cfloat>
+#include <functional>
+#include "SVXBVH.h"
+#include "SVXDistanceField.h"
+
+using namespace std;
+using namespace SVX;
+
+//--------------------------------------------------------------------------------------
+// Squared distance to the closest point of a triangle, by its Voronoi regions (Ericson)
+//--------------------------------------------------------------------------------------
+static float lengthSq(const float3 &v)
+{
+	return dot(v, v);
+}
+
+static float distanceSqToTriangle(const float3 &p, const float3 &a, const float3 &b, const float3 &c)
+{
+	const auto ab = b - a, ac = c - a, ap = p - a;
+	const auto d1 = dot(ab, ap), d2 = dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) return lengthSq(ap);
+
+	const auto bp = p - b;
+	const auto d3 = dot(ab, bp), d4 = dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3) return lengthSq(bp);
+
+	const auto vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return lengthSq(ap - ab * (d1 / (d1 - d3)));
+
+	const auto cp = p - c;
+	const auto d5 = dot(ab, cp), d6 = dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6) return lengthSq(cp);
+
+	const auto vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return lengthSq(ap - ac * (d2 / (d2 - d6)));
+
+	const auto va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+		return lengthSq(bp - (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))));
+
+	const auto fDenom = 1.0f / (va + vb + vc);
+
+	return lengthSq(ap - ab * (vb * fDenom) - ac * (vc * fDenom));
+}
+
+const uint32_t DistanceField::EMPTY_OUTSIDE;
+const uint32_t DistanceField::EMPTY_INSIDE;
+const uint32_t DistanceField::BRICK_SIZE;
+const uint32_t DistanceField::PACKET_SIZE;
+
+DistanceField::DistanceField() :
+	m_vOrigin(0.0f),
+	m_fCellSize(0.0f),
+	m_fBand(0.0f),
+	m_uGridSize(0),
+	m_vTable(0),
+	m_vPool(0)
+{
+}
+
+DistanceField::~DistanceField()
+{
+}
+
+void DistanceField::Create(const Mesh &mesh, const uint32_t uResolution, Scheduler &scheduler)
+{
+	// Cubic cells over the bounding cube, with a margin so that the grid faces are outside
+	const auto fHalfSize = mesh.GetRadius() * 1.02f;
+	m_uGridSize = (uResolution + BRICK_SIZE - 1) / BRICK_SIZE;
+	const auto uCells = m_uGridSize * BRICK_SIZE;
+	m_fCellSize = fHalfSize * 2.0f / uCells;
+	m_fBand = m_fCellSize * 2.0f;
+	m_vOrigin = mesh.GetCenter() - float3(fHalfSize);
+
+	const auto uGridSize = m_uGridSize;
+	const auto uNumCells = uGridSize * uGridSize * uGridSize;
+	const auto fBrickExtent = m_fCellSize * BRICK_SIZE;
+	const auto pPositions = mesh.GetPositions();
+	const auto pIndices = mesh.GetIndices();
+	const auto uNumTriangles = mesh.GetNumIndices() / 3;
+
+	// Bricks within the band of the bound of each triangle, counted then filled
+	const auto brickRange = [&](const uint32_t t, uint32_t vBegin[3], uint32_t vEnd[3])
+	{
+		const auto &v0 = pPositions[pIndices[t * 3]];
+		const auto &v1 = pPositions[pIndices[t * 3 + 1]];
+		const auto &v2 = pPositions[pIndices[t * 3 + 2]];
+		const auto vMin = (min)((min)(v0, v1), v2) - float3(m_fBand) - m_vOrigin;
+		const auto vMax = (max)((max)(v0, v1), v2) + float3(m_fBand) - m_vOrigin;
+		for (auto i = 0u; i < 3; ++i)
+		{
+			vBegin[i] = static_cast<uint32_t>((std::max)(floor(vMin[i] / fBrickExtent), 0.0f));
+			vEnd[i] = static_cast<uint32_t>((std::min)(floor(vMax[i] / fBrickExtent) + 1.0f, static_cast<float>(uGridSize)));
+		}
+	};
+
+	const auto forBricks = [&](const uint32_t t, const function<void(uint32_t)> &fn)
+	{
+		uint32_t vBegin[3], vEnd[3];
+		brickRange(t, vBegin, vEnd);
+		for (auto k = vBegin[2]; k < vEnd[2]; ++k)
+			for (auto j = vBegin[1]; j < vEnd[1]; ++j)
+				for (auto i = vBegin[0]; i < vEnd[0]; ++i) fn((k * uGridSize + j) * uGridSize + i);
+	};
+
+	vector<uint32_t> vOffsets(uNumCells + 1, 0);
+	for (auto t = 0u; t < uNumTriangles; ++t) forBricks(t, [&vOffsets](const uint32_t uCell) { ++vOffsets[uCell + 1]; });
+	for (auto i = 0u; i < uNumCells; ++i) vOffsets[i + 1] += vOffsets[i];
+	vector<uint32_t> vTriangles(vOffsets[uNumCells]);
+	{
+		auto vNext = vOffsets;
+		for (auto t = 0u; t < uNumTriangles; ++t)
+			forBricks(t, [&vNext, &vTriangles, t](const uint32_t uCell) { vTriangles[vNext[uCell]++] = t; });
+	}
+
+	vector<uint32_t> vBricks;
+	m_vTable.assign(uNumCells, EMPTY_OUTSIDE);
+	for (auto i = 0u; i < uNumCells; ++i)
+	{
+		if (vOffsets[i] == vOffsets[i + 1]) continue;
+		m_vTable[i] = static_cast<uint32_t>(vBricks.size());
+		vBricks.push_back(i);
+	}
+	m_vTable.shrink_to_fit();
+
+	// Unsigned squared distances, each brick splatting its triangles into the samples within the band
+	const auto uSamples = BRICK_SIZE + 1;
+	const auto uBrickSamples = brickSamples();
+	m_vPool.assign(vBricks.size() * uBrickSamples, m_fBand * m_fBand);
+	m_vPool.shrink_to_fit();
+	const auto brickOrigin = [&](const uint32_t uCell)
+	{
+		return float3(static_cast<float>(uCell % uGridSize), static_cast<float>(uCell / uGridSize % uGridSize),
+			static_cast<float>(uCell / (uGridSize * uGridSize))) * fBrickExtent + m_vOrigin;
+	};
+
+	scheduler.ParallelFor(0, static_cast<uint32_t>(vBricks.size()), 1, [&](const uint32_t uBegin,
+		const uint32_t uEnd, uint32_t)
+	{
+		for (auto b = uBegin; b < uEnd; ++b)
+		{
+			const auto uCell = vBricks[b];
+			const auto vBrickOrigin = brickOrigin(uCell);
+			const auto pBrick = &m_vPool[static_cast<size_t>(b) * uBrickSamples];
+			for (auto i = vOffsets[uCell]; i < vOffsets[uCell + 1]; ++i)
+			{
+				const auto t = vTriangles[i];
+				const auto &v0 = pPositions[pIndices[t * 3]];
+				const auto &v1 = pPositions[pIndices[t * 3 + 1]];
+				const auto &v2 = pPositions[pIndices[t * 3 + 2]];
+				const auto vMin = ((min)((min)(v0, v1), v2) - float3(m_fBand) - vBrickOrigin) / m_fCellSize;
+				const auto vMax = ((max)((max)(v0, v1), v2) + float3(m_fBand) - vBrickOrigin) / m_fCellSize;
+
+				// The plane of the triangle bounds its distance from below, which rejects most
+				// samples once they are closer to a neighbor
+				const auto vNormal = cross(v1 - v0, v2 - v0);
+				const auto fNormalLength = length(vNormal);
+				const auto vUnitNormal = fNormalLength > 0.0f ? vNormal / fNormalLength : float3(0.0f);
+
+				uint32_t vBegin[3], vEnd[3];
+				for (auto j = 0u; j < 3; ++j)
+				{
+					vBegin[j] = static_cast<uint32_t>((std::max)(ceil(vMin[j]), 0.0f));
+					vEnd[j] = static_cast<uint32_t>((std::max)((std::min)(floor(vMax[j]) + 1.0f,
+						static_cast<float>(uSamples)), 0.0f));
+				}
+
+				for (auto z = vBegin[2]; z < vEnd[2]; ++z)
+					for (auto y = vBegin[1]; y < vEnd[1]; ++y)
+						for (auto x = vBegin[0]; x < vEnd[0]; ++x)
+						{
+							const auto vPos = vBrickOrigin + float3(static_cast<float>(x), static_cast<float>(y),
+								static_cast<float>(z)) * m_fCellSize;
+							auto &fDistSq = pBrick[(z * uSamples + y) * uSamples + x];
+							const auto fPlane = dot(vUnitNormal, vPos - v0);
+							if (fPlane * fPlane >= fDistSq) continue;
+							fDistSq = (std::min)(fDistSq, distanceSqToTriangle(vPos, v0, v1, v2));
+						}
+			}
+		}
+	});
+
+	// Inside votes of the samples and of the centers of the empty bricks, from the parity
+	// of the hits in front of them along rays through the grid on each axis
+	BVH bvh;
+	bvh.Create(mesh, scheduler);
+	vector<uint8_t> vSampleVotes(m_vPool.size(), 0), vBrickVotes(uNumCells, 0);
+	const auto fGridExtent = fBrickExtent * uGridSize;
+	for (auto uAxis = 0u; uAxis < 3; ++uAxis)
+	{
+		const auto u = (uAxis + 1) % 3, v = (uAxis + 2) % 3;
+		auto vDir = float3(0.0f);
+		vDir[uAxis] = 1.0f;
+		const auto castRay = [&](const float fU, const float fV, vector<float> &vT)
+		{
+			auto vOrigin = m_vOrigin;
+			vOrigin[u] += fU;
+			vOrigin[v] += fV;
+			bvh.Intersect(vOrigin, vDir, 0.0f, fGridExtent, vT);
+		};
+		const auto isInside = [](const vector<float> &vT, const float fT)
+		{
+			return (lower_bound(vT.begin(), vT.end(), fT) - vT.begin()) & 1;
+		};
+		const auto cellOf = [uGridSize, uAxis, u, v](const uint32_t a, const uint32_t bu, const uint32_t bv)
+		{
+			uint32_t vCoords[3];
+			vCoords[uAxis] = a;
+			vCoords[u] = bu;
+			vCoords[v] = bv;
+
+			return (vCoords[2] * uGridSize + vCoords[1]) * uGridSize + vCoords[0];
+		};
+
+		// Sample lines; a line on a brick face runs through the samples of both bricks
+		const auto uLines = uGridSize * BRICK_SIZE + 1;
+		scheduler.ParallelFor(0, uLines * uLines, 64, [&](const uint32_t uBegin, const uint32_t uEnd, uint32_t)
+		{
+			vector<float> vT;
+			for (auto uLine = uBegin; uLine < uEnd; ++uLine)
+			{
+				const auto su = uLine % uLines, sv = uLine / uLines;
+				auto bCast = false;
+				for (auto du = 0u; du < 2; ++du)
+					for (auto dv = 0u; dv < 2; ++dv)
+					{
+						const auto bu = su / BRICK_SIZE - du, bv = sv / BRICK_SIZE - dv;
+						if (bu >= uGridSize || bv >= uGridSize || (du && su % BRICK_SIZE) || (dv && sv % BRICK_SIZE)) continue;
+
+						for (auto a = 0u; a < uGridSize; ++a)
+						{
+							const auto uPoolBrick = m_vTable[cellOf(a, bu, bv)];
+							if (uPoolBrick >= EMPTY_INSIDE) continue;
+							if (!bCast) castRay(su * m_fCellSize, sv * m_fCellSize, vT);
+							bCast = true;
+
+							uint32_t vSample[3];
+							vSample[u] = su - bu * BRICK_SIZE;
+							vSample[v] = sv - bv * BRICK_SIZE;
+							for (vSample[uAxis] = 0; vSample[uAxis] < uSamples; ++vSample[uAxis])
+							{
+								const auto fT = (a * BRICK_SIZE + vSample[uAxis]) * m_fCellSize;
+								vSampleVotes[static_cast<size_t>(uPoolBrick) * uBrickSamples +
+									(vSample[2] * uSamples + vSample[1]) * uSamples + vSample[0]] += isInside(vT, fT);
+							}
+						}
+					}
+			}
+		});
+
+		// Brick center lines
+		scheduler.ParallelFor(0, uGridSize * uGridSize, 16, [&](const uint32_t uBegin, const uint32_t uEnd, uint32_t)
+		{
+			vector<float> vT;
+			for (auto uLine = uBegin; uLine < uEnd; ++uLine)
+			{
+				const auto bu = uLine % uGridSize, bv = uLine / uGridSize;
+				castRay((bu + 0.5f) * fBrickExtent, (bv + 0.5f) * fBrickExtent, vT);
+				for (auto a = 0u; a < uGridSize; ++a)
+				{
+					const auto uCell = cellOf(a, bu, bv);
+					if (m_vTable[uCell] == EMPTY_OUTSIDE) vBrickVotes[uCell] += isInside(vT, (a + 0.5f) * fBrickExtent);
+				}
+			}
+		});
+	}
+
+	for (auto i = 0u; i < m_vPool.size(); ++i)
+		m_vPool[i] = vSampleVotes[i] >= 2 ? -sqrt(m_vPool[i]) : sqrt(m_vPool[i]);
+	for (auto i = 0u; i < uNumCells; ++i)
+		if (m_vTable[i] == EMPTY_OUTSIDE && vBrickVotes[i] >= 2) m_vTable[i] = EMPTY_INSIDE;
+}
+
+float DistanceField::Sample(const float3 &vPos) const
+{
+	const auto vLocal = (vPos - m_vOrigin) / m_fCellSize;
+	uint32_t vBrick[3];
+	const auto uPoolBrick = findBrick(vLocal, vBrick);
+	if (uPoolBrick == EMPTY_OUTSIDE) return m_fBand;
+	if (uPoolBrick == EMPTY_INSIDE) return -m_fBand;
+
+	return sampleBrick(uPoolBrick, vLocal, vBrick);
+}
+
+float DistanceField::TraceThickness(const float3 &vOrigin, const float3 &vDir) const
+{
+	float fThickness;
+	TraceThickness(&vOrigin, 1, vDir, &fThickness);
+
+	return fThickness;
+}
+
+void DistanceField::TraceThickness(const float3 *pOrigins, const uint32_t uNumRays, const float3 &vDir,
+	float *pThicknesses) const
+{
+	// In cell units; the faces of the grid and of the bricks ahead are planes along vDir
+	const auto fCellInv = 1.0f / m_fCellSize;
+	const auto fExtent = static_cast<float>(m_uGridSize * BRICK_SIZE);
+	const auto fBand = m_fBand * fCellInv;
+	float3 vDirInv, vFace;
+	for (auto i = 0u; i < 3; ++i)
+	{
+		vDirInv[i] = vDir[i] != 0.0f ? 1.0f / vDir[i] : FLT_MAX;
+		vFace[i] = vDir[i] > 0.0f ? 1.0f : 0.0f;
+	}
+
+	// Distance of a point, and the step across its brick if that is off the band
+	const auto distance = [&](const float3 &vPos, float &fSkip)
+	{
+		uint32_t vBrick[3];
+		const auto uPoolBrick = findBrick(vPos, vBrick);
+		fSkip = 0.0f;
+		if (uPoolBrick < EMPTY_INSIDE) return sampleBrick(uPoolBrick, vPos, vBrick) * fCellInv;
+
+		fSkip = FLT_MAX;
+		for (auto i = 0u; i < 3; ++i)
+			if (vDir[i] != 0.0f) fSkip = (std::min)(fSkip, ((vBrick[i] + vFace[i]) * BRICK_SIZE - vPos[i]) * vDirInv[i]);
+		fSkip += 0.01f;
+
+		return uPoolBrick == EMPTY_INSIDE ? -fBand : fBand;
+	};
+
+	// The rays step in lockstep, so that the latencies of their samples overlap
+	float3 vLocal[PACKET_SIZE];
+	float fT[PACKET_SIZE], fTEnd[PACKET_SIZE], fDist[PACKET_SIZE], fSkip[PACKET_SIZE];
+	for (auto r = 0u; r < uNumRays; ++r)
+	{
+		vLocal[r] = (pOrigins[r] - m_vOrigin) * fCellInv;
+		fTEnd[r] = FLT_MAX;
+		for (auto i = 0u; i < 3; ++i)
+			if (vDir[i] != 0.0f) fTEnd[r] = (std::min)(fTEnd[r], (vFace[i] * fExtent - vLocal[r][i]) * vDirInv[i]);
+		fT[r] = 0.0f;
+		fDist[r] = distance(vLocal[r], fSkip[r]);
+		pThicknesses[r] = 0.0f;
+	}
+
+	for (auto bActive = true; bActive;)
+	{
+		bActive = false;
+		for (auto r = 0u; r < uNumRays; ++r)
+		{
+			if (fT[r] >= fTEnd[r]) continue;
+			bActive = true;
+
+			const auto fStep = (std::min)((std::max)((std::max)(fabs(fDist[r]), fSkip[r]), 1.0f), fTEnd[r] - fT[r]);
+			fT[r] += fStep;
+			const auto fNextDist = distance(vLocal[r] + vDir * fT[r], fSkip[r]);
+
+			// A step over the surface counts the part of it behind the zero crossing
+			if (fDist[r] < 0.0f && fNextDist < 0.0f) pThicknesses[r] += fStep;
+			else if (fDist[r] < 0.0f || fNextDist < 0.0f)
+			{
+				const auto fInside = (std::min)(fDist[r], fNextDist);
+				pThicknesses[r] += fStep * fInside / (fInside - (std::max)(fDist[r], fNextDist));
+			}
+			fDist[r] = fNextDist;
+		}
+	}
+
+	for (auto r = 0u; r < uNumRays; ++r) pThicknesses[r] *= m_fCellSize;
+}
+
+uint32_t DistanceField::GetResolution() const
+{
+	return m_uGridSize * BRICK_SIZE;
+}
+
+uint32_t DistanceField::GetNumBricks() const
+{
+	return static_cast<uint32_t>(m_vPool.size() / brickSamples());
+}
+
+float DistanceField::GetBand() const
+{
+	return m_fBand;
+}
+
+size_t DistanceField::GetBytes() const
+{
+	return sizeof(uint32_t) * m_vTable.capacity() + sizeof(float) * m_vPool.capacity();
+}
+
+uint32_t DistanceField::brickSamples()
+{
+	return (BRICK_SIZE + 1) * (BRICK_SIZE + 1) * (BRICK_SIZE + 1);
+}
+
+uint32_t DistanceField::findBrick(const float3 &vLocal, uint32_t vBrick[3]) const
+{
+	// Clamped to the grid, so that the brick is valid even off it
+	const auto fExtent = static_cast<float>(m_uGridSize * BRICK_SIZE);
+	auto bInside = true;
+	for (auto i = 0u; i < 3; ++i)
+	{
+		bInside = bInside && vLocal[i] >= 0.0f && vLocal[i] < fExtent;
+		const auto fCell = (std::min)((std::max)(vLocal[i], 0.0f), fExtent - 1.0f);
+		vBrick[i] = static_cast<uint32_t>(fCell) / BRICK_SIZE;
+	}
+
+	return bInside ? m_vTable[(vBrick[2] * m_uGridSize + vBrick[1]) * m_uGridSize + vBrick[0]] : EMPTY_OUTSIDE;
+}
+
+float DistanceField::sampleBrick(const uint32_t uPoolBrick, const float3 &vLocal, const uint32_t vBrick[3]) const
+{
+	const auto uSamples = BRICK_SIZE + 1;
+	const auto pBrick = &m_vPool[static_cast<size_t>(uPoolBrick) * brickSamples()];
+
+	uint32_t vCell[3];
+	float vFrac[3];
+	for (auto i = 0u; i < 3; ++i)
+	{
+		const auto f = (std::min)((std::max)(vLocal[i] - static_cast<float>(vBrick[i] * BRICK_SIZE), 0.0f),
+			static_cast<float>(BRICK_SIZE));
+		vCell[i] = (std::min)(static_cast<uint32_t>(f), BRICK_SIZE - 1);
+		vFrac[i] = f - vCell[i];
+	}
+
+	float fPlanes[2];
+	for (auto z = 0u; z < 2; ++z)
+	{
+		const auto pRow0 = &pBrick[((vCell[2] + z) * uSamples + vCell[1]) * uSamples + vCell[0]];
+		const auto pRow1 = pRow0 + uSamples;
+		const auto f0 = pRow0[0] + (pRow0[1] - pRow0[0]) * vFrac[0];
+		const auto f1 = pRow1[0] + (pRow1[1] - pRow1[0]) * vFrac[0];
+		fPlanes[z] = f0 + (f1 - f0) * vFrac[1];
+	}
+
+	return fPlanes[0] + (fPlanes[1] - fPlanes[0]) * vFrac[2];
+}
@@ -0,0 +1,74 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SVXMesh.h"
+#include "SVXScheduler.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Signed distance field of a mesh, negative inside, in a narrow band of bricks around
+	// its surface. Only the bricks within the band of a triangle own samples in the pool;
+	// the others only record whether they are inside or outside. The distances are exact
+	// to the triangles of each brick, clamped to the band, and the signs take the majority
+	// of the ray parities along the three axes through the BVH, so that a stray crossing
+	// or a hole on one axis does not flip them.
+	// Sphere tracing it along a light direction estimates the light-path thickness of a
+	// point without peeling the light views.
+	//--------------------------------------------------------------------------------------
+	class DistanceField
+	{
+	public:
+		static const uint32_t EMPTY_OUTSIDE = 0xffffffff;
+		static const uint32_t EMPTY_INSIDE = 0xfffffffe;
+		static const uint32_t BRICK_SIZE = 8;	// Cells per brick axis, each brick with (N + 1)^3 samples
+		static const uint32_t PACKET_SIZE = 4;
+
+		DistanceField();
+		virtual ~DistanceField();
+
+		// uResolution^3 cells over the bounding cube of the mesh, rounded up to whole bricks;
+		// the bricks are baked on the threads of the scheduler
+		void Create(const Mesh &mesh, const uint32_t uResolution, Scheduler &scheduler);
+
+		// Trilinear in the band, and plus or minus the band outside it
+		float Sample(const float3 &vPos) const;
+
+		// Length inside the mesh of the ray from vOrigin along the unit vDir, up to the exit
+		// of the grid. Steps are the distance, at least a cell, and cross the bricks off the
+		// band at once; a step over the surface counts the part of it inside by the linear
+		// distance between its ends.
+		float TraceThickness(const float3 &vOrigin, const float3 &vDir) const;
+
+		// Up to PACKET_SIZE rays along the same vDir, e.g. the samples of a view interval,
+		// traced together so that their steps overlap
+		void TraceThickness(const float3 *pOrigins, const uint32_t uNumRays, const float3 &vDir,
+			float *pThicknesses) const;
+
+		uint32_t GetResolution() const;
+		uint32_t GetNumBricks() const;
+		float GetBand() const;
+		size_t GetBytes() const;
+
+	protected:
+		static uint32_t brickSamples();
+
+		// Brick of a grid-relative position, or EMPTY_OUTSIDE off the grid
+		uint32_t findBrick(const float3 &vLocal, uint32_t vBrick[3]) const;
+		float sampleBrick(const uint32_t uPoolBrick, const float3 &vLocal, const uint32_t vBrick[3]) const;
+
+		float3					m_vOrigin;
+		float					m_fCellSize;
+		float					m_fBand;
+		uint32_t				m_uGridSize;	// Bricks per axis
+
+		std::vector<uint32_t>	m_vTable;		// Brick grid to pool brick, or EMPTY_*
+		std::vector<float>		m_vPool;
+	};
+
+	using upDistanceField = std::unique_ptr<DistanceField>;
+	using spDistanceField = std::shared_ptr<DistanceField>;
+}
@@ -0,0 +1,60 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <sys/stat.h>
+
+namespace SVX
+{
+	// fopen_s under MSVC, where /sdl turns the fopen deprecation into an error
+	inline FILE *OpenFile(const char *pszFilename, const char *pszMode)
+	{
+		FILE *pFile;
+#ifdef _MSC_VER
+		if (fopen_s(&pFile, pszFilename, pszMode)) pFile = nullptr;
+#else
+		pFile = fopen(pszFilename, pszMode);
+#endif
+
+		return pFile;
+	}
+
+	// Returns 0 when the file does not exist
+	inline uint64_t GetFileSize(const char *pszFilename)
+	{
+		const auto pFile = OpenFile(pszFilename, "rb");
+		if (!pFile) return 0;
+
+#ifdef _MSC_VER
+		_fseeki64(pFile, 0, SEEK_END);
+		const auto uSize = static_cast<uint64_t>(_ftelli64(pFile));
+#else
+		fseek(pFile, 0, SEEK_END);
+		const auto uSize = static_cast<uint64_t>(ftell(pFile));
+#endif
+		fclose(pFile);
+
+		return uSize;
+	}
+
+	// Size and modification time of a file folded into a tag of its version, so that the
+	// caches derived from an earlier version are rejected; 0 when the file does not exist
+	inline uint64_t GetFileStamp(const char *pszFilename)
+	{
+#ifdef _MSC_VER
+		struct _stat64 fileStat;
+		if (_stat64(pszFilename, &fileStat)) return 0;
+#else
+		struct stat fileStat;
+		if (stat(pszFilename, &fileStat)) return 0;
+#endif
+		const auto uSize = static_cast<uint64_t>(fileStat.st_size);
+		const auto uTime = static_cast<uint64_t>(fileStat.st_mtime);
+
+		return uSize ^ (uTime * 0x9e3779b97f4a7c15ull) ^ (uTime >> 32);
+	}
+}
@@ -0,0 +1,289 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include "SVXFrameGraph.h"
+
+using namespace std;
+using namespace SVX;
+
+// Alignment of the transients in the heap, a cache line
+static const size_t g_uTransientAlignment = 64;
+
+FrameGraph::FrameGraph() :
+	m_arena(),
+	m_vResources(),
+	m_vPasses(),
+	m_vTasks(0),
+	m_vTaskDependencies(0),
+	m_vHeap(0),
+	m_uHeapBytes(0),
+	m_bCompiled(false),
+	m_tStart(chrono::steady_clock::now())
+{
+}
+
+FrameGraph::~FrameGraph()
+{
+	Reset();
+}
+
+void FrameGraph::Reset()
+{
+	for (auto &pass : m_vPasses) pass.execute.pfnDestroy(pass.execute.pFunction);
+
+	// The vectors keep their capacity, and their arena its high-water block
+	m_vResources.clear();
+	m_vPasses.clear();
+	m_arena.Reset();
+	m_uHeapBytes = 0;
+	m_bCompiled = false;
+}
+
+uint32_t FrameGraph::ImportResource(const char *pszName)
+{
+	const ArenaAllocator<uint32_t> allocator(m_arena);
+	m_vResources.push_back({ pszName, 0, 0, false, -1, ArenaVector<uint32_t>(allocator),
+		ArenaVector<uint32_t>(allocator) });
+	m_bCompiled = false;
+
+	return static_cast<uint32_t>(m_vResources.size() - 1);
+}
+
+uint32_t FrameGraph::CreateTransient(const char *pszName, const size_t uBytes)
+{
+	const ArenaAllocator<uint32_t> allocator(m_arena);
+	m_vResources.push_back({ pszName, uBytes, 0, true, -1, ArenaVector<uint32_t>(allocator),
+		ArenaVector<uint32_t>(allocator) });
+	m_bCompiled = false;
+
+	return static_cast<uint32_t>(m_vResources.size() - 1);
+}
+
+uint32_t FrameGraph::addPass(const char *pszName, const Resources &reads, const Resources &writes,
+	const Function &execute)
+{
+	const ArenaAllocator<uint32_t> allocator(m_arena);
+	m_vPasses.push_back({ pszName, ArenaVector<uint32_t>(reads.begin(), reads.end(), allocator),
+		ArenaVector<uint32_t>(writes.begin(), writes.end(), allocator), ArenaVector<uint32_t>(allocator),
+		execute, -1.0, -1.0 });
+	m_bCompiled = false;
+
+	return static_cast<uint32_t>(m_vPasses.size() - 1);
+}
+
+void FrameGraph::Compile()
+{
+	for (auto &resource : m_vResources)
+	{
+		resource.iLastWriter = -1;
+		resource.vReaders.clear();
+		resource.vPasses.clear();
+	}
+
+	// Hazards in declaration order
+	for (auto i = 0u; i < m_vPasses.size(); ++i)
+	{
+		auto &pass = m_vPasses[i];
+		pass.vDependencies.clear();
+
+		for (const auto &uRead : pass.vReads)
+		{
+			auto &resource = m_vResources[uRead];
+			addDependency(i, resource.iLastWriter);
+			resource.vReaders.push_back(i);
+			resource.vPasses.push_back(i);
+		}
+
+		for (const auto &uWrite : pass.vWrites)
+		{
+			auto &resource = m_vResources[uWrite];
+			addDependency(i, resource.iLastWriter);
+			for (const auto &uReader : resource.vReaders) addDependency(i, uReader);
+			resource.vReaders.clear();
+			resource.iLastWriter = static_cast<int32_t>(i);
+			resource.vPasses.push_back(i);
+		}
+	}
+
+	placeTransients();
+
+	for (auto &pass : m_vPasses)
+	{
+		auto &vDependencies = pass.vDependencies;
+		sort(vDependencies.begin(), vDependencies.end());
+		vDependencies.erase(unique(vDependencies.begin(), vDependencies.end()), vDependencies.end());
+	}
+
+	m_bCompiled = true;
+}
+
+void FrameGraph::Execute(Scheduler *pScheduler, Profiler *pProfiler)
+{
+	if (!m_bCompiled) Compile();
+	if (m_vHeap.size() < m_uHeapBytes) m_vHeap.resize(m_uHeapBytes);
+
+	m_tStart = chrono::steady_clock::now();
+	const auto fProfilerStart = pProfiler ? pProfiler->GetTime() : 0.0;
+	for (auto &pass : m_vPasses) pass.fStart = pass.fEnd = -1.0;
+
+	if (!pScheduler)
+	{
+		for (auto &pass : m_vPasses)
+		{
+			const Profiler::Scope scope(pProfiler, pass.pszName);
+			run(pass);
+		}
+
+		return;
+	}
+
+	// The task vectors keep their capacity across frames, but not the tasks, which return
+	// to the pool of the scheduler
+	m_vTasks.resize(m_vPasses.size());
+	for (auto i = 0u; i < m_vPasses.size(); ++i)
+	{
+		m_vTaskDependencies.clear();
+		for (const auto &uDependency : m_vPasses[i].vDependencies) m_vTaskDependencies.push_back(m_vTasks[uDependency]);
+		m_vTasks[i] = pScheduler->Run([this, i]() { run(m_vPasses[i]); }, m_vTaskDependencies);
+	}
+	m_vTaskDependencies.clear();
+	pScheduler->Wait(pScheduler->WhenAll(m_vTasks));
+	m_vTasks.clear();
+
+	// The profiler is not thread-safe, so the stages are added once all passes are done
+	if (pProfiler)
+		for (const auto &pass : m_vPasses)
+			pProfiler->AddStage(pProfiler->GetFrame(), pass.pszName, Profiler::TRACK_CPU,
+				fProfilerStart + pass.fStart, pass.fEnd - pass.fStart);
+}
+
+uint8_t *FrameGraph::GetTransient(const uint32_t uResource)
+{
+	return &m_vHeap[m_vResources[uResource].uOffset];
+}
+
+uint32_t FrameGraph::GetNumPasses() const
+{
+	return static_cast<uint32_t>(m_vPasses.size());
+}
+
+size_t FrameGraph::GetHeapBytes() const
+{
+	return m_uHeapBytes;
+}
+
+size_t FrameGraph::GetTransientBytes() const
+{
+	size_t uBytes = 0;
+	for (const auto &resource : m_vResources) if (resource.bTransient) uBytes += resource.uBytes;
+
+	return uBytes;
+}
+
+double FrameGraph::GetSpan(initializer_list<const char*> ilPasses) const
+{
+	auto fStart = -1.0, fEnd = -1.0;
+	for (const auto &pass : m_vPasses)
+	{
+		if (pass.fEnd < 0.0 || none_of(ilPasses.begin(), ilPasses.end(),
+			[&pass](const char *pszName) { return strcmp(pszName, pass.pszName) == 0; })) continue;
+		fStart = fStart < 0.0 ? pass.fStart : (std::min)(fStart, pass.fStart);
+		fEnd = (std::max)(fEnd, pass.fEnd);
+	}
+
+	return fEnd >= 0.0 ? fEnd - fStart : 0.0;
+}
+
+Arena &FrameGraph::GetArena()
+{
+	return m_arena;
+}
+
+size_t FrameGraph::GetArenaBytes() const
+{
+	return m_arena.GetBytes();
+}
+
+uint64_t FrameGraph::GetNumArenaAllocations() const
+{
+	return m_arena.GetNumBlockAllocations();
+}
+
+void FrameGraph::addDependency(const uint32_t uPass, const int32_t iDependency)
+{
+	if (iDependency >= 0 && static_cast<uint32_t>(iDependency) != uPass)
+		m_vPasses[uPass].vDependencies.push_back(iDependency);
+}
+
+void FrameGraph::placeTransients()
+{
+	const ArenaAllocator<uint32_t> allocator(m_arena);
+	ArenaVector<uint32_t> vTransients(allocator);
+	for (auto i = 0u; i < m_vResources.size(); ++i)
+	{
+		const auto &resource = m_vResources[i];
+		if (resource.bTransient && resource.uBytes > 0 && !resource.vPasses.empty()) vTransients.push_back(i);
+	}
+
+	// By first pass, then declaration, each at the lowest offset clear of the transients
+	// still alive
+	sort(vTransients.begin(), vTransients.end(), [this](const uint32_t a, const uint32_t b)
+	{
+		const auto uFirstA = m_vResources[a].vPasses.front();
+		const auto uFirstB = m_vResources[b].vPasses.front();
+
+		return uFirstA < uFirstB || (uFirstA == uFirstB && a < b);
+	});
+
+	ArenaVector<uint32_t> vPlaced(allocator);
+	ArenaVector<pair<size_t, size_t>> vLive(allocator);
+	m_uHeapBytes = 0;
+	for (const auto &uTransient : vTransients)
+	{
+		auto &resource = m_vResources[uTransient];
+		const auto uFirst = resource.vPasses.front();
+
+		vLive.clear();
+		for (const auto &uPlaced : vPlaced)
+		{
+			const auto &placed = m_vResources[uPlaced];
+			if (placed.vPasses.back() >= uFirst) vLive.emplace_back(placed.uOffset, placed.uOffset + placed.uBytes);
+		}
+		sort(vLive.begin(), vLive.end());
+
+		size_t uOffset = 0;
+		for (const auto &live : vLive)
+		{
+			if (uOffset + resource.uBytes <= live.first) break;
+			uOffset = (std::max)(uOffset, (live.second + g_uTransientAlignment - 1) / g_uTransientAlignment * g_uTransientAlignment);
+		}
+		resource.uOffset = uOffset;
+
+		// Every pass of a dead transient in the same memory runs before this one is written
+		for (const auto &uPlaced : vPlaced)
+		{
+			const auto &placed = m_vResources[uPlaced];
+			if (placed.vPasses.back() < uFirst && placed.uOffset < uOffset + resource.uBytes &&
+				uOffset < placed.uOffset + placed.uBytes)
+				for (const auto &uPass : placed.vPasses) addDependency(uFirst, uPass);
+		}
+
+		vPlaced.push_back(uTransient);
+		m_uHeapBytes = (std::max)(m_uHeapBytes, uOffset + resource.uBytes);
+	}
+}
+
+void FrameGraph::run(Pass &pass)
+{
+	pass.fStart = getTime();
+	pass.execute.pfnCall(pass.execute.pFunction);
+	pass.fEnd = getTime();
+}
+
+double FrameGraph::getTime() const
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - m_tStart).count();
+}
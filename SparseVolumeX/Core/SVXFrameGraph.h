@@ -0,0 +1,151 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <initializer_list>
+#include <new>
+#include <utility>
+#include "SVXArena.h"
+#include "SVXProfiler.h"
+#include "SVXScheduler.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// A frame as a graph of passes with declared resource reads and writes. The passes run
+	// in declaration order on the calling thread, or as tasks of a scheduler ordered only
+	// by their read-after-write, write-after-write and write-after-read hazards.
+	// Transient resources share one heap and alias wherever their lifetimes, from their
+	// first to their last pass in declaration order, do not overlap; the passes of the
+	// earlier resource are then ordered before the first pass of the later one, so the
+	// declaration order bounds the transients in flight.
+	// The passes, their functions and the scratch of the frame live in an arena reset with
+	// the graph, so that a frame declared like the last one makes no heap allocation. The
+	// names of the passes and resources are not copied, and must outlive the frame.
+	//--------------------------------------------------------------------------------------
+	class FrameGraph
+	{
+	public:
+		// Resources read or written by a pass, as a braced list or a vector; a view valid for
+		// the call of AddPass() only
+		class Resources
+		{
+		public:
+			Resources(const std::initializer_list<uint32_t> &ilResources) :
+				m_pResources(nullptr), m_uNumResources(static_cast<uint32_t>(ilResources.size()))
+			{
+				m_pResources = ilResources.begin();
+			}
+			template<typename Alloc>
+			Resources(const std::vector<uint32_t, Alloc> &vResources) :
+				m_pResources(vResources.data()), m_uNumResources(static_cast<uint32_t>(vResources.size())) {}
+
+			const uint32_t *begin() const { return m_pResources; }
+			const uint32_t *end() const { return m_pResources + m_uNumResources; }
+
+		protected:
+			const uint32_t	*m_pResources;
+			uint32_t		m_uNumResources;
+		};
+
+		FrameGraph();
+		virtual ~FrameGraph();
+
+		// Drops the passes and resources and resets the arena, but keeps the heap
+		void Reset();
+
+		// Resource owned outside the graph, e.g. a k-buffer kept across frames
+		uint32_t ImportResource(const char *pszName);
+		uint32_t CreateTransient(const char *pszName, const size_t uBytes);
+
+		// The function is moved into the arena and destroyed by Reset()
+		template<typename Fn>
+		uint32_t AddPass(const char *pszName, const Resources &reads, const Resources &writes, Fn &&execute)
+		{
+			using Callable = typename std::decay<Fn>::type;
+			const auto pFunction = new(m_arena.Allocate(sizeof(Callable), alignof(Callable)))
+				Callable(std::forward<Fn>(execute));
+
+			return addPass(pszName, reads, writes, { pFunction, [](void *p) { (*static_cast<Callable*>(p))(); },
+				[](void *p) { static_cast<Callable*>(p)->~Callable(); } });
+		}
+
+		// Orders the passes and places the transients
+		void Compile();
+
+		// Runs the passes as tasks of the scheduler, or in order if null, with a profiler
+		// stage per pass; stages of concurrent passes add up to their thread time
+		void Execute(Scheduler *pScheduler, Profiler *pProfiler = nullptr);
+
+		// Storage of a transient, valid while its passes run
+		uint8_t *GetTransient(const uint32_t uResource);
+
+		uint32_t GetNumPasses() const;
+		size_t GetHeapBytes() const;		// Aliased transients
+		size_t GetTransientBytes() const;	// Sum of the transients
+
+		// Milliseconds from the first start to the last end of the passes of these names,
+		// in the last execution; 0 if none ran
+		double GetSpan(std::initializer_list<const char*> ilPasses) const;
+
+		// Scratch of the frame, e.g. the resource lists of the passes, valid until Reset()
+		Arena &GetArena();
+		size_t GetArenaBytes() const;
+		uint64_t GetNumArenaAllocations() const;	// Blocks taken from the heap
+
+	protected:
+		struct Resource
+		{
+			const char				*pszName;
+			size_t					uBytes;
+			size_t					uOffset;
+			bool					bTransient;
+			int32_t					iLastWriter;
+			ArenaVector<uint32_t>	vReaders;		// Since the last write
+			ArenaVector<uint32_t>	vPasses;		// All accesses, in declaration order
+		};
+
+		// Type-erased function in the arena
+		struct Function
+		{
+			void					*pFunction;
+			void					(*pfnCall)(void*);
+			void					(*pfnDestroy)(void*);
+		};
+
+		struct Pass
+		{
+			const char				*pszName;
+			ArenaVector<uint32_t>	vReads;
+			ArenaVector<uint32_t>	vWrites;
+			ArenaVector<uint32_t>	vDependencies;
+			Function				execute;
+			double					fStart;
+			double					fEnd;
+		};
+
+		uint32_t addPass(const char *pszName, const Resources &reads, const Resources &writes,
+			const Function &execute);
+		void addDependency(const uint32_t uPass, const int32_t iDependency);
+		void placeTransients();
+		void run(Pass &pass);
+		double getTime() const;
+
+		Arena					m_arena;
+		std::vector<Resource>	m_vResources;
+		std::vector<Pass>		m_vPasses;
+		std::vector<spTask>		m_vTasks;				// Of the last execution
+		std::vector<spTask>		m_vTaskDependencies;	// Scratch of a submission
+		std::vector<uint8_t>	m_vHeap;
+		size_t					m_uHeapBytes;
+		bool					m_bCompiled;
+
+		std::chrono::steady_clock::time_point	m_tStart;
+	};
+
+	using upFrameGraph = std::unique_ptr<FrameGraph>;
+	using spFrameGraph = std::shared_ptr<FrameGraph>;
+}
@@ -0,0 +1,206 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include "SVXImageIO.h"
+
+using namespace std;
+using namespace SVX;
+
+//--------------------------------------------------------------------------------------
+// PNG checksums
+//--------------------------------------------------------------------------------------
+static uint32_t crc32(uint32_t uCRC, const uint8_t *pData, const size_t uSize)
+{
+	static uint32_t uTable[256] = {};
+	if (!uTable[1])
+		for (auto i = 0u; i < 256; ++i)
+		{
+			auto c = i;
+			for (auto k = 0; k < 8; ++k) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			uTable[i] = c;
+		}
+
+	uCRC = ~uCRC;
+	for (size_t i = 0; i < uSize; ++i) uCRC = uTable[(uCRC ^ pData[i]) & 0xff] ^ (uCRC >> 8);
+
+	return ~uCRC;
+}
+
+static uint32_t adler32(uint32_t uAdler, const uint8_t *pData, const size_t uSize)
+{
+	auto a = uAdler & 0xffff, b = uAdler >> 16;
+	for (size_t i = 0; i < uSize; ++i)
+	{
+		a = (a + pData[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	return (b << 16) | a;
+}
+
+static void appendBE32(vector<uint8_t> &vData, const uint32_t u)
+{
+	const uint8_t vBytes[] = { static_cast<uint8_t>(u >> 24), static_cast<uint8_t>(u >> 16),
+		static_cast<uint8_t>(u >> 8), static_cast<uint8_t>(u) };
+	vData.insert(vData.end(), vBytes, vBytes + 4);
+}
+
+static void writeChunk(FILE *pFile, const char *pszType, const vector<uint8_t> &vData)
+{
+	vector<uint8_t> vChunk;
+	appendBE32(vChunk, static_cast<uint32_t>(vData.size()));
+	vChunk.insert(vChunk.end(), pszType, pszType + 4);
+	vChunk.insert(vChunk.end(), vData.cbegin(), vData.cend());
+	appendBE32(vChunk, crc32(0, &vChunk[4], vChunk.size() - 4));
+	fwrite(vChunk.data(), 1, vChunk.size(), pFile);
+}
+
+bool SVX::WritePPM(const char *pszFilename, const uint8_t *pRGB, const uint32_t uWidth, const uint32_t uHeight)
+{
+	const auto pFile = OpenFile(pszFilename, "wb");
+	if (!pFile) return false;
+
+	fprintf(pFile, "P6\n%u %u\n255\n", uWidth, uHeight);
+	fwrite(pRGB, 3, static_cast<size_t>(uWidth) * uHeight, pFile);
+	fclose(pFile);
+
+	return true;
+}
+
+bool SVX::WritePNG(const char *pszFilename, const uint8_t *pRGB, const uint32_t uWidth, const uint32_t uHeight)
+{
+	const auto pFile = OpenFile(pszFilename, "wb");
+	if (!pFile) return false;
+
+	static const uint8_t vSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	fwrite(vSignature, 1, sizeof(vSignature), pFile);
+
+	// IHDR: 8-bit RGB, no interlacing
+	vector<uint8_t> vData;
+	appendBE32(vData, uWidth);
+	appendBE32(vData, uHeight);
+	const uint8_t vFormat[] = { 8, 2, 0, 0, 0 };
+	vData.insert(vData.end(), vFormat, vFormat + sizeof(vFormat));
+	writeChunk(pFile, "IHDR", vData);
+
+	// Scanlines with filter type 0
+	const auto uPitch = static_cast<size_t>(uWidth) * 3;
+	vector<uint8_t> vRaw;
+	vRaw.reserve((uPitch + 1) * uHeight);
+	for (auto y = 0u; y < uHeight; ++y)
+	{
+		vRaw.push_back(0);
+		vRaw.insert(vRaw.end(), pRGB + uPitch * y, pRGB + uPitch * (y + 1));
+	}
+
+	// IDAT: zlib stream of stored deflate blocks
+	const size_t uMaxBlock = 65535;
+	vData.clear();
+	vData.reserve(vRaw.size() + (vRaw.size() / uMaxBlock + 1) * 5 + 6);
+	vData.push_back(0x78);
+	vData.push_back(0x01);
+	for (size_t i = 0; i < vRaw.size() || i == 0; i += uMaxBlock)
+	{
+		const auto uSize = static_cast<uint16_t>((std::min)(vRaw.size() - i, uMaxBlock));
+		const auto bFinal = i + uSize >= vRaw.size();
+		const uint8_t vHeader[] = { static_cast<uint8_t>(bFinal ? 1 : 0),
+			static_cast<uint8_t>(uSize), static_cast<uint8_t>(uSize >> 8),
+			static_cast<uint8_t>(~uSize), static_cast<uint8_t>(~uSize >> 8) };
+		vData.insert(vData.end(), vHeader, vHeader + sizeof(vHeader));
+		vData.insert(vData.end(), vRaw.cbegin() + i, vRaw.cbegin() + i + uSize);
+		if (bFinal) break;
+	}
+	appendBE32(vData, adler32(1, vRaw.data(), vRaw.size()));
+	writeChunk(pFile, "IDAT", vData);
+
+	writeChunk(pFile, "IEND", vector<uint8_t>());
+	fclose(pFile);
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// YUV4MPEG2
+//--------------------------------------------------------------------------------------
+Y4MWriter::Y4MWriter() :
+	m_pFile(nullptr),
+	m_uWidth(0),
+	m_uHeight(0),
+	m_vPlanes(0)
+{
+}
+
+Y4MWriter::~Y4MWriter()
+{
+	Close();
+}
+
+bool Y4MWriter::Open(const char *pszFilename, const uint32_t uWidth, const uint32_t uHeight, const uint32_t uFPS)
+{
+	Close();
+	m_pFile = strcmp(pszFilename, "-") ? OpenFile(pszFilename, "wb") : stdout;
+	if (!m_pFile) return false;
+
+	m_uWidth = uWidth;
+	m_uHeight = uHeight;
+	const auto uChromaSize = static_cast<size_t>((uWidth + 1) / 2) * ((uHeight + 1) / 2);
+	m_vPlanes.resize(static_cast<size_t>(uWidth) * uHeight + uChromaSize * 2);
+	fprintf(m_pFile, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", uWidth, uHeight, uFPS);
+
+	return true;
+}
+
+bool Y4MWriter::Write(const uint8_t *pRGB)
+{
+	if (!m_pFile) return false;
+
+	const auto uChromaWidth = (m_uWidth + 1) / 2;
+	const auto uChromaHeight = (m_uHeight + 1) / 2;
+	auto pY = m_vPlanes.data();
+	auto pU = pY + static_cast<size_t>(m_uWidth) * m_uHeight;
+	auto pV = pU + static_cast<size_t>(uChromaWidth) * uChromaHeight;
+
+	const auto toByte = [](const float f)
+	{
+		return static_cast<uint8_t>((std::min)((std::max)(f + 0.5f, 0.0f), 255.0f));
+	};
+
+	// Luma per pixel, chroma averaged over 2x2 quads
+	for (auto y = 0u; y < m_uHeight; ++y)
+		for (auto x = 0u; x < m_uWidth; ++x)
+		{
+			const auto pPixel = &pRGB[(static_cast<size_t>(y) * m_uWidth + x) * 3];
+			pY[static_cast<size_t>(y) * m_uWidth + x] = toByte(0.299f * pPixel[0] + 0.587f * pPixel[1] + 0.114f * pPixel[2]);
+		}
+
+	for (auto y = 0u; y < uChromaHeight; ++y)
+		for (auto x = 0u; x < uChromaWidth; ++x)
+		{
+			float vSum[3] = {};
+			auto uCount = 0u;
+			for (auto j = y * 2; j < (std::min)(y * 2 + 2, m_uHeight); ++j)
+				for (auto i = x * 2; i < (std::min)(x * 2 + 2, m_uWidth); ++i, ++uCount)
+					for (auto k = 0u; k < 3; ++k) vSum[k] += pRGB[(static_cast<size_t>(j) * m_uWidth + i) * 3 + k];
+
+			const auto r = vSum[0] / uCount, g = vSum[1] / uCount, b = vSum[2] / uCount;
+			pU[static_cast<size_t>(y) * uChromaWidth + x] = toByte(-0.168736f * r - 0.331264f * g + 0.5f * b + 128.0f);
+			pV[static_cast<size_t>(y) * uChromaWidth + x] = toByte(0.5f * r - 0.418688f * g - 0.081312f * b + 128.0f);
+		}
+
+	fputs("FRAME\n", m_pFile);
+
+	return fwrite(m_vPlanes.data(), 1, m_vPlanes.size(), m_pFile) == m_vPlanes.size();
+}
+
+void Y4MWriter::Close()
+{
+	if (m_pFile)
+	{
+		if (m_pFile == stdout) fflush(m_pFile);
+		else fclose(m_pFile);
+		m_pFile = nullptr;
+	}
+}
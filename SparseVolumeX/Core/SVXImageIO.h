@@ -0,0 +1,38 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include "SVXFile.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Dependency-free writers for 8-bit RGB frames. PNG is written with stored (uncompressed)
+	// deflate blocks, which every decoder accepts and which costs no encoding time.
+	//--------------------------------------------------------------------------------------
+	bool WritePPM(const char *pszFilename, const uint8_t *pRGB, const uint32_t uWidth, const uint32_t uHeight);
+	bool WritePNG(const char *pszFilename, const uint8_t *pRGB, const uint32_t uWidth, const uint32_t uHeight);
+
+	// Raw YUV4MPEG2 stream (4:2:0, full-range BT.601), "-" for stdout
+	class Y4MWriter
+	{
+	public:
+		Y4MWriter();
+		virtual ~Y4MWriter();
+
+		bool Open(const char *pszFilename, const uint32_t uWidth, const uint32_t uHeight, const uint32_t uFPS);
+		bool Write(const uint8_t *pRGB);
+		void Close();
+
+	protected:
+		FILE					*m_pFile;
+		uint32_t				m_uWidth;
+		uint32_t				m_uHeight;
+		std::vector<uint8_t>	m_vPlanes;
+	};
+}
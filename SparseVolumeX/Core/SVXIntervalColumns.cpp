@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include "SVXIntervalColumns.h"
+
+using namespace std;
+using namespace SVX;
+
+IntervalColumns::IntervalColumns() :
+	m_uWidth(0),
+	m_uHeight(0),
+	m_fDepthScale(1.0f),
+	m_vOffsets(1, 0),
+	m_vCrossings(0)
+{
+}
+
+IntervalColumns::~IntervalColumns()
+{
+}
+
+void IntervalColumns::Create(const KBuffer &kBuffer, const float fDepthScale, Scheduler &scheduler)
+{
+	m_uWidth = kBuffer.GetWidth();
+	m_uHeight = kBuffer.GetHeight();
+	m_fDepthScale = fDepthScale;
+	const auto uNumIntervals = kBuffer.GetNumLayers() >> 1;
+	const auto uNumTexels = static_cast<size_t>(m_uWidth) * m_uHeight;
+
+	// Crossings of the complete intervals, which lead the layers of a texel
+	const auto countCrossings = [&kBuffer, uNumIntervals](const uint32_t x, const uint32_t y)
+	{
+		const auto pLayers = kBuffer.GetLayers(x, y);
+		auto i = 0u;
+		while (i < uNumIntervals && pLayers[i * 2] < 1.0f && pLayers[i * 2 + 1] < 1.0f) ++i;
+
+		return i * 2;
+	};
+
+	m_vOffsets.resize(uNumTexels + 1);
+	m_vOffsets[0] = 0;
+	scheduler.ParallelFor(0, m_uHeight, 1, [&](const uint32_t uRowBegin, const uint32_t uRowEnd, uint32_t)
+	{
+		for (auto y = uRowBegin; y < uRowEnd; ++y)
+			for (auto x = 0u; x < m_uWidth; ++x)
+				m_vOffsets[static_cast<size_t>(y) * m_uWidth + x + 1] = countCrossings(x, y);
+	});
+	for (auto i = 0u; i < uNumTexels; ++i) m_vOffsets[i + 1] += m_vOffsets[i];
+
+	// Prefix-summed thicknesses, as CSThicknessPrefix
+	m_vCrossings.resize(m_vOffsets[uNumTexels]);
+	m_vCrossings.shrink_to_fit();
+	scheduler.ParallelFor(0, m_uHeight, 1, [&](const uint32_t uRowBegin, const uint32_t uRowEnd, uint32_t)
+	{
+		for (auto y = uRowBegin; y < uRowEnd; ++y)
+		{
+			for (auto x = 0u; x < m_uWidth; ++x)
+			{
+				const auto uTexel = static_cast<size_t>(y) * m_uWidth + x;
+				const auto pLayers = kBuffer.GetLayers(x, y);
+				auto pCrossing = &m_vCrossings[m_vOffsets[uTexel]];
+				auto fThickness = 0.0f;
+				for (auto i = 0u; i < m_vOffsets[uTexel + 1] - m_vOffsets[uTexel]; i += 2)
+				{
+					*pCrossing++ = { pLayers[i], fThickness };
+					fThickness += (pLayers[i + 1] - pLayers[i]) * fDepthScale;
+					*pCrossing++ = { pLayers[i + 1], fThickness };
+				}
+			}
+		}
+	});
+}
+
+const IntervalColumns::Crossing *IntervalColumns::GetCrossings(const uint32_t x, const uint32_t y) const
+{
+	return m_vCrossings.data() + m_vOffsets[static_cast<size_t>(y) * m_uWidth + x];
+}
+
+uint32_t IntervalColumns::GetNumCrossings(const uint32_t x, const uint32_t y) const
+{
+	const auto uTexel = static_cast<size_t>(y) * m_uWidth + x;
+
+	return m_vOffsets[uTexel + 1] - m_vOffsets[uTexel];
+}
+
+uint32_t IntervalColumns::GetWidth() const
+{
+	return m_uWidth;
+}
+
+uint32_t IntervalColumns::GetHeight() const
+{
+	return m_uHeight;
+}
+
+size_t IntervalColumns::GetNumCrossings() const
+{
+	return m_vCrossings.size();
+}
+
+size_t IntervalColumns::GetBytes() const
+{
+	return sizeof(uint32_t) * m_vOffsets.size() + sizeof(Crossing) * m_vCrossings.size();
+}
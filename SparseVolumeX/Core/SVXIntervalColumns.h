@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SVXKBuffer.h"
+#include "SVXScheduler.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Run-length columns of a light-space k-buffer: the surface crossings of each texel with
+	// the thickness accumulated along the light ray up to them, in one pooled array with an
+	// offset per texel. Only the complete intervals are kept, so the memory follows the
+	// crossings rather than the K layers of every texel, and the thickness in front of any
+	// depth is a binary search away.
+	//--------------------------------------------------------------------------------------
+	class IntervalColumns
+	{
+	public:
+		struct Crossing
+		{
+			float	fDepth;
+			float	fThickness;		// Along the column up to the crossing
+		};
+
+		IntervalColumns();
+		virtual ~IntervalColumns();
+
+		// Depths scaled by fDepthScale into thicknesses; the rows are counted and then filled
+		// on the threads of the scheduler
+		void Create(const KBuffer &kBuffer, const float fDepthScale, Scheduler &scheduler);
+
+		// Thickness of the column (x, y) in front of fDepth, as CSRender from the prefix sums
+		float GetThickness(const uint32_t x, const uint32_t y, const float fDepth) const
+		{
+			const auto uTexel = static_cast<size_t>(y) * m_uWidth + x;
+			const auto pCrossings = m_vCrossings.data() + m_vOffsets[uTexel];
+
+			// Binary search for the number of crossings in front of the point
+			auto uFirst = 0u;
+			auto uCount = m_vOffsets[uTexel + 1] - m_vOffsets[uTexel];
+			while (uCount > 0)
+			{
+				const auto uStep = uCount >> 1;
+				const auto i = uFirst + uStep;
+				if (pCrossings[i].fDepth <= fDepth)
+				{
+					uFirst = i + 1;
+					uCount -= uStep + 1;
+				}
+				else uCount = uStep;
+			}
+
+			if (uFirst == 0) return 0.0f;
+
+			// Behind an exit the thickness is that of the exit; inside an interval the part
+			// clipped to the point is added to the entry
+			const auto &crossing = pCrossings[uFirst - 1];
+			if ((uFirst & 1) == 0) return crossing.fThickness;
+
+			return crossing.fThickness + (fDepth - crossing.fDepth) * m_fDepthScale;
+		}
+
+		const Crossing *GetCrossings(const uint32_t x, const uint32_t y) const;
+		uint32_t GetNumCrossings(const uint32_t x, const uint32_t y) const;
+
+		uint32_t GetWidth() const;
+		uint32_t GetHeight() const;
+		size_t GetNumCrossings() const;
+		size_t GetBytes() const;
+
+	protected:
+		uint32_t				m_uWidth;
+		uint32_t				m_uHeight;
+		float					m_fDepthScale;
+		std::vector<uint32_t>	m_vOffsets;		// First crossing per texel, then the end
+		std::vector<Crossing>	m_vCrossings;	// Entry/exit pairs per texel, ascending
+	};
+
+	using upIntervalColumns = std::unique_ptr<IntervalColumns>;
+	using spIntervalColumns = std::shared_ptr<IntervalColumns>;
+}
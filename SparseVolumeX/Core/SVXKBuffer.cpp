@@ -0,0 +1,126 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "SVXKBuffer.h"
+
+using namespace std;
+using namespace SVX;
+
+KBuffer::KBuffer() :
+	m_uWidth(0),
+	m_uHeight(0),
+	m_uRowBegin(0),
+	m_uRowEnd(0),
+	m_uNumLayers(0),
+	m_vDepths(0),
+	m_pDepths(nullptr)
+{
+}
+
+KBuffer::KBuffer(const KBuffer &kBuffer) :
+	KBuffer()
+{
+	*this = kBuffer;
+}
+
+KBuffer::~KBuffer()
+{
+}
+
+KBuffer &KBuffer::operator=(const KBuffer &kBuffer)
+{
+	m_uWidth = kBuffer.m_uWidth;
+	m_uHeight = kBuffer.m_uHeight;
+	m_uRowBegin = kBuffer.m_uRowBegin;
+	m_uRowEnd = kBuffer.m_uRowEnd;
+	m_uNumLayers = kBuffer.m_uNumLayers;
+	m_vDepths = kBuffer.m_vDepths;
+
+	// A copied band refers to the same storage
+	m_pDepths = kBuffer.m_pDepths == kBuffer.m_vDepths.data() ? m_vDepths.data() : kBuffer.m_pDepths;
+
+	return *this;
+}
+
+void KBuffer::Create(const uint32_t uWidth, const uint32_t uHeight, const uint32_t uNumLayers)
+{
+	// Reuse the storage when the size is unchanged; allocated first, so that a failure
+	// leaves the k-buffer as it was
+	m_vDepths.resize(static_cast<size_t>(uWidth) * uHeight * uNumLayers);
+	m_vDepths.shrink_to_fit();
+	m_pDepths = m_vDepths.data();
+
+	m_uWidth = uWidth;
+	m_uHeight = uHeight;
+	m_uRowBegin = 0;
+	m_uRowEnd = uHeight;
+	m_uNumLayers = uNumLayers;
+	Clear();
+}
+
+void KBuffer::CreateBand(float *pDepths, const uint32_t uWidth, const uint32_t uHeight,
+	const uint32_t uRowBegin, const uint32_t uRowEnd, const uint32_t uNumLayers)
+{
+	m_uWidth = uWidth;
+	m_uHeight = uHeight;
+	m_uRowBegin = uRowBegin;
+	m_uRowEnd = (std::min)(uRowEnd, uHeight);
+	m_uNumLayers = uNumLayers;
+
+	m_vDepths.clear();
+	m_vDepths.shrink_to_fit();
+	m_pDepths = pDepths;
+}
+
+void KBuffer::Clear()
+{
+	Clear(m_uRowBegin, m_uRowEnd);
+}
+
+void KBuffer::Clear(const uint32_t uRowBegin, const uint32_t uRowEnd)
+{
+	const auto uBegin = (std::max)(uRowBegin, m_uRowBegin);
+	const auto uEnd = (std::min)(uRowEnd, m_uRowEnd);
+	if (uBegin >= uEnd) return;
+
+	const auto uRowSize = static_cast<size_t>(m_uWidth) * m_uNumLayers;
+	fill(m_pDepths + (uBegin - m_uRowBegin) * uRowSize, m_pDepths + (uEnd - m_uRowBegin) * uRowSize, 1.0f);
+}
+
+uint32_t KBuffer::GetWidth() const
+{
+	return m_uWidth;
+}
+
+uint32_t KBuffer::GetHeight() const
+{
+	return m_uHeight;
+}
+
+uint32_t KBuffer::GetRowBegin() const
+{
+	return m_uRowBegin;
+}
+
+uint32_t KBuffer::GetRowEnd() const
+{
+	return m_uRowEnd;
+}
+
+uint32_t KBuffer::GetNumLayers() const
+{
+	return m_uNumLayers;
+}
+
+size_t KBuffer::GetBytes() const
+{
+	return sizeof(float) * m_vDepths.size();
+}
+
+size_t KBuffer::GetBytes(const uint32_t uWidth, const uint32_t uRowBegin, const uint32_t uRowEnd,
+	const uint32_t uNumLayers)
+{
+	return sizeof(float) * uWidth * (uRowEnd - uRowBegin) * uNumLayers;
+}
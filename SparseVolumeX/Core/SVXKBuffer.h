@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "SVXMath.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// CPU k-buffer: the K nearest depths of each pixel in ascending order, 1.0 when empty.
+	// The layers of a pixel are contiguous, so walking its intervals touches one cache line.
+	// A band holds only some rows of the image, in memory owned elsewhere.
+	//--------------------------------------------------------------------------------------
+	class KBuffer
+	{
+	public:
+		KBuffer();
+		KBuffer(const KBuffer &kBuffer);
+		virtual ~KBuffer();
+
+		KBuffer &operator=(const KBuffer &kBuffer);
+
+		void Create(const uint32_t uWidth, const uint32_t uHeight, const uint32_t uNumLayers);
+
+		// Rows [uRowBegin, uRowEnd) of a uWidth x uHeight k-buffer, stored in pDepths
+		void CreateBand(float *pDepths, const uint32_t uWidth, const uint32_t uHeight,
+			const uint32_t uRowBegin, const uint32_t uRowEnd, const uint32_t uNumLayers);
+
+		void Clear();
+		void Clear(const uint32_t uRowBegin, const uint32_t uRowEnd);
+
+		// Same insertion as the InterlockedMin chain of PSDepthPeel
+		void Insert(const uint32_t x, const uint32_t y, float fDepth)
+		{
+			auto pLayers = &m_pDepths[(static_cast<size_t>(y - m_uRowBegin) * m_uWidth + x) * m_uNumLayers];
+			for (auto i = 0u; i < m_uNumLayers; ++i)
+			{
+				const auto fPrev = pLayers[i];
+				if (fDepth < fPrev)
+				{
+					pLayers[i] = fDepth;
+					fDepth = fPrev;
+				}
+			}
+		}
+
+		const float *GetLayers(const uint32_t x, const uint32_t y) const
+		{
+			return &m_pDepths[(static_cast<size_t>(y - m_uRowBegin) * m_uWidth + x) * m_uNumLayers];
+		}
+
+		float *GetLayers(const uint32_t x, const uint32_t y)
+		{
+			return &m_pDepths[(static_cast<size_t>(y - m_uRowBegin) * m_uWidth + x) * m_uNumLayers];
+		}
+
+		uint32_t GetWidth() const;
+		uint32_t GetHeight() const;
+		uint32_t GetRowBegin() const;
+		uint32_t GetRowEnd() const;
+		uint32_t GetNumLayers() const;
+		size_t GetBytes() const;		// Owned storage only
+
+		// Bytes of the rows [uRowBegin, uRowEnd)
+		static size_t GetBytes(const uint32_t uWidth, const uint32_t uRowBegin, const uint32_t uRowEnd,
+			const uint32_t uNumLayers);
+
+	protected:
+		uint32_t			m_uWidth;
+		uint32_t			m_uHeight;
+		uint32_t			m_uRowBegin;
+		uint32_t			m_uRowEnd;
+		uint32_t			m_uNumLayers;
+		std::vector<float>	m_vDepths;
+		float				*m_pDepths;		// m_vDepths, or the storage of a band
+	};
+
+	using upKBuffer = std::unique_ptr<KBuffer>;
+	using spKBuffer = std::shared_ptr<KBuffer>;
+}
@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Least-recently-used cache of shared assets. Find() promotes the entry, Insert()
+	// evicts from the cold end once the capacity is reached. Values are typically
+	// shared pointers, so an evicted asset stays alive while a job still holds it.
+	//--------------------------------------------------------------------------------------
+	template<typename Key, typename Value>
+	class LRUCache
+	{
+	public:
+		LRUCache(const size_t uCapacity = 8) : m_uCapacity(uCapacity), m_uHits(0), m_uMisses(0) {}
+
+		void SetCapacity(const size_t uCapacity)
+		{
+			m_uCapacity = uCapacity;
+			while (m_lEntries.size() > m_uCapacity) evict();
+		}
+
+		Value *Find(const Key &key)
+		{
+			const auto iter = m_mEntries.find(key);
+			if (iter == m_mEntries.end())
+			{
+				++m_uMisses;
+				return nullptr;
+			}
+
+			++m_uHits;
+			m_lEntries.splice(m_lEntries.begin(), m_lEntries, iter->second);
+
+			return &iter->second->second;
+		}
+
+		Value &Insert(const Key &key, const Value &value)
+		{
+			const auto iter = m_mEntries.find(key);
+			if (iter != m_mEntries.end())
+			{
+				iter->second->second = value;
+				m_lEntries.splice(m_lEntries.begin(), m_lEntries, iter->second);
+
+				return iter->second->second;
+			}
+
+			while (m_uCapacity > 0 && m_lEntries.size() >= m_uCapacity) evict();
+			m_lEntries.emplace_front(key, value);
+			m_mEntries[key] = m_lEntries.begin();
+
+			return m_lEntries.front().second;
+		}
+
+		// Visits the entries from the most recent, without promoting them
+		template<typename Fn>
+		void ForEach(const Fn &fn) const
+		{
+			for (const auto &entry : m_lEntries) fn(entry.first, entry.second);
+		}
+
+		// Removes the entries for which fn(key, value) holds, without counting misses
+		template<typename Fn>
+		void EraseIf(const Fn &fn)
+		{
+			for (auto iter = m_lEntries.begin(); iter != m_lEntries.end();)
+			{
+				if (fn(iter->first, iter->second))
+				{
+					m_mEntries.erase(iter->first);
+					iter = m_lEntries.erase(iter);
+				}
+				else ++iter;
+			}
+		}
+
+		void Clear()
+		{
+			m_lEntries.clear();
+			m_mEntries.clear();
+		}
+
+		size_t GetSize() const { return m_lEntries.size(); }
+		size_t GetCapacity() const { return m_uCapacity; }
+		size_t GetHits() const { return m_uHits; }
+		size_t GetMisses() const { return m_uMisses; }
+
+	protected:
+		using Entry = std::pair<Key, Value>;
+
+		void evict()
+		{
+			m_mEntries.erase(m_lEntries.back().first);
+			m_lEntries.pop_back();
+		}
+
+		size_t				m_uCapacity;
+		size_t				m_uHits;
+		size_t				m_uMisses;
+		std::list<Entry>	m_lEntries;		// Most recent first
+		std::unordered_map<Key, typename std::list<Entry>::iterator> m_mEntries;
+	};
+}
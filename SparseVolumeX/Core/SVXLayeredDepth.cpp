@@ -0,0 +1,303 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <cstring>
+#include <limits>
+#include "SVXFile.h"
+#include "SVXLayeredDepth.h"
+
+using namespace std;
+using namespace SVX;
+
+static const char g_szMagic[] = "SVXLDI01";
+
+// Columns per side of the tiles whose depth ranges let rays skip empty space
+static const uint32_t g_uTileSize = 8;
+
+//--------------------------------------------------------------------------------------
+// 2D DDA over the cells of iCellSize texels crossed by (u, v) = origin + t * dir for t in
+// [t0, t1], within the cells [iMinU, iMaxU] x [iMinV, iMaxV]. The crossings come from
+// the cell indices, so the tile and column walks of a ray agree on every shared edge.
+// visit(i, j, tBegin, tEnd) returns false to stop.
+//--------------------------------------------------------------------------------------
+template<typename Visit>
+static void walkCells(const float fUOrigin, const float fUDir, const float fVOrigin, const float fVDir,
+	const int32_t iCellSize, const int32_t iMinU, const int32_t iMaxU, const int32_t iMinV, const int32_t iMaxV,
+	const float t0, const float t1, const Visit &visit)
+{
+	const auto fCellSize = static_cast<float>(iCellSize);
+	const auto cell = [fCellSize](const float f, const int32_t iMin, const int32_t iMax)
+	{
+		return (std::min)((std::max)(static_cast<int32_t>(floor(f / fCellSize)), iMin), iMax);
+	};
+	const auto fUDirInv = 1.0f / fUDir, fVDirInv = 1.0f / fVDir;
+	const auto nextCrossing = [iCellSize](const int32_t i, const float fOrigin, const float fDir, const float fDirInv)
+	{
+		if (fDir == 0.0f) return numeric_limits<float>::infinity();
+
+		return (static_cast<float>((fDir > 0.0f ? i + 1 : i) * iCellSize) - fOrigin) * fDirInv;
+	};
+
+	const auto iStepU = fUDir > 0.0f ? 1 : -1, iStepV = fVDir > 0.0f ? 1 : -1;
+	auto i = cell(fUOrigin + fUDir * t0, iMinU, iMaxU), j = cell(fVOrigin + fVDir * t0, iMinV, iMaxV);
+	auto tNextU = nextCrossing(i, fUOrigin, fUDir, fUDirInv), tNextV = nextCrossing(j, fVOrigin, fVDir, fVDirInv);
+	for (auto t = t0; ; )
+	{
+		const auto tEnd = (std::max)((std::min)((std::min)(tNextU, tNextV), t1), t);
+		if (!visit(i, j, t, tEnd) || tEnd >= t1) return;
+
+		if (tNextU <= tNextV)
+		{
+			i += iStepU;
+			if (i < iMinU || i > iMaxU) return;
+			tNextU = nextCrossing(i, fUOrigin, fUDir, fUDirInv);
+		}
+		else
+		{
+			j += iStepV;
+			if (j < iMinV || j > iMaxV) return;
+			tNextV = nextCrossing(j, fVOrigin, fVDir, fVDirInv);
+		}
+		t = tEnd;
+	}
+}
+
+LayeredDepth::LayeredDepth() :
+	m_kBuffers()
+{
+}
+
+LayeredDepth::~LayeredDepth()
+{
+}
+
+void LayeredDepth::Create(const Mesh &mesh, const uint32_t uResolution, const uint32_t uNumLayers,
+	Scheduler &scheduler)
+{
+	setBound(mesh);
+	for (auto i = 0u; i < 3; ++i)
+	{
+		m_kBuffers[i].Create(uResolution, uResolution, uNumLayers);
+		peel(mesh, i, m_kBuffers[i], scheduler);
+	}
+
+	computeTiles();
+}
+
+bool LayeredDepth::Save(const char *pszFilename, const uint64_t uSourceStamp) const
+{
+	const auto pFile = OpenFile(pszFilename, "wb");
+	if (!pFile) return false;
+
+	const uint32_t vSizes[] = { GetResolution(), GetNumLayers() };
+	const float vBound[] = { m_vCenter.x, m_vCenter.y, m_vCenter.z, m_fHalfSize };
+	const auto uNumDepths = static_cast<size_t>(vSizes[0]) * vSizes[0] * vSizes[1];
+	auto bSuccess = fwrite(g_szMagic, 1, 8, pFile) == 8;
+	bSuccess = bSuccess && fwrite(&uSourceStamp, sizeof(uint64_t), 1, pFile) == 1;
+	bSuccess = bSuccess && fwrite(vSizes, sizeof(uint32_t), 2, pFile) == 2;
+	bSuccess = bSuccess && fwrite(vBound, sizeof(float), 4, pFile) == 4;
+	for (const auto &kBuffer : m_kBuffers)
+		bSuccess = bSuccess && fwrite(kBuffer.GetLayers(0, 0), sizeof(float), uNumDepths, pFile) == uNumDepths;
+	fclose(pFile);
+
+	return bSuccess;
+}
+
+bool LayeredDepth::Load(const char *pszFilename, const uint64_t uSourceStamp, const uint32_t uResolution,
+	const uint32_t uNumLayers)
+{
+	const auto pFile = OpenFile(pszFilename, "rb");
+	if (!pFile) return false;
+
+	char szMagic[8];
+	uint64_t uStamp;
+	uint32_t vSizes[2];
+	float vBound[4];
+	auto bSuccess = fread(szMagic, 1, 8, pFile) == 8 && !memcmp(szMagic, g_szMagic, 8);
+	bSuccess = bSuccess && fread(&uStamp, sizeof(uint64_t), 1, pFile) == 1 && uStamp == uSourceStamp;
+	bSuccess = bSuccess && fread(vSizes, sizeof(uint32_t), 2, pFile) == 2 &&
+		vSizes[0] == uResolution && vSizes[1] == uNumLayers;
+	bSuccess = bSuccess && fread(vBound, sizeof(float), 4, pFile) == 4;
+	if (bSuccess)
+	{
+		m_vCenter = float3(vBound[0], vBound[1], vBound[2]);
+		m_fHalfSize = vBound[3];
+		const auto uNumDepths = static_cast<size_t>(uResolution) * uResolution * uNumLayers;
+		for (auto &kBuffer : m_kBuffers)
+		{
+			kBuffer.Create(uResolution, uResolution, uNumLayers);
+			bSuccess = bSuccess && fread(kBuffer.GetLayers(0, 0), sizeof(float), uNumDepths, pFile) == uNumDepths;
+		}
+	}
+	fclose(pFile);
+
+	if (bSuccess) computeTiles();
+
+	return bSuccess;
+}
+
+uint32_t LayeredDepth::CastRay(const float3 &vOrigin, const float3 &vDir, const float fTMin, const float fTMax,
+	float *pT, const uint32_t uMaxValues) const
+{
+	// Image of the axis closest to the ray, in texel coordinates and depth affine in t
+	const float vAbs[] = { fabs(vDir.x), fabs(vDir.y), fabs(vDir.z) };
+	const auto uAxis = vAbs[0] >= vAbs[1] && vAbs[0] >= vAbs[2] ? 0u : vAbs[1] >= vAbs[2] ? 1u : 2u;
+	const auto &kBuffer = m_kBuffers[uAxis];
+	const auto mViewProj = getViewProj(uAxis);
+	const auto vOriginH = mul(float4(vOrigin, 1.0f), mViewProj);
+	const auto vDirH = mul(float4(vDir, 0.0f), mViewProj);
+
+	const auto fSize = static_cast<float>(kBuffer.GetWidth());
+	const auto fUOrigin = (vOriginH.x * 0.5f + 0.5f) * fSize, fUDir = vDirH.x * 0.5f * fSize;
+	const auto fVOrigin = (0.5f - vOriginH.y * 0.5f) * fSize, fVDir = -vDirH.y * 0.5f * fSize;
+	const auto fZOrigin = vOriginH.z, fZDir = vDirH.z;
+	if (fZDir == 0.0f) return 0;
+	const auto fZDirInv = 1.0f / fZDir;
+
+	// Clip to the image and its depth range
+	auto t0 = fTMin, t1 = fTMax;
+	const auto clipSlab = [&t0, &t1](const float fOrigin, const float fDir, const float fMin, const float fMax)
+	{
+		if (fDir == 0.0f)
+		{
+			if (fOrigin < fMin || fOrigin > fMax) t1 = -numeric_limits<float>::infinity();
+			return;
+		}
+
+		auto ta = (fMin - fOrigin) / fDir, tb = (fMax - fOrigin) / fDir;
+		if (ta > tb) swap(ta, tb);
+		t0 = (std::max)(t0, ta);
+		t1 = (std::min)(t1, tb);
+	};
+	clipSlab(fUOrigin, fUDir, 0.0f, fSize);
+	clipSlab(fVOrigin, fVDir, 0.0f, fSize);
+	clipSlab(fZOrigin, fZDir, 0.0f, 1.0f);
+	if (t0 >= t1) return 0;
+
+	// Appends an inside segment, merged with the last one where it continues in the next
+	// column across a gap under a texel, the staircase of a surface oblique to the axis.
+	// A finished interval under a texel is dropped: near a silhouette the ray grazes the
+	// corners of the columns the surface sticks out of by up to a texel. False once full.
+	const auto fGap = 2.0f * m_fHalfSize / (fSize * length(vDir));
+	auto uCount = 0u;
+	const auto isSliver = [pT, fGap, &uCount]()
+	{ return uCount > 0 && pT[uCount - 1] - pT[uCount - 2] < fGap; };
+	const auto append = [pT, uMaxValues, fGap, &uCount, &isSliver](const float tA, const float tB)
+	{
+		if (tA >= tB) return true;
+		if (uCount > 0 && tA > pT[uCount - 1] + fGap && isSliver()) uCount -= 2;
+		if (uCount > 0 && tA <= pT[uCount - 1] + fGap)
+		{
+			pT[uCount - 1] = (std::max)(pT[uCount - 1], tB);
+			return true;
+		}
+		if (uCount + 2 > uMaxValues) return false;
+		pT[uCount++] = tA;
+		pT[uCount++] = tB;
+
+		return true;
+	};
+
+	// Columns of the tiles whose depth range the ray meets, clipping their intervals
+	const auto uNumIntervals = kBuffer.GetNumLayers() >> 1;
+	const auto &vTileRanges = m_vTileRanges[uAxis];
+	const auto iSize = static_cast<int32_t>(kBuffer.GetWidth());
+	const auto iTileSize = static_cast<int32_t>(g_uTileSize);
+	const auto iNumTiles = (iSize + iTileSize - 1) / iTileSize;
+	const auto visitColumn = [&](const int32_t i, const int32_t j, const float tBegin, const float tEnd)
+	{
+		const auto pLayers = kBuffer.GetLayers(i, j);
+		auto uNumValid = 0u;
+		while (uNumValid < uNumIntervals && pLayers[uNumValid * 2 + 1] < 1.0f) ++uNumValid;
+
+		// Intervals in the order the ray meets them
+		for (auto k = 0u; k < uNumValid; ++k)
+		{
+			const auto uInterval = fZDir > 0.0f ? k : uNumValid - 1 - k;
+			auto tA = (pLayers[uInterval * 2] - fZOrigin) * fZDirInv;
+			auto tB = (pLayers[uInterval * 2 + 1] - fZOrigin) * fZDirInv;
+			if (tA > tB) swap(tA, tB);
+			if (tA > tEnd) break;
+			if (!append((std::max)(tA, tBegin), (std::min)(tB, tEnd))) return false;
+		}
+
+		return true;
+	};
+
+	walkCells(fUOrigin, fUDir, fVOrigin, fVDir, iTileSize, 0, iNumTiles - 1, 0, iNumTiles - 1, t0, t1,
+		[&](const int32_t i, const int32_t j, const float tBegin, const float tEnd)
+	{
+		const auto &range = vTileRanges[j * iNumTiles + i];
+		const auto fZBegin = fZOrigin + fZDir * tBegin, fZEnd = fZOrigin + fZDir * tEnd;
+		if ((std::max)(fZBegin, fZEnd) < range.first || (std::min)(fZBegin, fZEnd) > range.second) return true;
+
+		auto bContinue = true;
+		const auto iMinU = i * iTileSize, iMinV = j * iTileSize;
+		walkCells(fUOrigin, fUDir, fVOrigin, fVDir, 1, iMinU, (std::min)(iMinU + iTileSize, iSize) - 1,
+			iMinV, (std::min)(iMinV + iTileSize, iSize) - 1, tBegin, tEnd,
+			[&](const int32_t x, const int32_t y, const float tColumnBegin, const float tColumnEnd)
+		{
+			bContinue = visitColumn(x, y, tColumnBegin, tColumnEnd);
+
+			return bContinue;
+		});
+
+		return bContinue;
+	});
+	if (isSliver()) uCount -= 2;
+
+	return uCount;
+}
+
+const KBuffer &LayeredDepth::GetImage(const uint32_t uAxis) const
+{
+	return m_kBuffers[uAxis];
+}
+
+uint32_t LayeredDepth::GetResolution() const
+{
+	return m_kBuffers[0].GetWidth();
+}
+
+uint32_t LayeredDepth::GetNumLayers() const
+{
+	return m_kBuffers[0].GetNumLayers();
+}
+
+size_t LayeredDepth::GetBytes() const
+{
+	size_t uBytes = 0;
+	for (auto i = 0u; i < 3; ++i)
+		uBytes += m_kBuffers[i].GetBytes() + sizeof(pair<float, float>) * m_vTileRanges[i].size();
+
+	return uBytes;
+}
+
+void LayeredDepth::computeTiles()
+{
+	// Nearest front and farthest back depth of the columns of each tile, an empty range
+	// where none holds an interval
+	const auto uSize = GetResolution();
+	const auto uNumIntervals = GetNumLayers() >> 1;
+	const auto uNumTiles = (uSize + g_uTileSize - 1) / g_uTileSize;
+	for (auto i = 0u; i < 3; ++i)
+	{
+		const auto &kBuffer = m_kBuffers[i];
+		auto &vTileRanges = m_vTileRanges[i];
+		vTileRanges.assign(static_cast<size_t>(uNumTiles) * uNumTiles, make_pair(1.0f, 0.0f));
+		for (auto y = 0u; y < uSize; ++y)
+		{
+			for (auto x = 0u; x < uSize; ++x)
+			{
+				const auto pLayers = kBuffer.GetLayers(x, y);
+				auto &range = vTileRanges[y / g_uTileSize * uNumTiles + x / g_uTileSize];
+				for (auto k = 0u; k < uNumIntervals && pLayers[k * 2 + 1] < 1.0f; ++k)
+				{
+					range.first = (std::min)(range.first, pLayers[k * 2]);
+					range.second = (std::max)(range.second, pLayers[k * 2 + 1]);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,54 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SVXSolid.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// View-independent layered depth images: orthographic k-buffers of a mesh along the X,
+	// Y and Z axes over its bounding cube, peeled once with the insertion of PSDepthPeel.
+	// A camera ray walks the columns of the image whose axis is closest to its direction
+	// and clips their intervals, so a view k-buffer is resampled without rasterizing the
+	// mesh, at a cost independent of its triangle count. Surfaces finer than a texel of
+	// the images are lost, like the slivers a ray grazing a silhouette cuts from column
+	// corners, and so are the intervals past the K nearest depths of a column.
+	//--------------------------------------------------------------------------------------
+	class LayeredDepth : public Solid
+	{
+	public:
+		LayeredDepth();
+		virtual ~LayeredDepth();
+
+		// Peels the three images in row bands over the threads of the scheduler
+		void Create(const Mesh &mesh, const uint32_t uResolution, const uint32_t uNumLayers,
+			Scheduler &scheduler);
+
+		// Binary cache tagged with the stamp of the mesh source file, as Mesh::Save(); Load()
+		// rejects a cache of another resolution or layer count
+		bool Save(const char *pszFilename, const uint64_t uSourceStamp) const;
+		bool Load(const char *pszFilename, const uint64_t uSourceStamp, const uint32_t uResolution,
+			const uint32_t uNumLayers);
+
+		uint32_t CastRay(const float3 &vOrigin, const float3 &vDir, const float fTMin, const float fTMax,
+			float *pT, const uint32_t uMaxValues) const override;
+
+		const KBuffer &GetImage(const uint32_t uAxis) const;
+		uint32_t GetResolution() const;
+		uint32_t GetNumLayers() const;
+		size_t GetBytes() const override;
+
+	protected:
+		void computeTiles();
+
+		KBuffer		m_kBuffers[3];	// Looking along +X, +Y and +Z
+
+		std::vector<std::pair<float, float>> m_vTileRanges[3];	// Depth ranges of the column tiles
+	};
+
+	using upLayeredDepth = std::unique_ptr<LayeredDepth>;
+	using spLayeredDepth = std::shared_ptr<LayeredDepth>;
+}
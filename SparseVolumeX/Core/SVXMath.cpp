@@ -0,0 +1,96 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include "SVXMath.h"
+
+using namespace SVX;
+
+float4x4 SVX::MatrixInverse(const float4x4 &m)
+{
+	const float *a = &m.r[0].x;
+	float inv[16];
+
+	// Cofactor expansion
+	inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] +
+		a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+	inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] -
+		a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+	inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] +
+		a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+	inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] -
+		a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+	inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] -
+		a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+	inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] +
+		a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+	inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] -
+		a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+	inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] +
+		a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+	inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] +
+		a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+	inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] -
+		a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+	inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] +
+		a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+	inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] -
+		a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+	inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] -
+		a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+	inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] +
+		a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+	inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] -
+		a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+	inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] +
+		a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+	const auto fDetInv = 1.0f / (a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12]);
+
+	float4x4 mInv;
+	for (auto i = 0u; i < 16; ++i) (&mInv.r[0].x)[i] = inv[i] * fDetInv;
+
+	return mInv;
+}
+
+float4x4 SVX::MatrixLookAtLH(const float3 &vEye, const float3 &vAt, const float3 &vUp)
+{
+	const auto vZ = normalize(vAt - vEye);
+	const auto vX = normalize(cross(vUp, vZ));
+	const auto vY = cross(vZ, vX);
+
+	return float4x4{ {
+		float4(vX.x, vY.x, vZ.x, 0.0f),
+		float4(vX.y, vY.y, vZ.y, 0.0f),
+		float4(vX.z, vY.z, vZ.z, 0.0f),
+		float4(-dot(vX, vEye), -dot(vY, vEye), -dot(vZ, vEye), 1.0f)
+	} };
+}
+
+float4x4 SVX::MatrixPerspectiveFovLH(const float fFovY, const float fAspect, const float fZNear, const float fZFar)
+{
+	const auto fHeight = 1.0f / std::tan(fFovY * 0.5f);
+	const auto fRange = fZFar / (fZFar - fZNear);
+
+	return float4x4{ {
+		float4(fHeight / fAspect, 0.0f, 0.0f, 0.0f),
+		float4(0.0f, fHeight, 0.0f, 0.0f),
+		float4(0.0f, 0.0f, fRange, 1.0f),
+		float4(0.0f, 0.0f, -fRange * fZNear, 0.0f)
+	} };
+}
+
+float4x4 SVX::MatrixOrthographicOffCenterLH(const float fLeft, const float fRight, const float fBottom,
+	const float fTop, const float fZNear, const float fZFar)
+{
+	const auto fWidthInv = 1.0f / (fRight - fLeft);
+	const auto fHeightInv = 1.0f / (fTop - fBottom);
+	const auto fRange = 1.0f / (fZFar - fZNear);
+
+	return float4x4{ {
+		float4(fWidthInv + fWidthInv, 0.0f, 0.0f, 0.0f),
+		float4(0.0f, fHeightInv + fHeightInv, 0.0f, 0.0f),
+		float4(0.0f, 0.0f, fRange, 0.0f),
+		float4(-(fLeft + fRight) * fWidthInv, -(fTop + fBottom) * fHeightInv, -fRange * fZNear, 1.0f)
+	} };
+}
@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Portable vector type for the CPU core
+	//--------------------------------------------------------------------------------------
+	struct float3
+	{
+		float x;
+		float y;
+		float z;
+
+		float3() = default;
+		constexpr float3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+		constexpr explicit float3(float f) : x(f), y(f), z(f) {}
+
+		float &operator[](const uint32_t i) { return (&x)[i]; }
+		const float &operator[](const uint32_t i) const { return (&x)[i]; }
+
+		float3 operator+(const float3 &v) const { return float3(x + v.x, y + v.y, z + v.z); }
+		float3 operator-(const float3 &v) const { return float3(x - v.x, y - v.y, z - v.z); }
+		float3 operator*(const float3 &v) const { return float3(x * v.x, y * v.y, z * v.z); }
+		float3 operator*(const float f) const { return float3(x * f, y * f, z * f); }
+		float3 operator/(const float f) const { return *this * (1.0f / f); }
+		float3 operator-() const { return float3(-x, -y, -z); }
+		float3 &operator+=(const float3 &v) { x += v.x; y += v.y; z += v.z; return *this; }
+		float3 &operator-=(const float3 &v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+		float3 &operator*=(const float f) { x *= f; y *= f; z *= f; return *this; }
+	};
+
+	inline float dot(const float3 &a, const float3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	inline float3 cross(const float3 &a, const float3 &b)
+	{
+		return float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+	inline float length(const float3 &v) { return std::sqrt(dot(v, v)); }
+	inline float3 normalize(const float3 &v) { return v / length(v); }
+	inline float3 lerp(const float3 &a, const float3 &b, const float t) { return a + (b - a) * t; }
+
+	// Parenthesized to survive the min/max macros of windows.h
+	inline float3 (min)(const float3 &a, const float3 &b)
+	{
+		return float3((std::min)(a.x, b.x), (std::min)(a.y, b.y), (std::min)(a.z, b.z));
+	}
+	inline float3 (max)(const float3 &a, const float3 &b)
+	{
+		return float3((std::max)(a.x, b.x), (std::max)(a.y, b.y), (std::max)(a.z, b.z));
+	}
+
+	struct float4
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+
+		float4() = default;
+		constexpr float4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+		constexpr float4(const float3 &v, float _w) : x(v.x), y(v.y), z(v.z), w(_w) {}
+
+		float &operator[](const uint32_t i) { return (&x)[i]; }
+		const float &operator[](const uint32_t i) const { return (&x)[i]; }
+
+		float4 operator+(const float4 &v) const { return float4(x + v.x, y + v.y, z + v.z, w + v.w); }
+		float4 operator-(const float4 &v) const { return float4(x - v.x, y - v.y, z - v.z, w - v.w); }
+		float4 operator*(const float f) const { return float4(x * f, y * f, z * f, w * f); }
+
+		float3 xyz() const { return float3(x, y, z); }
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Row-major matrix for row vectors, i.e. the DirectXMath and HLSL mul(v, M) convention
+	//--------------------------------------------------------------------------------------
+	struct float4x4
+	{
+		float4 r[4];
+
+		static float4x4 Identity()
+		{
+			return float4x4{ { float4(1.0f, 0.0f, 0.0f, 0.0f), float4(0.0f, 1.0f, 0.0f, 0.0f),
+				float4(0.0f, 0.0f, 1.0f, 0.0f), float4(0.0f, 0.0f, 0.0f, 1.0f) } };
+		}
+	};
+
+	inline float4 mul(const float4 &v, const float4x4 &m)
+	{
+		return m.r[0] * v.x + m.r[1] * v.y + m.r[2] * v.z + m.r[3] * v.w;
+	}
+
+	inline float4x4 mul(const float4x4 &a, const float4x4 &b)
+	{
+		return float4x4{ { mul(a.r[0], b), mul(a.r[1], b), mul(a.r[2], b), mul(a.r[3], b) } };
+	}
+
+	// Transforms a point and divides by w
+	inline float3 TransformCoord(const float3 &v, const float4x4 &m)
+	{
+		const auto vH = mul(float4(v, 1.0f), m);
+
+		return vH.xyz() / vH.w;
+	}
+
+	float4x4 MatrixInverse(const float4x4 &m);
+	float4x4 MatrixLookAtLH(const float3 &vEye, const float3 &vAt, const float3 &vUp);
+	float4x4 MatrixPerspectiveFovLH(const float fFovY, const float fAspect, const float fZNear, const float fZFar);
+	float4x4 MatrixOrthographicOffCenterLH(const float fLeft, const float fRight, const float fBottom,
+		const float fTop, const float fZNear, const float fZFar);
+}
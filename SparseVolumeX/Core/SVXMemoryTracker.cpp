@@ -0,0 +1,146 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "SVXMemoryTracker.h"
+
+using namespace std;
+using namespace SVX;
+
+static const char *g_pszCategoryNames[] = { "geometry", "k-buffer", "light", "constant", "lookup", "history", "import" };
+
+static double toMB(const size_t uBytes)
+{
+	return uBytes / (1024.0 * 1024.0);
+}
+
+MemoryTracker::MemoryTracker() :
+	m_vEntries(0),
+	m_uBytes(0),
+	m_uPeakBytes(0),
+	m_vCategoryPeakBytes()
+{
+}
+
+MemoryTracker::~MemoryTracker()
+{
+}
+
+void MemoryTracker::Allocate(const char *pszAsset, const char *pszResource, const Category eCategory, const size_t uBytes)
+{
+	const auto i = findEntry(pszAsset, pszResource);
+	if (i >= 0)
+	{
+		auto &entry = m_vEntries[i];
+		m_uBytes -= entry.uBytes;
+		entry.eCategory = eCategory;
+		entry.uBytes = uBytes;
+	}
+	else m_vEntries.push_back({ pszAsset, pszResource, eCategory, uBytes });
+
+	m_uBytes += uBytes;
+	m_uPeakBytes = (std::max)(m_uPeakBytes, m_uBytes);
+	m_vCategoryPeakBytes[eCategory] = (std::max)(m_vCategoryPeakBytes[eCategory], GetBytes(eCategory));
+}
+
+void MemoryTracker::Release(const char *pszAsset, const char *pszResource)
+{
+	const auto i = findEntry(pszAsset, pszResource);
+	if (i < 0) return;
+
+	m_uBytes -= m_vEntries[i].uBytes;
+	m_vEntries.erase(m_vEntries.begin() + i);
+}
+
+void MemoryTracker::ReleaseAsset(const char *pszAsset)
+{
+	const auto iter = remove_if(m_vEntries.begin(), m_vEntries.end(),
+		[pszAsset](const Entry &entry) { return entry.strAsset == pszAsset; });
+	for (auto i = iter; i != m_vEntries.end(); ++i) m_uBytes -= i->uBytes;
+	m_vEntries.erase(iter, m_vEntries.end());
+}
+
+void MemoryTracker::ReleaseAll()
+{
+	m_vEntries.clear();
+	m_uBytes = 0;
+}
+
+void MemoryTracker::ResetPeak()
+{
+	m_uPeakBytes = m_uBytes;
+	for (auto c = 0u; c < NUM_CATEGORY; ++c) m_vCategoryPeakBytes[c] = GetBytes(static_cast<Category>(c));
+}
+
+size_t MemoryTracker::GetBytes() const
+{
+	return m_uBytes;
+}
+
+size_t MemoryTracker::GetPeakBytes() const
+{
+	return m_uPeakBytes;
+}
+
+size_t MemoryTracker::GetBytes(const Category eCategory) const
+{
+	size_t uBytes = 0;
+	for (const auto &entry : m_vEntries)
+		if (entry.eCategory == eCategory) uBytes += entry.uBytes;
+
+	return uBytes;
+}
+
+size_t MemoryTracker::GetPeakBytes(const Category eCategory) const
+{
+	return m_vCategoryPeakBytes[eCategory];
+}
+
+size_t MemoryTracker::GetAssetBytes(const char *pszAsset) const
+{
+	size_t uBytes = 0;
+	for (const auto &entry : m_vEntries)
+		if (entry.strAsset == pszAsset) uBytes += entry.uBytes;
+
+	return uBytes;
+}
+
+void MemoryTracker::PrintReport(FILE *pFile) const
+{
+	fprintf(pFile, "%-32s %-40s %-10s %12s\n", "asset", "resource", "category", "bytes");
+	for (const auto &entry : m_vEntries)
+		fprintf(pFile, "%-32s %-40s %-10s %12zu\n", entry.strAsset.c_str(), entry.strResource.c_str(),
+			g_pszCategoryNames[entry.eCategory], entry.uBytes);
+
+	// Assets in order of their first allocation
+	fprintf(pFile, "\n%-32s %12s\n", "asset", "MB");
+	vector<string> vAssets;
+	for (const auto &entry : m_vEntries)
+		if (find(vAssets.cbegin(), vAssets.cend(), entry.strAsset) == vAssets.cend())
+		{
+			vAssets.push_back(entry.strAsset);
+			fprintf(pFile, "%-32s %12.3f\n", entry.strAsset.c_str(), toMB(GetAssetBytes(entry.strAsset.c_str())));
+		}
+
+	fprintf(pFile, "\n%-32s %12s %12s\n", "category", "MB", "peak MB");
+	for (auto c = 0u; c < NUM_CATEGORY; ++c)
+		if (m_vCategoryPeakBytes[c] > 0) fprintf(pFile, "%-32s %12.3f %12.3f\n", g_pszCategoryNames[c],
+			toMB(GetBytes(static_cast<Category>(c))), toMB(m_vCategoryPeakBytes[c]));
+
+	fprintf(pFile, "\n%-32s %12.3f %12.3f\n", "total", toMB(m_uBytes), toMB(m_uPeakBytes));
+}
+
+const char *MemoryTracker::GetCategoryName(const Category eCategory)
+{
+	return g_pszCategoryNames[eCategory];
+}
+
+int32_t MemoryTracker::findEntry(const char *pszAsset, const char *pszResource) const
+{
+	for (auto i = 0u; i < m_vEntries.size(); ++i)
+		if (m_vEntries[i].strAsset == pszAsset && m_vEntries[i].strResource == pszResource)
+			return static_cast<int32_t>(i);
+
+	return -1;
+}
@@ -0,0 +1,75 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Byte accounting of GPU resources and CPU allocations. Each allocation is named by
+	// its asset and resource, so re-creating a resource (e.g. on resize) replaces its
+	// entry. Peaks are the high-water marks of the total and of each category since the
+	// last ResetPeak(), so the import peak survives the release of the loader temporaries.
+	//--------------------------------------------------------------------------------------
+	class MemoryTracker
+	{
+	public:
+		enum Category : uint8_t
+		{
+			CATEGORY_GEOMETRY,		// Vertex and index data
+			CATEGORY_K_BUFFER,		// View-space k-buffers
+			CATEGORY_LIGHT,			// Light-space k-buffers and thickness prefixes or columns
+			CATEGORY_CONSTANT,		// Constant buffers
+			CATEGORY_LOOKUP,		// Transmission LUTs, density bricks
+			CATEGORY_HISTORY,		// Temporal accumulation
+			CATEGORY_IMPORT,		// Loader temporaries, released once the asset is created
+
+			NUM_CATEGORY
+		};
+
+		MemoryTracker();
+		virtual ~MemoryTracker();
+
+		void Allocate(const char *pszAsset, const char *pszResource, const Category eCategory, const size_t uBytes);
+		void Release(const char *pszAsset, const char *pszResource);
+		void ReleaseAsset(const char *pszAsset);
+		void ReleaseAll();
+		void ResetPeak();
+
+		size_t GetBytes() const;
+		size_t GetPeakBytes() const;
+		size_t GetBytes(const Category eCategory) const;
+		size_t GetPeakBytes(const Category eCategory) const;
+		size_t GetAssetBytes(const char *pszAsset) const;
+
+		// Per resource, per asset and per category, with the current and the peak totals
+		void PrintReport(FILE *pFile) const;
+
+		static const char *GetCategoryName(const Category eCategory);
+
+	protected:
+		struct Entry
+		{
+			std::string	strAsset;
+			std::string	strResource;
+			Category	eCategory;
+			size_t		uBytes;
+		};
+
+		int32_t findEntry(const char *pszAsset, const char *pszResource) const;
+
+		std::vector<Entry>	m_vEntries;
+		size_t				m_uBytes;
+		size_t				m_uPeakBytes;
+		size_t				m_vCategoryPeakBytes[NUM_CATEGORY];
+	};
+
+	using upMemoryTracker = std::unique_ptr<MemoryTracker>;
+	using spMemoryTracker = std::shared_ptr<MemoryTracker>;
+}
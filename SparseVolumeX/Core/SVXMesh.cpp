@@ -0,0 +1,469 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include "SVXFile.h"
+#include "SVXMesh.h"
+#include "SVXSimplifier.h"
+
+using namespace std;
+using namespace SVX;
+
+static const char g_szMagic[] = "SVXMESH3";
+
+const uint32_t Mesh::MAX_MESHLET_VERTICES;
+const uint32_t Mesh::MAX_MESHLET_TRIANGLES;
+
+// Spreads the low 10 bits of a grid coordinate to every third bit
+static uint32_t spreadBits(uint32_t x)
+{
+	x &= 0x3ff;
+	x = (x | (x << 16)) & 0x030000ff;
+	x = (x | (x << 8)) & 0x0300f00f;
+	x = (x | (x << 4)) & 0x030c30c3;
+	x = (x | (x << 2)) & 0x09249249;
+
+	return x;
+}
+
+Mesh::Mesh() :
+	m_vPositions(0),
+	m_vIndices(0),
+	m_vMeshlets(0),
+	m_vMeshletVertices(0),
+	m_vMeshletTriangles(0),
+	m_vLODs(0),
+	m_fLODError(0.0f),
+	m_vCenter(0.0f),
+	m_fRadius(0.0f),
+	m_vAABBMin(0.0f),
+	m_vAABBMax(0.0f)
+{
+}
+
+Mesh::~Mesh()
+{
+}
+
+void Mesh::Create(const uint8_t *pVertices, const uint32_t uStride, const uint32_t uNumVertices,
+	const uint32_t *pIndices, const uint32_t uNumIndices)
+{
+	// Positions are the leading 3 floats of each vertex
+	m_vPositions.resize(uNumVertices);
+	m_vPositions.shrink_to_fit();
+	for (auto i = 0u; i < uNumVertices; ++i)
+		memcpy(&m_vPositions[i], &pVertices[static_cast<size_t>(uStride) * i], sizeof(float3));
+
+	m_vIndices.assign(pIndices, pIndices + uNumIndices);
+	m_vIndices.shrink_to_fit();
+
+	computeBound();
+	buildMeshlets();
+	m_vLODs.clear();
+}
+
+bool Mesh::Save(const char *pszFilename, const uint64_t uSourceStamp) const
+{
+	const auto pFile = OpenFile(pszFilename, "wb");
+	if (!pFile) return false;
+
+	const auto uNumLODs = GetNumLODs();
+	auto bSuccess = fwrite(g_szMagic, 1, 8, pFile) == 8;
+	bSuccess = bSuccess && fwrite(&uSourceStamp, sizeof(uint64_t), 1, pFile) == 1;
+	bSuccess = bSuccess && fwrite(&uNumLODs, sizeof(uint32_t), 1, pFile) == 1;
+	for (auto i = 0u; i < uNumLODs; ++i) bSuccess = bSuccess && GetLOD(i).write(pFile);
+	fclose(pFile);
+
+	return bSuccess;
+}
+
+bool Mesh::Load(const char *pszFilename, const uint64_t uSourceStamp)
+{
+	const auto pFile = OpenFile(pszFilename, "rb");
+	if (!pFile) return false;
+
+	char szMagic[8];
+	uint64_t uStamp;
+	uint32_t uNumLODs;
+	auto bSuccess = fread(szMagic, 1, 8, pFile) == 8 && !memcmp(szMagic, g_szMagic, 8);
+	bSuccess = bSuccess && fread(&uStamp, sizeof(uint64_t), 1, pFile) == 1 && uStamp == uSourceStamp;
+	bSuccess = bSuccess && fread(&uNumLODs, sizeof(uint32_t), 1, pFile) == 1 && uNumLODs > 0;
+	bSuccess = bSuccess && read(pFile);
+	m_vLODs.clear();
+	for (auto i = 1u; bSuccess && i < uNumLODs; ++i)
+	{
+		const auto pLOD = make_shared<Mesh>();
+		bSuccess = pLOD->read(pFile);
+		m_vLODs.push_back(pLOD);
+	}
+	fclose(pFile);
+
+	return bSuccess;
+}
+
+void Mesh::BuildLODs(const uint32_t uMinTriangles)
+{
+	m_vLODs.clear();
+
+	// One simplification down the chain, so that the errors are all from this mesh; a
+	// level that falls well short of halving ends the chain
+	Simplifier simplifier(m_vPositions.data(), GetNumVertices(), m_vIndices.data(), GetNumIndices());
+	vector<float3> vPositions;
+	vector<uint32_t> vIndices;
+	for (auto uTarget = GetNumIndices() / 6; uTarget >= uMinTriangles; uTarget = simplifier.GetNumTriangles() / 2)
+	{
+		if (simplifier.Collapse(uTarget) > uTarget + uTarget / 4) break;
+
+		simplifier.Extract(vPositions, vIndices);
+		const auto pLOD = make_shared<Mesh>();
+		pLOD->Create(reinterpret_cast<const uint8_t*>(vPositions.data()), sizeof(float3),
+			static_cast<uint32_t>(vPositions.size()), vIndices.data(), static_cast<uint32_t>(vIndices.size()));
+		pLOD->m_fLODError = simplifier.GetError();
+		m_vLODs.push_back(pLOD);
+	}
+}
+
+void Mesh::SortMorton()
+{
+	const auto uNumTriangles = static_cast<uint32_t>(m_vIndices.size() / 3);
+	if (uNumTriangles == 0) return;
+
+	// Centroids on a 1024^3 grid over the AABB; the triangle index in the low bits keeps
+	// the original order among triangles of the same cell
+	const auto vExtent = m_vAABBMax - m_vAABBMin;
+	float3 vScale;
+	for (auto i = 0u; i < 3; ++i) vScale[i] = vExtent[i] > 0.0f ? 1023.0f / vExtent[i] : 0.0f;
+
+	vector<uint64_t> vKeys(uNumTriangles);
+	for (auto i = 0u; i < uNumTriangles; ++i)
+	{
+		const auto pTriangle = &m_vIndices[i * 3];
+		const auto vCentroid = (m_vPositions[pTriangle[0]] + m_vPositions[pTriangle[1]] +
+			m_vPositions[pTriangle[2]]) * (1.0f / 3.0f);
+		auto uCode = 0u;
+		for (auto j = 0u; j < 3; ++j)
+		{
+			const auto fCell = (std::min)((std::max)((vCentroid[j] - m_vAABBMin[j]) * vScale[j], 0.0f), 1023.0f);
+			uCode |= spreadBits(static_cast<uint32_t>(fCell)) << (2 - j);
+		}
+		vKeys[i] = static_cast<uint64_t>(uCode) << 32 | i;
+	}
+	sort(vKeys.begin(), vKeys.end());
+
+	// The winding of each triangle is kept; unreferenced vertices go last
+	vector<uint32_t> vRemap(m_vPositions.size(), UINT32_MAX), vIndices(m_vIndices.size());
+	vector<float3> vPositions;
+	vPositions.reserve(m_vPositions.size());
+	for (auto i = 0u; i < uNumTriangles; ++i)
+	{
+		const auto pTriangle = &m_vIndices[static_cast<uint32_t>(vKeys[i]) * 3];
+		for (auto j = 0u; j < 3; ++j)
+		{
+			auto &uVertex = vRemap[pTriangle[j]];
+			if (uVertex == UINT32_MAX)
+			{
+				uVertex = static_cast<uint32_t>(vPositions.size());
+				vPositions.push_back(m_vPositions[pTriangle[j]]);
+			}
+			vIndices[i * 3 + j] = uVertex;
+		}
+	}
+	for (auto i = 0u; i < m_vPositions.size(); ++i)
+		if (vRemap[i] == UINT32_MAX) vPositions.push_back(m_vPositions[i]);
+
+	m_vPositions.swap(vPositions);
+	m_vIndices.swap(vIndices);
+	buildMeshlets();
+
+	// The levels may be shared with copies of this mesh, so they are sorted as copies
+	for (auto &pLOD : m_vLODs)
+	{
+		const auto pSorted = make_shared<Mesh>(*pLOD);
+		pSorted->SortMorton();
+		pLOD = pSorted;
+	}
+}
+
+uint32_t Mesh::GetNumVertices() const
+{
+	return static_cast<uint32_t>(m_vPositions.size());
+}
+
+uint32_t Mesh::GetNumIndices() const
+{
+	return static_cast<uint32_t>(m_vIndices.size());
+}
+
+const float3 *Mesh::GetPositions() const
+{
+	return m_vPositions.data();
+}
+
+const uint32_t *Mesh::GetIndices() const
+{
+	return m_vIndices.data();
+}
+
+uint32_t Mesh::GetNumMeshlets() const
+{
+	return static_cast<uint32_t>(m_vMeshlets.size());
+}
+
+uint32_t Mesh::GetNumMeshletVertices() const
+{
+	return static_cast<uint32_t>(m_vMeshletVertices.size());
+}
+
+const Mesh::Meshlet *Mesh::GetMeshlets() const
+{
+	return m_vMeshlets.data();
+}
+
+const uint32_t *Mesh::GetMeshletVertices() const
+{
+	return m_vMeshletVertices.data();
+}
+
+const uint8_t *Mesh::GetMeshletTriangles() const
+{
+	return m_vMeshletTriangles.data();
+}
+
+const float3 &Mesh::GetCenter() const
+{
+	return m_vCenter;
+}
+
+float Mesh::GetRadius() const
+{
+	return m_fRadius;
+}
+
+const float3 &Mesh::GetAABBMin() const
+{
+	return m_vAABBMin;
+}
+
+const float3 &Mesh::GetAABBMax() const
+{
+	return m_vAABBMax;
+}
+
+uint32_t Mesh::GetNumLODs() const
+{
+	return static_cast<uint32_t>(m_vLODs.size()) + 1;
+}
+
+const Mesh &Mesh::GetLOD(const uint32_t uLevel) const
+{
+	return uLevel > 0 ? *m_vLODs[uLevel - 1] : *this;
+}
+
+float Mesh::GetLODError() const
+{
+	return m_fLODError;
+}
+
+uint32_t Mesh::SelectLOD(const float4x4 &mViewProj, const uint32_t uHeight, const float fTolerance) const
+{
+	if (fTolerance <= 0.0f || m_vLODs.empty()) return 0;
+
+	// Clip w at the nearest point of the bounding sphere, and the pixels per unit length
+	// there from the clip y axis; a view from inside the sphere takes the full mesh
+	const auto &m = mViewProj;
+	const float3 vAxisY(m.r[0].y, m.r[1].y, m.r[2].y);
+	const float3 vAxisW(m.r[0].w, m.r[1].w, m.r[2].w);
+	const auto fW = dot(m_vCenter, vAxisW) + m.r[3].w - length(m_vAABBMax - m_vCenter) * length(vAxisW);
+	if (fW <= 0.0f) return 0;
+
+	const auto fPixelsPerUnit = length(vAxisY) * 0.5f * uHeight / fW;
+	auto uLevel = 0u;
+	while (uLevel < m_vLODs.size() && m_vLODs[uLevel]->m_fLODError * fPixelsPerUnit <= fTolerance) ++uLevel;
+
+	return uLevel;
+}
+
+size_t Mesh::GetBytes() const
+{
+	auto uBytes = sizeof(float3) * m_vPositions.capacity() + sizeof(uint32_t) * m_vIndices.capacity() +
+		sizeof(Meshlet) * m_vMeshlets.capacity() + sizeof(uint32_t) * m_vMeshletVertices.capacity() +
+		m_vMeshletTriangles.capacity();
+	for (const auto &pLOD : m_vLODs) uBytes += pLOD->GetBytes();
+
+	return uBytes;
+}
+
+bool Mesh::write(FILE *pFile) const
+{
+	// The meshlets are kept, so a cached mesh is not clustered again
+	const uint32_t vCounts[] = { GetNumVertices(), GetNumIndices(), GetNumMeshlets(), GetNumMeshletVertices(),
+		static_cast<uint32_t>(m_vMeshletTriangles.size()) };
+	auto bSuccess = fwrite(vCounts, sizeof(uint32_t), 5, pFile) == 5;
+	bSuccess = bSuccess && fwrite(&m_fLODError, sizeof(float), 1, pFile) == 1;
+	bSuccess = bSuccess && fwrite(m_vPositions.data(), sizeof(float3), vCounts[0], pFile) == vCounts[0];
+	bSuccess = bSuccess && fwrite(m_vIndices.data(), sizeof(uint32_t), vCounts[1], pFile) == vCounts[1];
+	bSuccess = bSuccess && fwrite(m_vMeshlets.data(), sizeof(Meshlet), vCounts[2], pFile) == vCounts[2];
+	bSuccess = bSuccess && fwrite(m_vMeshletVertices.data(), sizeof(uint32_t), vCounts[3], pFile) == vCounts[3];
+	bSuccess = bSuccess && fwrite(m_vMeshletTriangles.data(), 1, vCounts[4], pFile) == vCounts[4];
+
+	return bSuccess;
+}
+
+bool Mesh::read(FILE *pFile)
+{
+	uint32_t vCounts[5];
+	auto bSuccess = fread(vCounts, sizeof(uint32_t), 5, pFile) == 5;
+	bSuccess = bSuccess && fread(&m_fLODError, sizeof(float), 1, pFile) == 1;
+	if (!bSuccess) return false;
+
+	m_vPositions.resize(vCounts[0]);
+	m_vPositions.shrink_to_fit();
+	m_vIndices.resize(vCounts[1]);
+	m_vIndices.shrink_to_fit();
+	m_vMeshlets.resize(vCounts[2]);
+	m_vMeshlets.shrink_to_fit();
+	m_vMeshletVertices.resize(vCounts[3]);
+	m_vMeshletVertices.shrink_to_fit();
+	m_vMeshletTriangles.resize(vCounts[4]);
+	m_vMeshletTriangles.shrink_to_fit();
+	bSuccess = fread(m_vPositions.data(), sizeof(float3), vCounts[0], pFile) == vCounts[0];
+	bSuccess = bSuccess && fread(m_vIndices.data(), sizeof(uint32_t), vCounts[1], pFile) == vCounts[1];
+	bSuccess = bSuccess && fread(m_vMeshlets.data(), sizeof(Meshlet), vCounts[2], pFile) == vCounts[2];
+	bSuccess = bSuccess && fread(m_vMeshletVertices.data(), sizeof(uint32_t), vCounts[3], pFile) == vCounts[3];
+	bSuccess = bSuccess && fread(m_vMeshletTriangles.data(), 1, vCounts[4], pFile) == vCounts[4];
+	if (bSuccess) computeBound();
+
+	return bSuccess;
+}
+
+void Mesh::computeBound()
+{
+	if (m_vPositions.empty()) return;
+
+	m_vAABBMin = m_vAABBMax = m_vPositions[0];
+	for (const auto &vPos : m_vPositions)
+	{
+		m_vAABBMin = (min)(m_vAABBMin, vPos);
+		m_vAABBMax = (max)(m_vAABBMax, vPos);
+	}
+
+	// Same bounding cube as ObjLoader
+	const auto vExtent = m_vAABBMax - m_vAABBMin;
+	m_vCenter = (m_vAABBMin + m_vAABBMax) * 0.5f;
+	m_fRadius = (std::max)((std::max)(vExtent.x, vExtent.y), vExtent.z) * 0.5f;
+}
+
+void Mesh::buildMeshlets()
+{
+	m_vMeshlets.clear();
+	m_vMeshletVertices.clear();
+	m_vMeshletTriangles.clear();
+
+	// Local index of each vertex in the open meshlet, reset through its vertex list
+	vector<uint8_t> vLocal(m_vPositions.size(), UINT8_MAX);
+	vector<float3> vNormals;
+	const auto close = [&](Meshlet &meshlet)
+	{
+		const auto pVertices = &m_vMeshletVertices[meshlet.uVertexOffset];
+		const auto pTriangles = &m_vMeshletTriangles[meshlet.uTriangleOffset];
+		for (auto i = 0u; i < meshlet.uNumVertices; ++i) vLocal[pVertices[i]] = UINT8_MAX;
+
+		// Sphere around the center of the box
+		auto vMin = m_vPositions[pVertices[0]], vMax = vMin;
+		for (auto i = 1u; i < meshlet.uNumVertices; ++i)
+		{
+			vMin = (min)(vMin, m_vPositions[pVertices[i]]);
+			vMax = (max)(vMax, m_vPositions[pVertices[i]]);
+		}
+		meshlet.vCenter = (vMin + vMax) * 0.5f;
+		meshlet.fRadius = 0.0f;
+		for (auto i = 0u; i < meshlet.uNumVertices; ++i)
+			meshlet.fRadius = (std::max)(meshlet.fRadius, length(m_vPositions[pVertices[i]] - meshlet.vCenter));
+
+		// Cone around the mean normal; degenerate triangles have none
+		vNormals.clear();
+		auto vAxis = float3(0.0f);
+		for (auto i = 0u; i < meshlet.uNumTriangles; ++i)
+		{
+			const auto &v0 = m_vPositions[pVertices[pTriangles[i * 3]]];
+			const auto vNormal = cross(m_vPositions[pVertices[pTriangles[i * 3 + 1]]] - v0,
+				m_vPositions[pVertices[pTriangles[i * 3 + 2]]] - v0);
+			const auto fLength = length(vNormal);
+			if (fLength <= 0.0f) continue;
+			vNormals.push_back(vNormal / fLength);
+			vAxis += vNormals.back();
+		}
+
+		const auto fLength = length(vAxis);
+		meshlet.vConeAxis = fLength > 0.0f ? vAxis / fLength : float3(0.0f, 0.0f, 1.0f);
+		meshlet.fConeCutoff = fLength > 0.0f ? 1.0f : -1.0f;
+		for (const auto &vNormal : vNormals)
+			meshlet.fConeCutoff = (std::min)(meshlet.fConeCutoff, dot(vNormal, meshlet.vConeAxis));
+
+		m_vMeshlets.push_back(meshlet);
+	};
+
+	// Triangles around each vertex
+	const auto uNumTriangles = static_cast<uint32_t>(m_vIndices.size() / 3);
+	vector<uint32_t> vAdjacencyOffsets(m_vPositions.size() + 1, 0), vAdjacency(uNumTriangles * 3);
+	for (auto i = 0u; i < uNumTriangles * 3; ++i) ++vAdjacencyOffsets[m_vIndices[i] + 1];
+	for (auto i = 0u; i < m_vPositions.size(); ++i) vAdjacencyOffsets[i + 1] += vAdjacencyOffsets[i];
+	{
+		auto vNext = vAdjacencyOffsets;
+		for (auto i = 0u; i < uNumTriangles * 3; ++i) vAdjacency[vNext[m_vIndices[i]]++] = i / 3;
+	}
+
+	// Each meshlet grows breadth-first from the first free triangle over the triangles
+	// sharing its vertices, so it stays compact whatever the index order; the triangles
+	// that no longer fit are left to later meshlets
+	vector<uint32_t> vQueued(uNumTriangles, UINT32_MAX), vQueue;
+	vector<bool> vUsed(uNumTriangles, false);
+	auto uSeed = 0u;
+	while (true)
+	{
+		while (uSeed < uNumTriangles && vUsed[uSeed]) ++uSeed;
+		if (uSeed == uNumTriangles) break;
+
+		Meshlet meshlet = {};
+		meshlet.uVertexOffset = static_cast<uint32_t>(m_vMeshletVertices.size());
+		meshlet.uTriangleOffset = static_cast<uint32_t>(m_vMeshletTriangles.size());
+		const auto uMeshlet = static_cast<uint32_t>(m_vMeshlets.size());
+		vQueue.assign(1, uSeed);
+		vQueued[uSeed] = uMeshlet;
+		for (auto q = 0u; q < vQueue.size() && meshlet.uNumTriangles < MAX_MESHLET_TRIANGLES; ++q)
+		{
+			const auto pTriangle = &m_vIndices[vQueue[q] * 3];
+			auto uNewVertices = 0u;
+			for (auto j = 0u; j < 3; ++j) uNewVertices += vLocal[pTriangle[j]] == UINT8_MAX ? 1 : 0;
+			if (meshlet.uNumVertices + uNewVertices > MAX_MESHLET_VERTICES) continue;
+
+			vUsed[vQueue[q]] = true;
+			for (auto j = 0u; j < 3; ++j)
+			{
+				auto &uLocal = vLocal[pTriangle[j]];
+				if (uLocal == UINT8_MAX)
+				{
+					uLocal = static_cast<uint8_t>(meshlet.uNumVertices++);
+					m_vMeshletVertices.push_back(pTriangle[j]);
+				}
+				m_vMeshletTriangles.push_back(uLocal);
+
+				for (auto k = vAdjacencyOffsets[pTriangle[j]]; k < vAdjacencyOffsets[pTriangle[j] + 1]; ++k)
+				{
+					const auto uNeighbor = vAdjacency[k];
+					if (vUsed[uNeighbor] || vQueued[uNeighbor] == uMeshlet) continue;
+					vQueued[uNeighbor] = uMeshlet;
+					vQueue.push_back(uNeighbor);
+				}
+			}
+			++meshlet.uNumTriangles;
+		}
+		close(meshlet);
+	}
+
+	m_vMeshlets.shrink_to_fit();
+	m_vMeshletVertices.shrink_to_fit();
+	m_vMeshletTriangles.shrink_to_fit();
+}
@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "SVXMath.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Indexed triangle positions with their bounds, the only mesh data the peeling needs.
+	// The triangles are also clustered into meshlets of up to 64 vertices and 124
+	// triangles in index order, each bounded by a sphere and a normal cone, so that a
+	// peel transforms and scans only the clusters inside its view. SortMorton() optionally
+	// lays the triangles out along a Morton curve, so that neighboring clusters and the
+	// triangles of a screen tile are also close in memory. BuildLODs() adds a chain of
+	// simplified levels, so that a distant view peels fewer triangles than the source.
+	//--------------------------------------------------------------------------------------
+	class Mesh
+	{
+	public:
+		struct Meshlet
+		{
+			float3		vCenter;			// Bounding sphere
+			float		fRadius;
+			float3		vConeAxis;			// Mean of the triangle normals
+			float		fConeCutoff;		// Least cosine of a normal to the axis
+			uint32_t	uVertexOffset;		// Into the meshlet vertices
+			uint32_t	uTriangleOffset;	// Into the meshlet triangles, 3 local indices each
+			uint32_t	uNumVertices;
+			uint32_t	uNumTriangles;
+		};
+
+		static const uint32_t MAX_MESHLET_VERTICES = 64;
+		static const uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+		Mesh();
+		virtual ~Mesh();
+
+		void Create(const uint8_t *pVertices, const uint32_t uStride, const uint32_t uNumVertices,
+			const uint32_t *pIndices, const uint32_t uNumIndices);
+
+		// Binary cache of the imported mesh and its levels of detail, tagged with the stamp
+		// of its source file (GetFileStamp()) so that a stale cache is rejected
+		bool Save(const char *pszFilename, const uint64_t uSourceStamp) const;
+		bool Load(const char *pszFilename, const uint64_t uSourceStamp);
+
+		// Reorders the triangles by the 3D Morton code of their centroids in the AABB and
+		// the vertices by first use, then rebuilds the meshlets in that order
+		void SortMorton();
+
+		// Levels of detail by quadric error simplification, each with half the triangles of
+		// the previous one, down to uMinTriangles
+		void BuildLODs(const uint32_t uMinTriangles = 1024);
+
+		// Level 0 is the mesh itself; the error of a level bounds its distance to level 0
+		uint32_t GetNumLODs() const;
+		const Mesh &GetLOD(const uint32_t uLevel) const;
+		float GetLODError() const;
+
+		// Coarsest level whose error projects to at most fTolerance pixels of a view of
+		// uHeight rows, 0 without a tolerance
+		uint32_t SelectLOD(const float4x4 &mViewProj, const uint32_t uHeight, const float fTolerance) const;
+
+		uint32_t GetNumVertices() const;
+		uint32_t GetNumIndices() const;
+		const float3 *GetPositions() const;
+		const uint32_t *GetIndices() const;
+
+		// Vertex indices of all meshlets, and their triangles as 8-bit indices into them
+		uint32_t GetNumMeshlets() const;
+		uint32_t GetNumMeshletVertices() const;
+		const Meshlet *GetMeshlets() const;
+		const uint32_t *GetMeshletVertices() const;
+		const uint8_t *GetMeshletTriangles() const;
+
+		const float3 &GetCenter() const;
+		float GetRadius() const;
+		const float3 &GetAABBMin() const;
+		const float3 &GetAABBMax() const;
+		size_t GetBytes() const;
+
+	protected:
+		void computeBound();
+		void buildMeshlets();
+		bool write(FILE *pFile) const;
+		bool read(FILE *pFile);
+
+		std::vector<float3>		m_vPositions;
+		std::vector<uint32_t>	m_vIndices;
+
+		std::vector<Meshlet>	m_vMeshlets;
+		std::vector<uint32_t>	m_vMeshletVertices;
+		std::vector<uint8_t>	m_vMeshletTriangles;
+
+		std::vector<std::shared_ptr<Mesh>> m_vLODs;	// Immutable, shared by copies
+		float					m_fLODError;
+
+		float3					m_vCenter;
+		float					m_fRadius;
+		float3					m_vAABBMin;
+		float3					m_vAABBMax;
+	};
+
+	using upMesh = std::unique_ptr<Mesh>;
+	using spMesh = std::shared_ptr<Mesh>;
+}
@@ -0,0 +1,216 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "SVXFile.h"
+#include "SVXProfiler.h"
+
+using namespace std;
+using namespace SVX;
+
+static const char *g_pszTrackNames[] = { "CPU", "GPU" };
+
+Profiler::Profiler(const uint32_t uNumFrames) :
+	m_vFrames(uNumFrames),
+	m_vStageNames(0),
+	m_uFrame(0),
+	m_bInFrame(false),
+	m_tStart(chrono::steady_clock::now())
+{
+	// Frame numbers are 1-based, so an unused slot never matches
+	for (auto &frame : m_vFrames) frame.uFrame = 0;
+}
+
+Profiler::~Profiler()
+{
+}
+
+void Profiler::BeginFrame()
+{
+	auto &frame = m_vFrames[++m_uFrame % m_vFrames.size()];
+	frame.uFrame = m_uFrame;
+	frame.fStart = GetTime();
+	frame.fDuration = 0.0;
+	frame.vEvents.clear();
+	m_bInFrame = true;
+}
+
+void Profiler::EndFrame()
+{
+	auto &frame = m_vFrames[m_uFrame % m_vFrames.size()];
+	frame.fDuration = GetTime() - frame.fStart;
+	m_bInFrame = false;
+}
+
+uint32_t Profiler::BeginStage(const char *pszStage)
+{
+	// Stages outside BeginFrame()/EndFrame() get a frame of their own
+	if (!m_bInFrame) BeginFrame();
+
+	auto &vEvents = m_vFrames[m_uFrame % m_vFrames.size()].vEvents;
+	vEvents.push_back({ stageIndex(pszStage), TRACK_CPU, GetTime(), 0.0 });
+
+	return static_cast<uint32_t>(vEvents.size() - 1);
+}
+
+void Profiler::EndStage(const uint32_t uEvent)
+{
+	auto &event = m_vFrames[m_uFrame % m_vFrames.size()].vEvents[uEvent];
+	event.fDuration = GetTime() - event.fStart;
+}
+
+void Profiler::AddStage(const uint64_t uFrame, const char *pszStage, const Track eTrack,
+	const double fStart, const double fDuration)
+{
+	const auto uStage = stageIndex(pszStage);
+	const auto pFrame = findFrame(uFrame);
+	if (pFrame) pFrame->vEvents.push_back({ uStage, eTrack, fStart, fDuration });
+}
+
+double Profiler::GetTime() const
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - m_tStart).count();
+}
+
+uint64_t Profiler::GetFrame() const
+{
+	return m_uFrame;
+}
+
+bool Profiler::GetPercentiles(const char *pszStage, const Track eTrack, double &fP50,
+	double &fP95, double &fP99) const
+{
+	const auto iStage = findStage(pszStage);
+	if (iStage < 0) return false;
+
+	vector<double> vDurations;
+	collect(static_cast<uint16_t>(iStage), eTrack, vDurations);
+	if (vDurations.empty()) return false;
+
+	// Nearest rank
+	sort(vDurations.begin(), vDurations.end());
+	const auto percentile = [&vDurations](const double fP)
+	{
+		const auto i = static_cast<size_t>(ceil(fP * vDurations.size()));
+		return vDurations[i > 0 ? i - 1 : 0];
+	};
+	fP50 = percentile(0.5);
+	fP95 = percentile(0.95);
+	fP99 = percentile(0.99);
+
+	return true;
+}
+
+double Profiler::GetLatest(const char *pszStage, const Track eTrack) const
+{
+	const auto iStage = findStage(pszStage);
+	if (iStage < 0) return 0.0;
+
+	// The GPU track lags behind, so search back for the newest frame with the stage
+	for (auto i = 0u; i < m_vFrames.size() && i < m_uFrame; ++i)
+	{
+		const auto &frame = m_vFrames[(m_uFrame - i) % m_vFrames.size()];
+		auto fDuration = 0.0;
+		auto bFound = false;
+		for (const auto &event : frame.vEvents)
+			if (event.uStage == iStage && event.uTrack == eTrack)
+			{
+				fDuration += event.fDuration;
+				bFound = true;
+			}
+
+		if (bFound) return fDuration;
+	}
+
+	return 0.0;
+}
+
+void Profiler::PrintSummary(FILE *pFile) const
+{
+	fprintf(pFile, "%-24s %-5s %10s %10s %10s\n", "stage", "track", "p50 (ms)", "p95 (ms)", "p99 (ms)");
+	for (auto t = 0u; t < NUM_TRACK; ++t)
+		for (const auto &strStage : m_vStageNames)
+		{
+			double fP50, fP95, fP99;
+			if (GetPercentiles(strStage.c_str(), static_cast<Track>(t), fP50, fP95, fP99))
+				fprintf(pFile, "%-24s %-5s %10.3f %10.3f %10.3f\n", strStage.c_str(),
+					g_pszTrackNames[t], fP50, fP95, fP99);
+		}
+}
+
+bool Profiler::WriteChromeTrace(const char *pszFilename) const
+{
+	const auto pFile = OpenFile(pszFilename, "w");
+	if (!pFile) return false;
+
+	// Complete ("X") events in microseconds, one thread per track
+	fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (auto t = 0u; t < NUM_TRACK; ++t)
+		fprintf(pFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n",
+			t, g_pszTrackNames[t]);
+
+	// Oldest frame first
+	const auto uNumFrames = static_cast<uint32_t>((std::min)(static_cast<uint64_t>(m_vFrames.size()), m_uFrame));
+	for (auto i = 0u; i < uNumFrames; ++i)
+	{
+		const auto &frame = m_vFrames[(m_uFrame - uNumFrames + 1 + i) % m_vFrames.size()];
+		fprintf(pFile, "{\"name\":\"Frame %llu\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f},\n",
+			static_cast<unsigned long long>(frame.uFrame), frame.fStart * 1000.0, frame.fDuration * 1000.0);
+		for (const auto &event : frame.vEvents)
+			fprintf(pFile, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+				m_vStageNames[event.uStage].c_str(), event.uTrack, event.fStart * 1000.0, event.fDuration * 1000.0);
+	}
+
+	// Terminating metadata event, so that no trailing comma is left
+	fprintf(pFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"SparseVolumeX\"}}\n]}\n");
+	fclose(pFile);
+
+	return true;
+}
+
+uint16_t Profiler::stageIndex(const char *pszStage)
+{
+	const auto iStage = findStage(pszStage);
+	if (iStage >= 0) return static_cast<uint16_t>(iStage);
+
+	m_vStageNames.emplace_back(pszStage);
+
+	return static_cast<uint16_t>(m_vStageNames.size() - 1);
+}
+
+int32_t Profiler::findStage(const char *pszStage) const
+{
+	for (auto i = 0u; i < m_vStageNames.size(); ++i)
+		if (m_vStageNames[i] == pszStage) return static_cast<int32_t>(i);
+
+	return -1;
+}
+
+Profiler::Frame *Profiler::findFrame(const uint64_t uFrame)
+{
+	auto &frame = m_vFrames[uFrame % m_vFrames.size()];
+
+	return uFrame > 0 && frame.uFrame == uFrame ? &frame : nullptr;
+}
+
+void Profiler::collect(const uint16_t uStage, const uint8_t uTrack, vector<double> &vDurations) const
+{
+	for (const auto &frame : m_vFrames)
+	{
+		if (frame.uFrame == 0) continue;
+
+		auto fDuration = 0.0;
+		auto bFound = false;
+		for (const auto &event : frame.vEvents)
+			if (event.uStage == uStage && event.uTrack == uTrack)
+			{
+				fDuration += event.fDuration;
+				bFound = true;
+			}
+
+		if (bFound) vDurations.push_back(fDuration);
+	}
+}
@@ -0,0 +1,102 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Per-stage frame profiler. Each frame keeps its stage durations in a ring buffer of
+	// the last uNumFrames frames, on a CPU track timed here and a GPU track filled in
+	// later by the API backend once its timestamp queries resolve. Times are in
+	// milliseconds since the profiler was created.
+	//--------------------------------------------------------------------------------------
+	class Profiler
+	{
+	public:
+		enum Track : uint8_t
+		{
+			TRACK_CPU,
+			TRACK_GPU,
+
+			NUM_TRACK
+		};
+
+		// Times a stage on the CPU track for its lifetime; a null profiler is a no-op
+		class Scope
+		{
+		public:
+			Scope(Profiler *pProfiler, const char *pszStage) :
+				m_pProfiler(pProfiler), m_uEvent(pProfiler ? pProfiler->BeginStage(pszStage) : 0) {}
+			~Scope() { if (m_pProfiler) m_pProfiler->EndStage(m_uEvent); }
+
+		protected:
+			Profiler	*m_pProfiler;
+			uint32_t	m_uEvent;
+		};
+
+		Profiler(const uint32_t uNumFrames = 256);
+		virtual ~Profiler();
+
+		void BeginFrame();
+		void EndFrame();
+
+		uint32_t BeginStage(const char *pszStage);
+		void EndStage(const uint32_t uEvent);
+
+		// Adds a stage timed elsewhere to a frame still in the ring buffer
+		void AddStage(const uint64_t uFrame, const char *pszStage, const Track eTrack,
+			const double fStart, const double fDuration);
+
+		double GetTime() const;
+		uint64_t GetFrame() const;
+
+		// Duration of a stage summed per frame, over the frames in the ring buffer;
+		// false if the stage has not been recorded
+		bool GetPercentiles(const char *pszStage, const Track eTrack, double &fP50,
+			double &fP95, double &fP99) const;
+		double GetLatest(const char *pszStage, const Track eTrack) const;
+
+		void PrintSummary(FILE *pFile) const;
+		bool WriteChromeTrace(const char *pszFilename) const;
+
+	protected:
+		struct Event
+		{
+			uint16_t	uStage;
+			uint8_t		uTrack;
+			double		fStart;
+			double		fDuration;
+		};
+
+		struct Frame
+		{
+			uint64_t			uFrame;
+			double				fStart;
+			double				fDuration;
+			std::vector<Event>	vEvents;
+		};
+
+		uint16_t stageIndex(const char *pszStage);
+		int32_t findStage(const char *pszStage) const;
+		Frame *findFrame(const uint64_t uFrame);
+		void collect(const uint16_t uStage, const uint8_t uTrack, std::vector<double> &vDurations) const;
+
+		std::vector<Frame>			m_vFrames;
+		std::vector<std::string>	m_vStageNames;
+		uint64_t					m_uFrame;		// Number of the current (or next) frame
+		bool						m_bInFrame;
+
+		std::chrono::steady_clock::time_point	m_tStart;
+	};
+
+	using upProfiler = std::unique_ptr<Profiler>;
+	using spProfiler = std::shared_ptr<Profiler>;
+}
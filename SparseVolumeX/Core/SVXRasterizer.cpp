@@ -0,0 +1,268 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <limits>
+#include "SVXRasterizer.h"
+
+using namespace std;
+using namespace SVX;
+
+//--------------------------------------------------------------------------------------
+// Whether a sphere is outside a plane of the D3D clip volume, -w <= x, y <= w and
+// 0 <= z <= w, extracted from the columns of the view-projection matrix
+//--------------------------------------------------------------------------------------
+static bool outsideFrustum(const float4x4 &m, const float3 &vCenter, const float fRadius)
+{
+	float4 vColumns[4];
+	for (auto i = 0u; i < 4; ++i) vColumns[i] = float4(m.r[0][i], m.r[1][i], m.r[2][i], m.r[3][i]);
+
+	const float4 vPlanes[] =
+	{
+		vColumns[3] + vColumns[0], vColumns[3] - vColumns[0],
+		vColumns[3] + vColumns[1], vColumns[3] - vColumns[1],
+		vColumns[2], vColumns[3] - vColumns[2]
+	};
+
+	for (const auto &vPlane : vPlanes)
+		if (dot(vPlane.xyz(), vCenter) + vPlane.w < -fRadius * length(vPlane.xyz())) return true;
+
+	return false;
+}
+
+//--------------------------------------------------------------------------------------
+// Sutherland-Hodgman against one clip plane, d(v) >= 0 is inside
+//--------------------------------------------------------------------------------------
+template<typename Distance>
+static uint32_t clipPolygon(const float4 *pIn, const uint32_t uNumIn, float4 *pOut, const Distance &distance)
+{
+	auto uNumOut = 0u;
+	for (auto i = 0u; i < uNumIn; ++i)
+	{
+		const auto &v0 = pIn[i];
+		const auto &v1 = pIn[(i + 1) % uNumIn];
+		const auto d0 = distance(v0);
+		const auto d1 = distance(v1);
+
+		if (d0 >= 0.0f) pOut[uNumOut++] = v0;
+		if ((d0 >= 0.0f) != (d1 >= 0.0f)) pOut[uNumOut++] = v0 + (v1 - v0) * (d0 / (d0 - d1));
+	}
+
+	return uNumOut;
+}
+
+Rasterizer::Rasterizer() :
+	m_vClipPos(0),
+	m_iRowMin(0),
+	m_iRowMax(0)
+{
+}
+
+Rasterizer::~Rasterizer()
+{
+}
+
+void Rasterizer::DepthPeel(const Mesh &mesh, const float4x4 &mWorldViewProj, KBuffer &kBuffer,
+	const uint32_t uRowBegin, const uint32_t uRowEnd)
+{
+	if ((std::max)(uRowBegin, kBuffer.GetRowBegin()) >= (std::min)(uRowEnd, kBuffer.GetRowEnd())) return;
+
+	m_vClipPos.resize(GetNumClipPos(mesh));
+	TransformVertices(mesh, mWorldViewProj, m_vClipPos.data());
+	DepthPeel(mesh, m_vClipPos.data(), kBuffer, uRowBegin, uRowEnd);
+}
+
+void Rasterizer::DepthPeel(const Mesh &mesh, const float4 *pClipPos, KBuffer &kBuffer,
+	const uint32_t uRowBegin, const uint32_t uRowEnd)
+{
+	// Rows of the band that the k-buffer holds
+	m_iRowMin = static_cast<int32_t>((std::max)(uRowBegin, kBuffer.GetRowBegin()));
+	m_iRowMax = static_cast<int32_t>((std::min)(uRowEnd, kBuffer.GetRowEnd())) - 1;
+	if (m_iRowMin > m_iRowMax) return;
+
+	const auto nearDist = [](const float4 &v) { return v.z; };
+	const auto farDist = [](const float4 &v) { return v.w - v.z; };
+
+	// NDC y of the band with a row of margin, to cull the triangles in front of the
+	// divisions; culled triangles would not cover a pixel center of the band anyway
+	const auto fHeight = static_cast<float>(kBuffer.GetHeight());
+	const auto fBandTop = 1.0f - 2.0f * (m_iRowMin - 1) / fHeight;
+	const auto fBandBottom = 1.0f - 2.0f * (m_iRowMax + 2) / fHeight;
+	const auto outsideBand = [fBandTop, fBandBottom](const float4 &v0, const float4 &v1, const float4 &v2)
+	{
+		if (v0.w <= 0.0f || v1.w <= 0.0f || v2.w <= 0.0f) return false;
+
+		return (v0.y > fBandTop * v0.w && v1.y > fBandTop * v1.w && v2.y > fBandTop * v2.w) ||
+			(v0.y < fBandBottom * v0.w && v1.y < fBandBottom * v1.w && v2.y < fBandBottom * v2.w);
+	};
+
+	// Meshlets culled by the frustum have an empty range, so they are skipped by every band
+	const auto pMeshlets = mesh.GetMeshlets();
+	const auto pTriangles = mesh.GetMeshletTriangles();
+	const auto pRanges = pClipPos + mesh.GetNumMeshletVertices();
+	for (auto m = 0u; m < mesh.GetNumMeshlets(); ++m)
+	{
+		const auto &meshlet = pMeshlets[m];
+		if (pRanges[m].x > fBandTop || pRanges[m].y < fBandBottom) continue;
+
+		const auto pVertices = pClipPos + meshlet.uVertexOffset;
+		const auto pIndices = pTriangles + meshlet.uTriangleOffset;
+		for (auto i = 0u; i < meshlet.uNumTriangles * 3; i += 3)
+		{
+			const auto &v0 = pVertices[pIndices[i]];
+			const auto &v1 = pVertices[pIndices[i + 1]];
+			const auto &v2 = pVertices[pIndices[i + 2]];
+			if (outsideBand(v0, v1, v2)) continue;
+
+			// Trivial accept or reject against the depth clip planes
+			const auto uInside = (nearDist(v0) >= 0.0f) + (nearDist(v1) >= 0.0f) + (nearDist(v2) >= 0.0f) +
+				(farDist(v0) >= 0.0f) + (farDist(v1) >= 0.0f) + (farDist(v2) >= 0.0f);
+			if (uInside == 6)
+			{
+				rasterize(v0, v1, v2, kBuffer);
+				continue;
+			}
+
+			if ((nearDist(v0) < 0.0f && nearDist(v1) < 0.0f && nearDist(v2) < 0.0f) ||
+				(farDist(v0) < 0.0f && farDist(v1) < 0.0f && farDist(v2) < 0.0f)) continue;
+
+			// Clip, then triangulate as a fan
+			float4 vTriangle[] = { v0, v1, v2 };
+			float4 vPolygon[4], vClipped[5];
+			const auto uNumPolygon = clipPolygon(vTriangle, 3, vPolygon, nearDist);
+			const auto uNumClipped = clipPolygon(vPolygon, uNumPolygon, vClipped, farDist);
+			for (auto j = 2u; j < uNumClipped; ++j)
+				rasterize(vClipped[0], vClipped[j - 1], vClipped[j], kBuffer);
+		}
+	}
+}
+
+uint32_t Rasterizer::TransformVertices(const Mesh &mesh, const float4x4 &mWorldViewProj, float4 *pClipPos)
+{
+	const auto pPositions = mesh.GetPositions();
+	const auto pMeshlets = mesh.GetMeshlets();
+	const auto pVertices = mesh.GetMeshletVertices();
+	const auto pRanges = pClipPos + mesh.GetNumMeshletVertices();
+	const auto fInf = numeric_limits<float>::infinity();
+
+	auto uNumVisible = 0u;
+	for (auto m = 0u; m < mesh.GetNumMeshlets(); ++m)
+	{
+		const auto &meshlet = pMeshlets[m];
+		if (outsideFrustum(mWorldViewProj, meshlet.vCenter, meshlet.fRadius))
+		{
+			pRanges[m] = float4(fInf, -fInf, 0.0f, 0.0f);
+			continue;
+		}
+
+		// NDC y range, unbounded if a vertex is behind the eye
+		auto fMin = fInf, fMax = -fInf;
+		for (auto i = meshlet.uVertexOffset; i < meshlet.uVertexOffset + meshlet.uNumVertices; ++i)
+		{
+			pClipPos[i] = mul(float4(pPositions[pVertices[i]], 1.0f), mWorldViewProj);
+			if (pClipPos[i].w <= 0.0f)
+			{
+				fMin = -fInf;
+				fMax = fInf;
+			}
+			else
+			{
+				const auto fY = pClipPos[i].y / pClipPos[i].w;
+				fMin = (std::min)(fMin, fY);
+				fMax = (std::max)(fMax, fY);
+			}
+		}
+		pRanges[m] = float4(fMin, fMax, 0.0f, 0.0f);
+		++uNumVisible;
+	}
+
+	return uNumVisible;
+}
+
+uint32_t Rasterizer::GetNumClipPos(const Mesh &mesh)
+{
+	return mesh.GetNumMeshletVertices() + mesh.GetNumMeshlets();
+}
+
+void Rasterizer::rasterize(const float4 &v0, const float4 &v1, const float4 &v2, KBuffer &kBuffer) const
+{
+	const auto fWidth = static_cast<float>(kBuffer.GetWidth());
+	const auto fHeight = static_cast<float>(kBuffer.GetHeight());
+
+	// Clip space to screen space
+	const auto toScreen = [fWidth, fHeight](const float4 &v)
+	{
+		const auto fWInv = 1.0f / v.w;
+
+		return float3((v.x * fWInv * 0.5f + 0.5f) * fWidth, (0.5f - v.y * fWInv * 0.5f) * fHeight, v.z * fWInv);
+	};
+
+	const auto a = toScreen(v0);
+	auto b = toScreen(v1);
+	auto c = toScreen(v2);
+
+	// Orient counterclockwise in the edge-function sense, no culling
+	auto fArea = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	if (fArea == 0.0f) return;
+	if (fArea < 0.0f)
+	{
+		swap(b, c);
+		fArea = -fArea;
+	}
+
+	// Pixel-center bounding box
+	const auto xMin = (std::max)(static_cast<int32_t>(ceil((std::min)((std::min)(a.x, b.x), c.x) - 0.5f)), 0);
+	const auto yMin = (std::max)(static_cast<int32_t>(ceil((std::min)((std::min)(a.y, b.y), c.y) - 0.5f)), 0);
+	const auto xMax = (std::min)(static_cast<int32_t>(floor((std::max)((std::max)(a.x, b.x), c.x) - 0.5f)),
+		static_cast<int32_t>(kBuffer.GetWidth()) - 1);
+	const auto yMax = (std::min)(static_cast<int32_t>(floor((std::max)((std::max)(a.y, b.y), c.y) - 0.5f)), m_iRowMax);
+	const auto yBegin = (std::max)(yMin, m_iRowMin);
+	if (xMin > xMax || yBegin > yMax) return;
+
+	// Edge functions, each positive inside and equal to the area at the opposite vertex.
+	// A point exactly on an edge belongs to the triangle for only one direction of the
+	// edge, so shared edges are never peeled twice. The setup is at the top of the whole
+	// k-buffer, so the depths do not depend on the row band.
+	struct Edge
+	{
+		float dx, dy, e0;
+		bool bInclusive;
+	};
+
+	const auto setup = [xMin, yMin](const float3 &p, const float3 &q)
+	{
+		Edge edge;
+		edge.dx = q.x - p.x;
+		edge.dy = q.y - p.y;
+		edge.e0 = edge.dx * (yMin + 0.5f - p.y) - edge.dy * (xMin + 0.5f - p.x);
+		edge.bInclusive = edge.dy > 0.0f || (edge.dy == 0.0f && edge.dx < 0.0f);
+
+		return edge;
+	};
+
+	const Edge edges[] = { setup(b, c), setup(c, a), setup(a, b) };
+	const auto fAreaInv = 1.0f / fArea;
+
+	for (auto y = yBegin; y <= yMax; ++y)
+	{
+		const auto fRow = static_cast<float>(y - yMin);
+		float e[3];
+		for (auto k = 0u; k < 3; ++k) e[k] = edges[k].e0 + edges[k].dx * fRow;
+
+		for (auto x = xMin; x <= xMax; ++x)
+		{
+			auto bInside = true;
+			for (auto k = 0u; k < 3; ++k)
+				bInside = bInside && (e[k] > 0.0f || (e[k] == 0.0f && edges[k].bInclusive));
+
+			if (bInside)
+			{
+				// Screen-space depth is affine in the barycentrics
+				const auto fDepth = (e[0] * a.z + e[1] * b.z + e[2] * c.z) * fAreaInv;
+				kBuffer.Insert(x, y, fDepth);
+			}
+
+			for (auto k = 0u; k < 3; ++k) e[k] -= edges[k].dy;
+		}
+	}
+}
@@ -0,0 +1,50 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SVXMesh.h"
+#include "SVXKBuffer.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Software depth peeling. Follows the D3D11 conventions of the GPU path: pixel-center
+	// sampling, near/far depth clipping, no face culling, and a consistent tie-breaking
+	// rule so that pixels on a shared edge are peeled exactly once. The meshlets of the
+	// mesh outside the view frustum are neither transformed nor scanned, and a band only
+	// scans those overlapping its rows.
+	//--------------------------------------------------------------------------------------
+	class Rasterizer
+	{
+	public:
+		Rasterizer();
+		virtual ~Rasterizer();
+
+		// Only the rows in [uRowBegin, uRowEnd) are written, so threads may peel disjoint
+		// bands of one k-buffer with a rasterizer each
+		void DepthPeel(const Mesh &mesh, const float4x4 &mWorldViewProj, KBuffer &kBuffer,
+			const uint32_t uRowBegin = 0, const uint32_t uRowEnd = UINT32_MAX);
+
+		// Same, from clip-space positions transformed once for all the bands of a view
+		void DepthPeel(const Mesh &mesh, const float4 *pClipPos, KBuffer &kBuffer,
+			const uint32_t uRowBegin = 0, const uint32_t uRowEnd = UINT32_MAX);
+
+		// Clip-space positions of the meshlet vertices, followed by the NDC y range of each
+		// meshlet, which is empty for a meshlet culled by the view frustum; returns the
+		// meshlets left
+		static uint32_t TransformVertices(const Mesh &mesh, const float4x4 &mWorldViewProj, float4 *pClipPos);
+		static uint32_t GetNumClipPos(const Mesh &mesh);
+
+	protected:
+		void rasterize(const float4 &v0, const float4 &v1, const float4 &v2, KBuffer &kBuffer) const;
+
+		std::vector<float4>	m_vClipPos;		// Scratch, reused across frames
+		int32_t				m_iRowMin;
+		int32_t				m_iRowMax;
+	};
+
+	using upRasterizer = std::unique_ptr<Rasterizer>;
+	using spRasterizer = std::shared_ptr<Rasterizer>;
+}
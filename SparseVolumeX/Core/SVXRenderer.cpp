@@ -0,0 +1,159 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <chrono>
+#include "SVXRenderer.h"
+
+using namespace std;
+using namespace SVX;
+
+static double elapsedMs(const chrono::high_resolution_clock::time_point &tStart)
+{
+	return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - tStart).count();
+}
+
+Renderer::Renderer() :
+	m_state(),
+	m_backend(1),
+	m_bLightsValid(false),
+	m_frameGraph(),
+	m_timings(),
+	m_pProfiler(nullptr)
+{
+	// Default light of the GPU path
+	m_state.vLights.push_back({ float3(10.0f, 45.0f, 75.0f), float3(1.0f) });
+}
+
+Renderer::~Renderer()
+{
+}
+
+void Renderer::Init(const spMesh &pMesh, const uint32_t uWidth, const uint32_t uHeight,
+	const uint32_t uNumLayers, const uint32_t uLightMapSize, const spKBuffer &pKBuffer)
+{
+	m_state.vCenter = pMesh->GetCenter();
+	m_state.fRadius = pMesh->GetRadius();
+	m_state.uWidth = uWidth;
+	m_state.uHeight = uHeight;
+	m_state.uNumLayers = uNumLayers;
+	m_state.uLightMapSize = uLightMapSize;
+	m_state.FitLightsToObject();
+
+	m_backend.SetMesh(pMesh);
+	m_backend.SetKBuffer(pKBuffer);
+	m_backend.CreateKBuffers(m_state);
+	m_bLightsValid = false;
+}
+
+void Renderer::SetLights(const vector<Light> &vLights, const spLightField &pLightField)
+{
+	m_state.vLights = vLights;
+	m_state.FitLightsToObject();
+	m_backend.SetLightField(pLightField);
+	m_bLightsValid = pLightField != nullptr;
+}
+
+void Renderer::Render(const Camera &camera, vector<uint8_t> &vRGB)
+{
+	const auto tStart = chrono::high_resolution_clock::now();
+	const auto fAspect = static_cast<float>(m_state.uWidth) / m_state.uHeight;
+	m_state.fZNear = camera.fZNear;
+	m_state.fZFar = camera.fZFar;
+	m_state.SetCamera(mul(MatrixLookAtLH(camera.vEye, camera.vAt, camera.vUp),
+		MatrixPerspectiveFovLH(camera.fFovY, fAspect, camera.fZNear, camera.fZFar)));
+	m_backend.UpdateFrame(m_state);
+
+	// Light-space k-buffers only if not peeled yet, then the view-space k-buffer and the
+	// integration, as one graph
+	m_backend.SetTarget(&vRGB);
+	m_frameGraph.Reset();
+	m_backend.BuildFrame(m_frameGraph, m_state, !m_bLightsValid);
+	m_frameGraph.Compile();
+	m_frameGraph.Execute(m_backend.GetScheduler(), m_pProfiler);
+	m_backend.SetTarget(nullptr);
+	m_bLightsValid = true;
+
+	m_timings.fLightPeel = m_frameGraph.GetSpan({ "vertexTransformLightSpace", "depthPeelLightSpace", "thicknessPrefix" });
+	m_timings.fPeel = m_frameGraph.GetSpan({ "vertexTransform", "depthPeel", "resampleSolid" });
+	m_timings.fIntegrate = m_frameGraph.GetSpan({ "integrate" });
+	m_timings.fFrame = elapsedMs(tStart);
+}
+
+void Renderer::SetSolid(const spSolid &pSolid)
+{
+	m_backend.SetSolid(pSolid);
+}
+
+void Renderer::SetProfiler(Profiler *pProfiler)
+{
+	m_pProfiler = pProfiler;
+}
+
+void Renderer::SetNumThreads(const uint32_t uNumThreads)
+{
+	m_backend.SetNumThreads(uNumThreads);
+}
+
+void Renderer::SetRetainKBuffer(const bool bRetainKBuffer)
+{
+	m_backend.SetRetainKBuffer(bRetainKBuffer);
+}
+
+void Renderer::SetLODTolerance(const float fTolerance)
+{
+	m_backend.SetLODTolerance(fTolerance);
+}
+
+void Renderer::SetDistanceField(const spDistanceField &pDistanceField)
+{
+	// Back to peeling, the light field is only valid if one was peeled or shared before
+	m_backend.SetDistanceField(pDistanceField);
+	if (!pDistanceField) m_bLightsValid = m_bLightsValid && m_backend.GetLightField() != nullptr;
+}
+
+void Renderer::SetTransmission(const CPUBackend::Evaluator eEvaluator)
+{
+	m_backend.SetTransmission(eEvaluator);
+}
+
+const Renderer::Timings &Renderer::GetTimings() const
+{
+	return m_timings;
+}
+
+const KBuffer &Renderer::GetKBuffer() const
+{
+	return *m_backend.GetKBuffer();
+}
+
+const spLightField &Renderer::GetLightField() const
+{
+	return m_backend.GetLightField();
+}
+
+size_t Renderer::GetLightCacheBytes() const
+{
+	const auto &pLightField = m_backend.GetLightField();
+
+	return pLightField ? pLightField->GetBytes() : 0;
+}
+
+size_t Renderer::GetFrameArenaBytes() const
+{
+	return m_frameGraph.GetArenaBytes();
+}
+
+uint64_t Renderer::GetNumFrameAllocations() const
+{
+	const auto pScheduler = m_backend.GetScheduler();
+
+	return m_frameGraph.GetNumArenaAllocations() + (pScheduler ? pScheduler->GetNumAllocations() : 0);
+}
+
+void Renderer::TrackMemory(MemoryTracker &memoryTracker, const char *pszAsset) const
+{
+	m_backend.TrackMemory(memoryTracker, pszAsset);
+	memoryTracker.Allocate(pszAsset, "frameHeap", MemoryTracker::CATEGORY_K_BUFFER, m_frameGraph.GetHeapBytes());
+	memoryTracker.Allocate(pszAsset, "frameArena", MemoryTracker::CATEGORY_K_BUFFER, m_frameGraph.GetArenaBytes());
+}
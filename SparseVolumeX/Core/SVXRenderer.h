@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SVXCPUBackend.h"
+
+namespace SVX
+{
+	struct Camera
+	{
+		float3	vEye;
+		float3	vAt;
+		float3	vUp;
+		float	fFovY;
+		float	fZNear;
+		float	fZFar;
+
+		Camera() : vEye(-8.0f, 12.0f, 14.0f), vAt(0.0f, 4.0f, 0.0f), vUp(0.0f, 1.0f, 0.0f),
+			fFovY(0.785398163f), fZNear(1.0f), fZFar(1000.0f) {}
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Headless renderer of camera paths over the CPU backend. The lights are framed on
+	// the whole object rather than on camera cascades, so the light-space k-buffers depend
+	// only on the mesh and the lights and stay warm across frames until SetLights().
+	//--------------------------------------------------------------------------------------
+	class Renderer
+	{
+	public:
+		struct Timings
+		{
+			double	fLightPeel;		// Milliseconds, 0 when the light-space k-buffers were reused
+			double	fPeel;
+			double	fIntegrate;
+			double	fFrame;			// The stages above overlap, so not their sum
+		};
+
+		Renderer();
+		virtual ~Renderer();
+
+		void Init(const spMesh &pMesh, const uint32_t uWidth, const uint32_t uHeight,
+			const uint32_t uNumLayers = 16, const uint32_t uLightMapSize = 512,
+			const spKBuffer &pKBuffer = nullptr);
+
+		// A light field peeled earlier for the same mesh and lights skips the light peeling
+		void SetLights(const std::vector<Light> &vLights, const spLightField &pLightField = nullptr);
+
+		// Outputs 8-bit RGB with the same sqrt encoding as the swap chain of the GPU path
+		void Render(const Camera &camera, std::vector<uint8_t> &vRGB);
+
+		// Resamples the view k-buffer from a solid representation of the mesh, e.g. layered
+		// depth images or a voxel octree, instead of peeling it; null to peel
+		void SetSolid(const spSolid &pSolid);
+
+		// Records the stages on the CPU track of the profiler; null to disable
+		void SetProfiler(Profiler *pProfiler);
+
+		// Worker threads of the passes, 0 for one per hardware thread
+		void SetNumThreads(const uint32_t uNumThreads);
+
+		// Without a retained k-buffer the view is peeled into aliased transient bands
+		// just ahead of their integration, and GetKBuffer() is not available
+		void SetRetainKBuffer(const bool bRetainKBuffer);
+
+		// Error in pixels of the level of detail of the mesh peeled for the view, 0 (the
+		// default) for the full mesh; see Mesh::BuildLODs()
+		void SetLODTolerance(const float fTolerance);
+
+		// Sphere-traces the light-path thicknesses in a distance field of the mesh instead
+		// of peeling the light views, which then cost nothing; null (the default) to peel
+		void SetDistanceField(const spDistanceField &pDistanceField);
+
+		// Evaluator of the transmission in the integration, exact (the default), polynomial
+		// or LUT; see SVXTransmission.h
+		void SetTransmission(const CPUBackend::Evaluator eEvaluator);
+
+		const Timings &GetTimings() const;
+		const KBuffer &GetKBuffer() const;
+		const spLightField &GetLightField() const;
+		size_t GetLightCacheBytes() const;
+		size_t GetFrameArenaBytes() const;	// Scratch of the frame graph
+
+		// Heap allocations of the frame arena and of the tasks of the scheduler since Init(),
+		// which stop growing once both cover a frame
+		uint64_t GetNumFrameAllocations() const;
+
+		// Accounts the mesh, the view k-buffer, the light field and the transient heap and
+		// the arena of the frame graph under the asset name
+		void TrackMemory(MemoryTracker &memoryTracker, const char *pszAsset) const;
+
+	protected:
+		VolumeState					m_state;
+		CPUBackend					m_backend;
+		bool						m_bLightsValid;
+		FrameGraph					m_frameGraph;
+
+		Timings						m_timings;
+		Profiler					*m_pProfiler;
+	};
+
+	using upRenderer = std::unique_ptr<Renderer>;
+	using spRenderer = std::shared_ptr<Renderer>;
+}
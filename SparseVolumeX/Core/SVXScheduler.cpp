@@ -0,0 +1,614 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include "SVXScheduler.h"
+
+using namespace std;
+using namespace SVX;
+
+// Scheduler and slot of the calling thread, if it is a worker or the host of one
+struct CurrentSlot
+{
+	const Scheduler	*pScheduler;
+	int32_t			iSlot;
+};
+
+static thread_local CurrentSlot g_currentSlot = { nullptr, -1 };
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Finished tasks, kept with the capacity of their successors, and the freed control
+	// blocks of their shared pointers, which all have the same size. Every task returned
+	// to the pool is grown to the largest capacity of successors seen, so that whichever
+	// task comes next to take a wide fan-out does not allocate again.
+	//--------------------------------------------------------------------------------------
+	class TaskPool
+	{
+	public:
+		template<typename T>
+		class Allocator
+		{
+		public:
+			using value_type = T;
+
+			Allocator(const shared_ptr<TaskPool> &pPool) : m_pPool(pPool) {}
+			template<typename U>
+			Allocator(const Allocator<U> &allocator) : m_pPool(allocator.GetPool()) {}
+
+			T *allocate(const size_t n) { return static_cast<T*>(m_pPool->allocateBlock(sizeof(T) * n)); }
+			void deallocate(T *p, const size_t n) { m_pPool->deallocateBlock(p, sizeof(T) * n); }
+
+			const shared_ptr<TaskPool> &GetPool() const { return m_pPool; }
+
+			template<typename U>
+			bool operator==(const Allocator<U> &allocator) const { return m_pPool == allocator.GetPool(); }
+			template<typename U>
+			bool operator!=(const Allocator<U> &allocator) const { return m_pPool != allocator.GetPool(); }
+
+		protected:
+			shared_ptr<TaskPool> m_pPool;
+		};
+
+		// Deleter of the shared pointers, returning the task to the pool
+		struct Recycler
+		{
+			shared_ptr<TaskPool> pPool;
+
+			void operator()(Task *pTask) const
+			{
+				pTask->m_function = nullptr;
+				pTask->m_pException = nullptr;
+				pTask->m_vSuccessors.clear();
+
+				lock_guard<mutex> lock(pPool->m_mutex);
+				auto &uNumSuccessors = pPool->m_uNumSuccessors;
+				uNumSuccessors = (std::max)(uNumSuccessors, pTask->m_vSuccessors.capacity());
+				if (pTask->m_vSuccessors.capacity() < uNumSuccessors)
+				{
+					pTask->m_vSuccessors.reserve(uNumSuccessors);
+					++pPool->m_uNumAllocations;
+				}
+				pPool->m_vTasks.push_back(pTask);
+			}
+		};
+
+		TaskPool() : m_vTasks(0), m_vBlocks(0), m_uBlockBytes(0), m_uNumSuccessors(0), m_uNumAllocations(0) {}
+
+		~TaskPool()
+		{
+			for (const auto &pTask : m_vTasks) delete pTask;
+			for (const auto &pBlock : m_vBlocks) ::operator delete(pBlock);
+		}
+
+		Task *AcquireTask()
+		{
+			lock_guard<mutex> lock(m_mutex);
+			if (m_vTasks.empty()) return nullptr;
+
+			const auto pTask = m_vTasks.back();
+			m_vTasks.pop_back();
+
+			return pTask;
+		}
+
+		// Heap allocation of a task or of the successors of one outside the pool
+		void CountAllocation()
+		{
+			++m_uNumAllocations;
+		}
+
+		uint64_t GetNumAllocations() const
+		{
+			return m_uNumAllocations;
+		}
+
+	protected:
+		void *allocateBlock(const size_t uBytes)
+		{
+			{
+				lock_guard<mutex> lock(m_mutex);
+				if (!m_uBlockBytes) m_uBlockBytes = uBytes;
+				if (uBytes == m_uBlockBytes && !m_vBlocks.empty())
+				{
+					const auto pBlock = m_vBlocks.back();
+					m_vBlocks.pop_back();
+
+					return pBlock;
+				}
+			}
+
+			++m_uNumAllocations;
+
+			return ::operator new(uBytes);
+		}
+
+		void deallocateBlock(void *pBlock, const size_t uBytes)
+		{
+			{
+				lock_guard<mutex> lock(m_mutex);
+				if (uBytes == m_uBlockBytes)
+				{
+					m_vBlocks.push_back(pBlock);
+					return;
+				}
+			}
+
+			::operator delete(pBlock);
+		}
+
+		mutex			m_mutex;
+		vector<Task*>	m_vTasks;
+		vector<void*>	m_vBlocks;
+		size_t			m_uBlockBytes;
+		size_t			m_uNumSuccessors;	// Largest capacity of the successors of a task
+
+		atomic<uint64_t>	m_uNumAllocations;
+	};
+}
+
+Task::Task(const function<void()> &function, const uint32_t uNumDependencies) :
+	m_function(function),
+	m_uNumDependencies(uNumDependencies),
+	m_bDone(false),
+	m_pException(nullptr),
+	m_vSuccessors(0)
+{
+}
+
+Task::~Task()
+{
+}
+
+bool Task::IsDone() const
+{
+	return m_bDone;
+}
+
+void Task::reset(const function<void()> &function, const uint32_t uNumDependencies)
+{
+	m_function = function;
+	m_uNumDependencies = uNumDependencies;
+	m_bDone = false;
+}
+
+//--------------------------------------------------------------------------------------
+// Task ring
+//--------------------------------------------------------------------------------------
+
+Scheduler::TaskRing::TaskRing() :
+	m_vTasks(0),
+	m_uFront(0),
+	m_uNumTasks(0),
+	m_uNumAllocations(0)
+{
+}
+
+bool Scheduler::TaskRing::Empty() const
+{
+	return m_uNumTasks == 0;
+}
+
+void Scheduler::TaskRing::PushBack(const spTask &pTask)
+{
+	// Doubles, unrolling the ring from its front
+	if (m_uNumTasks == m_vTasks.size())
+	{
+		vector<spTask> vTasks((std::max)(m_vTasks.size() * 2, size_t(16)));
+		for (auto i = 0u; i < m_uNumTasks; ++i) vTasks[i] = move(m_vTasks[(m_uFront + i) % m_vTasks.size()]);
+		m_vTasks.swap(vTasks);
+		m_uFront = 0;
+		++m_uNumAllocations;
+	}
+
+	m_vTasks[(m_uFront + m_uNumTasks++) % m_vTasks.size()] = pTask;
+}
+
+spTask Scheduler::TaskRing::PopBack()
+{
+	assert(m_uNumTasks > 0);
+
+	return move(m_vTasks[(m_uFront + --m_uNumTasks) % m_vTasks.size()]);
+}
+
+uint64_t Scheduler::TaskRing::GetNumAllocations() const
+{
+	return m_uNumAllocations;
+}
+
+spTask Scheduler::TaskRing::PopFront()
+{
+	assert(m_uNumTasks > 0);
+	auto pTask = move(m_vTasks[m_uFront]);
+	m_uFront = (m_uFront + 1) % m_vTasks.size();
+	--m_uNumTasks;
+
+	return pTask;
+}
+
+//--------------------------------------------------------------------------------------
+// Scheduler
+//--------------------------------------------------------------------------------------
+
+Scheduler::Scheduler(const uint32_t uNumThreads) :
+	m_pTaskPool(make_shared<TaskPool>()),
+	m_vSlots(uNumThreads > 0 ? uNumThreads : (std::max)(thread::hardware_concurrency(), 1u)),
+	m_vWorkers(0),
+	m_uNextSlot(0),
+	m_iNumQueued(0),
+	m_uNumWaiters(0),
+	m_bQuit(false)
+{
+	for (auto &pSlot : m_vSlots)
+	{
+		pSlot = make_unique<Slot>();
+		pSlot->uTasks = 0;
+		pSlot->uSteals = 0;
+	}
+
+	// Slot 0 is left to the host
+	const auto uNumSlots = static_cast<uint32_t>(m_vSlots.size());
+	m_vWorkers.reserve(uNumSlots - 1);
+	for (auto i = 1u; i < uNumSlots; ++i) m_vWorkers.emplace_back(&Scheduler::worker, this, i);
+}
+
+Scheduler::~Scheduler()
+{
+	{
+		lock_guard<mutex> lock(m_mutexWake);
+		m_bQuit = true;
+	}
+	m_cvWake.notify_all();
+	for (auto &worker : m_vWorkers) worker.join();
+}
+
+spTask Scheduler::Run(const function<void()> &function, const vector<spTask> &vDependencies)
+{
+	const auto pTask = createTask(function, static_cast<uint32_t>(vDependencies.size()) + 1);
+
+	for (const auto &pDependency : vDependencies)
+	{
+		exception_ptr pException;
+		{
+			lock_guard<mutex> lock(pDependency->m_mutex);
+			if (!pDependency->m_bDone)
+			{
+				auto &vSuccessors = pDependency->m_vSuccessors;
+				if (vSuccessors.size() == vSuccessors.capacity()) m_pTaskPool->CountAllocation();
+				vSuccessors.push_back(pTask);
+				continue;
+			}
+			pException = pDependency->m_pException;
+		}
+		release(pTask, pException);
+	}
+	release(pTask, nullptr);
+
+	return pTask;
+}
+
+spTask Scheduler::Then(const spTask &pTask, const function<void()> &continuation)
+{
+	return Run(continuation, { pTask });
+}
+
+spTask Scheduler::WhenAll(const vector<spTask> &vTasks)
+{
+	return Run(nullptr, vTasks);
+}
+
+void Scheduler::Wait(const spTask &pTask)
+{
+	helpUntil([&pTask]() { return pTask->IsDone(); });
+
+	lock_guard<mutex> lock(pTask->m_mutex);
+	if (pTask->m_pException) rethrow_exception(pTask->m_pException);
+}
+
+void Scheduler::ParallelFor(const uint32_t uBegin, const uint32_t uEnd, const uint32_t uGrain,
+	const function<void(uint32_t, uint32_t, uint32_t)> &body)
+{
+	if (uEnd <= uBegin) return;
+
+	const auto uMinGrain = (std::max)(uGrain, 1u);
+	const auto iSlot = currentSlot();
+	if (iSlot >= 0 && uEnd - uBegin <= uMinGrain)
+	{
+		body(uBegin, uEnd, iSlot);
+		return;
+	}
+
+	// Each range keeps its lower half and pushes the upper half, which idle threads steal
+	// whole; the first body exception is rethrown once every range has finished. The
+	// tasks only capture the loop, so that their functions need no heap storage.
+	struct Loop
+	{
+		Scheduler									*pScheduler;
+		const function<void(uint32_t, uint32_t, uint32_t)>	*pBody;
+		uint32_t									uMinGrain;
+		atomic<uint32_t>							uRemaining;
+		exception_ptr								pException;
+		mutex										mutexException;
+
+		void Split(uint32_t uRangeBegin, uint32_t uRangeEnd)
+		{
+			while (uRangeEnd - uRangeBegin > uMinGrain)
+			{
+				const auto uMid = uRangeBegin + (uRangeEnd - uRangeBegin) / 2;
+				const auto pLoop = this;
+				pScheduler->push(pScheduler->createTask([pLoop, uMid, uRangeEnd]() { pLoop->Split(uMid, uRangeEnd); }, 0));
+				uRangeEnd = uMid;
+			}
+
+			try
+			{
+				(*pBody)(uRangeBegin, uRangeEnd, pScheduler->currentSlot());
+			}
+			catch (...)
+			{
+				lock_guard<mutex> lock(mutexException);
+				if (!pException) pException = current_exception();
+			}
+
+			// Once the count drops to 0 the loop may return, so nothing captured is touched after
+			const auto pLoopScheduler = pScheduler;
+			if ((uRemaining -= uRangeEnd - uRangeBegin) == 0) pLoopScheduler->notifyDone();
+		}
+	};
+
+	Loop loop;
+	loop.pScheduler = this;
+	loop.pBody = &body;
+	loop.uMinGrain = uMinGrain;
+	loop.uRemaining = uEnd - uBegin;
+	const auto pLoop = &loop;
+	push(createTask([pLoop, uBegin, uEnd]() { pLoop->Split(uBegin, uEnd); }, 0));
+	helpUntil([pLoop]() { return pLoop->uRemaining == 0; });
+
+	if (loop.pException) rethrow_exception(loop.pException);
+}
+
+uint32_t Scheduler::GetNumThreads() const
+{
+	return static_cast<uint32_t>(m_vSlots.size());
+}
+
+uint32_t Scheduler::GetCurrentThread() const
+{
+	const auto iSlot = currentSlot();
+	assert(iSlot >= 0);
+
+	return static_cast<uint32_t>(iSlot);
+}
+
+Scheduler::Stats Scheduler::GetStats(const uint32_t uThread) const
+{
+	const auto &slot = *m_vSlots[uThread];
+
+	return Stats{ slot.uTasks, slot.uSteals };
+}
+
+void Scheduler::ResetStats()
+{
+	for (auto &pSlot : m_vSlots)
+	{
+		pSlot->uTasks = 0;
+		pSlot->uSteals = 0;
+	}
+}
+
+uint64_t Scheduler::GetNumAllocations() const
+{
+	auto uNumAllocations = m_pTaskPool->GetNumAllocations();
+	for (const auto &pSlot : m_vSlots)
+	{
+		lock_guard<mutex> lock(pSlot->mutex);
+		uNumAllocations += pSlot->tasks.GetNumAllocations();
+	}
+
+	return uNumAllocations;
+}
+
+Scheduler &Scheduler::GetDefault()
+{
+	// Never destroyed, so no worker is joined during static destruction
+	static const auto pScheduler = new Scheduler();
+
+	return *pScheduler;
+}
+
+spTask Scheduler::createTask(const function<void()> &function, const uint32_t uNumDependencies)
+{
+	auto pTask = m_pTaskPool->AcquireTask();
+	if (pTask) pTask->reset(function, uNumDependencies);
+	else
+	{
+		pTask = new Task(function, uNumDependencies);
+		m_pTaskPool->CountAllocation();
+	}
+
+	return spTask(pTask, TaskPool::Recycler{ m_pTaskPool }, TaskPool::Allocator<Task>(m_pTaskPool));
+}
+
+void Scheduler::worker(const uint32_t uSlot)
+{
+	g_currentSlot = { this, static_cast<int32_t>(uSlot) };
+
+	while (true)
+	{
+		const auto pTask = acquire(uSlot);
+		if (pTask)
+		{
+			execute(pTask);
+			continue;
+		}
+
+		unique_lock<mutex> lock(m_mutexWake);
+		m_cvWake.wait(lock, [this]() { return m_iNumQueued > 0 || m_bQuit; });
+		if (m_bQuit && m_iNumQueued <= 0) break;
+	}
+}
+
+void Scheduler::push(const spTask &pTask)
+{
+	// Own deque of a scheduler thread, otherwise round robin
+	const auto iSlot = currentSlot();
+	const auto uSlot = iSlot >= 0 ? iSlot : m_uNextSlot++ % GetNumThreads();
+	{
+		auto &slot = *m_vSlots[uSlot];
+		lock_guard<mutex> lock(slot.mutex);
+		slot.tasks.PushBack(pTask);
+	}
+
+	// A waiter of helpUntil() may take the single notification, and one from outside cannot
+	// run the task, so all are woken while any waits
+	auto bWaiters = false;
+	{
+		lock_guard<mutex> lock(m_mutexWake);
+		++m_iNumQueued;
+		bWaiters = m_uNumWaiters > 0;
+	}
+	if (bWaiters) m_cvWake.notify_all();
+	else m_cvWake.notify_one();
+}
+
+spTask Scheduler::acquire(const uint32_t uSlot)
+{
+	spTask pTask;
+
+	// Newest task of the own deque
+	auto &slot = *m_vSlots[uSlot];
+	{
+		lock_guard<mutex> lock(slot.mutex);
+		if (!slot.tasks.Empty()) pTask = slot.tasks.PopBack();
+	}
+
+	// Otherwise the oldest task of another deque
+	const auto uNumSlots = GetNumThreads();
+	for (auto i = 1u; !pTask && i < uNumSlots; ++i)
+	{
+		auto &victim = *m_vSlots[(uSlot + i) % uNumSlots];
+		lock_guard<mutex> lock(victim.mutex);
+		if (!victim.tasks.Empty())
+		{
+			pTask = victim.tasks.PopFront();
+			++slot.uSteals;
+		}
+	}
+
+	if (pTask)
+	{
+		--m_iNumQueued;
+		++slot.uTasks;
+	}
+
+	return pTask;
+}
+
+void Scheduler::execute(const spTask &pTask)
+{
+	// Tasks after a failed dependency are skipped
+	if (!pTask->m_pException && pTask->m_function)
+	{
+		try
+		{
+			pTask->m_function();
+		}
+		catch (...)
+		{
+			lock_guard<mutex> lock(pTask->m_mutex);
+			pTask->m_pException = current_exception();
+		}
+	}
+
+	complete(pTask);
+}
+
+void Scheduler::complete(const spTask &pTask)
+{
+	exception_ptr pException;
+	{
+		lock_guard<mutex> lock(pTask->m_mutex);
+		pTask->m_bDone = true;
+		pException = pTask->m_pException;
+	}
+	pTask->m_function = nullptr;
+
+	// No successor is added once the task is done, so they are released outside the lock,
+	// and cleared in place to keep their capacity for the next use of the task
+	for (const auto &pSuccessor : pTask->m_vSuccessors) release(pSuccessor, pException);
+	pTask->m_vSuccessors.clear();
+	notifyDone();
+}
+
+void Scheduler::release(const spTask &pTask, const exception_ptr &pException)
+{
+	if (pException)
+	{
+		lock_guard<mutex> lock(pTask->m_mutex);
+		if (!pTask->m_pException) pTask->m_pException = pException;
+	}
+
+	if (--pTask->m_uNumDependencies == 0) push(pTask);
+}
+
+void Scheduler::notifyDone()
+{
+	if (m_uNumWaiters == 0) return;
+
+	{
+		lock_guard<mutex> lock(m_mutexWake);
+	}
+	m_cvWake.notify_all();
+}
+
+void Scheduler::helpUntil(const function<bool()> &isDone)
+{
+	// A thread from outside runs tasks as thread 0 while it holds the host slot; otherwise
+	// it sleeps and retries, since nothing else may run a task submitted to slot 0
+	auto iSlot = currentSlot();
+	auto bHost = false;
+	const auto previousSlot = g_currentSlot;
+
+	while (!isDone())
+	{
+		if (iSlot < 0 && m_mutexHost.try_lock())
+		{
+			bHost = true;
+			iSlot = 0;
+			g_currentSlot = { this, 0 };
+		}
+
+		if (iSlot >= 0)
+		{
+			const auto pTask = acquire(iSlot);
+			if (pTask)
+			{
+				execute(pTask);
+				continue;
+			}
+		}
+
+		unique_lock<mutex> lock(m_mutexWake);
+		++m_uNumWaiters;
+		const auto wake = [this, iSlot, &isDone]() { return isDone() || (iSlot >= 0 && m_iNumQueued > 0); };
+		if (iSlot >= 0) m_cvWake.wait(lock, wake);
+		else m_cvWake.wait_for(lock, chrono::milliseconds(1), wake);
+		--m_uNumWaiters;
+	}
+
+	if (bHost)
+	{
+		g_currentSlot = previousSlot;
+		m_mutexHost.unlock();
+	}
+}
+
+int32_t Scheduler::currentSlot() const
+{
+	return g_currentSlot.pScheduler == this ? g_currentSlot.iSlot : -1;
+}
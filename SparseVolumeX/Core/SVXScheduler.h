@@ -0,0 +1,153 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SVX
+{
+	class Scheduler;
+	class TaskPool;
+
+	//--------------------------------------------------------------------------------------
+	// Task of a Scheduler, run once the tasks it depends on are done. If one of them threw,
+	// the task is skipped and the exception is passed on to its successors and to Wait().
+	//--------------------------------------------------------------------------------------
+	class Task
+	{
+	public:
+		Task(const std::function<void()> &function, const uint32_t uNumDependencies);
+		virtual ~Task();
+
+		bool IsDone() const;
+
+	protected:
+		friend class Scheduler;
+		friend class TaskPool;
+
+		void reset(const std::function<void()> &function, const uint32_t uNumDependencies);
+
+		std::function<void()>				m_function;
+		std::atomic<uint32_t>				m_uNumDependencies;	// Pending, plus 1 until submitted
+		std::atomic<bool>					m_bDone;
+		std::exception_ptr					m_pException;
+		std::mutex							m_mutex;			// Guards the exception and successors
+		std::vector<std::shared_ptr<Task>>	m_vSuccessors;
+	};
+
+	using spTask = std::shared_ptr<Task>;
+
+	//--------------------------------------------------------------------------------------
+	// Work-stealing scheduler. Every thread owns a deque: it pushes and pops its own tasks
+	// at the back, newest first, and idle threads steal the oldest, i.e. the largest ranges
+	// of a parallel loop, from the front of the others. Thread 0 belongs to the thread
+	// calling Wait() or ParallelFor(), so a single-threaded scheduler runs everything there.
+	// Finished tasks are recycled, so that submitting them stops allocating once the pool
+	// covers the tasks in flight.
+	//--------------------------------------------------------------------------------------
+	class Scheduler
+	{
+	public:
+		struct Stats
+		{
+			uint64_t	uTasks;		// Tasks run
+			uint64_t	uSteals;	// Tasks taken from the deque of another thread
+		};
+
+		// 0 threads for one per hardware thread
+		Scheduler(const uint32_t uNumThreads = 0);
+		virtual ~Scheduler();
+
+		spTask Run(const std::function<void()> &function, const std::vector<spTask> &vDependencies = {});
+		spTask Then(const spTask &pTask, const std::function<void()> &continuation);
+		spTask WhenAll(const std::vector<spTask> &vTasks);
+
+		// Runs other tasks until pTask is done, and rethrows its exception
+		void Wait(const spTask &pTask);
+
+		// Runs body(uRangeBegin, uRangeEnd, uThread) over [uBegin, uEnd), halving the range
+		// down to uGrain items; uThread is unique among the bodies running at a time
+		void ParallelFor(const uint32_t uBegin, const uint32_t uEnd, const uint32_t uGrain,
+			const std::function<void(uint32_t, uint32_t, uint32_t)> &body);
+
+		uint32_t GetNumThreads() const;
+
+		// Thread of the calling task or loop body, unique among those running at a time
+		uint32_t GetCurrentThread() const;
+
+		Stats GetStats(const uint32_t uThread) const;
+		void ResetStats();
+
+		// Heap allocations of the tasks, their control blocks, successors and deques since
+		// the creation; constant once the pools cover the tasks in flight
+		uint64_t GetNumAllocations() const;
+
+		// Shared scheduler with one thread per hardware thread
+		static Scheduler &GetDefault();
+
+	protected:
+		// Deque of a slot as a ring that only grows, so that pushing and popping stop
+		// allocating once it has held the most tasks queued at once
+		class TaskRing
+		{
+		public:
+			TaskRing();
+
+			bool Empty() const;
+			void PushBack(const spTask &pTask);
+			spTask PopBack();
+			spTask PopFront();
+
+			uint64_t GetNumAllocations() const;
+
+		protected:
+			std::vector<spTask>	m_vTasks;
+			size_t				m_uFront;
+			size_t				m_uNumTasks;
+			uint64_t			m_uNumAllocations;
+		};
+
+		struct Slot
+		{
+			std::mutex				mutex;
+			TaskRing				tasks;
+			std::atomic<uint64_t>	uTasks;
+			std::atomic<uint64_t>	uSteals;
+		};
+
+		spTask createTask(const std::function<void()> &function, const uint32_t uNumDependencies);
+		void worker(const uint32_t uSlot);
+		void push(const spTask &pTask);
+		spTask acquire(const uint32_t uSlot);
+		void execute(const spTask &pTask);
+		void complete(const spTask &pTask);
+		void release(const spTask &pTask, const std::exception_ptr &pException);
+		void notifyDone();
+		void helpUntil(const std::function<bool()> &isDone);
+		int32_t currentSlot() const;
+
+		std::shared_ptr<TaskPool>			m_pTaskPool;	// Shared with the tasks, which may outlive the scheduler
+		std::vector<std::unique_ptr<Slot>>	m_vSlots;
+		std::vector<std::thread>			m_vWorkers;
+		std::atomic<uint32_t>				m_uNextSlot;	// Round robin of the submissions from outside
+		std::atomic<int32_t>				m_iNumQueued;
+		std::atomic<uint32_t>				m_uNumWaiters;
+		std::atomic<bool>					m_bQuit;
+
+		std::mutex							m_mutexHost;	// Owner of slot 0
+		std::mutex							m_mutexWake;
+		std::condition_variable				m_cvWake;
+	};
+
+	using upScheduler = std::unique_ptr<Scheduler>;
+	using spScheduler = std::shared_ptr<Scheduler>;
+}
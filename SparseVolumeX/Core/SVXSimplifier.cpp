@@ -0,0 +1,304 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "SVXSimplifier.h"
+
+using namespace std;
+using namespace SVX;
+
+void Simplifier::Quadric::AddPlane(const float3 &vNormal, const float fDist)
+{
+	const double n[] = { vNormal.x, vNormal.y, vNormal.z, fDist };
+	a[0] += n[0] * n[0];
+	a[1] += n[0] * n[1];
+	a[2] += n[0] * n[2];
+	a[3] += n[1] * n[1];
+	a[4] += n[1] * n[2];
+	a[5] += n[2] * n[2];
+	a[6] += n[0] * n[3];
+	a[7] += n[1] * n[3];
+	a[8] += n[2] * n[3];
+	a[9] += n[3] * n[3];
+}
+
+void Simplifier::Quadric::Add(const Quadric &quadric)
+{
+	for (auto i = 0u; i < 10; ++i) a[i] += quadric.a[i];
+}
+
+double Simplifier::Quadric::Evaluate(const float3 &vPos) const
+{
+	const double x = vPos.x, y = vPos.y, z = vPos.z;
+
+	return a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z + a[3] * y * y + 2.0 * a[4] * y * z +
+		a[5] * z * z + 2.0 * (a[6] * x + a[7] * y + a[8] * z) + a[9];
+}
+
+Simplifier::Simplifier(const float3 *pPositions, const uint32_t uNumVertices, const uint32_t *pIndices,
+	const uint32_t uNumIndices) :
+	m_vPositions(pPositions, pPositions + uNumVertices),
+	m_vIndices(pIndices, pIndices + uNumIndices),
+	m_vQuadrics(uNumVertices, Quadric{}),
+	m_vVertexTriangles(uNumVertices),
+	m_vVersions(uNumVertices, 0),
+	m_vVertexAlive(uNumVertices, true),
+	m_vTriangleAlive(uNumIndices / 3, true),
+	m_uNumTriangles(uNumIndices / 3),
+	m_fMaxCost(0.0)
+{
+	// Planes of the triangles; degenerate ones have none
+	vector<float3> vNormals(m_uNumTriangles, float3(0.0f));
+	for (auto t = 0u; t < m_uNumTriangles; ++t)
+	{
+		const auto pTriangle = &m_vIndices[t * 3];
+		const auto &v0 = m_vPositions[pTriangle[0]];
+		const auto vNormal = cross(m_vPositions[pTriangle[1]] - v0, m_vPositions[pTriangle[2]] - v0);
+		const auto fLength = length(vNormal);
+		for (auto j = 0u; j < 3; ++j) m_vVertexTriangles[pTriangle[j]].push_back(t);
+		if (fLength <= 0.0f) continue;
+
+		vNormals[t] = vNormal / fLength;
+		for (auto j = 0u; j < 3; ++j) m_vQuadrics[pTriangle[j]].AddPlane(vNormals[t], -dot(vNormals[t], v0));
+	}
+
+	// Every edge once, (v0, v1) with v0 < v1, counting its triangles to find the borders
+	vector<uint64_t> vEdges;
+	vEdges.reserve(m_vIndices.size());
+	for (auto t = 0u; t < m_uNumTriangles; ++t)
+		for (auto j = 0u; j < 3; ++j)
+		{
+			const auto v0 = m_vIndices[t * 3 + j], v1 = m_vIndices[t * 3 + (j + 1) % 3];
+			if (v0 == v1) continue;
+			vEdges.push_back(static_cast<uint64_t>((std::min)(v0, v1)) << 32 | (std::max)(v0, v1));
+		}
+	sort(vEdges.begin(), vEdges.end());
+
+	for (auto i = 0u; i < vEdges.size();)
+	{
+		auto j = i + 1;
+		while (j < vEdges.size() && vEdges[j] == vEdges[i]) ++j;
+		const auto v0 = static_cast<uint32_t>(vEdges[i] >> 32), v1 = static_cast<uint32_t>(vEdges[i]);
+
+		// The plane through a border edge perpendicular to its triangle
+		if (j - i == 1)
+			for (const auto t : m_vVertexTriangles[v0])
+			{
+				const auto pTriangle = &m_vIndices[t * 3];
+				if (pTriangle[0] != v1 && pTriangle[1] != v1 && pTriangle[2] != v1) continue;
+
+				const auto vBorder = cross(m_vPositions[v1] - m_vPositions[v0], vNormals[t]);
+				const auto fLength = length(vBorder);
+				if (fLength <= 0.0f) break;
+				const auto vNormal = vBorder / fLength;
+				m_vQuadrics[v0].AddPlane(vNormal, -dot(vNormal, m_vPositions[v0]));
+				m_vQuadrics[v1].AddPlane(vNormal, -dot(vNormal, m_vPositions[v0]));
+				break;
+			}
+		i = j;
+	}
+
+	for (auto i = 0u; i < vEdges.size(); ++i)
+		if (i == 0 || vEdges[i] != vEdges[i - 1])
+			pushEdge(static_cast<uint32_t>(vEdges[i] >> 32), static_cast<uint32_t>(vEdges[i]));
+}
+
+Simplifier::~Simplifier()
+{
+}
+
+uint32_t Simplifier::Collapse(const uint32_t uNumTriangles)
+{
+	while (m_uNumTriangles > uNumTriangles && !m_edges.empty())
+	{
+		const auto edge = m_edges.top();
+		m_edges.pop();
+
+		// Stale once either end has collapsed or changed its quadric
+		if (!m_vVertexAlive[edge.v0] || !m_vVertexAlive[edge.v1] ||
+			m_vVersions[edge.v0] != edge.uVersion0 || m_vVersions[edge.v1] != edge.uVersion1) continue;
+
+		float3 vPos;
+		const auto fCost = computeCollapse(edge.v0, edge.v1, vPos);
+		if (!canCollapse(edge.v0, edge.v1, vPos)) continue;
+
+		m_fMaxCost = (std::max)(m_fMaxCost, fCost);
+		collapse(edge.v0, edge.v1, vPos);
+	}
+
+	return m_uNumTriangles;
+}
+
+void Simplifier::Extract(vector<float3> &vPositions, vector<uint32_t> &vIndices) const
+{
+	vector<uint32_t> vRemap(m_vPositions.size(), UINT32_MAX);
+	for (auto t = 0u; t < m_vTriangleAlive.size(); ++t)
+		if (m_vTriangleAlive[t])
+			for (auto j = 0u; j < 3; ++j) vRemap[m_vIndices[t * 3 + j]] = 0;
+
+	vPositions.clear();
+	for (auto i = 0u; i < m_vPositions.size(); ++i)
+	{
+		if (vRemap[i] == UINT32_MAX) continue;
+		vRemap[i] = static_cast<uint32_t>(vPositions.size());
+		vPositions.push_back(m_vPositions[i]);
+	}
+
+	vIndices.clear();
+	for (auto t = 0u; t < m_vTriangleAlive.size(); ++t)
+		if (m_vTriangleAlive[t])
+			for (auto j = 0u; j < 3; ++j) vIndices.push_back(vRemap[m_vIndices[t * 3 + j]]);
+}
+
+uint32_t Simplifier::GetNumTriangles() const
+{
+	return m_uNumTriangles;
+}
+
+float Simplifier::GetError() const
+{
+	return static_cast<float>(sqrt(m_fMaxCost));
+}
+
+double Simplifier::computeCollapse(const uint32_t v0, const uint32_t v1, float3 &vPos) const
+{
+	auto quadric = m_vQuadrics[v0];
+	quadric.Add(m_vQuadrics[v1]);
+	const auto &a = quadric.a;
+
+	// The minimum of the quadric, solving A p = -b by Cramer's rule, if well conditioned
+	// and near the edge; otherwise the best of the ends and the midpoint
+	const auto &p0 = m_vPositions[v0], &p1 = m_vPositions[v1];
+	const auto vMid = (p0 + p1) * 0.5f;
+	vPos = vMid;
+	auto fCost = quadric.Evaluate(vMid);
+
+	const auto c0 = a[3] * a[5] - a[4] * a[4];
+	const auto c1 = a[2] * a[4] - a[1] * a[5];
+	const auto c2 = a[1] * a[4] - a[2] * a[3];
+	const auto fDet = a[0] * c0 + a[1] * c1 + a[2] * c2;
+	const auto fScale = a[0] + a[3] + a[5];
+	if (fabs(fDet) > 1e-6 * fScale * fScale * fScale)
+	{
+		const auto fDetInv = -1.0 / fDet;
+		const auto x = (c0 * a[6] + c1 * a[7] + c2 * a[8]) * fDetInv;
+		const auto y = (c1 * a[6] + (a[0] * a[5] - a[2] * a[2]) * a[7] + (a[1] * a[2] - a[0] * a[4]) * a[8]) * fDetInv;
+		const auto z = (c2 * a[6] + (a[1] * a[2] - a[0] * a[4]) * a[7] + (a[0] * a[3] - a[1] * a[1]) * a[8]) * fDetInv;
+		const auto vOptimal = float3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
+		const auto fOptimalCost = quadric.Evaluate(vOptimal);
+		if (length(vOptimal - vMid) <= length(p1 - p0) && fOptimalCost < fCost)
+		{
+			vPos = vOptimal;
+			fCost = fOptimalCost;
+		}
+	}
+
+	for (const auto &vEnd : { p0, p1 })
+	{
+		const auto fEndCost = quadric.Evaluate(vEnd);
+		if (fEndCost < fCost)
+		{
+			vPos = vEnd;
+			fCost = fEndCost;
+		}
+	}
+
+	return (std::max)(fCost, 0.0);
+}
+
+bool Simplifier::canCollapse(const uint32_t v0, const uint32_t v1, const float3 &vPos)
+{
+	// Link condition: the ends share no neighbors but the third vertices of the triangles
+	// on the edge, or the collapse would pinch the surface
+	auto uShared = 0u;
+	const uint32_t vEnds[] = { v0, v1 };
+	for (auto k = 0u; k < 2; ++k)
+	{
+		auto &vNeighbors = m_vNeighbors[k];
+		vNeighbors.clear();
+		for (const auto t : m_vVertexTriangles[vEnds[k]])
+		{
+			if (!m_vTriangleAlive[t]) continue;
+
+			const auto pTriangle = &m_vIndices[t * 3];
+			const auto bShared = pTriangle[0] == vEnds[1 - k] || pTriangle[1] == vEnds[1 - k] ||
+				pTriangle[2] == vEnds[1 - k];
+			if (k == 0 && bShared) ++uShared;
+			for (auto j = 0u; j < 3; ++j)
+				if (pTriangle[j] != v0 && pTriangle[j] != v1) vNeighbors.push_back(pTriangle[j]);
+
+			// No triangle may fold over about the moved vertex
+			if (bShared) continue;
+			const auto &p0 = m_vPositions[pTriangle[0]], &p1 = m_vPositions[pTriangle[1]], &p2 = m_vPositions[pTriangle[2]];
+			const auto vNormal = cross(p1 - p0, p2 - p0);
+			const auto &q0 = pTriangle[0] == vEnds[k] ? vPos : p0;
+			const auto &q1 = pTriangle[1] == vEnds[k] ? vPos : p1;
+			const auto &q2 = pTriangle[2] == vEnds[k] ? vPos : p2;
+			if (dot(vNormal, cross(q1 - q0, q2 - q0)) <= 0.0f && dot(vNormal, vNormal) > 0.0f) return false;
+		}
+		sort(vNeighbors.begin(), vNeighbors.end());
+		vNeighbors.erase(unique(vNeighbors.begin(), vNeighbors.end()), vNeighbors.end());
+	}
+	if (uShared == 0) return false;
+
+	auto uCommon = 0u;
+	for (auto i = 0u, j = 0u; i < m_vNeighbors[0].size() && j < m_vNeighbors[1].size();)
+	{
+		if (m_vNeighbors[0][i] < m_vNeighbors[1][j]) ++i;
+		else if (m_vNeighbors[1][j] < m_vNeighbors[0][i]) ++j;
+		else
+		{
+			++uCommon;
+			++i;
+			++j;
+		}
+	}
+
+	return uCommon == uShared;
+}
+
+void Simplifier::collapse(const uint32_t v0, const uint32_t v1, const float3 &vPos)
+{
+	// v1 merges into v0; the triangles on the edge vanish and the rest of v1 move over
+	auto &vTriangles = m_vVertexTriangles[v0];
+	for (const auto t : m_vVertexTriangles[v1])
+	{
+		if (!m_vTriangleAlive[t]) continue;
+
+		const auto pTriangle = &m_vIndices[t * 3];
+		if (pTriangle[0] == v0 || pTriangle[1] == v0 || pTriangle[2] == v0)
+		{
+			m_vTriangleAlive[t] = false;
+			--m_uNumTriangles;
+			continue;
+		}
+		for (auto j = 0u; j < 3; ++j)
+			if (pTriangle[j] == v1) pTriangle[j] = v0;
+		vTriangles.push_back(t);
+	}
+	vTriangles.erase(remove_if(vTriangles.begin(), vTriangles.end(),
+		[this](const uint32_t t) { return !m_vTriangleAlive[t]; }), vTriangles.end());
+	vector<uint32_t>().swap(m_vVertexTriangles[v1]);
+
+	m_vPositions[v0] = vPos;
+	m_vQuadrics[v0].Add(m_vQuadrics[v1]);
+	m_vVertexAlive[v1] = false;
+	++m_vVersions[v0];
+
+	// The edges of the merged vertex at their new costs
+	auto &vNeighbors = m_vNeighbors[0];
+	vNeighbors.clear();
+	for (const auto t : vTriangles)
+		for (auto j = 0u; j < 3; ++j)
+			if (m_vIndices[t * 3 + j] != v0) vNeighbors.push_back(m_vIndices[t * 3 + j]);
+	sort(vNeighbors.begin(), vNeighbors.end());
+	vNeighbors.erase(unique(vNeighbors.begin(), vNeighbors.end()), vNeighbors.end());
+	for (const auto v : vNeighbors) pushEdge(v0, v);
+}
+
+void Simplifier::pushEdge(const uint32_t v0, const uint32_t v1)
+{
+	float3 vPos;
+	m_edges.push(Edge{ computeCollapse(v0, v1, vPos), v0, v1, m_vVersions[v0], m_vVersions[v1] });
+}
@@ -0,0 +1,80 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <queue>
+#include <vector>
+#include "SVXMath.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Quadric error simplification of Garland and Heckbert: each vertex accumulates the
+	// squared distances to the planes of its triangles, and the edge whose collapse adds
+	// the least error is collapsed first, to the point minimizing the summed quadric.
+	// Border edges add planes perpendicular to their triangles, so that open borders are
+	// kept. Collapses that would fold a triangle over or pinch the surface into a
+	// nonmanifold are rejected. The quadrics carry over from collapse to collapse, so
+	// successive calls of Collapse() give a chain of levels, all measured from the source.
+	//--------------------------------------------------------------------------------------
+	class Simplifier
+	{
+	public:
+		Simplifier(const float3 *pPositions, const uint32_t uNumVertices, const uint32_t *pIndices,
+			const uint32_t uNumIndices);
+		virtual ~Simplifier();
+
+		// Collapses edges until at most uNumTriangles are left, or no edge can collapse;
+		// returns the triangles left
+		uint32_t Collapse(const uint32_t uNumTriangles);
+
+		// The current level, its triangles in source order and its vertices compacted
+		void Extract(std::vector<float3> &vPositions, std::vector<uint32_t> &vIndices) const;
+
+		uint32_t GetNumTriangles() const;
+
+		// Bound of the distance of the current level to the source planes, the root of
+		// the largest quadric error collapsed so far
+		float GetError() const;
+
+	protected:
+		struct Quadric
+		{
+			double a[10];	// xx, xy, xz, yy, yz, zz, x, y, z, 1 of the symmetric 4 x 4 form
+
+			void AddPlane(const float3 &vNormal, const float fDist);
+			void Add(const Quadric &quadric);
+			double Evaluate(const float3 &vPos) const;
+		};
+
+		struct Edge
+		{
+			double		fCost;
+			uint32_t	v0, v1;
+			uint32_t	uVersion0, uVersion1;
+
+			bool operator>(const Edge &edge) const { return fCost > edge.fCost; }
+		};
+
+		double computeCollapse(const uint32_t v0, const uint32_t v1, float3 &vPos) const;
+		bool canCollapse(const uint32_t v0, const uint32_t v1, const float3 &vPos);
+		void collapse(const uint32_t v0, const uint32_t v1, const float3 &vPos);
+		void pushEdge(const uint32_t v0, const uint32_t v1);
+
+		std::vector<float3>					m_vPositions;
+		std::vector<uint32_t>				m_vIndices;
+		std::vector<Quadric>				m_vQuadrics;
+		std::vector<std::vector<uint32_t>>	m_vVertexTriangles;	// Dead triangles are dropped lazily
+		std::vector<uint32_t>				m_vVersions;		// Bumped as the quadric of a vertex changes
+		std::vector<bool>					m_vVertexAlive;
+		std::vector<bool>					m_vTriangleAlive;
+		std::vector<uint32_t>				m_vNeighbors[2];	// Scratch of the link test
+
+		std::priority_queue<Edge, std::vector<Edge>, std::greater<Edge>> m_edges;
+
+		uint32_t							m_uNumTriangles;
+		double								m_fMaxCost;
+	};
+}
@@ -0,0 +1,104 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "SVXRasterizer.h"
+#include "SVXSolid.h"
+
+using namespace std;
+using namespace SVX;
+
+// Row bands per thread of the peels, as in the CPU backend
+static const uint32_t g_uBandsPerThread = 4;
+
+Solid::Solid() :
+	m_vCenter(0.0f),
+	m_fHalfSize(0.0f)
+{
+}
+
+Solid::~Solid()
+{
+}
+
+void Solid::Resample(const float4x4 &mViewProj, const float4x4 &mScreenToWorld, KBuffer &kBuffer,
+	const uint32_t uRowBegin, const uint32_t uRowEnd) const
+{
+	const auto uWidth = kBuffer.GetWidth();
+	const auto uNumLayers = kBuffer.GetNumLayers();
+	const auto yBegin = (std::max)(uRowBegin, kBuffer.GetRowBegin());
+	const auto yEnd = (std::min)(uRowEnd, kBuffer.GetRowEnd());
+
+	vector<float> vT(uNumLayers);
+	for (auto y = yBegin; y < yEnd; ++y)
+	{
+		for (auto x = 0u; x < uWidth; ++x)
+		{
+			float3 vOrigin, vDir;
+			getPixelRay(mScreenToWorld, x, y, vOrigin, vDir);
+			const auto uCount = CastRay(vOrigin, vDir, 0.0f, 1.0f, vT.data(), uNumLayers);
+			writeLayers(mViewProj, vOrigin, vDir, vT.data(), uCount, kBuffer.GetLayers(x, y), uNumLayers);
+		}
+	}
+}
+
+void Solid::getPixelRay(const float4x4 &mScreenToWorld, const uint32_t x, const uint32_t y,
+	float3 &vOrigin, float3 &vDir)
+{
+	// From the near to the far plane, so t is in [0, 1]
+	const auto fX = x + 0.5f, fY = y + 0.5f;
+	vOrigin = TransformCoord(float3(fX, fY, 0.0f), mScreenToWorld);
+	vDir = TransformCoord(float3(fX, fY, 1.0f), mScreenToWorld) - vOrigin;
+}
+
+void Solid::writeLayers(const float4x4 &mViewProj, const float3 &vOrigin, const float3 &vDir,
+	const float *pT, const uint32_t uCount, float *pLayers, const uint32_t uNumLayers)
+{
+	const auto fMaxDepth = nextafter(1.0f, 0.0f);
+	for (auto i = 0u; i < uCount; ++i)
+	{
+		const auto vPos = mul(float4(vOrigin + vDir * pT[i], 1.0f), mViewProj);
+		pLayers[i] = (std::min)((std::max)(vPos.z / vPos.w, 0.0f), fMaxDepth);
+	}
+	fill(pLayers + uCount, pLayers + uNumLayers, 1.0f);
+}
+
+void Solid::setBound(const Mesh &mesh)
+{
+	m_vCenter = mesh.GetCenter();
+	m_fHalfSize = mesh.GetRadius() * 1.01f;
+}
+
+float4x4 Solid::getViewProj(const uint32_t uAxis) const
+{
+	const auto u = (uAxis + 1) % 3, v = (uAxis + 2) % 3;
+	const auto fScale = 1.0f / m_fHalfSize;
+	auto mViewProj = float4x4{ { float4(0.0f, 0.0f, 0.0f, 0.0f), float4(0.0f, 0.0f, 0.0f, 0.0f),
+		float4(0.0f, 0.0f, 0.0f, 0.0f), float4(0.0f, 0.0f, 0.0f, 1.0f) } };
+	mViewProj.r[u].x = fScale;
+	mViewProj.r[v].y = fScale;
+	mViewProj.r[uAxis].z = 0.5f * fScale;
+	mViewProj.r[3].x = -m_vCenter[u] * fScale;
+	mViewProj.r[3].y = -m_vCenter[v] * fScale;
+	mViewProj.r[3].z = 0.5f - 0.5f * m_vCenter[uAxis] * fScale;
+
+	return mViewProj;
+}
+
+void Solid::peel(const Mesh &mesh, const uint32_t uAxis, KBuffer &kBuffer, Scheduler &scheduler) const
+{
+	vector<float4> vClipPos(Rasterizer::GetNumClipPos(mesh));
+	Rasterizer::TransformVertices(mesh, getViewProj(uAxis), vClipPos.data());
+
+	const auto uHeight = kBuffer.GetHeight();
+	const auto uNumThreads = scheduler.GetNumThreads();
+	const auto uNumBands = (std::min)(uNumThreads * g_uBandsPerThread, uHeight);
+	const auto uBandHeight = (uHeight + uNumBands - 1) / uNumBands;
+	vector<Rasterizer> vRasterizers(uNumThreads);
+	scheduler.ParallelFor(0, uNumBands, 1, [&](const uint32_t uBegin, const uint32_t uEnd, const uint32_t uThread)
+	{
+		for (auto i = uBegin; i < uEnd; ++i)
+			vRasterizers[uThread].DepthPeel(mesh, vClipPos.data(), kBuffer, i * uBandHeight, (i + 1) * uBandHeight);
+	});
+}
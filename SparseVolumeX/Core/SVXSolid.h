@@ -0,0 +1,63 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SVXKBuffer.h"
+#include "SVXMesh.h"
+#include "SVXScheduler.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Offline representation of the solid a mesh bounds, over its bounding cube, answering
+	// the entry and exit intervals of arbitrary rays. A view k-buffer is resampled from the
+	// rays through its pixel centers instead of rasterizing the mesh, so one representation
+	// serves every camera and light.
+	//--------------------------------------------------------------------------------------
+	class Solid
+	{
+	public:
+		Solid();
+		virtual ~Solid();
+
+		// Entries and exits of the solid along vOrigin + t * vDir for t in [fTMin, fTMax],
+		// ascending; returns the count written, even and at most uMaxValues
+		virtual uint32_t CastRay(const float3 &vOrigin, const float3 &vDir, const float fTMin, const float fTMax,
+			float *pT, const uint32_t uMaxValues) const = 0;
+
+		virtual size_t GetBytes() const = 0;
+
+		// Rows [uRowBegin, uRowEnd) of a view k-buffer, from the intervals along the rays
+		// through the pixel centers between the near and far planes
+		virtual void Resample(const float4x4 &mViewProj, const float4x4 &mScreenToWorld, KBuffer &kBuffer,
+			const uint32_t uRowBegin = 0, const uint32_t uRowEnd = UINT32_MAX) const;
+
+	protected:
+		// Ray of Resample() through the center of pixel (x, y)
+		static void getPixelRay(const float4x4 &mScreenToWorld, const uint32_t x, const uint32_t y,
+			float3 &vOrigin, float3 &vDir);
+
+		// The uCount values of t along a ray of Resample() as the depths of a pixel, the
+		// layers past them cleared
+		static void writeLayers(const float4x4 &mViewProj, const float3 &vOrigin, const float3 &vDir,
+			const float *pT, const uint32_t uCount, float *pLayers, const uint32_t uNumLayers);
+
+		// A margin keeps the surfaces on the bound off the clip planes
+		void setBound(const Mesh &mesh);
+
+		// Orthographic over the bounding cube: the next two axes map to x and y in [-1, 1],
+		// this one to depth in [0, 1]
+		float4x4 getViewProj(const uint32_t uAxis) const;
+
+		// Peels the k-buffer along an axis in row bands, each by the rasterizer of its thread
+		void peel(const Mesh &mesh, const uint32_t uAxis, KBuffer &kBuffer, Scheduler &scheduler) const;
+
+		float3	m_vCenter;
+		float	m_fHalfSize;	// Of the bounding cube
+	};
+
+	using upSolid = std::unique_ptr<Solid>;
+	using spSolid = std::shared_ptr<Solid>;
+}
@@ -0,0 +1,101 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Transmission evaluators: T = exp(-fSigma * fThickness)
+	//
+	// TransmissionExact	std::exp, reference
+	// TransmissionPoly		2^n * p(f) with f in [-0.5, 0.5] and p a 5th order polynomial,
+	//						relative error below 6e-6 for optical depths up to 87
+	// TransmissionLUT		Linear interpolation of a table sampled at a fixed fSigma,
+	//						relative error (fSigma * fStep)^2 / 8 plus the rounding of
+	//						the float index, below 3.2e-5 for 1024 entries over optical
+	//						depths [0, 16]
+	//--------------------------------------------------------------------------------------
+
+	inline float TransmissionExact(const float fSigma, const float fThickness)
+	{
+		return std::exp(-fSigma * fThickness);
+	}
+
+	inline float TransmissionPoly(const float fSigma, const float fThickness)
+	{
+		// exp(-x) = 2^(-x log2(e)), clamped to the smallest normal exponent
+		auto x = -fSigma * fThickness * 1.44269504f;
+		x = x > -126.0f ? x : -126.0f;
+
+		// Split into the integral and the fractional parts (x <= 0)
+		const auto n = static_cast<int32_t>(x - 0.5f);
+		const auto f = x - static_cast<float>(n);
+
+		// 2^f on [-0.5, 0.5]
+		auto p = 1.33335581e-3f;
+		p = p * f + 9.61812911e-3f;
+		p = p * f + 5.55041087e-2f;
+		p = p * f + 2.40226507e-1f;
+		p = p * f + 6.93147181e-1f;
+		p = p * f + 1.0f;
+
+		// 2^n from the exponent bits
+		const auto uBits = static_cast<uint32_t>(n + 127) << 23;
+		float fScale;
+		memcpy(&fScale, &uBits, sizeof(float));
+
+		return p * fScale;
+	}
+
+	// Batched form, written branch-free so that the loop vectorizes
+	inline void TransmissionPoly(const float fSigma, const float *pfThickness, float *pfTransmission, const uint32_t uCount)
+	{
+		for (auto i = 0u; i < uCount; ++i) pfTransmission[i] = TransmissionPoly(fSigma, pfThickness[i]);
+	}
+
+	class TransmissionLUT
+	{
+	public:
+		TransmissionLUT() : m_fSigma(0.0f), m_fScale(0.0f), m_fMaxIndex(0.0f) {}
+
+		void Create(const float fSigma, const float fMaxOpticalDepth, const uint32_t uSize)
+		{
+			m_fSigma = fSigma;
+			m_fMaxIndex = static_cast<float>(uSize - 1);
+			m_fScale = m_fMaxIndex * fSigma / fMaxOpticalDepth;
+
+			// Pad one entry to avoid clamping the upper neighbor
+			m_vTable.resize(uSize + 1);
+			for (auto i = 0u; i < uSize; ++i)
+				m_vTable[i] = std::exp(-fMaxOpticalDepth * i / m_fMaxIndex);
+			m_vTable[uSize] = m_vTable[uSize - 1];
+		}
+
+		float Lookup(const float fThickness) const
+		{
+			auto x = fThickness * m_fScale;
+			x = x < m_fMaxIndex ? x : m_fMaxIndex;
+			const auto i = static_cast<uint32_t>(x);
+			const auto t = x - static_cast<float>(i);
+
+			return m_vTable[i] + (m_vTable[i + 1] - m_vTable[i]) * t;
+		}
+
+		float GetSigma() const { return m_fSigma; }
+		uint32_t GetSize() const { return static_cast<uint32_t>(m_vTable.size()) - 1; }
+		const float *GetData() const { return m_vTable.data(); }
+
+	protected:
+		float				m_fSigma;
+		float				m_fScale;
+		float				m_fMaxIndex;
+		std::vector<float>	m_vTable;
+	};
+}
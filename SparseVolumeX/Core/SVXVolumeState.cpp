@@ -0,0 +1,145 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <limits>
+#include "SVXVolumeState.h"
+
+using namespace std;
+using namespace SVX;
+
+VolumeState::VolumeState() :
+	vCenter(0.0f),
+	fRadius(1.0f),
+	uWidth(0),
+	uHeight(0),
+	uNumLayers(16),
+	uLightMapSize(256),
+	uNumCascades(1),
+	fZNear(1.0f),
+	fZFar(1000.0f),
+	mViewProj(float4x4::Identity()),
+	mWorldToScreen(float4x4::Identity()),
+	mScreenToWorld(float4x4::Identity()),
+	mWorldToScreenPrev(float4x4::Identity()),
+	fCascadeSplits(),
+	vLights(0),
+	vLightViewProjs(0),
+	fLightDepthScale(0.0f),
+	uFrame(0),
+	bHistoryValid(false)
+{
+}
+
+uint32_t VolumeState::GetNumLightViews() const
+{
+	return static_cast<uint32_t>(vLights.size()) * uNumCascades;
+}
+
+void VolumeState::SetCamera(const float4x4 &mViewProjCur)
+{
+	const float4x4 mToScreen = { {
+		float4(0.5f * uWidth, 0.0f, 0.0f, 0.0f),
+		float4(0.0f, -0.5f * uHeight, 0.0f, 0.0f),
+		float4(0.0f, 0.0f, 1.0f, 0.0f),
+		float4(0.5f * uWidth, 0.5f * uHeight, 0.0f, 1.0f)
+	} };
+
+	mViewProj = mViewProjCur;
+	mWorldToScreenPrev = mWorldToScreen;
+	mWorldToScreen = mul(mViewProj, mToScreen);
+	mScreenToWorld = MatrixInverse(mWorldToScreen);
+}
+
+void VolumeState::FitLightsToObject()
+{
+	uNumCascades = 1;
+	for (auto &fSplit : fCascadeSplits) fSplit = (numeric_limits<float>::max)();
+
+	fLightDepthScale = fRadius * 4.0f;
+	vLightViewProjs.resize(vLights.size());
+	for (auto i = 0u; i < vLights.size(); ++i)
+	{
+		const auto vLightPt = vCenter + vLights[i].vPosition;
+		const auto fDist = length(vLights[i].vPosition);
+		const auto mViewLS = MatrixLookAtLH(vLightPt, vCenter, float3(0.0f, 1.0f, 0.0f));
+		const auto mProjLS = MatrixOrthographicOffCenterLH(-fRadius * 1.5f, fRadius * 1.5f,
+			-fRadius * 1.5f, fRadius * 1.5f, fDist - fRadius * 2.0f, fDist + fRadius * 2.0f);
+		vLightViewProjs[i] = mul(mViewLS, mProjLS);
+	}
+}
+
+void VolumeState::FitLightsToCascades(const float3 &vEye, const float4x4 &mViewProjNoJitter,
+	const float fZNearLS, const float fZFarLS, const float fSplitLog)
+{
+	// Cascade splits by camera view depth over the depth range of the object
+	const auto fDist = length(vCenter - vEye);
+	const auto fZMin = (std::max)(fDist - fRadius, fZNear);
+	const auto fZMax = (std::max)(fDist + fRadius, fZMin + fZNear);
+
+	float fSplits[5];
+	fSplits[0] = fZMin;
+	for (auto i = 1u; i <= uNumCascades; ++i)
+	{
+		const auto t = static_cast<float>(i) / uNumCascades;
+		const auto fSplitLogI = fZMin * pow(fZMax / fZMin, t);
+		const auto fSplitUniform = fZMin + (fZMax - fZMin) * t;
+		fSplits[i] = fSplitUniform + (fSplitLogI - fSplitUniform) * fSplitLog;
+	}
+
+	for (auto i = 0u; i < 4; ++i) fCascadeSplits[i] = i + 1 < uNumCascades ? fSplits[i + 1] : fZFar;
+
+	// Bounding spheres of the camera frustum slices
+	float3 vCascadeCenters[4];
+	float fCascadeRadii[4];
+	const auto mViewProjI = MatrixInverse(mViewProjNoJitter);
+	for (auto i = 0u; i < uNumCascades; ++i)
+	{
+		float3 vCorners[8];
+		vCascadeCenters[i] = float3(0.0f);
+		for (auto j = 0u; j < 8; ++j)
+		{
+			// View depth to perspective clip space
+			const auto fZ = fSplits[i + (j >> 2)];
+			const auto fDepth = fZFar * (fZ - fZNear) / ((fZFar - fZNear) * fZ);
+			const auto vCorner = float3(j & 1 ? 1.0f : -1.0f, j & 2 ? 1.0f : -1.0f, fDepth);
+			vCorners[j] = TransformCoord(vCorner, mViewProjI);
+			vCascadeCenters[i] += vCorners[j];
+		}
+		vCascadeCenters[i] *= 1.0f / 8.0f;
+
+		fCascadeRadii[i] = 0.0f;
+		for (const auto &vCorner : vCorners)
+			fCascadeRadii[i] = (std::max)(fCascadeRadii[i], length(vCorner - vCascadeCenters[i]));
+
+		// Never wider than the frame of the whole object
+		if (fCascadeRadii[i] > fRadius * 1.5f)
+		{
+			vCascadeCenters[i] = vCenter;
+			fCascadeRadii[i] = fRadius * 1.5f;
+		}
+	}
+
+	// Light-space matrices
+	fLightDepthScale = fZFarLS - fZNearLS;
+	vLightViewProjs.resize(vLights.size() * uNumCascades);
+	const auto fMapSize = static_cast<float>(uLightMapSize);
+	for (auto i = 0u; i < vLights.size(); ++i)
+	{
+		const auto vLightPt = vCenter + vLights[i].vPosition;
+		const auto mViewLS = MatrixLookAtLH(vLightPt, vCenter, float3(0.0f, 1.0f, 0.0f));
+
+		for (auto j = 0u; j < uNumCascades; ++j)
+		{
+			// Snap to light texels against shimmering, with one texel of margin
+			const auto fCascadeRadius = fCascadeRadii[j] * fMapSize / (fMapSize - 2.0f);
+			const auto fTexel = fCascadeRadius * 2.0f / fMapSize;
+			const auto vCenterLS = TransformCoord(vCascadeCenters[j], mViewLS);
+			const auto fX = floor(vCenterLS.x / fTexel) * fTexel;
+			const auto fY = floor(vCenterLS.y / fTexel) * fTexel;
+			const auto mProjLS = MatrixOrthographicOffCenterLH(fX - fCascadeRadius, fX + fCascadeRadius,
+				fY - fCascadeRadius, fY + fCascadeRadius, fZNearLS, fZFarLS);
+			vLightViewProjs[i * uNumCascades + j] = mul(mViewLS, mProjLS);
+		}
+	}
+}
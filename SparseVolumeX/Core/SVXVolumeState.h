@@ -0,0 +1,69 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "SVXMath.h"
+
+namespace SVX
+{
+	struct Light
+	{
+		float3	vPosition;	// Relative to the mesh center
+		float3	vColor;
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Algorithmic state shared by the backends: the bound of the mesh, the k-buffer sizes,
+	// and the camera and light-space matrices of the current frame. Backends only read it.
+	//--------------------------------------------------------------------------------------
+	struct VolumeState
+	{
+		// Mesh bound
+		float3					vCenter;
+		float					fRadius;
+
+		// K-buffer sizes
+		uint32_t				uWidth;
+		uint32_t				uHeight;
+		uint32_t				uNumLayers;
+		uint32_t				uLightMapSize;
+		uint32_t				uNumCascades;		// Light-space views per light, at most 4
+
+		// Camera
+		float					fZNear;
+		float					fZFar;
+		float4x4				mViewProj;			// Jittered when the backend accumulates a history
+		float4x4				mWorldToScreen;
+		float4x4				mScreenToWorld;
+		float4x4				mWorldToScreenPrev;
+		float					fCascadeSplits[4];	// View depths ending the cascades
+
+		// Lights
+		std::vector<Light>		vLights;
+		std::vector<float4x4>	vLightViewProjs;	// uNumCascades per light
+		float					fLightDepthScale;	// Light-space depth range
+
+		// Temporal history
+		uint32_t				uFrame;
+		bool					bHistoryValid;
+
+		VolumeState();
+
+		uint32_t GetNumLightViews() const;
+
+		// Screen-space matrices of the view projection; the current ones become the previous
+		void SetCamera(const float4x4 &mViewProj);
+
+		// Orthographic frame of the whole object per light, independent of the camera,
+		// with one cascade and the depth range fitted to the bound
+		void FitLightsToObject();
+
+		// Orthographic frames of the camera frustum slices, split by view depth over the
+		// depth range of the object and snapped to light texels against shimmering
+		void FitLightsToCascades(const float3 &vEye, const float4x4 &mViewProjNoJitter,
+			const float fZNearLS, const float fZFarLS, const float fSplitLog);
+	};
+}
@@ -0,0 +1,430 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include <cstring>
+#include "SVXFile.h"
+#include "SVXVoxelOctree.h"
+
+using namespace std;
+using namespace SVX;
+
+static const char g_szMagic[] = "SVXSVO01";
+
+// Voxels per side of a brick
+static const uint32_t g_uBrickSize = 4;
+
+// Bits of the octant 0 of a brick, the others shifted by their first voxel
+static const uint64_t g_uOctantBits = 0x330033;
+
+enum ChildType : uint32_t
+{
+	CHILD_EMPTY,
+	CHILD_SOLID,
+	CHILD_NODE,
+	CHILD_BRICK
+};
+
+// Voxels [uBegin, uEnd) of a column inside the solid
+struct Span
+{
+	uint32_t uBegin;
+	uint32_t uEnd;
+};
+
+// Ray in voxel coordinates with the intervals it has met so far
+struct VoxelRay
+{
+	float3		vOrigin;
+	float3		vDir;
+	float3		vDirInv;
+	float		fGap;		// Of a voxel, merged as the staircase of an oblique surface
+	float		*pT;
+	uint32_t	uMaxValues;
+	uint32_t	uCount;
+};
+
+static uint32_t roundResolution(const uint32_t uResolution)
+{
+	auto uSize = g_uBrickSize;
+	while (uSize < uResolution) uSize <<= 1;
+
+	return uSize;
+}
+
+static ChildType classifyColumn(const Span *pBegin, const Span *pEnd, const uint32_t uZBegin, const uint32_t uZEnd)
+{
+	for (auto pSpan = pBegin; pSpan < pEnd && pSpan->uBegin < uZEnd; ++pSpan)
+	{
+		if (pSpan->uEnd <= uZBegin) continue;
+
+		return pSpan->uBegin <= uZBegin && pSpan->uEnd >= uZEnd ? CHILD_SOLID : CHILD_NODE;
+	}
+
+	return CHILD_EMPTY;
+}
+
+// Top-down: a cube is uniform if every column of its footprint is over its depth range,
+// so only the cubes the surface crosses are split
+static uint32_t buildNode(vector<uint32_t> &vNodes, vector<uint64_t> &vBricks, const vector<Span> &vSpans,
+	const vector<uint32_t> &vColumns, const uint32_t uResolution, const uint32_t x, const uint32_t y,
+	const uint32_t z, const uint32_t uSize)
+{
+	const auto spans = [&](const uint32_t u, const uint32_t v)
+	{
+		const auto uColumn = v * uResolution + u;
+
+		return make_pair(vSpans.data() + vColumns[uColumn], vSpans.data() + vColumns[uColumn + 1]);
+	};
+
+	auto bEmpty = true, bSolid = true;
+	for (auto v = y; v < y + uSize && (bEmpty || bSolid); ++v)
+	{
+		for (auto u = x; u < x + uSize && (bEmpty || bSolid); ++u)
+		{
+			const auto column = spans(u, v);
+			const auto type = classifyColumn(column.first, column.second, z, z + uSize);
+			bEmpty = bEmpty && type == CHILD_EMPTY;
+			bSolid = bSolid && type == CHILD_SOLID;
+		}
+	}
+	if (bEmpty) return CHILD_EMPTY;
+	if (bSolid) return CHILD_SOLID;
+
+	if (uSize == g_uBrickSize)
+	{
+		uint64_t uBits = 0;
+		for (auto j = 0u; j < g_uBrickSize; ++j)
+		{
+			for (auto i = 0u; i < g_uBrickSize; ++i)
+			{
+				const auto column = spans(x + i, y + j);
+				for (auto k = 0u; k < g_uBrickSize; ++k)
+					if (classifyColumn(column.first, column.second, z + k, z + k + 1) == CHILD_SOLID)
+						uBits |= 1ull << (k * 16 + j * 4 + i);
+			}
+		}
+		vBricks.push_back(uBits);
+
+		return static_cast<uint32_t>(vBricks.size() - 1) << 2 | CHILD_BRICK;
+	}
+
+	// The children are built after the node is allocated, which may grow the nodes
+	const auto uNode = static_cast<uint32_t>(vNodes.size() / 8);
+	const auto uHalf = uSize / 2;
+	vNodes.resize(vNodes.size() + 8);
+	for (auto i = 0u; i < 8; ++i)
+	{
+		const auto uChild = buildNode(vNodes, vBricks, vSpans, vColumns, uResolution,
+			x + (i & 1) * uHalf, y + (i >> 1 & 1) * uHalf, z + (i >> 2 & 1) * uHalf, uHalf);
+		vNodes[uNode * 8 + i] = uChild;
+	}
+
+	return uNode << 2 | CHILD_NODE;
+}
+
+// Whether the last interval is under a voxel, the corner of a voxel grazed near a
+// silhouette, where the voxels stick out of the surface by up to their size
+static bool isSliver(const VoxelRay &ray)
+{
+	return ray.uCount > 0 && ray.pT[ray.uCount - 1] - ray.pT[ray.uCount - 2] < ray.fGap;
+}
+
+// Appends an inside segment, merged with the last one where it continues it across a gap
+// under a voxel, and drops the last one if it ends as a sliver; false once full
+static bool append(VoxelRay &ray, const float tA, const float tB)
+{
+	if (ray.uCount > 0 && tA > ray.pT[ray.uCount - 1] + ray.fGap && isSliver(ray)) ray.uCount -= 2;
+	if (ray.uCount > 0 && tA <= ray.pT[ray.uCount - 1] + ray.fGap)
+	{
+		ray.pT[ray.uCount - 1] = (std::max)(ray.pT[ray.uCount - 1], tB);
+		return true;
+	}
+	if (ray.uCount + 2 > ray.uMaxValues) return false;
+	ray.pT[ray.uCount++] = tA;
+	ray.pT[ray.uCount++] = tB;
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Octants of the cube at vMin, of half size fHalf, crossed by the ray in [t0, t1], in
+// the order the ray meets them. The segments share their ends, so the intervals of
+// adjacent octants continue exactly. visit(uOctant, vOctantMin, tBegin, tEnd) returns false
+// to stop.
+//--------------------------------------------------------------------------------------
+template<typename Visit>
+static bool splitRay(const VoxelRay &ray, const float3 &vMin, const float fHalf, const float t0, const float t1,
+	const Visit &visit)
+{
+	const auto vMid = vMin + float3(fHalf);
+
+	// Crossings of the mid planes, at most 3, inserted in order; NaN for a ray in a plane
+	// fails the test as well
+	float vT[5];
+	auto uNumT = 0u;
+	vT[uNumT++] = t0;
+	for (auto i = 0u; i < 3; ++i)
+	{
+		const auto t = (vMid[i] - ray.vOrigin[i]) * ray.vDirInv[i];
+		if (!(t > t0 && t < t1)) continue;
+
+		auto j = uNumT++;
+		for (; j > 1 && vT[j - 1] > t; --j) vT[j] = vT[j - 1];
+		vT[j] = t;
+	}
+	vT[uNumT++] = t1;
+
+	for (auto i = 0u; i + 1 < uNumT; ++i)
+	{
+		const auto tBegin = vT[i], tEnd = vT[i + 1];
+		if (tBegin >= tEnd) continue;
+
+		const auto vPos = ray.vOrigin + ray.vDir * (0.5f * (tBegin + tEnd));
+		const auto uOctant = (vPos.x >= vMid.x ? 1u : 0u) | (vPos.y >= vMid.y ? 2u : 0u) | (vPos.z >= vMid.z ? 4u : 0u);
+		const float3 vOctantMin(uOctant & 1 ? vMid.x : vMin.x, uOctant & 2 ? vMid.y : vMin.y,
+			uOctant & 4 ? vMid.z : vMin.z);
+		if (!visit(uOctant, vOctantMin, tBegin, tEnd)) return false;
+	}
+
+	return true;
+}
+
+static bool castBrick(VoxelRay &ray, const uint64_t uBits, const float3 &vMin, const float t0, const float t1)
+{
+	// Octants of 2^3 voxels, then the voxels of the mixed ones
+	return splitRay(ray, vMin, 2.0f, t0, t1,
+		[&ray, uBits](const uint32_t uOctant, const float3 &vOctantMin, const float tBegin, const float tEnd)
+	{
+		const auto uFirst = (uOctant & 1) * 2 + (uOctant >> 1 & 1) * 8 + (uOctant >> 2 & 1) * 32;
+		const auto uOctantBits = g_uOctantBits << uFirst;
+		if (!(uBits & uOctantBits)) return true;
+		if ((uBits & uOctantBits) == uOctantBits) return append(ray, tBegin, tEnd);
+
+		return splitRay(ray, vOctantMin, 1.0f, tBegin, tEnd,
+			[&ray, uBits, uFirst](const uint32_t uVoxel, const float3 &, const float tVoxelBegin, const float tVoxelEnd)
+		{
+			const auto uBit = uFirst + (uVoxel & 1) + (uVoxel >> 1 & 1) * 4 + (uVoxel >> 2 & 1) * 16;
+
+			return !(uBits >> uBit & 1) || append(ray, tVoxelBegin, tVoxelEnd);
+		});
+	});
+}
+
+static bool castChild(VoxelRay &ray, const vector<uint32_t> &vNodes, const vector<uint64_t> &vBricks,
+	const uint32_t uChild, const float3 &vMin, const float fSize, const float t0, const float t1)
+{
+	switch (uChild & 3)
+	{
+	case CHILD_SOLID:
+		return append(ray, t0, t1);
+	case CHILD_NODE:
+	{
+		const auto pChildren = &vNodes[(uChild >> 2) * 8];
+		const auto fHalf = 0.5f * fSize;
+
+		return splitRay(ray, vMin, fHalf, t0, t1,
+			[&, pChildren, fHalf](const uint32_t uOctant, const float3 &vOctantMin, const float tBegin, const float tEnd)
+		{
+			return castChild(ray, vNodes, vBricks, pChildren[uOctant], vOctantMin, fHalf, tBegin, tEnd);
+		});
+	}
+	case CHILD_BRICK:
+		return castBrick(ray, vBricks[uChild >> 2], vMin, t0, t1);
+	default:
+		return true;
+	}
+}
+
+VoxelOctree::VoxelOctree() :
+	m_uResolution(0),
+	m_uNumLayers(0),
+	m_uRoot(CHILD_EMPTY),
+	m_vNodes(0),
+	m_vBricks(0)
+{
+}
+
+VoxelOctree::~VoxelOctree()
+{
+}
+
+void VoxelOctree::Create(const Mesh &mesh, const uint32_t uResolution, const uint32_t uNumLayers,
+	Scheduler &scheduler)
+{
+	setBound(mesh);
+	m_uResolution = roundResolution(uResolution);
+	m_uNumLayers = uNumLayers;
+
+	KBuffer kBuffer;
+	kBuffer.Create(m_uResolution, m_uResolution, uNumLayers);
+	peel(mesh, 2, kBuffer, scheduler);
+
+	// Spans of the voxel centers inside the front/back pairs of each column; a front
+	// left unpaired past the K layers is dropped
+	const auto fResolution = static_cast<float>(m_uResolution);
+	const auto toVoxel = [fResolution](const float fDepth)
+	{
+		return static_cast<uint32_t>((std::min)((std::max)(ceil(fDepth * fResolution - 0.5f), 0.0f), fResolution));
+	};
+
+	vector<Span> vSpans;
+	vector<uint32_t> vColumns(static_cast<size_t>(m_uResolution) * m_uResolution + 1);
+	for (auto y = 0u; y < m_uResolution; ++y)
+	{
+		for (auto x = 0u; x < m_uResolution; ++x)
+		{
+			const auto uColumnBegin = static_cast<uint32_t>(vSpans.size());
+			vColumns[y * m_uResolution + x] = uColumnBegin;
+
+			const auto pLayers = kBuffer.GetLayers(x, y);
+			for (auto k = 0u; k + 1 < uNumLayers && pLayers[k + 1] < 1.0f; k += 2)
+			{
+				const Span span = { toVoxel(pLayers[k]), toVoxel(pLayers[k + 1]) };
+				if (span.uBegin >= span.uEnd) continue;
+				if (vSpans.size() > uColumnBegin && vSpans.back().uEnd >= span.uBegin) vSpans.back().uEnd = span.uEnd;
+				else vSpans.push_back(span);
+			}
+		}
+	}
+	vColumns.back() = static_cast<uint32_t>(vSpans.size());
+
+	m_vNodes.clear();
+	m_vBricks.clear();
+	m_uRoot = buildNode(m_vNodes, m_vBricks, vSpans, vColumns, m_uResolution, 0, 0, 0, m_uResolution);
+	m_vNodes.shrink_to_fit();
+	m_vBricks.shrink_to_fit();
+}
+
+bool VoxelOctree::Save(const char *pszFilename, const uint64_t uSourceStamp) const
+{
+	const auto pFile = OpenFile(pszFilename, "wb");
+	if (!pFile) return false;
+
+	const uint32_t vSizes[] = { m_uResolution, m_uNumLayers, m_uRoot, GetNumNodes(), GetNumBricks() };
+	const float vBound[] = { m_vCenter.x, m_vCenter.y, m_vCenter.z, m_fHalfSize };
+	auto bSuccess = fwrite(g_szMagic, 1, 8, pFile) == 8;
+	bSuccess = bSuccess && fwrite(&uSourceStamp, sizeof(uint64_t), 1, pFile) == 1;
+	bSuccess = bSuccess && fwrite(vSizes, sizeof(uint32_t), 5, pFile) == 5;
+	bSuccess = bSuccess && fwrite(vBound, sizeof(float), 4, pFile) == 4;
+	bSuccess = bSuccess && fwrite(m_vNodes.data(), sizeof(uint32_t), m_vNodes.size(), pFile) == m_vNodes.size();
+	bSuccess = bSuccess && fwrite(m_vBricks.data(), sizeof(uint64_t), m_vBricks.size(), pFile) == m_vBricks.size();
+	fclose(pFile);
+
+	return bSuccess;
+}
+
+bool VoxelOctree::Load(const char *pszFilename, const uint64_t uSourceStamp, const uint32_t uResolution,
+	const uint32_t uNumLayers)
+{
+	const auto pFile = OpenFile(pszFilename, "rb");
+	if (!pFile) return false;
+
+	char szMagic[8];
+	uint64_t uStamp;
+	uint32_t vSizes[5];
+	float vBound[4];
+	auto bSuccess = fread(szMagic, 1, 8, pFile) == 8 && !memcmp(szMagic, g_szMagic, 8);
+	bSuccess = bSuccess && fread(&uStamp, sizeof(uint64_t), 1, pFile) == 1 && uStamp == uSourceStamp;
+	bSuccess = bSuccess && fread(vSizes, sizeof(uint32_t), 5, pFile) == 5 &&
+		vSizes[0] == roundResolution(uResolution) && vSizes[1] == uNumLayers;
+	bSuccess = bSuccess && fread(vBound, sizeof(float), 4, pFile) == 4;
+	if (bSuccess)
+	{
+		m_uResolution = vSizes[0];
+		m_uNumLayers = vSizes[1];
+		m_uRoot = vSizes[2];
+		m_vCenter = float3(vBound[0], vBound[1], vBound[2]);
+		m_fHalfSize = vBound[3];
+		m_vNodes.resize(static_cast<size_t>(vSizes[3]) * 8);
+		m_vBricks.resize(vSizes[4]);
+		bSuccess = fread(m_vNodes.data(), sizeof(uint32_t), m_vNodes.size(), pFile) == m_vNodes.size();
+		bSuccess = bSuccess && fread(m_vBricks.data(), sizeof(uint64_t), m_vBricks.size(), pFile) == m_vBricks.size();
+	}
+	fclose(pFile);
+
+	return bSuccess;
+}
+
+uint32_t VoxelOctree::CastRay(const float3 &vOrigin, const float3 &vDir, const float fTMin, const float fTMax,
+	float *pT, const uint32_t uMaxValues) const
+{
+	if ((m_uRoot & 3) == CHILD_EMPTY) return 0;
+
+	// Voxel coordinates of the peel image, an affine map of the world that keeps t
+	const auto mViewProj = getViewProj(2);
+	const auto vOriginH = mul(float4(vOrigin, 1.0f), mViewProj);
+	const auto vDirH = mul(float4(vDir, 0.0f), mViewProj);
+	const auto fResolution = static_cast<float>(m_uResolution);
+	VoxelRay ray;
+	ray.vOrigin = float3((vOriginH.x * 0.5f + 0.5f) * fResolution, (0.5f - vOriginH.y * 0.5f) * fResolution,
+		vOriginH.z * fResolution);
+	ray.vDir = float3(vDirH.x * 0.5f * fResolution, -vDirH.y * 0.5f * fResolution, vDirH.z * fResolution);
+	ray.fGap = 1.0f / length(ray.vDir);
+	ray.pT = pT;
+	ray.uMaxValues = uMaxValues;
+	ray.uCount = 0;
+
+	// Clip to the cube
+	auto t0 = fTMin, t1 = fTMax;
+	for (auto i = 0u; i < 3; ++i)
+	{
+		ray.vDirInv[i] = 1.0f / ray.vDir[i];
+		if (ray.vDir[i] == 0.0f)
+		{
+			if (ray.vOrigin[i] < 0.0f || ray.vOrigin[i] > fResolution) return 0;
+			continue;
+		}
+
+		auto ta = -ray.vOrigin[i] * ray.vDirInv[i], tb = (fResolution - ray.vOrigin[i]) * ray.vDirInv[i];
+		if (ta > tb) swap(ta, tb);
+		t0 = (std::max)(t0, ta);
+		t1 = (std::min)(t1, tb);
+	}
+	if (t0 >= t1) return 0;
+
+	castChild(ray, m_vNodes, m_vBricks, m_uRoot, float3(0.0f), fResolution, t0, t1);
+	if (isSliver(ray)) ray.uCount -= 2;
+
+	return ray.uCount;
+}
+
+bool VoxelOctree::IsSolid(const uint32_t x, const uint32_t y, const uint32_t z) const
+{
+	auto uChild = m_uRoot;
+	for (auto uHalf = m_uResolution / 2; (uChild & 3) == CHILD_NODE; uHalf >>= 1)
+	{
+		const auto uOctant = (x & uHalf ? 1 : 0) | (y & uHalf ? 2 : 0) | (z & uHalf ? 4 : 0);
+		uChild = m_vNodes[(uChild >> 2) * 8 + uOctant];
+	}
+
+	switch (uChild & 3)
+	{
+	case CHILD_SOLID:
+		return true;
+	case CHILD_BRICK:
+		return (m_vBricks[uChild >> 2] >> ((z & 3) * 16 + (y & 3) * 4 + (x & 3)) & 1) != 0;
+	default:
+		return false;
+	}
+}
+
+uint32_t VoxelOctree::GetResolution() const
+{
+	return m_uResolution;
+}
+
+uint32_t VoxelOctree::GetNumNodes() const
+{
+	return static_cast<uint32_t>(m_vNodes.size() / 8);
+}
+
+uint32_t VoxelOctree::GetNumBricks() const
+{
+	return static_cast<uint32_t>(m_vBricks.size());
+}
+
+size_t VoxelOctree::GetBytes() const
+{
+	return sizeof(uint32_t) * m_vNodes.size() + sizeof(uint64_t) * m_vBricks.size();
+}
@@ -0,0 +1,61 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SVXSolid.h"
+
+namespace SVX
+{
+	//--------------------------------------------------------------------------------------
+	// Solid voxelization of a mesh into a sparse voxel octree over its bounding cube. The
+	// mesh is peeled once along Z, and the front/back pairs of each column classify the
+	// voxel centers as inside or outside. Uniform nodes collapse into empty or solid
+	// children, and mixed 4^3 leaves are 64-bit occupancy bricks, so the memory follows
+	// the surface area rather than the volume. A ray descends the nodes it crosses in
+	// order and merges the solid runs it meets into entry/exit intervals, dropping those
+	// under a voxel, which a ray grazing a silhouette cuts from the voxel corners.
+	//--------------------------------------------------------------------------------------
+	class VoxelOctree : public Solid
+	{
+	public:
+		VoxelOctree();
+		virtual ~VoxelOctree();
+
+		// Resolution rounded up to a power of 2 of at least the brick size; the K layers of
+		// the peel bound the intervals per column
+		void Create(const Mesh &mesh, const uint32_t uResolution, const uint32_t uNumLayers,
+			Scheduler &scheduler);
+
+		// Binary cache tagged with the stamp of the mesh source file, as Mesh::Save(); Load()
+		// rejects a cache of another resolution or layer count
+		bool Save(const char *pszFilename, const uint64_t uSourceStamp) const;
+		bool Load(const char *pszFilename, const uint64_t uSourceStamp, const uint32_t uResolution,
+			const uint32_t uNumLayers);
+
+		uint32_t CastRay(const float3 &vOrigin, const float3 &vDir, const float fTMin, const float fTMax,
+			float *pT, const uint32_t uMaxValues) const override;
+
+		// Occupancy of the voxel at (x, y, z), z along the peel from the front
+		bool IsSolid(const uint32_t x, const uint32_t y, const uint32_t z) const;
+
+		uint32_t GetResolution() const;
+		uint32_t GetNumNodes() const;
+		uint32_t GetNumBricks() const;
+		size_t GetBytes() const override;
+
+	protected:
+		uint32_t	m_uResolution;
+		uint32_t	m_uNumLayers;
+		uint32_t	m_uRoot;		// Tagged as the children
+
+		// Children are tagged references, the index of a node or brick above 2 bits of
+		// their type: empty, solid, node or brick
+		std::vector<uint32_t>	m_vNodes;	// 8 children per node, in x, y, z bit order
+		std::vector<uint64_t>	m_vBricks;	// 4^3 bits per brick, in x, y, z order
+	};
+
+	using upVoxelOctree = std::unique_ptr<VoxelOctree>;
+	using spVoxelOctree = std::shared_ptr<VoxelOctree>;
+}
@@ -0,0 +1,120 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#include "XSDXProfiler.h"
+
+using namespace DX;
+using namespace std;
+using namespace XSDX;
+
+const uint8_t GPUProfiler::FRAME_LATENCY;
+
+GPUProfiler::GPUProfiler(const CPDXDevice &pDXDevice, const uint8_t uMaxStages) :
+	m_uCurrent(0),
+	m_uMaxStages(uMaxStages),
+	m_pProfiler(nullptr),
+	m_pDXDevice(pDXDevice)
+{
+	m_pDXDevice->GetImmediateContext(&m_pDXContext);
+
+	const auto disjointDesc = CD3D11_QUERY_DESC(D3D11_QUERY_TIMESTAMP_DISJOINT);
+	const auto timestampDesc = CD3D11_QUERY_DESC(D3D11_QUERY_TIMESTAMP);
+	for (auto &queries : m_vFrameQueries)
+	{
+		ThrowIfFailed(m_pDXDevice->CreateQuery(&disjointDesc, &queries.pDisjoint));
+		ThrowIfFailed(m_pDXDevice->CreateQuery(&timestampDesc, &queries.pFrameBegin));
+
+		VEC_ALLOC(queries.vBegins, uMaxStages);
+		VEC_ALLOC(queries.vEnds, uMaxStages);
+		for (auto i = 0ui8; i < uMaxStages; ++i)
+		{
+			ThrowIfFailed(m_pDXDevice->CreateQuery(&timestampDesc, &queries.vBegins[i]));
+			ThrowIfFailed(m_pDXDevice->CreateQuery(&timestampDesc, &queries.vEnds[i]));
+		}
+
+		queries.vStages.reserve(uMaxStages);
+		queries.uFrame = 0;
+		queries.fCPUTime = 0.0;
+		queries.bPending = false;
+	}
+}
+
+GPUProfiler::~GPUProfiler()
+{
+}
+
+void GPUProfiler::BeginFrame(SVX::Profiler &profiler)
+{
+	m_pProfiler = &profiler;
+
+	// Drop the oldest frame if the GPU is still behind
+	auto &queries = m_vFrameQueries[m_uCurrent];
+	if (queries.bPending) resolve(queries);
+	queries.bPending = false;
+
+	queries.uFrame = profiler.GetFrame();
+	queries.fCPUTime = profiler.GetTime();
+	queries.vStages.clear();
+
+	m_pDXContext->Begin(queries.pDisjoint.Get());
+	m_pDXContext->End(queries.pFrameBegin.Get());
+}
+
+void GPUProfiler::EndFrame()
+{
+	auto &queries = m_vFrameQueries[m_uCurrent];
+	m_pDXContext->End(queries.pDisjoint.Get());
+	queries.bPending = true;
+
+	// Read back the frames that have completed since
+	m_uCurrent = (m_uCurrent + 1) % FRAME_LATENCY;
+	for (auto i = 0ui8; i < FRAME_LATENCY; ++i)
+	{
+		auto &queriesPrev = m_vFrameQueries[(m_uCurrent + i) % FRAME_LATENCY];
+		if (queriesPrev.bPending) resolve(queriesPrev);
+	}
+}
+
+uint8_t GPUProfiler::BeginStage(const char *pszStage)
+{
+	auto &queries = m_vFrameQueries[m_uCurrent];
+	const auto uStage = static_cast<uint8_t>(queries.vStages.size());
+	if (uStage >= m_uMaxStages) return m_uMaxStages;
+
+	queries.vStages.push_back(pszStage);
+	m_pDXContext->End(queries.vBegins[uStage].Get());
+
+	return uStage;
+}
+
+void GPUProfiler::EndStage(const uint8_t uStage)
+{
+	if (uStage >= m_uMaxStages) return;
+	m_pDXContext->End(m_vFrameQueries[m_uCurrent].vEnds[uStage].Get());
+}
+
+void GPUProfiler::resolve(FrameQueries &queries)
+{
+	auto disjoint = D3D11_QUERY_DATA_TIMESTAMP_DISJOINT();
+	const auto uFlags = D3D11_ASYNC_GETDATA_DONOTFLUSH;
+	if (m_pDXContext->GetData(queries.pDisjoint.Get(), &disjoint, sizeof(disjoint), uFlags) != S_OK) return;
+	queries.bPending = false;
+	if (disjoint.Disjoint || !m_pProfiler) return;
+
+	// Timestamps of a completed disjoint range are all available
+	auto uFrameBegin = 0ui64;
+	m_pDXContext->GetData(queries.pFrameBegin.Get(), &uFrameBegin, sizeof(uint64_t), uFlags);
+
+	const auto fScale = 1000.0 / disjoint.Frequency;
+	for (auto i = 0u; i < queries.vStages.size(); ++i)
+	{
+		auto uBegin = 0ui64, uEnd = 0ui64;
+		m_pDXContext->GetData(queries.vBegins[i].Get(), &uBegin, sizeof(uint64_t), uFlags);
+		m_pDXContext->GetData(queries.vEnds[i].Get(), &uEnd, sizeof(uint64_t), uFlags);
+
+		// Aligned to the CPU timeline at the frame start
+		m_pProfiler->AddStage(queries.uFrame, queries.vStages[i], SVX::Profiler::TRACK_GPU,
+			queries.fCPUTime + (uBegin - uFrameBegin) * fScale, (uEnd - uBegin) * fScale);
+	}
+}
@@ -0,0 +1,71 @@
+//--------------------------------------------------------------------------------------
+// By Stars XU Tianchen
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "SVXProfiler.h"
+#include "XSDXType.h"
+
+namespace XSDX
+{
+	//--------------------------------------------------------------------------------------
+	// GPU stage timer with timestamp queries, feeding the GPU track of SVX::Profiler.
+	// Queries of a frame are read back FRAME_LATENCY frames later without flushing, so
+	// the timer never stalls the pipeline; a frame whose queries are not ready by the
+	// time its slot is reused is dropped.
+	//--------------------------------------------------------------------------------------
+	class GPUProfiler
+	{
+	public:
+		static const uint8_t FRAME_LATENCY = 4;
+
+		// Brackets a stage with timestamps; a null profiler is a no-op
+		class Scope
+		{
+		public:
+			Scope(GPUProfiler *pProfiler, const char *pszStage) :
+				m_pProfiler(pProfiler), m_uStage(pProfiler ? pProfiler->BeginStage(pszStage) : 0) {}
+			~Scope() { if (m_pProfiler) m_pProfiler->EndStage(m_uStage); }
+
+		protected:
+			GPUProfiler	*m_pProfiler;
+			uint8_t		m_uStage;
+		};
+
+		GPUProfiler(const CPDXDevice &pDXDevice, const uint8_t uMaxStages = 16);
+		virtual ~GPUProfiler();
+
+		void BeginFrame(SVX::Profiler &profiler);
+		void EndFrame();
+
+		uint8_t BeginStage(const char *pszStage);
+		void EndStage(const uint8_t uStage);
+
+	protected:
+		struct FrameQueries
+		{
+			CPDXQuery					pDisjoint;
+			CPDXQuery					pFrameBegin;
+			std::vector<CPDXQuery>		vBegins;
+			std::vector<CPDXQuery>		vEnds;
+			std::vector<const char*>	vStages;
+			uint64_t					uFrame;
+			double						fCPUTime;	// CPU time of the frame start
+			bool						bPending;
+		};
+
+		void resolve(FrameQueries &queries);
+
+		std::array<FrameQueries, FRAME_LATENCY>	m_vFrameQueries;
+		uint8_t									m_uCurrent;
+		uint8_t									m_uMaxStages;
+		SVX::Profiler							*m_pProfiler;
+
+		CPDXDevice								m_pDXDevice;
+		CPDXContext								m_pDXContext;
+	};
+
+	using upGPUProfiler = std::unique_ptr<GPUProfiler>;
+	using spGPUProfiler = std::shared_ptr<GPUProfiler>;
+}
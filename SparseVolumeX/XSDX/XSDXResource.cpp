@@ -35,6 +35,37 @@ void Resource::CreateReadBuffer(const CPDXDevice &pDXDevice, CPDXBuffer &pDstBuf
 	ThrowIfFailed(pDXDevice->CreateBuffer(&desc, nullptr, &pDstBuffer));
 }
 
+size_t Resource::GetBytes() const
+{
+	return 0;
+}
+
+size_t Resource::GetBytes(const CPDXBuffer &pBuffer)
+{
+	if (!pBuffer) return 0;
+
+	auto desc = D3D11_BUFFER_DESC();
+	pBuffer->GetDesc(&desc);
+
+	return desc.ByteWidth;
+}
+
+uint32_t Resource::GetFormatBytes(const DXGI_FORMAT eFormat)
+{
+	// Uncompressed formats only; block-compressed ones count as 0
+	if (eFormat >= DXGI_FORMAT_R32G32B32A32_TYPELESS && eFormat <= DXGI_FORMAT_R32G32B32A32_SINT) return 16;
+	if (eFormat >= DXGI_FORMAT_R32G32B32_TYPELESS && eFormat <= DXGI_FORMAT_R32G32B32_SINT) return 12;
+	if (eFormat >= DXGI_FORMAT_R16G16B16A16_TYPELESS && eFormat <= DXGI_FORMAT_X32_TYPELESS_G8X24_UINT) return 8;
+	if (eFormat >= DXGI_FORMAT_R10G10B10A2_TYPELESS && eFormat <= DXGI_FORMAT_X24_TYPELESS_G8_UINT) return 4;
+	if (eFormat >= DXGI_FORMAT_R8G8_TYPELESS && eFormat <= DXGI_FORMAT_R16_SINT) return 2;
+	if (eFormat >= DXGI_FORMAT_R8_TYPELESS && eFormat <= DXGI_FORMAT_A8_UNORM) return 1;
+	if (eFormat >= DXGI_FORMAT_R9G9B9E5_SHAREDEXP && eFormat <= DXGI_FORMAT_G8R8_G8B8_UNORM) return 4;
+	if (eFormat >= DXGI_FORMAT_B5G6R5_UNORM && eFormat <= DXGI_FORMAT_B5G5R5A1_UNORM) return 2;
+	if (eFormat >= DXGI_FORMAT_B8G8R8A8_UNORM && eFormat <= DXGI_FORMAT_B8G8R8X8_UNORM_SRGB) return 4;
+
+	return 0;
+}
+
 //--------------------------------------------------------------------------------------
 // 2D Texture
 //--------------------------------------------------------------------------------------
@@ -150,6 +181,20 @@ void Texture2D::CreateSubSRVs()
 	}
 }
 
+size_t Texture2D::GetBytes() const
+{
+	if (!m_pTexture) return 0;
+
+	auto desc = D3D11_TEXTURE2D_DESC();
+	m_pTexture->GetDesc(&desc);
+
+	size_t uTexels = 0;
+	for (auto i = 0u; i < desc.MipLevels; ++i)
+		uTexels += static_cast<size_t>(max(desc.Width >> i, 1u)) * max(desc.Height >> i, 1u);
+
+	return uTexels * desc.ArraySize * desc.SampleDesc.Count * GetFormatBytes(desc.Format);
+}
+
 const CPDXTexture2D &Texture2D::GetTexture() const
 {
 	return m_pTexture;
@@ -513,6 +558,21 @@ void Texture3D::CreateSubSRVs()
 	}
 }
 
+size_t Texture3D::GetBytes() const
+{
+	if (!m_pTexture) return 0;
+
+	auto desc = D3D11_TEXTURE3D_DESC();
+	m_pTexture->GetDesc(&desc);
+
+	size_t uTexels = 0;
+	for (auto i = 0u; i < desc.MipLevels; ++i)
+		uTexels += static_cast<size_t>(max(desc.Width >> i, 1u)) * max(desc.Height >> i, 1u) *
+			max(desc.Depth >> i, 1u);
+
+	return uTexels * GetFormatBytes(desc.Format);
+}
+
 const CPDXTexture3D &Texture3D::GetTexture() const
 {
 	return m_pTexture;
@@ -597,6 +657,11 @@ void RawBuffer::CreateSRV(const uint32_t uByteWidth)
 	ThrowIfFailed(m_pDXDevice->CreateShaderResourceView(pBuffer, &desc, &m_pSRV));
 }
 
+size_t RawBuffer::GetBytes() const
+{
+	return Resource::GetBytes(m_pBuffer);
+}
+
 const CPDXBuffer &RawBuffer::GetBuffer() const
 {
 	return m_pBuffer;
@@ -18,8 +18,13 @@ namespace XSDX
 
 		const CPDXShaderResourceView	&GetSRV() const;
 
+		// Video memory of the resource as described, all mips, slices and samples included
+		virtual size_t GetBytes() const;
+
 		static void CreateReadBuffer(const CPDXDevice &pDXDevice,
 			CPDXBuffer &pDstBuffer, const CPDXBuffer &pSrcBuffer);
+		static size_t GetBytes(const CPDXBuffer &pBuffer);
+		static uint32_t GetFormatBytes(const DXGI_FORMAT eFormat);
 	protected:
 		CPDXShaderResourceView			m_pSRV;
 
@@ -51,6 +56,8 @@ namespace XSDX
 		void CreateUAV(const uint32_t uArraySize, const uint8_t uMips = 1);
 		void CreateSubSRVs();
 
+		size_t GetBytes() const override;
+
 		const CPDXTexture2D				&GetTexture() const;
 		const CPDXUnorderedAccessView	&GetUAV(const uint8_t i = 0) const;
 		const CPDXShaderResourceView	&GetSRVLevel(const uint8_t i) const;
@@ -141,6 +148,8 @@ namespace XSDX
 			const D3D11_USAGE eUsage = D3D11_USAGE_DEFAULT);
 		void CreateSubSRVs();
 
+		size_t GetBytes() const override;
+
 		const CPDXTexture3D				&GetTexture() const;
 		const CPDXUnorderedAccessView	&GetUAV(const uint8_t i = 0) const;
 		const CPDXShaderResourceView	&GetSRVLevel(const uint8_t i) const;
@@ -171,6 +180,8 @@ namespace XSDX
 			const D3D11_USAGE eUsage = D3D11_USAGE_DEFAULT);
 		void CreateSRV(const uint32_t uByteWidth);
 
+		size_t GetBytes() const override;
+
 		const CPDXBuffer				&GetBuffer() const;
 		const CPDXUnorderedAccessView	&GetUAV() const;
 	protected:
@@ -5,7 +5,6 @@
 #include "XSDXShader.h"
 
 using namespace std;
-using namespace Concurrency;
 using namespace DX;
 using namespace XSDX;
 
@@ -18,36 +17,20 @@ Shader::~Shader(void)
 {
 }
 
-TaskCPDXBlob Shader::ReadShaderFile(const wstring &szFileName)
+CPDXBlob Shader::ReadShaderFile(const wstring &szFileName)
 {
-#ifdef WIN32_DESKTOP_DXUT
-	return create_task([szFileName]()
-	{
-		auto pReturnBuffer = CPDXBlob();
-		ThrowIfFailed(D3DReadFileToBlob(szFileName.c_str(), &pReturnBuffer));
-		
-		return pReturnBuffer;
-	});
-#else
-	return ReadDataAsync(szFileName.c_str()).then([this, i](const vbyte& vFileData)
-	{
-		auto pReturnBuffer = CPDXBlob();
-		const auto uSize = vFileData.size();
-		ThrowIfFailed(D3DCreateBlob(uSize, &pReturnBuffer));
-		memcpy(pReturnBuffer->GetBufferPointer(), vFileData.data(), uSize);
+	auto pFileData = CPDXBlob();
+	ThrowIfFailed(D3DReadFileToBlob(szFileName.c_str(), &pFileData));
 
-		return pReturnBuffer;
-	});
-#endif
+	return pFileData;
 }
 
 TaskVoid Shader::CreateVertexShader(const wstring &szFileName, const uint8_t i)
 {
-	auto loadVSTask = ReadShaderFile(szFileName);
-
-	// Create the shader
-	return loadVSTask.then([this, i](const CPDXBlob &pFileData)
+	// Read and create the shader on a worker thread
+	return SVX::Scheduler::GetDefault().Run([this, szFileName, i]()
 	{
+		const auto pFileData = ReadShaderFile(szFileName);
 		m_ppVSBuffers[i] = pFileData;
 		ThrowIfFailed(m_pDXDevice->CreateVertexShader(pFileData->GetBufferPointer(),
 			pFileData->GetBufferSize(), nullptr, &m_ppVertexShaders[i]));
@@ -58,11 +41,10 @@ TaskVoid Shader::CreateVertexShader(const wstring &szFileName, const uint8_t i)
 
 TaskVoid Shader::CreateHullShader(const wstring &szFileName, const uint8_t i)
 {
-	auto loadVSTask = ReadShaderFile(szFileName);
-
-	// Create the shader
-	return loadVSTask.then([this, i](const CPDXBlob &pFileData)
+	// Read and create the shader on a worker thread
+	return SVX::Scheduler::GetDefault().Run([this, szFileName, i]()
 	{
+		const auto pFileData = ReadShaderFile(szFileName);
 		ThrowIfFailed(m_pDXDevice->CreateHullShader(pFileData->GetBufferPointer(),
 			pFileData->GetBufferSize(), nullptr, &m_ppHullShaders[i]));
 		ThrowIfFailed(D3DReflect(pFileData->GetBufferPointer(), pFileData->GetBufferSize(),
@@ -72,11 +54,10 @@ TaskVoid Shader::CreateHullShader(const wstring &szFileName, const uint8_t i)
 
 TaskVoid Shader::CreateDomainShader(const wstring &szFileName, const uint8_t i)
 {
-	auto loadVSTask = ReadShaderFile(szFileName);
-
-	// Create the shader
-	return loadVSTask.then([this, i](const CPDXBlob &pFileData)
+	// Read and create the shader on a worker thread
+	return SVX::Scheduler::GetDefault().Run([this, szFileName, i]()
 	{
+		const auto pFileData = ReadShaderFile(szFileName);
 		ThrowIfFailed(m_pDXDevice->CreateDomainShader(pFileData->GetBufferPointer(),
 			pFileData->GetBufferSize(), nullptr, &m_ppDomainShaders[i]));
 		ThrowIfFailed(D3DReflect(pFileData->GetBufferPointer(), pFileData->GetBufferSize(),
@@ -86,11 +67,10 @@ TaskVoid Shader::CreateDomainShader(const wstring &szFileName, const uint8_t i)
 
 TaskVoid Shader::CreateGeometryShader(const wstring &szFileName, const uint8_t i)
 {
-	auto loadGSTask = ReadShaderFile(szFileName);
-
-	// Create the shader
-	return loadGSTask.then([this, i](const CPDXBlob &pFileData)
+	// Read and create the shader on a worker thread
+	return SVX::Scheduler::GetDefault().Run([this, szFileName, i]()
 	{
+		const auto pFileData = ReadShaderFile(szFileName);
 		ThrowIfFailed(m_pDXDevice->CreateGeometryShader(pFileData->GetBufferPointer(),
 			pFileData->GetBufferSize(), nullptr, &m_ppGeometryShaders[i]));
 		ThrowIfFailed(D3DReflect(pFileData->GetBufferPointer(), pFileData->GetBufferSize(),
@@ -101,11 +81,10 @@ TaskVoid Shader::CreateGeometryShader(const wstring &szFileName, const uint8_t i
 TaskVoid Shader::CreateGeometryShaderWithSO(const wstring &szFileName, const uint8_t i,
 	const LPCD3D11_SO_DECLARATION_ENTRY pDecl, const uint8_t uNumEntries)
 {
-	auto loadGSTask = ReadShaderFile(szFileName);
-
-	// Create the shader
-	return loadGSTask.then([this, i, pDecl, uNumEntries](const CPDXBlob &pFileData)
+	// Read and create the shader on a worker thread
+	return SVX::Scheduler::GetDefault().Run([this, szFileName, i, pDecl, uNumEntries]()
 	{
+		const auto pFileData = ReadShaderFile(szFileName);
 		auto uStride = 0u;
 		for (auto j = 0ui8; j < uNumEntries; ++j)
 			uStride += pDecl[j].ComponentCount * sizeof(float);
@@ -119,11 +98,10 @@ TaskVoid Shader::CreateGeometryShaderWithSO(const wstring &szFileName, const uin
 
 TaskVoid Shader::CreatePixelShader(const wstring &szFileName, const uint8_t i)
 {
-	auto loadPSTask = ReadShaderFile(szFileName);
-
-	// Create the shader
-	return loadPSTask.then([this, i](const CPDXBlob &pFileData)
+	// Read and create the shader on a worker thread
+	return SVX::Scheduler::GetDefault().Run([this, szFileName, i]()
 	{
+		const auto pFileData = ReadShaderFile(szFileName);
 		ThrowIfFailed(m_pDXDevice->CreatePixelShader(pFileData->GetBufferPointer(),
 			pFileData->GetBufferSize(), nullptr, &m_ppPixelShaders[i]));
 		ThrowIfFailed(D3DReflect(pFileData->GetBufferPointer(), pFileData->GetBufferSize(),
@@ -133,11 +111,10 @@ TaskVoid Shader::CreatePixelShader(const wstring &szFileName, const uint8_t i)
 
 TaskVoid Shader::CreateComputeShader(const wstring &szFileName, const uint8_t i)
 {
-	auto loadCSTask = ReadShaderFile(szFileName);
-
-	// Create the shader
-	return loadCSTask.then([this, i](const CPDXBlob &pFileData)
+	// Read and create the shader on a worker thread
+	return SVX::Scheduler::GetDefault().Run([this, szFileName, i]()
 	{
+		const auto pFileData = ReadShaderFile(szFileName);
 		ThrowIfFailed(m_pDXDevice->CreateComputeShader(pFileData->GetBufferPointer(),
 			pFileData->GetBufferSize(), nullptr, &m_ppComputeShaders[i]));
 		ThrowIfFailed(D3DReflect(pFileData->GetBufferPointer(), pFileData->GetBufferSize(),
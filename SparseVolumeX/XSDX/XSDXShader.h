@@ -21,7 +21,7 @@ namespace XSDX
 		Shader(const CPDXDevice &pDXDevice);
 		virtual ~Shader(void);
 
-		TaskCPDXBlob ReadShaderFile(const std::wstring &szFileName);
+		CPDXBlob ReadShaderFile(const std::wstring &szFileName);
 		TaskVoid CreateVertexShader(const std::wstring &szFileName, const uint8_t i);
 		TaskVoid CreateHullShader(const std::wstring &szFileName, const uint8_t i);
 		TaskVoid CreateDomainShader(const std::wstring &szFileName, const uint8_t i);
@@ -6,6 +6,7 @@
 
 #include <array>
 #include "Common\DirectXHelper.h"
+#include "SVXScheduler.h"
 
 // Vector allocation and fit 
 #define VEC_ALLOC(v, i)			{ v.resize(i); v.shrink_to_fit(); }
@@ -17,6 +18,8 @@ namespace XSDX
 	// Dereference
 	//--------------------------------------------------------------------------------------
 	
+#ifdef _MSC_VER
+	// Checked iterators of the MSVC standard library
 	template<typename T, size_t S>
 	inline T& dref(std::_Array_iterator<T, S> &p)
 	{
@@ -45,6 +48,8 @@ namespace XSDX
 		return p[0];
 	}
 
+#endif
+
 	template<typename T, typename = std::enable_if_t<std::is_pointer<T>::value>>
 	inline typename std::remove_pointer_t<T>& dref(T p)
 	{
@@ -104,6 +109,9 @@ namespace XSDX
 	// Input assembler
 	using CPDXInputLayout			= Microsoft::WRL::ComPtr<ID3D11InputLayout>;
 
+	// Queries
+	using CPDXQuery					= Microsoft::WRL::ComPtr<ID3D11Query>;
+
 	// Blob
 	using CPDXBlob					= Microsoft::WRL::ComPtr<ID3DBlob>;
 
@@ -271,9 +279,7 @@ namespace XSDX
 #endif
 
 	//--------------------------------------------------------------------------------------
-	// Concurrency tasks
+	// Tasks of the work-stealing scheduler
 	//--------------------------------------------------------------------------------------
-	using TaskVecByte				= Concurrency::task<vbyte>;
-	using TaskVoid					= Concurrency::task<void>;
-	using TaskCPDXBlob				= Concurrency::task<CPDXBlob>;
+	using TaskVoid					= SVX::spTask;
 }